@@ -0,0 +1,140 @@
+#include "blake2s.h"
+
+#include <cstring>
+
+#include "secure_util.h"
+
+static const uint32_t BLAKE2S_IV[8] = {
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+    0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+static const uint8_t BLAKE2S_SIGMA[10][16] = {
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+    {14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3},
+    {11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4},
+    { 7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8},
+    { 9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13},
+    { 2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9},
+    {12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11},
+    {13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10},
+    { 6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5},
+    {10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0},
+};
+
+#define BLAKE2S_ROTR(v, n) (((v) >> (n)) | ((v) << (32 - (n))))
+
+#define BLAKE2S_G(a, b, c, d, x, y)                       \
+    do {                                                  \
+        a += b + x; d = BLAKE2S_ROTR(d ^ a, 16);          \
+        c += d;     b = BLAKE2S_ROTR(b ^ c, 12);          \
+        a += b + y; d = BLAKE2S_ROTR(d ^ a, 8);           \
+        c += d;     b = BLAKE2S_ROTR(b ^ c, 7);           \
+    } while (0)
+
+static inline uint32_t load32_le(const unsigned char *p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) |
+           ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/**
+ * Compresses one block into the chain value
+ * The message words and working vector hold input bytes: both are wiped
+ */
+static void blake2s_compress(Blake2sState *state, const unsigned char *block, bool last) {
+    uint32_t m[16], v[16];
+    for (int i = 0; i < 16; i++) m[i] = load32_le(block + 4 * i);
+    for (int i = 0; i < 8; i++) {
+        v[i] = state->h[i];
+        v[i + 8] = BLAKE2S_IV[i];
+    }
+    v[12] ^= state->t[0];
+    v[13] ^= state->t[1];
+    if (last) v[14] = ~v[14];
+
+    for (int r = 0; r < 10; r++) {
+        const uint8_t *s = BLAKE2S_SIGMA[r];
+        BLAKE2S_G(v[0], v[4], v[8],  v[12], m[s[0]],  m[s[1]]);
+        BLAKE2S_G(v[1], v[5], v[9],  v[13], m[s[2]],  m[s[3]]);
+        BLAKE2S_G(v[2], v[6], v[10], v[14], m[s[4]],  m[s[5]]);
+        BLAKE2S_G(v[3], v[7], v[11], v[15], m[s[6]],  m[s[7]]);
+        BLAKE2S_G(v[0], v[5], v[10], v[15], m[s[8]],  m[s[9]]);
+        BLAKE2S_G(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+        BLAKE2S_G(v[2], v[7], v[8],  v[13], m[s[12]], m[s[13]]);
+        BLAKE2S_G(v[3], v[4], v[9],  v[14], m[s[14]], m[s[15]]);
+    }
+    for (int i = 0; i < 8; i++) state->h[i] ^= v[i] ^ v[i + 8];
+
+    secure_wipe_vectorized(m, sizeof(m));
+    secure_wipe_vectorized(v, sizeof(v));
+}
+
+static void blake2s_count(Blake2sState *state, uint32_t bytes) {
+    state->t[0] += bytes;
+    if (state->t[0] < bytes) state->t[1]++;
+}
+
+bool blake2s_init(Blake2sState *state, size_t outLen, const void *key, size_t keyLen) {
+    if (!state || outLen == 0 || outLen > BLAKE2S_OUT_BYTES || keyLen > BLAKE2S_KEY_BYTES ||
+        (keyLen && !key)) {
+        return false;
+    }
+
+    memset(state, 0, sizeof(*state));
+    for (int i = 0; i < 8; i++) state->h[i] = BLAKE2S_IV[i];
+    // Parameter block: digest length, key length, fanout 1, depth 1
+    state->h[0] ^= 0x01010000u ^ ((uint32_t) keyLen << 8) ^ (uint32_t) outLen;
+    state->outLen = outLen;
+
+    // The key is absorbed as a full zero-padded first block
+    if (keyLen) {
+        memcpy(state->buf, key, keyLen);
+        state->bufLen = BLAKE2S_BLOCK_BYTES;
+    }
+    return true;
+}
+
+void blake2s_update(Blake2sState *state, const void *in, size_t len) {
+    const unsigned char *p = (const unsigned char *) in;
+    while (len > 0) {
+        // A full buffer is only compressed once more input shows it is not
+        // the last block (which is compressed with the final flag)
+        if (state->bufLen == BLAKE2S_BLOCK_BYTES) {
+            blake2s_count(state, BLAKE2S_BLOCK_BYTES);
+            blake2s_compress(state, state->buf, false);
+            state->bufLen = 0;
+        }
+        size_t take = BLAKE2S_BLOCK_BYTES - state->bufLen;
+        if (take > len) take = len;
+        memcpy(state->buf + state->bufLen, p, take);
+        state->bufLen += take;
+        p += take;
+        len -= take;
+    }
+}
+
+void blake2s_final(Blake2sState *state, void *out) {
+    blake2s_count(state, (uint32_t) state->bufLen);
+    memset(state->buf + state->bufLen, 0, BLAKE2S_BLOCK_BYTES - state->bufLen);
+    blake2s_compress(state, state->buf, true);
+
+    unsigned char digest[BLAKE2S_OUT_BYTES];
+    for (int i = 0; i < 8; i++) {
+        digest[4 * i] = (unsigned char) state->h[i];
+        digest[4 * i + 1] = (unsigned char) (state->h[i] >> 8);
+        digest[4 * i + 2] = (unsigned char) (state->h[i] >> 16);
+        digest[4 * i + 3] = (unsigned char) (state->h[i] >> 24);
+    }
+    memcpy(out, digest, state->outLen);
+    secure_wipe_vectorized(digest, sizeof(digest));
+    secure_wipe_vectorized(state, sizeof(*state));
+}
+
+bool blake2s(void *out, size_t outLen, const void *key, size_t keyLen,
+             const void *in, size_t inLen) {
+    Blake2sState state;
+    if (!blake2s_init(&state, outLen, key, keyLen)) return false;
+    blake2s_update(&state, in, inLen);
+    blake2s_final(&state, out);
+    return true;
+}
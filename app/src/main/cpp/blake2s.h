@@ -0,0 +1,51 @@
+#ifndef FUZZME_V3_BLAKE2S_H
+#define FUZZME_V3_BLAKE2S_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ========== BLAKE2s ==========
+// Incremental (optionally keyed) BLAKE2s as specified in RFC 7693. Small
+// enough to live inside a locked region; the 64-byte input buffer holds
+// not-yet-compressed message bytes, so states must be treated as secrets
+// and wiped like any other plaintext.
+
+static const size_t BLAKE2S_BLOCK_BYTES = 64;
+static const size_t BLAKE2S_OUT_BYTES = 32;   // Largest (and default) digest
+static const size_t BLAKE2S_KEY_BYTES = 32;   // Largest key
+
+struct Blake2sState {
+    uint32_t h[8];
+    uint32_t t[2];                              // Bytes compressed so far
+    unsigned char buf[BLAKE2S_BLOCK_BYTES];
+    size_t bufLen;
+    size_t outLen;
+};
+
+/**
+ * Starts a hash
+ *
+ * @param outLen Digest length, 1 .. BLAKE2S_OUT_BYTES
+ * @param key    MAC key (NULL for a plain hash)
+ * @param keyLen 0 .. BLAKE2S_KEY_BYTES
+ * @return false on an invalid length
+ */
+bool blake2s_init(Blake2sState *state, size_t outLen, const void *key, size_t keyLen);
+
+/**
+ * Absorbs more input; any split of the message gives the same digest
+ */
+void blake2s_update(Blake2sState *state, const void *in, size_t len);
+
+/**
+ * Writes the digest (state->outLen bytes) and wipes the state
+ */
+void blake2s_final(Blake2sState *state, void *out);
+
+/**
+ * One-shot keyed hash
+ */
+bool blake2s(void *out, size_t outLen, const void *key, size_t keyLen,
+             const void *in, size_t inLen);
+
+#endif // FUZZME_V3_BLAKE2S_H
@@ -0,0 +1,164 @@
+#include "breach_filter.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "breach_filter_format.h"
+#include "secure_util.h"
+#include "sha1.h"
+
+struct BreachFilter {
+    const unsigned char *base;          // Read-only mapping of the whole file
+    size_t mapLen;
+    BreachFilterHeader header;          // Validated copies
+    BreachFilterShard *shards;
+};
+
+// Lookups hold it shared, open/close exclusively (to swap or unmap)
+static pthread_rwlock_t g_filterLock = PTHREAD_RWLOCK_INITIALIZER;
+static BreachFilter g_filter;
+
+/**
+ * Checks a mapped file and copies its header and shard table
+ *
+ * @return false if anything would make a lookup read outside the file
+ */
+static bool filter_load(BreachFilter *filter, const unsigned char *base, size_t len) {
+    if (len < sizeof(BreachFilterHeader)) return false;
+    BreachFilterHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (memcmp(header.magic, BREACH_FILTER_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != BREACH_FILTER_VERSION ||
+        (header.fingerprintBits != 8 && header.fingerprintBits != 16) ||
+        header.shardBits > BREACH_FILTER_MAX_SHARD_BITS || header.fileBytes != len) {
+        return false;
+    }
+
+    size_t shardCount = (size_t) 1 << header.shardBits;
+    size_t tableBytes = shardCount * sizeof(BreachFilterShard);
+    if (len - sizeof(header) < tableBytes) return false;
+    BreachFilterShard *shards = (BreachFilterShard *) malloc(tableBytes);
+    if (!shards) return false;
+    memcpy(shards, base + sizeof(header), tableBytes);
+
+    size_t fingerprintBytes = header.fingerprintBits / 8;
+    uint64_t keys = 0;
+    for (size_t i = 0; i < shardCount; i++) {
+        const BreachFilterShard *shard = &shards[i];
+        uint32_t segmentLength = shard->segmentLength;
+        bool ok = segmentLength != 0 && (segmentLength & (segmentLength - 1)) == 0 &&
+                  segmentLength <= BREACH_FILTER_MAX_SEGMENT_LENGTH &&
+                  shard->segmentCount != 0 &&
+                  (uint64_t) shard->arrayLength ==
+                          ((uint64_t) shard->segmentCount + 2) * segmentLength &&
+                  shard->offset <= len &&
+                  (uint64_t) shard->arrayLength * fingerprintBytes <= len - shard->offset;
+        if (!ok) {
+            free(shards);
+            return false;
+        }
+        keys += shard->keyCount;
+    }
+    if (keys != header.keyCount) {
+        free(shards);
+        return false;
+    }
+
+    filter->base = base;
+    filter->mapLen = len;
+    filter->header = header;
+    filter->shards = shards;
+    return true;
+}
+
+static void filter_unload(BreachFilter *filter) {
+    if (filter->base) munmap((void *) filter->base, filter->mapLen);
+    free(filter->shards);
+    memset(filter, 0, sizeof(*filter));
+}
+
+long long breach_filter_open(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct stat st;
+    void *base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        base = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) return -1;
+
+    BreachFilter loaded = {};
+    if (!filter_load(&loaded, (const unsigned char *) base, (size_t) st.st_size)) {
+        munmap(base, (size_t) st.st_size);
+        return -1;
+    }
+    // Lookups hit random pages: readahead would only evict other data
+    madvise(base, (size_t) st.st_size, MADV_RANDOM);
+
+    pthread_rwlock_wrlock(&g_filterLock);
+    BreachFilter old = g_filter;
+    g_filter = loaded;
+    pthread_rwlock_unlock(&g_filterLock);
+
+    filter_unload(&old);
+    return (long long) loaded.header.keyCount;
+}
+
+void breach_filter_close() {
+    pthread_rwlock_wrlock(&g_filterLock);
+    BreachFilter old = g_filter;
+    memset(&g_filter, 0, sizeof(g_filter));
+    pthread_rwlock_unlock(&g_filterLock);
+
+    filter_unload(&old);
+}
+
+/**
+ * Fingerprint at a position (little-endian for 16-bit fingerprints)
+ */
+static inline uint32_t fingerprint_at(const unsigned char *array, uint32_t pos, bool wide) {
+    if (!wide) return array[pos];
+    return (uint32_t) array[2 * (size_t) pos] | ((uint32_t) array[2 * (size_t) pos + 1] << 8);
+}
+
+int breach_filter_contains(const void *password, size_t len) {
+    // Everything below is derived from the password: wiped before return
+    struct {
+        unsigned char digest[SHA1_OUT_BYTES];
+        uint64_t key;
+        uint64_t hash;
+        uint32_t pos[3];
+        uint32_t x;
+    } t;
+    sha1(t.digest, password, len);
+    t.key = breach_filter_key(t.digest);
+
+    int found = -1;
+    pthread_rwlock_rdlock(&g_filterLock);
+    if (g_filter.base) {
+        const BreachFilterHeader *header = &g_filter.header;
+        const BreachFilterShard *shard =
+                &g_filter.shards[breach_filter_shard(t.key, header->shardBits)];
+        const unsigned char *array = g_filter.base + shard->offset;
+        bool wide = header->fingerprintBits == 16;
+        uint32_t mask = wide ? 0xFFFF : 0xFF;
+
+        t.hash = breach_filter_hash(t.key, shard->seed);
+        breach_filter_positions(t.hash, shard, t.pos);
+        // All three are always read and combined; x == 0 is tested without a branch
+        t.x = (breach_filter_fingerprint(t.hash) ^ fingerprint_at(array, t.pos[0], wide) ^
+               fingerprint_at(array, t.pos[1], wide) ^ fingerprint_at(array, t.pos[2], wide)) &
+              mask;
+        found = (int) (((t.x | (0u - t.x)) >> 31) ^ 1);
+    }
+    pthread_rwlock_unlock(&g_filterLock);
+
+    secure_wipe_vectorized(&t, sizeof(t));
+    return found;
+}
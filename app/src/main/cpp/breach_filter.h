@@ -0,0 +1,43 @@
+#ifndef FUZZME_V3_BREACH_FILTER_H
+#define FUZZME_V3_BREACH_FILTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ========== BREACHED PASSWORD FILTER ==========
+// Offline "has this password appeared in a breach?" check against a
+// memory-mapped filter file built on the host from a corpus of SHA-1
+// hashes (format: breach_filter_format.h, builder: tools/). The file is
+// read-only and paged in on demand; a lookup touches three fingerprints.
+//
+// A lookup SHA-1s the candidate and combines the three fingerprints
+// without branching on them; the digest and everything derived from it are
+// wiped before returning. Which fingerprints are read depends on the
+// candidate, as in any hash table: the page cache shows which ~3 * 4 KiB
+// of the file were touched, so the file itself should be app-private.
+
+/**
+ * Maps a filter file, replacing the current one
+ * The header and shard table are validated and copied, so a file modified
+ * later can only change answers, never make a lookup read out of bounds
+ *
+ * @return Distinct keys in the filter, -1 if the file is missing or
+ *         malformed (the current filter then stays)
+ */
+long long breach_filter_open(const char *path);
+
+/**
+ * Unmaps the current filter
+ */
+void breach_filter_close();
+
+/**
+ * Looks a password up (callable from any thread)
+ *
+ * @param password UTF-8 as typed: corpora hash the raw bytes, not a normal form
+ * @return 1 if it is in the corpus (or a false positive, rate
+ *         2^-fingerprintBits), 0 if not, -1 if no filter is loaded
+ */
+int breach_filter_contains(const void *password, size_t len);
+
+#endif // FUZZME_V3_BREACH_FILTER_H
@@ -0,0 +1,116 @@
+#ifndef FUZZME_V3_BREACH_FILTER_FORMAT_H
+#define FUZZME_V3_BREACH_FILTER_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ========== BREACH FILTER FILE FORMAT ==========
+// Shared by the library (breach_filter.cpp) and the host builder
+// (tools/build_breach_filter.cpp); header-only so the builder needs
+// nothing else from the library.
+//
+// A filter answers "is this SHA-1 in the corpus?" with no false negatives
+// and a false-positive rate of 2^-fingerprintBits. It is a set of 3-wise
+// binary fuse filters (Graf and Lemire, "Binary Fuse Filters: Fast and
+// Smaller Than Xor Filters", 2022), one per shard, each an array of
+// fingerprints: a key is present iff the XOR of the fingerprints at its
+// three positions equals its own fingerprint.
+//
+// The key is the first 8 bytes of the SHA-1, big-endian; its top shardBits
+// bits pick the shard. SHA-1 output is uniform, so shards come out the same
+// size and no further hashing is needed to spread the keys.
+//
+// Layout (little-endian): BreachFilterHeader, then 1 << shardBits
+// BreachFilterShard entries, then the fingerprint arrays, each starting on
+// a BREACH_FILTER_ALIGN boundary. A shard without keys still gets a
+// (zeroed) array, so lookups never need a special case.
+
+static const char BREACH_FILTER_MAGIC[8] = {'F', 'Z', 'B', 'R', 'E', 'A', 'C', 'H'};
+static const uint32_t BREACH_FILTER_VERSION = 1;
+static const uint32_t BREACH_FILTER_MAX_SHARD_BITS = 16;
+static const uint32_t BREACH_FILTER_MAX_SEGMENT_LENGTH = 1u << 18;
+static const size_t BREACH_FILTER_ALIGN = 64;
+
+struct BreachFilterHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t fingerprintBits;   // 8 or 16
+    uint32_t shardBits;
+    uint32_t reserved;
+    uint64_t keyCount;          // Distinct keys over all shards
+    uint64_t fileBytes;
+};
+
+struct BreachFilterShard {
+    uint64_t seed;
+    uint64_t offset;            // Fingerprint array, from the start of the file
+    uint32_t segmentLength;     // Power of two
+    uint32_t segmentCount;
+    uint32_t arrayLength;       // (segmentCount + 2) * segmentLength, never 0
+    uint32_t keyCount;
+};
+
+static_assert(sizeof(BreachFilterHeader) == 40, "BreachFilterHeader layout");
+static_assert(sizeof(BreachFilterShard) == 32, "BreachFilterShard layout");
+
+/**
+ * Filter key of a SHA-1 digest
+ */
+static inline uint64_t breach_filter_key(const unsigned char *sha1) {
+    uint64_t key = 0;
+    for (int i = 0; i < 8; i++) key = (key << 8) | sha1[i];
+    return key;
+}
+
+static inline uint32_t breach_filter_shard(uint64_t key, uint32_t shardBits) {
+    // Two shifts: shardBits may be 0
+    return (uint32_t) ((key >> 1) >> (63 - shardBits));
+}
+
+/**
+ * Per-shard hash of a key (murmur3 finalizer of key + seed)
+ */
+static inline uint64_t breach_filter_hash(uint64_t key, uint64_t seed) {
+    uint64_t h = key + seed;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+static inline uint32_t breach_filter_fingerprint(uint64_t hash) {
+    return (uint32_t) (hash ^ (hash >> 32));
+}
+
+/**
+ * High 64 bits of a 64x64-bit product
+ */
+static inline uint64_t breach_filter_mulhi(uint64_t a, uint64_t b) {
+#ifdef __SIZEOF_INT128__
+    return (uint64_t) (((unsigned __int128) a * b) >> 64);
+#else
+    // 32-bit targets: four partial products
+    uint64_t aLo = (uint32_t) a, aHi = a >> 32, bLo = (uint32_t) b, bHi = b >> 32;
+    uint64_t lo = aLo * bLo, mid1 = aHi * bLo, mid2 = aLo * bHi;
+    uint64_t carry = ((lo >> 32) + (uint32_t) mid1 + (uint32_t) mid2) >> 32;
+    return aHi * bHi + (mid1 >> 32) + (mid2 >> 32) + carry;
+#endif
+}
+
+/**
+ * The three array positions of a hash: one in each of three consecutive
+ * segments, the first segment picked by the high bits
+ */
+static inline void breach_filter_positions(uint64_t hash, const BreachFilterShard *shard,
+                                           uint32_t out[3]) {
+    uint64_t span = (uint64_t) shard->segmentCount * shard->segmentLength;
+    uint32_t mask = shard->segmentLength - 1;
+    uint32_t h0 = (uint32_t) breach_filter_mulhi(hash, span);
+    out[0] = h0;
+    out[1] = (h0 + shard->segmentLength) ^ ((uint32_t) (hash >> 18) & mask);
+    out[2] = (h0 + 2 * shard->segmentLength) ^ ((uint32_t) hash & mask);
+}
+
+#endif // FUZZME_V3_BREACH_FILTER_FORMAT_H
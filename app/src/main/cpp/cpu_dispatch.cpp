@@ -0,0 +1,346 @@
+#include "cpu_dispatch.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#elif defined(__aarch64__)
+#include <sys/auxv.h>
+#endif
+
+// ========== FEATURE PROBE ==========
+
+// Set alongside the feature bits, so a CPU without any still probes once
+static const uint32_t FEATURES_PROBED = 1u << 31;
+
+static std::atomic<uint32_t> g_features{0};
+
+#if defined(__x86_64__) || defined(__i386__)
+
+static uint32_t probe_features() {
+    uint32_t features = 0;
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return 0;
+    if (edx & (1u << 26)) features |= CPU_X86_SSE2;
+    if (ecx & (1u << 9)) features |= CPU_X86_SSSE3;
+    if (ecx & (1u << 19)) features |= CPU_X86_SSE41;
+
+    // AVX2 also needs the OS to save the ymm registers (OSXSAVE, XCR0 bits 1-2)
+    bool ymmSaved = false;
+    if (ecx & (1u << 27)) {
+        uint32_t xcr0Lo, xcr0Hi;
+        __asm__ __volatile__("xgetbv" : "=a"(xcr0Lo), "=d"(xcr0Hi) : "c"(0));
+        ymmSaved = (xcr0Lo & 6) == 6;
+    }
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        if ((ebx & (1u << 5)) && ymmSaved) features |= CPU_X86_AVX2;
+        if (ebx & (1u << 29)) features |= CPU_X86_SHA;
+        if (ebx & (1u << 23)) features |= CPU_X86_CLFLUSHOPT;
+    }
+    return features;
+}
+
+#elif defined(__aarch64__)
+
+#ifndef HWCAP_ASIMD
+#define HWCAP_ASIMD (1 << 1)
+#endif
+#ifndef HWCAP_SHA1
+#define HWCAP_SHA1 (1 << 5)
+#endif
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2 (1 << 6)
+#endif
+
+static uint32_t probe_features() {
+    uint32_t features = 0;
+    unsigned long hwcap = getauxval(AT_HWCAP);
+    if (hwcap & HWCAP_ASIMD) features |= CPU_ARM_NEON;
+    if (hwcap & HWCAP_SHA1) features |= CPU_ARM_SHA1;
+    if (hwcap & HWCAP_SHA2) features |= CPU_ARM_SHA2;
+    return features;
+}
+
+#else
+
+static uint32_t probe_features() {
+    return 0;
+}
+
+#endif
+
+uint32_t cpu_features() {
+    uint32_t features = g_features.load(std::memory_order_relaxed);
+    if (!features) {
+        // Racing probes store the same value
+        features = probe_features() | FEATURES_PROBED;
+        g_features.store(features, std::memory_order_relaxed);
+    }
+    return features & ~FEATURES_PROBED;
+}
+
+// ========== BINDING ==========
+
+struct KernelSlotInfo {
+    const char *name;
+    const KernelVariant *variants;
+    const size_t *count;
+    size_t smallBytes;                  // Typical small input, for the bench
+};
+
+static const KernelSlotInfo SLOTS[KERNEL_COUNT] = {
+        {"wipe", WIPE_KERNELS, &WIPE_KERNEL_COUNT, 64},
+        {"compare", COMPARE_KERNELS, &COMPARE_KERNEL_COUNT, 32},
+        {"chacha20", CHACHA20_KERNELS, &CHACHA20_KERNEL_COUNT, 64},
+        {"sha1", SHA1_KERNELS, &SHA1_KERNEL_COUNT, 64},
+        {"sha256", SHA256_KERNELS, &SHA256_KERNEL_COUNT, 64},
+        {"sha256x8", SHA256_MULTI_KERNELS, &SHA256_MULTI_KERNEL_COUNT, 8 * 64}
+};
+
+// NULL until bound: callers then get the portable variant
+static std::atomic<KernelFn> g_bound[KERNEL_COUNT];
+
+static KernelFn bound_kernel(KernelSlot slot) {
+    KernelFn fn = g_bound[slot].load(std::memory_order_relaxed);
+    return fn ? fn : SLOTS[slot].variants[0].fn;
+}
+
+WipeKernel cpu_wipe_kernel() {
+    return (WipeKernel) bound_kernel(KERNEL_WIPE);
+}
+
+CompareKernel cpu_compare_kernel() {
+    return (CompareKernel) bound_kernel(KERNEL_COMPARE);
+}
+
+Chacha20Kernel cpu_chacha20_kernel() {
+    return (Chacha20Kernel) bound_kernel(KERNEL_CHACHA20);
+}
+
+Sha1BlocksFn cpu_sha1_kernel() {
+    return (Sha1BlocksFn) bound_kernel(KERNEL_SHA1);
+}
+
+Sha256BlocksFn cpu_sha256_kernel() {
+    return (Sha256BlocksFn) bound_kernel(KERNEL_SHA256);
+}
+
+Sha256MultiFn cpu_sha256_multi_kernel() {
+    return (Sha256MultiFn) bound_kernel(KERNEL_SHA256_MULTI);
+}
+
+static bool variant_usable(const KernelVariant *variant) {
+    return (variant->features & ~cpu_features()) == 0;
+}
+
+/**
+ * Tables list variants by preference: the last one the CPU can run
+ */
+static const KernelVariant *best_variant(KernelSlot slot) {
+    const KernelVariant *best = &SLOTS[slot].variants[0];
+    for (size_t i = 1; i < *SLOTS[slot].count; i++) {
+        if (variant_usable(&SLOTS[slot].variants[i])) best = &SLOTS[slot].variants[i];
+    }
+    return best;
+}
+
+bool cpu_dispatch_select(const char *kernel, const char *variant) {
+    if (!kernel || !variant) return false;
+    for (int slot = 0; slot < KERNEL_COUNT; slot++) {
+        if (strcmp(kernel, SLOTS[slot].name) != 0) continue;
+
+        const KernelVariant *chosen = NULL;
+        if (strcmp(variant, "auto") == 0) {
+            chosen = best_variant((KernelSlot) slot);
+        } else {
+            for (size_t i = 0; i < *SLOTS[slot].count && !chosen; i++) {
+                const KernelVariant *v = &SLOTS[slot].variants[i];
+                if (strcmp(variant, v->name) == 0 && variant_usable(v)) chosen = v;
+            }
+        }
+        if (!chosen) return false;
+        g_bound[slot].store(chosen->fn, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+int cpu_dispatch_configure(const char *spec) {
+    int failed = 0;
+    while (spec && *spec) {
+        const char *end = strchr(spec, ',');
+        size_t len = end ? (size_t) (end - spec) : strlen(spec);
+
+        char entry[64];
+        if (len > 0 && len < sizeof(entry)) {
+            memcpy(entry, spec, len);
+            entry[len] = '\0';
+            char *eq = strchr(entry, '=');
+            if (eq) *eq = '\0';
+            if (!eq || !cpu_dispatch_select(entry, eq + 1)) failed++;
+        } else if (len > 0) {
+            failed++;
+        }
+        spec = end ? end + 1 : NULL;
+    }
+    return failed;
+}
+
+const char *cpu_dispatch_bound(KernelSlot slot) {
+    KernelFn fn = bound_kernel(slot);
+    for (size_t i = 0; i < *SLOTS[slot].count; i++) {
+        if (SLOTS[slot].variants[i].fn == fn) return SLOTS[slot].variants[i].name;
+    }
+    return "?";
+}
+
+/**
+ * Binds every kernel when the library is loaded, before JNI_OnLoad;
+ * FUZZME_KERNELS then overrides single kernels
+ */
+__attribute__((constructor))
+static void cpu_dispatch_load() {
+    for (int slot = 0; slot < KERNEL_COUNT; slot++) {
+        g_bound[slot].store(best_variant((KernelSlot) slot)->fn, std::memory_order_relaxed);
+    }
+    const char *spec = getenv("FUZZME_KERNELS");
+    if (spec) cpu_dispatch_configure(spec);
+}
+
+// ========== BENCH ==========
+
+static const size_t BENCH_LARGE_BYTES = 4096;
+
+static volatile uint32_t g_benchSink;
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static void bench_call(KernelSlot slot, KernelFn fn, unsigned char *a, unsigned char *b,
+                       size_t len) {
+    static const uint32_t key[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    switch (slot) {
+        case KERNEL_WIPE:
+            ((WipeKernel) fn)(a, len);
+            break;
+        case KERNEL_COMPARE:
+            g_benchSink = ((CompareKernel) fn)(a, b, len);
+            break;
+        case KERNEL_CHACHA20:
+            ((Chacha20Kernel) fn)(key, 0, a, b, len);
+            break;
+        case KERNEL_SHA1: {
+            uint32_t h[5] = {};
+            ((Sha1BlocksFn) fn)(h, a, len / 64);
+            g_benchSink = h[0];
+            break;
+        }
+        case KERNEL_SHA256: {
+            uint32_t h[8] = {};
+            ((Sha256BlocksFn) fn)(h, a, len / 64);
+            g_benchSink = h[0];
+            break;
+        }
+        case KERNEL_SHA256_MULTI: {
+            // len is split over the lanes
+            uint32_t h[8][8] = {};
+            const unsigned char *lanes[8];
+            for (int l = 0; l < 8; l++) lanes[l] = a + l * (len / 8);
+            ((Sha256MultiFn) fn)(h, lanes, 8, len / (8 * 64));
+            g_benchSink = h[7][0];
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/**
+ * @return Nanoseconds per call, over batches that double until millis pass
+ */
+static double bench_variant(KernelSlot slot, KernelFn fn, unsigned char *a, unsigned char *b,
+                            size_t len, uint32_t millis) {
+    bench_call(slot, fn, a, b, len);
+    uint64_t budget = (uint64_t) millis * 1000000, calls = 0, batch = 1;
+    uint64_t start = now_ns(), elapsed = 0;
+    do {
+        for (uint64_t i = 0; i < batch; i++) bench_call(slot, fn, a, b, len);
+        calls += batch;
+        batch *= 2;
+        elapsed = now_ns() - start;
+    } while (elapsed < budget);
+    return (double) elapsed / (double) calls;
+}
+
+struct BenchText {
+    char *out;
+    size_t cap;
+    size_t len;
+};
+
+__attribute__((format(printf, 2, 3)))
+static void bench_append(BenchText *text, const char *fmt, ...) {
+    if (text->len + 1 >= text->cap) return;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(text->out + text->len, text->cap - text->len, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        size_t room = text->cap - text->len - 1;
+        text->len += (size_t) n < room ? (size_t) n : room;
+    }
+}
+
+size_t cpu_dispatch_bench(char *out, size_t cap, uint32_t millisPerRun) {
+    if (!out || cap == 0) return 0;
+    out[0] = '\0';
+    BenchText text = {out, cap, 0};
+
+    static const struct {
+        uint32_t bit;
+        const char *name;
+    } FEATURE_NAMES[] = {
+            {CPU_X86_SSE2, "sse2"}, {CPU_X86_SSSE3, "ssse3"}, {CPU_X86_SSE41, "sse4.1"},
+            {CPU_X86_AVX2, "avx2"}, {CPU_X86_SHA, "sha"}, {CPU_X86_CLFLUSHOPT, "clflushopt"},
+            {CPU_ARM_NEON, "neon"}, {CPU_ARM_SHA1, "sha1"}, {CPU_ARM_SHA2, "sha2"}
+    };
+    uint32_t features = cpu_features();
+    bench_append(&text, "features:");
+    for (const auto &feature : FEATURE_NAMES) {
+        if (features & feature.bit) bench_append(&text, " %s", feature.name);
+    }
+    bench_append(&text, "\n%-9s %-9s %13s %13s %11s\n", "kernel", "variant", "small",
+                 "4 KiB", "4 KiB");
+
+    // Not secret: plain heap, the kernels only need something to chew on
+    unsigned char *a = (unsigned char *) malloc(2 * BENCH_LARGE_BYTES);
+    if (!a) return text.len;
+    unsigned char *b = a + BENCH_LARGE_BYTES;
+    for (size_t i = 0; i < 2 * BENCH_LARGE_BYTES; i++) a[i] = (unsigned char) (i * 131 + 7);
+
+    for (int s = 0; s < KERNEL_COUNT; s++) {
+        KernelSlot slot = (KernelSlot) s;
+        KernelFn current = bound_kernel(slot);
+        for (size_t i = 0; i < *SLOTS[slot].count; i++) {
+            const KernelVariant *v = &SLOTS[slot].variants[i];
+            if (!variant_usable(v)) continue;
+            size_t small = SLOTS[slot].smallBytes;
+            double smallNs = bench_variant(slot, v->fn, a, b, small, millisPerRun);
+            double largeNs = bench_variant(slot, v->fn, a, b, BENCH_LARGE_BYTES, millisPerRun);
+            bench_append(&text, "%-9s %-8s%c %4zu B %6.1f ns %10.0f ns %6.0f MB/s\n",
+                         SLOTS[slot].name, v->name, v->fn == current ? '*' : ' ', small,
+                         smallNs, largeNs, BENCH_LARGE_BYTES * 1e3 / largeNs);
+        }
+    }
+
+    free(a);
+    return text.len;
+}
@@ -0,0 +1,125 @@
+#ifndef FUZZME_V3_CPU_DISPATCH_H
+#define FUZZME_V3_CPU_DISPATCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ========== CPU DISPATCH ==========
+// The hot kernels (wipe, constant-time compare, ChaCha20, SHA-1, SHA-256,
+// multi-buffer SHA-256) come in several variants: portable code, 16-byte
+// vectors, AVX2, the SHA instructions. CPU features are probed once (cpuid
+// on x86, getauxval(AT_HWCAP) on arm64) and every kernel is bound to the
+// fastest variant the CPU can run when the library is loaded; callers go
+// through the bound pointer, one relaxed load per call.
+//
+// Any variant the CPU supports can be forced, with cpu_dispatch_select() or
+// FUZZME_KERNELS="sha256=portable,wipe=vec16" in the environment, so every
+// variant can be measured on one device (cpu_dispatch_bench()). All
+// variants of a kernel give the same result, so switching is safe while
+// other threads run.
+
+enum CpuFeature {
+    CPU_X86_SSE2 = 1u << 0,
+    CPU_X86_SSSE3 = 1u << 1,
+    CPU_X86_SSE41 = 1u << 2,
+    CPU_X86_AVX2 = 1u << 3,
+    CPU_X86_SHA = 1u << 4,
+    CPU_X86_CLFLUSHOPT = 1u << 5,
+    CPU_ARM_NEON = 1u << 16,
+    CPU_ARM_SHA1 = 1u << 17,
+    CPU_ARM_SHA2 = 1u << 18
+};
+
+enum KernelSlot {
+    KERNEL_WIPE = 0,
+    KERNEL_COMPARE,
+    KERNEL_CHACHA20,
+    KERNEL_SHA1,
+    KERNEL_SHA256,
+    KERNEL_SHA256_MULTI,
+    KERNEL_COUNT
+};
+
+/**
+ * Kernel signatures, one per slot
+ */
+typedef void (*WipeKernel)(void *ptr, size_t len);
+typedef uint32_t (*CompareKernel)(const void *a, const void *b, size_t len);  // 0 iff equal
+typedef void (*Chacha20Kernel)(const uint32_t key[8], uint64_t nonce,
+                               const unsigned char *src, unsigned char *dst, size_t len);
+typedef void (*Sha1BlocksFn)(uint32_t h[5], const unsigned char *blocks, size_t count);
+typedef void (*Sha256BlocksFn)(uint32_t h[8], const unsigned char *blocks, size_t count);
+typedef void (*Sha256MultiFn)(uint32_t h[][8], const unsigned char *const blocks[], size_t lanes,
+                              size_t count);
+
+typedef void (*KernelFn)();
+
+struct KernelVariant {
+    const char *name;
+    uint32_t features;                  // CpuFeature bits the variant needs
+    KernelFn fn;                        // One of the slot's signatures
+};
+
+// Variant tables, portable first and then by preference; each is defined
+// next to its kernels
+extern const KernelVariant WIPE_KERNELS[];          // secure_util.cpp
+extern const size_t WIPE_KERNEL_COUNT;
+extern const KernelVariant COMPARE_KERNELS[];       // secure_util.cpp
+extern const size_t COMPARE_KERNEL_COUNT;
+extern const KernelVariant CHACHA20_KERNELS[];      // sealed_memory.cpp
+extern const size_t CHACHA20_KERNEL_COUNT;
+extern const KernelVariant SHA1_KERNELS[];          // sha1.cpp
+extern const size_t SHA1_KERNEL_COUNT;
+extern const KernelVariant SHA256_KERNELS[];        // sha256.cpp
+extern const size_t SHA256_KERNEL_COUNT;
+extern const KernelVariant SHA256_MULTI_KERNELS[];  // sha256.cpp
+extern const size_t SHA256_MULTI_KERNEL_COUNT;
+
+/**
+ * CpuFeature bits of this CPU, probed on first call. Async-signal-safe
+ */
+uint32_t cpu_features();
+
+/**
+ * Bound variant of each kernel: the portable one until the library's
+ * constructor has run. Async-signal-safe (a single atomic load)
+ */
+WipeKernel cpu_wipe_kernel();
+CompareKernel cpu_compare_kernel();
+Chacha20Kernel cpu_chacha20_kernel();
+Sha1BlocksFn cpu_sha1_kernel();
+Sha256BlocksFn cpu_sha256_kernel();
+Sha256MultiFn cpu_sha256_multi_kernel();
+
+/**
+ * Binds a kernel to a named variant
+ *
+ * @param kernel  "wipe", "compare", "chacha20", "sha1", "sha256" or "sha256x8"
+ * @param variant Name from the kernel's table, or "auto" for the fastest
+ *                the CPU supports
+ * @return false if either name is unknown or the CPU lacks the variant's
+ *         features (the binding is left as it was)
+ */
+bool cpu_dispatch_select(const char *kernel, const char *variant);
+
+/**
+ * Applies a "kernel=variant,..." list, as read from FUZZME_KERNELS
+ * @return Number of entries that could not be applied
+ */
+int cpu_dispatch_configure(const char *spec);
+
+/**
+ * Name of the variant a kernel is bound to
+ */
+const char *cpu_dispatch_bound(KernelSlot slot);
+
+/**
+ * Times every variant this CPU can run on a small and a 4 KiB input and
+ * formats a comparison table ('*' marks the bound variants)
+ * Runs on the calling thread for about millisPerRun per variant and size
+ *
+ * @return Length of the table, truncated to fit out (always NUL-terminated)
+ */
+size_t cpu_dispatch_bench(char *out, size_t cap, uint32_t millisPerRun);
+
+#endif // FUZZME_V3_CPU_DISPATCH_H
@@ -0,0 +1,292 @@
+#include "credential_text.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "secure_util.h"
+#include "unicode_tables.h"
+
+// ========== SIMD BLOCK PRIMITIVES ==========
+
+/**
+ * True if all 8 code units are below limit (limit is a power of two <= 0x100)
+ */
+static inline bool block_below(const uint16_t *src, uint16_t limit) {
+#if defined(__SSE2__)
+    __m128i v = _mm_loadu_si128((const __m128i *) src);
+    __m128i high = _mm_and_si128(v, _mm_set1_epi16((short) (uint16_t) ~(limit - 1)));
+    return _mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) == 0xFFFF;
+#elif defined(__ARM_NEON)
+    uint16x8_t v = vld1q_u16(src);
+    uint16x4_t any = vorr_u16(vget_low_u16(v), vget_high_u16(v));
+    uint64_t bits = vget_lane_u64(vreinterpret_u64_u16(any), 0);
+    uint64_t mask = 0x0001000100010001ull * (uint16_t) ~(limit - 1);
+    return (bits & mask) == 0;
+#else
+    uint16_t any = 0;
+    for (int i = 0; i < 8; i++) any |= src[i];
+    return (any & (uint16_t) ~(limit - 1)) == 0;
+#endif
+}
+
+/**
+ * Narrows 8 ASCII code units to 8 bytes
+ */
+static inline void block_narrow(const uint16_t *src, unsigned char *dst) {
+#if defined(__SSE2__)
+    __m128i v = _mm_loadu_si128((const __m128i *) src);
+    _mm_storel_epi64((__m128i *) dst, _mm_packus_epi16(v, v));
+#elif defined(__ARM_NEON)
+    vst1_u8(dst, vmovn_u16(vld1q_u16(src)));
+#else
+    for (int i = 0; i < 8; i++) dst[i] = (unsigned char) src[i];
+#endif
+}
+
+// ========== UTF-16 -> UTF-8 ==========
+
+size_t credential_utf8_capacity(size_t utf16Len) {
+    return utf16Len * NFKC_MAX_DECOMP * 3;
+}
+
+size_t credential_scratch_capacity(size_t utf16Len) {
+    // Decoded input followed by its decomposition
+    return utf16Len + utf16Len * NFKC_MAX_DECOMP;
+}
+
+static inline int utf8_put(uint32_t cp, unsigned char *dst) {
+    if (cp < 0x80) {
+        dst[0] = (unsigned char) cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        dst[0] = (unsigned char) (0xC0 | (cp >> 6));
+        dst[1] = (unsigned char) (0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        dst[0] = (unsigned char) (0xE0 | (cp >> 12));
+        dst[1] = (unsigned char) (0x80 | ((cp >> 6) & 0x3F));
+        dst[2] = (unsigned char) (0x80 | (cp & 0x3F));
+        return 3;
+    }
+    dst[0] = (unsigned char) (0xF0 | (cp >> 18));
+    dst[1] = (unsigned char) (0x80 | ((cp >> 12) & 0x3F));
+    dst[2] = (unsigned char) (0x80 | ((cp >> 6) & 0x3F));
+    dst[3] = (unsigned char) (0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/**
+ * Reads one code point, combining surrogate pairs
+ * @return Code units consumed, or 0 on an unpaired surrogate
+ */
+static inline size_t utf16_next(const uint16_t *src, size_t remaining, uint32_t *cp) {
+    uint16_t u = src[0];
+    if (u < 0xD800 || u > 0xDFFF) {
+        *cp = u;
+        return 1;
+    }
+    if (u > 0xDBFF || remaining < 2 || src[1] < 0xDC00 || src[1] > 0xDFFF) return 0;
+    *cp = 0x10000 + (((uint32_t) (u - 0xD800) << 10) | (uint32_t) (src[1] - 0xDC00));
+    return 2;
+}
+
+long utf16_to_utf8(const uint16_t *src, size_t len, unsigned char *dst, size_t dstCap) {
+    size_t i = 0, out = 0;
+    while (i < len) {
+        // ASCII fast path: 8 units per step
+        if (len - i >= 8 && dstCap - out >= 8 && block_below(src + i, 0x80)) {
+            block_narrow(src + i, dst + out);
+            i += 8;
+            out += 8;
+            continue;
+        }
+
+        uint32_t cp;
+        size_t used = utf16_next(src + i, len - i, &cp);
+        if (!used || dstCap - out < 4) return -1;
+        out += utf8_put(cp, dst + out);
+        i += used;
+    }
+    return (long) out;
+}
+
+// ========== NFKC ==========
+
+static const uint32_t HANGUL_S_BASE = 0xAC00, HANGUL_L_BASE = 0x1100;
+static const uint32_t HANGUL_V_BASE = 0x1161, HANGUL_T_BASE = 0x11A7;
+static const uint32_t HANGUL_L_COUNT = 19, HANGUL_V_COUNT = 21, HANGUL_T_COUNT = 28;
+static const uint32_t HANGUL_N_COUNT = HANGUL_V_COUNT * HANGUL_T_COUNT;
+static const uint32_t HANGUL_S_COUNT = HANGUL_L_COUNT * HANGUL_N_COUNT;
+
+static const uint16_t *find_decomp(uint32_t cp) {
+    size_t lo = 0, hi = sizeof(NFKC_DECOMP) / sizeof(NFKC_DECOMP[0]);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (NFKC_DECOMP[mid][0] == cp) return &NFKC_DECOMP[mid][1];
+        if (NFKC_DECOMP[mid][0] < cp) lo = mid + 1; else hi = mid;
+    }
+    return nullptr;
+}
+
+static int combining_class(uint32_t cp) {
+    if (cp < 0x300) return 0;
+    size_t lo = 0, hi = sizeof(NFKC_CCC) / sizeof(NFKC_CCC[0]);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (NFKC_CCC[mid][0] == cp) return NFKC_CCC[mid][1];
+        if (NFKC_CCC[mid][0] < cp) lo = mid + 1; else hi = mid;
+    }
+    return 0;
+}
+
+/**
+ * Primary composite of a starter and a following character, or 0
+ */
+static uint32_t compose_pair(uint32_t a, uint32_t b) {
+    // Hangul LV and LV + T
+    if (a >= HANGUL_L_BASE && a < HANGUL_L_BASE + HANGUL_L_COUNT &&
+        b >= HANGUL_V_BASE && b < HANGUL_V_BASE + HANGUL_V_COUNT) {
+        return HANGUL_S_BASE + ((a - HANGUL_L_BASE) * HANGUL_V_COUNT + (b - HANGUL_V_BASE)) * HANGUL_T_COUNT;
+    }
+    if (a >= HANGUL_S_BASE && a < HANGUL_S_BASE + HANGUL_S_COUNT &&
+        (a - HANGUL_S_BASE) % HANGUL_T_COUNT == 0 &&
+        b > HANGUL_T_BASE && b < HANGUL_T_BASE + HANGUL_T_COUNT) {
+        return a + (b - HANGUL_T_BASE);
+    }
+
+    size_t lo = 0, hi = sizeof(NFKC_COMPOSE) / sizeof(NFKC_COMPOSE[0]);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        uint32_t ma = NFKC_COMPOSE[mid][0], mb = NFKC_COMPOSE[mid][1];
+        if (ma == a && mb == b) return NFKC_COMPOSE[mid][2];
+        if (ma < a || (ma == a && mb < b)) lo = mid + 1; else hi = mid;
+    }
+    return 0;
+}
+
+/**
+ * True if the unit may change under NFKC (decomposes, combines or reorders)
+ * Units below U+00A0 never do, which the SIMD pre-scan exploits
+ */
+static bool unit_needs_nfkc(uint16_t u) {
+    if (u < 0xA0) return false;
+    if (u >= 0x1100 && u <= 0x11FF) return true;  // Conjoining jamo compose
+    return find_decomp(u) || combining_class(u) != 0;
+}
+
+/**
+ * NFKC quick check: true if the input is already normalized
+ */
+static bool is_nfkc(const uint16_t *src, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        if (len - i >= 8 && block_below(src + i, 0x80)) {
+            i += 8;
+            continue;
+        }
+        if (unit_needs_nfkc(src[i])) return false;
+        i++;
+    }
+    return true;
+}
+
+/**
+ * Full decomposition + canonical ordering + composition, in scratch
+ * @return Normalized length in cps, or -1 on invalid UTF-16
+ */
+static long nfkc_normalize(const uint16_t *src, size_t len, uint32_t *scratch,
+                           uint32_t **result) {
+    uint32_t *decoded = scratch;
+    uint32_t *buf = scratch + len;
+    size_t n = 0, m = 0;
+
+    // Decode
+    for (size_t i = 0; i < len;) {
+        size_t used = utf16_next(src + i, len - i, &decoded[n]);
+        if (!used) return -1;
+        i += used;
+        n++;
+    }
+
+    // Compatibility decomposition (table entries are already fully decomposed)
+    for (size_t i = 0; i < n; i++) {
+        uint32_t cp = decoded[i];
+        if (cp >= HANGUL_S_BASE && cp < HANGUL_S_BASE + HANGUL_S_COUNT) {
+            uint32_t s = cp - HANGUL_S_BASE;
+            buf[m++] = HANGUL_L_BASE + s / HANGUL_N_COUNT;
+            buf[m++] = HANGUL_V_BASE + (s % HANGUL_N_COUNT) / HANGUL_T_COUNT;
+            if (s % HANGUL_T_COUNT) buf[m++] = HANGUL_T_BASE + s % HANGUL_T_COUNT;
+            continue;
+        }
+        const uint16_t *d = cp < 0x10000 ? find_decomp(cp) : nullptr;
+        if (!d) {
+            buf[m++] = cp;
+            continue;
+        }
+        for (int k = 0; k < NFKC_MAX_DECOMP && d[k]; k++) buf[m++] = d[k];
+    }
+
+    // Canonical ordering: stable insertion sort of each run of combining marks
+    for (size_t i = 1; i < m; i++) {
+        uint32_t cp = buf[i];
+        int cc = combining_class(cp);
+        if (!cc) continue;
+        size_t j = i;
+        while (j > 0 && combining_class(buf[j - 1]) > cc) {
+            buf[j] = buf[j - 1];
+            j--;
+        }
+        buf[j] = cp;
+    }
+
+    // Canonical composition (UAX #15)
+    if (m == 0) {
+        *result = buf;
+        return 0;
+    }
+    size_t starter = 0, target = 1;
+    int lastClass = combining_class(buf[0]) ? 256 : 0;
+    for (size_t i = 1; i < m; i++) {
+        uint32_t cp = buf[i];
+        int cc = combining_class(cp);
+        uint32_t composite = lastClass == 256 ? 0 : compose_pair(buf[starter], cp);
+        if (composite && (lastClass < cc || lastClass == 0)) {
+            buf[starter] = composite;
+            continue;
+        }
+        if (cc == 0) starter = target;
+        lastClass = cc;
+        buf[target++] = cp;
+    }
+
+    secure_memzero(decoded, n * sizeof(uint32_t));
+    *result = buf;
+    return (long) target;
+}
+
+long credential_to_utf8(const uint16_t *src, size_t len,
+                        unsigned char *dst, size_t dstCap,
+                        uint32_t *scratch, size_t scratchCap) {
+    if (dstCap < credential_utf8_capacity(len)) return -1;
+
+    // Common case: nothing to normalize, transcode directly
+    if (is_nfkc(src, len)) return utf16_to_utf8(src, len, dst, dstCap);
+
+    if (scratchCap < credential_scratch_capacity(len)) return -1;
+
+    uint32_t *normalized = nullptr;
+    long n = nfkc_normalize(src, len, scratch, &normalized);
+    long out = -1;
+    if (n >= 0) {
+        out = 0;
+        for (long i = 0; i < n; i++) out += utf8_put(normalized[i], dst + out);
+    }
+
+    secure_memzero(scratch, credential_scratch_capacity(len) * sizeof(uint32_t));
+    return out;
+}
@@ -0,0 +1,45 @@
+#ifndef FUZZME_V3_CREDENTIAL_TEXT_H
+#define FUZZME_V3_CREDENTIAL_TEXT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ========== CREDENTIAL TEXT ==========
+// Turns the UTF-16 a user typed into the canonical byte form we compare:
+// NFKC-normalized UTF-8. Inputs that are already in NFKC (all ASCII, and most
+// other text) go straight through a SIMD transcoder; everything else is
+// decoded, normalized and re-encoded in caller-provided (locked) scratch.
+// Nothing here touches the heap.
+
+/**
+ * UTF-8 output bytes needed for a credential of utf16Len code units
+ * (worst case: every unit expands to NFKC_MAX_DECOMP 3-byte code points)
+ */
+size_t credential_utf8_capacity(size_t utf16Len);
+
+/**
+ * Code point scratch entries credential_to_utf8() may use
+ */
+size_t credential_scratch_capacity(size_t utf16Len);
+
+/**
+ * Validating UTF-16 to UTF-8 transcoder, 8 code units per step on ASCII runs
+ *
+ * @return Bytes written, or -1 on an unpaired surrogate or if dst is too small
+ */
+long utf16_to_utf8(const uint16_t *src, size_t len, unsigned char *dst, size_t dstCap);
+
+/**
+ * NFKC-normalizes and UTF-8-encodes a credential
+ *
+ * @param src        UTF-16 input
+ * @param len        Number of code units
+ * @param dst        Output, credential_utf8_capacity(len) bytes
+ * @param scratch    Work area, credential_scratch_capacity(len) entries (wiped before return)
+ * @return Bytes written to dst, or -1 if the input is not valid UTF-16
+ */
+long credential_to_utf8(const uint16_t *src, size_t len,
+                        unsigned char *dst, size_t dstCap,
+                        uint32_t *scratch, size_t scratchCap);
+
+#endif // FUZZME_V3_CREDENTIAL_TEXT_H
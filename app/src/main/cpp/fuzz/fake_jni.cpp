@@ -0,0 +1,235 @@
+#include "fake_jni.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "jni_util.h"
+
+// The JDK and the NDK name the function tables differently
+#ifdef _JAVASOFT_JNI_H_
+typedef JNINativeInterface_ FakeFunctionTable;
+typedef JNIInvokeInterface_ FakeInvokeTable;
+#else
+typedef JNINativeInterface FakeFunctionTable;
+typedef JNIInvokeInterface FakeInvokeTable;
+#endif
+
+struct FakeCharArray : _jcharArray {
+    jchar *javaEnd;       // End of the slot's Java arena (guard page follows)
+    jchar *copyEnd;       // End of the slot's copy arena
+    jchar *java;          // Java-visible elements
+    size_t len;
+    bool copy;
+    bool failGet;
+    int outstanding;      // Get without a matching release
+    long releasedZeros;
+};
+
+static FakeCharArray g_arrays[FAKE_ARRAY_SLOTS];
+static FakeFunctionTable g_functions;
+static JNIEnv g_env;
+
+/**
+ * Maps len bytes followed by a PROT_NONE page; returns the end of the usable part
+ */
+static jchar *map_guarded(size_t len) {
+    size_t ps = (size_t) sysconf(_SC_PAGESIZE);
+    size_t usable = (len + ps - 1) & ~(ps - 1);
+    unsigned char *mem = (unsigned char *) mmap(NULL, usable + ps, PROT_READ | PROT_WRITE,
+                                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED || mprotect(mem + usable, ps, PROT_NONE) != 0) {
+        fprintf(stderr, "fake_jni: cannot map arena\n");
+        abort();
+    }
+    return (jchar *) (mem + usable);
+}
+
+static FakeCharArray *as_array(jarray array) {
+    FakeCharArray *a = static_cast<FakeCharArray *>(static_cast<_jcharArray *>(array));
+    if (a < g_arrays || a >= g_arrays + FAKE_ARRAY_SLOTS) {
+        fprintf(stderr, "fake_jni: not an array handle\n");
+        abort();
+    }
+    return a;
+}
+
+// Slab free maps are only referenced from headers inside the mmap'd slab
+// pages, which LeakSanitizer does not scan. Weak: test_otp links this file
+// next to ../test/host_test.cpp, which has the same suppressions
+extern "C" __attribute__((weak)) const char *__lsan_default_suppressions() {
+    return "leak:grow_cache\n";
+}
+
+// ========== JNI FUNCTIONS ==========
+
+static jsize fake_GetArrayLength(JNIEnv *, jarray array) {
+    return (jsize) as_array(array)->len;
+}
+
+static jchar *fake_GetCharArrayElements(JNIEnv *, jcharArray array, jboolean *isCopy) {
+    FakeCharArray *a = as_array(array);
+    if (a->failGet) return NULL;
+    a->outstanding++;
+    if (isCopy) *isCopy = a->copy ? JNI_TRUE : JNI_FALSE;
+    if (!a->copy) return a->java;
+
+    jchar *view = a->copyEnd - a->len;
+    memcpy(view, a->java, a->len * sizeof(jchar));
+    return view;
+}
+
+static void fake_ReleaseCharArrayElements(JNIEnv *, jcharArray array, jchar *elems, jint mode) {
+    FakeCharArray *a = as_array(array);
+    jchar *expected = a->copy ? a->copyEnd - a->len : a->java;
+    if (elems != expected || a->outstanding <= 0) {
+        fprintf(stderr, "fake_jni: release of elements that were not handed out\n");
+        abort();
+    }
+
+    long zeros = 0;
+    while ((size_t) zeros < a->len && elems[zeros] == 0) zeros++;
+    a->releasedZeros = zeros;
+
+    if (a->copy && mode != JNI_ABORT) memcpy(a->java, elems, a->len * sizeof(jchar));
+    if (mode != JNI_COMMIT) a->outstanding--;
+}
+
+static void fake_GetCharArrayRegion(JNIEnv *, jcharArray array, jsize start, jsize len,
+                                    jchar *buf) {
+    FakeCharArray *a = as_array(array);
+    // A JVM would throw ArrayIndexOutOfBoundsException
+    if (start < 0 || len < 0 || (size_t) start + (size_t) len > a->len) {
+        fprintf(stderr, "fake_jni: region out of bounds\n");
+        abort();
+    }
+    memcpy(buf, a->java + start, (size_t) len * sizeof(jchar));
+}
+
+// ========== RESULT CALLBACKS ==========
+
+static _jobject g_callback;
+static _jclass g_callbackClass;
+static FakeInvokeTable g_invoke;
+static JavaVM g_vm;
+
+static pthread_mutex_t g_resultLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_resultCond = PTHREAD_COND_INITIALIZER;
+static jlong g_resultHandle = 0;    // Last onNativeResult() call
+static int g_resultOk = -1;
+
+static jclass fake_GetObjectClass(JNIEnv *, jobject) { return &g_callbackClass; }
+
+static jmethodID fake_GetMethodID(JNIEnv *, jclass, const char *, const char *) {
+    return (jmethodID) 1;
+}
+
+static void fake_DeleteLocalRef(JNIEnv *, jobject) {}
+static jobject fake_NewGlobalRef(JNIEnv *, jobject obj) { return obj; }
+static void fake_DeleteGlobalRef(JNIEnv *, jobject) {}
+static jboolean fake_ExceptionCheck(JNIEnv *) { return JNI_FALSE; }
+static void fake_ExceptionClear(JNIEnv *) {}
+static void fake_ExceptionDescribe(JNIEnv *) {}
+
+static void fake_CallVoidMethodV(JNIEnv *, jobject, jmethodID, va_list args) {
+    jlong handle = va_arg(args, jlong);
+    int ok = va_arg(args, int);
+    pthread_mutex_lock(&g_resultLock);
+    g_resultHandle = handle;
+    g_resultOk = ok ? 1 : 0;
+    pthread_cond_broadcast(&g_resultCond);
+    pthread_mutex_unlock(&g_resultLock);
+}
+
+static jint fake_GetEnv(JavaVM *, void **env, jint) {
+    *env = &g_env;
+    return JNI_OK;
+}
+
+// ========== PUBLIC API ==========
+
+void fake_jni_init() {
+    for (int i = 0; i < FAKE_ARRAY_SLOTS; i++) {
+        g_arrays[i].javaEnd = map_guarded(FAKE_ARRAY_MAX * sizeof(jchar));
+        g_arrays[i].copyEnd = map_guarded(FAKE_ARRAY_MAX * sizeof(jchar));
+    }
+    // Everything else stays NULL: an unexpected call crashes loudly
+    g_functions.GetArrayLength = fake_GetArrayLength;
+    g_functions.GetCharArrayElements = fake_GetCharArrayElements;
+    g_functions.ReleaseCharArrayElements = fake_ReleaseCharArrayElements;
+    g_functions.GetCharArrayRegion = fake_GetCharArrayRegion;
+    g_env.functions = &g_functions;
+}
+
+JNIEnv *fake_jni_env() {
+    return &g_env;
+}
+
+jcharArray fake_char_array(int slot, const jchar *data, size_t len, bool copy, bool failGet) {
+    FakeCharArray *a = &g_arrays[slot];
+    if (len > FAKE_ARRAY_MAX) len = FAKE_ARRAY_MAX;
+    a->java = a->javaEnd - len;
+    a->len = len;
+    a->copy = copy;
+    a->failGet = failGet;
+    a->outstanding = 0;
+    a->releasedZeros = -1;
+    if (data) {
+        memcpy(a->java, data, len * sizeof(jchar));
+    } else {
+        memset(a->java, 0, len * sizeof(jchar));
+    }
+    return a;
+}
+
+const jchar *fake_char_array_java(jcharArray array) {
+    return as_array(array)->java;
+}
+
+long fake_char_array_released_zeros(jcharArray array) {
+    return as_array(array)->releasedZeros;
+}
+
+void fake_jni_check_balanced() {
+    for (int i = 0; i < FAKE_ARRAY_SLOTS; i++) {
+        if (g_arrays[i].outstanding != 0) {
+            fprintf(stderr, "fake_jni: array %d elements never released\n", i);
+            abort();
+        }
+    }
+}
+
+jobject fake_result_callback() {
+    g_functions.GetObjectClass = fake_GetObjectClass;
+    g_functions.GetMethodID = fake_GetMethodID;
+    g_functions.DeleteLocalRef = fake_DeleteLocalRef;
+    g_functions.NewGlobalRef = fake_NewGlobalRef;
+    g_functions.DeleteGlobalRef = fake_DeleteGlobalRef;
+    g_functions.ExceptionCheck = fake_ExceptionCheck;
+    g_functions.ExceptionClear = fake_ExceptionClear;
+    g_functions.ExceptionDescribe = fake_ExceptionDescribe;
+    g_functions.CallVoidMethodV = fake_CallVoidMethodV;
+    g_invoke.GetEnv = fake_GetEnv;
+    g_vm.functions = &g_invoke;
+    jni_set_vm(&g_vm);
+    return &g_callback;
+}
+
+int fake_wait_result(jlong handle) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 10;
+
+    pthread_mutex_lock(&g_resultLock);
+    while (g_resultHandle != handle &&
+           pthread_cond_timedwait(&g_resultCond, &g_resultLock, &deadline) == 0) {
+    }
+    int ok = g_resultHandle == handle ? g_resultOk : -1;
+    pthread_mutex_unlock(&g_resultLock);
+    return ok;
+}
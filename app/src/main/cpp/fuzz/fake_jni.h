@@ -0,0 +1,67 @@
+#ifndef FUZZME_V3_FAKE_JNI_H
+#define FUZZME_V3_FAKE_JNI_H
+
+#include <jni.h>
+#include <cstddef>
+
+// ========== FAKE JNIEnv ==========
+// Just enough of a JVM to drive the JNI entry points in-process. Arrays live
+// at the very end of a reusable arena that is followed by a PROT_NONE guard
+// page, so reading or writing one element past an array faults even without
+// a sanitizer. Nothing is allocated per iteration.
+
+// Independent arrays a single input can create (user, pass, buffer, ...)
+static const int FAKE_ARRAY_SLOTS = 4;
+
+// Longest array a fuzz input can describe, in jchars
+static const size_t FAKE_ARRAY_MAX = 4096;
+
+/**
+ * Maps the arenas and builds the function table (once, from LLVMFuzzerInitialize)
+ */
+void fake_jni_init();
+
+JNIEnv *fake_jni_env();
+
+/**
+ * Fills an array slot for this iteration
+ *
+ * @param slot       0 .. FAKE_ARRAY_SLOTS - 1
+ * @param data       Initial contents (may be NULL for zeros)
+ * @param len        Element count, at most FAKE_ARRAY_MAX
+ * @param copy       Get*ArrayElements hands out a copy (like a moving GC)
+ * @param failGet    Get*ArrayElements returns NULL (out of memory)
+ */
+jcharArray fake_char_array(int slot, const jchar *data, size_t len, bool copy, bool failGet);
+
+/**
+ * Java-visible contents of an array
+ */
+const jchar *fake_char_array_java(jcharArray array);
+
+/**
+ * Leading zero elements of the native view when it was last released
+ * (-1 if the native code never got elements)
+ */
+long fake_char_array_released_zeros(jcharArray array);
+
+/**
+ * Aborts unless every Get*ArrayElements was matched by a release
+ */
+void fake_jni_check_balanced();
+
+/**
+ * A NativeBridge.ResultCallback whose onNativeResult() calls are recorded
+ * Also installs a JavaVM, so requests submitted to the worker pool can call
+ * back from its threads
+ */
+jobject fake_result_callback();
+
+/**
+ * Waits for the result of a submitted request
+ *
+ * @return ok as passed to onNativeResult(), -1 if none came within 10 s
+ */
+int fake_wait_result(jlong handle);
+
+#endif // FUZZME_V3_FAKE_JNI_H
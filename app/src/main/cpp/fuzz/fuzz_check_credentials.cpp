@@ -0,0 +1,118 @@
+#include <jni.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "fake_jni.h"
+#include "fuzz_input.h"
+
+// ========== checkCredentials() TARGET ==========
+// Input: flags, both array lengths, the userLen/passLen arguments Java
+// passes (unrelated to the arrays, negative and oversized included), then
+// the array contents.
+// Checks: no access outside either array (guard pages / ASan), every
+// element the call was given is wiped before release, nothing past the
+// given length is touched, every Get is released, "admin"/"admin" matches.
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_checkCredentials(
+        JNIEnv *env, jclass clazz, jcharArray juser, jcharArray jpass,
+        jint userLen, jint passLen);
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_setPasswordKdfCost(
+        JNIEnv *env, jclass clazz, jint memoryKiB, jint passes);
+
+enum {
+    FLAG_USER_COPY = 1 << 0,
+    FLAG_PASS_COPY = 1 << 1,
+    FLAG_USER_FAIL = 1 << 2,
+    FLAG_PASS_FAIL = 1 << 3,
+    FLAG_USER_NULL = 1 << 4,
+    FLAG_PASS_NULL = 1 << 5,
+};
+
+// Decoded contents, reused across iterations
+static jchar g_user[FAKE_ARRAY_MAX], g_pass[FAKE_ARRAY_MAX];
+
+static void fail(const char *what) {
+    fprintf(stderr, "fuzz_check_credentials: %s\n", what);
+    abort();
+}
+
+/**
+ * Checks one array after the call: the first wipeLen elements the native
+ * side saw were zero on release, the rest of the Java array is unchanged
+ */
+static void check_array(jcharArray array, const jchar *orig, size_t len, bool copy,
+                        bool gotElements, size_t wipeLen) {
+    long zeros = fake_char_array_released_zeros(array);
+    if (gotElements && (zeros < 0 || (size_t) zeros < wipeLen)) fail("elements released unwiped");
+
+    const jchar *java = fake_char_array_java(array);
+    size_t keep = copy || !gotElements ? 0 : wipeLen;  // JNI_ABORT drops a copy's changes
+    if (memcmp(java + keep, orig + keep, (len - keep) * sizeof(jchar)) != 0) {
+        fail("array changed past the requested length");
+    }
+}
+
+static bool is_admin(const jchar *chars, size_t len, jint argLen) {
+    static const char ADMIN[] = "admin";
+    if (len != 5 || argLen != 5) return false;
+    for (size_t i = 0; i < 5; i++) {
+        if (chars[i] != (jchar) ADMIN[i]) return false;
+    }
+    return true;
+}
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv) {
+    fake_jni_init();
+    // Cheapest password hash: the target is the JNI plumbing, not the KDF
+    Java_com_example_fuzzme_1v3_NativeBridge_setPasswordKdfCost(fake_jni_env(), NULL, 1, 1);
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    FuzzInput in = {data, size, 0};
+    uint8_t flags = in.u8();
+    size_t userArrayLen = in.array_len();
+    size_t passArrayLen = in.array_len();
+    jint userLen = in.i32();
+    jint passLen = in.i32();
+    in.chars(g_user, userArrayLen);
+    in.chars(g_pass, passArrayLen);
+
+    jcharArray juser = NULL, jpass = NULL;
+    if (!(flags & FLAG_USER_NULL)) {
+        juser = fake_char_array(0, g_user, userArrayLen, flags & FLAG_USER_COPY,
+                                flags & FLAG_USER_FAIL);
+    }
+    if (!(flags & FLAG_PASS_NULL)) {
+        jpass = fake_char_array(1, g_pass, passArrayLen, flags & FLAG_PASS_COPY,
+                                flags & FLAG_PASS_FAIL);
+    }
+
+    jboolean result = Java_com_example_fuzzme_1v3_NativeBridge_checkCredentials(
+            fake_jni_env(), NULL, juser, jpass, userLen, passLen);
+    fake_jni_check_balanced();
+
+    // Elements are only fetched for two arrays and sane lengths
+    bool fetched = juser && jpass && userLen >= 0 && passLen >= 0;
+    size_t userWipe = fetched ? ((size_t) userLen < userArrayLen ? userLen : userArrayLen) : 0;
+    size_t passWipe = fetched ? ((size_t) passLen < passArrayLen ? passLen : passArrayLen) : 0;
+    if (juser) {
+        check_array(juser, g_user, userArrayLen, flags & FLAG_USER_COPY,
+                    fetched && !(flags & FLAG_USER_FAIL), userWipe);
+    }
+    if (jpass) {
+        check_array(jpass, g_pass, passArrayLen, flags & FLAG_PASS_COPY,
+                    fetched && !(flags & FLAG_PASS_FAIL), passWipe);
+    }
+
+    bool expected = fetched && !(flags & (FLAG_USER_FAIL | FLAG_PASS_FAIL)) &&
+                    is_admin(g_user, userArrayLen, userLen) &&
+                    is_admin(g_pass, passArrayLen, passLen);
+    if (expected && !result) fail("valid credentials rejected");
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <jni.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "fake_jni.h"
+#include "fuzz_input.h"
+
+// ========== decryptFlagIntoBuffer() TARGET ==========
+// Input: flags, buffer length, buffer contents.
+// Checks: no access outside the buffer, a buffer that fits receives exactly
+// the flag and keeps the rest, a short one is left untouched, every Get is
+// released.
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_decryptFlagIntoBuffer(
+        JNIEnv *env, jclass clazz, jcharArray jbuffer);
+
+enum {
+    FLAG_COPY = 1 << 0,
+    FLAG_FAIL = 1 << 1,
+    FLAG_NULL = 1 << 2,
+};
+
+static const char EXPECTED_FLAG[] = "FLAG{SSSuper_Secret_Flag}";
+static const size_t EXPECTED_LEN = sizeof(EXPECTED_FLAG) - 1;
+
+static jchar g_buffer[FAKE_ARRAY_MAX];
+
+static void fail(const char *what) {
+    fprintf(stderr, "fuzz_decrypt_flag: %s\n", what);
+    abort();
+}
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv) {
+    fake_jni_init();
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    FuzzInput in = {data, size, 0};
+    uint8_t flags = in.u8();
+    size_t len = in.array_len();
+    in.chars(g_buffer, len);
+
+    jcharArray jbuffer = NULL;
+    if (!(flags & FLAG_NULL)) {
+        jbuffer = fake_char_array(0, g_buffer, len, flags & FLAG_COPY, flags & FLAG_FAIL);
+    }
+
+    Java_com_example_fuzzme_1v3_NativeBridge_decryptFlagIntoBuffer(fake_jni_env(), NULL, jbuffer);
+    fake_jni_check_balanced();
+    if (!jbuffer) return 0;
+
+    const jchar *java = fake_char_array_java(jbuffer);
+    size_t written = 0;
+    if (!(flags & FLAG_FAIL) && len >= EXPECTED_LEN) {
+        for (size_t i = 0; i < EXPECTED_LEN; i++) {
+            if (java[i] != (jchar) EXPECTED_FLAG[i]) fail("flag not delivered");
+        }
+        written = EXPECTED_LEN;
+    }
+    if (memcmp(java + written, g_buffer + written, (len - written) * sizeof(jchar)) != 0) {
+        fail("buffer changed past the flag");
+    }
+    return 0;
+}
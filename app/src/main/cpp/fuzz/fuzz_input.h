@@ -0,0 +1,48 @@
+#ifndef FUZZME_V3_FUZZ_INPUT_H
+#define FUZZME_V3_FUZZ_INPUT_H
+
+#include <jni.h>
+#include <cstddef>
+#include <cstdint>
+
+#include "fake_jni.h"
+
+// ========== FUZZ INPUT DECODING ==========
+// Targets read a few fixed header fields, then array contents. Reads past the
+// end of the input yield zeros, so every input decodes to something.
+
+struct FuzzInput {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+
+    uint8_t u8() {
+        return pos < size ? data[pos++] : 0;
+    }
+
+    uint16_t u16() {
+        uint16_t lo = u8();
+        return (uint16_t) (lo | (uint16_t) u8() << 8);
+    }
+
+    int32_t i32() {
+        uint32_t v = u16();
+        return (int32_t) (v | (uint32_t) u16() << 16);
+    }
+
+    /**
+     * Array length in jchars, 0 .. FAKE_ARRAY_MAX
+     */
+    size_t array_len() {
+        return u16() % (FAKE_ARRAY_MAX + 1);
+    }
+
+    /**
+     * Decodes up to len little-endian jchars into out, zero-filling the rest
+     */
+    void chars(jchar *out, size_t len) {
+        for (size_t i = 0; i < len; i++) out[i] = u16();
+    }
+};
+
+#endif // FUZZME_V3_FUZZ_INPUT_H
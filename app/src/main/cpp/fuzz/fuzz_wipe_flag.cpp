@@ -0,0 +1,59 @@
+#include <jni.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "fake_jni.h"
+#include "fuzz_input.h"
+
+// ========== wipeFlagBuffer() TARGET ==========
+// Input: flags, buffer length, buffer contents.
+// Checks: no access outside the buffer, the whole native view is zero when
+// released, a copy's zeros never reach Java (JNI_ABORT), every Get is
+// released.
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_wipeFlagBuffer(
+        JNIEnv *env, jclass clazz, jcharArray jbuffer);
+
+enum {
+    FLAG_COPY = 1 << 0,
+    FLAG_FAIL = 1 << 1,
+    FLAG_NULL = 1 << 2,
+};
+
+static jchar g_buffer[FAKE_ARRAY_MAX];
+
+static void fail(const char *what) {
+    fprintf(stderr, "fuzz_wipe_flag: %s\n", what);
+    abort();
+}
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv) {
+    fake_jni_init();
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    FuzzInput in = {data, size, 0};
+    uint8_t flags = in.u8();
+    size_t len = in.array_len();
+    in.chars(g_buffer, len);
+
+    jcharArray jbuffer = NULL;
+    if (!(flags & FLAG_NULL)) {
+        jbuffer = fake_char_array(0, g_buffer, len, flags & FLAG_COPY, flags & FLAG_FAIL);
+    }
+
+    Java_com_example_fuzzme_1v3_NativeBridge_wipeFlagBuffer(fake_jni_env(), NULL, jbuffer);
+    fake_jni_check_balanced();
+    if (!jbuffer || (flags & FLAG_FAIL)) return 0;
+
+    if (fake_char_array_released_zeros(jbuffer) != (long) len) fail("buffer released unwiped");
+    const jchar *java = fake_char_array_java(jbuffer);
+    if ((flags & FLAG_COPY) && memcmp(java, g_buffer, len * sizeof(jchar)) != 0) {
+        fail("copy written back to Java");
+    }
+    return 0;
+}
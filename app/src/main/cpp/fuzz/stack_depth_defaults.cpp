@@ -0,0 +1,19 @@
+#include "stack_scrub.h"
+
+// The fuzz build skips the stack_depth.cmake measurement step (sanitizers
+// inflate frames anyway); scrub the default depth instead
+const size_t STACK_DEPTH_CHECK_CREDENTIALS_IMPL = STACK_SCRUB_DEFAULT;
+const size_t STACK_DEPTH_DECRYPT_FLAG_IMPL = STACK_SCRUB_DEFAULT;
+const size_t STACK_DEPTH_VERIFY_CREDENTIALS_IMPL = STACK_SCRUB_DEFAULT;
+const size_t STACK_DEPTH_VERIFY_STREAMED_CREDENTIALS_IMPL = STACK_SCRUB_DEFAULT;
+const size_t STACK_DEPTH_APPLY_KEYSTROKE_EDIT = STACK_SCRUB_DEFAULT;
+const size_t STACK_DEPTH_PREPARE_STREAMED_CHECK_IMPL = STACK_SCRUB_DEFAULT;
+const size_t STACK_DEPTH_SPECULATE_KEYSTROKES_IMPL = STACK_SCRUB_DEFAULT;
+const size_t STACK_DEPTH_HASH_PASSWORD_IMPL = STACK_SCRUB_DEFAULT;
+const size_t STACK_DEPTH_PASSWORD_BREACHED_IMPL = STACK_SCRUB_DEFAULT;
+const size_t STACK_DEPTH_KEYSTROKES_BREACHED_IMPL = STACK_SCRUB_DEFAULT;
+const size_t STACK_DEPTH_PASSWORD_STRENGTH_IMPL = STACK_SCRUB_DEFAULT;
+const size_t STACK_DEPTH_KEYSTROKES_STRENGTH_IMPL = STACK_SCRUB_DEFAULT;
+const size_t STACK_DEPTH_PROVISION_OTP_IMPL = STACK_SCRUB_DEFAULT;
+const size_t STACK_DEPTH_VERIFY_OTP_IMPL = STACK_SCRUB_DEFAULT;
+const size_t STACK_DEPTH_VERIFY_KEYSTROKES_OTP_IMPL = STACK_SCRUB_DEFAULT;
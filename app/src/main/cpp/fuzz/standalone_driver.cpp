@@ -0,0 +1,73 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+// ========== STANDALONE DRIVER ==========
+// Stands in for libFuzzer where the compiler has no -fsanitize=fuzzer (gcc):
+//   target FILE...      runs each file once (reproduce a crash, replay a corpus)
+//   target -runs=N      runs N random inputs and reports execs/sec
+// No coverage feedback, so it only finds shallow bugs; use libFuzzer for real runs.
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv);
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static const size_t MAX_INPUT = 16 * 1024;
+static uint8_t g_input[MAX_INPUT];
+
+static uint64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int run_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    size_t size = fread(g_input, 1, MAX_INPUT, f);
+    fclose(f);
+    LLVMFuzzerTestOneInput(g_input, size);
+    return 0;
+}
+
+/**
+ * Random inputs; short ones are favoured since the targets read headers first
+ */
+static void run_random(uint64_t runs, uint64_t seed) {
+    uint64_t x = seed | 1;
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < runs; i++) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        size_t size = (x >> 32) % ((x & 7) == 0 ? MAX_INPUT : 64);
+        for (size_t j = 0; j < size; j++) {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            g_input[j] = (uint8_t) x;
+        }
+        LLVMFuzzerTestOneInput(g_input, size);
+    }
+    double secs = (now_ns() - start) / 1e9;
+    printf("%llu runs in %.2f s, %.0f exec/s\n", (unsigned long long) runs, secs, runs / secs);
+}
+
+int main(int argc, char **argv) {
+    LLVMFuzzerInitialize(&argc, &argv);
+
+    uint64_t runs = 0, seed = (uint64_t) now_ns();
+    int files = 0, rc = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-runs=", 6) == 0) {
+            runs = strtoull(argv[i] + 6, NULL, 10);
+        } else if (strncmp(argv[i], "-seed=", 6) == 0) {
+            seed = strtoull(argv[i] + 6, NULL, 10);
+        } else if (argv[i][0] != '-') {
+            rc |= run_file(argv[i]);
+            files++;
+        }
+    }
+    if (!files) run_random(runs ? runs : 100000, seed);
+    return rc;
+}
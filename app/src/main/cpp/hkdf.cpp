@@ -0,0 +1,61 @@
+#include "hkdf.h"
+
+#include <cstring>
+
+#include "secure_util.h"
+
+bool hkdf_extract(HmacKey *prk, HmacHash hash, const void *salt, size_t saltLen,
+                  const void *ikm, size_t ikmLen) {
+    size_t outBytes = hmac_out_bytes(hash);
+    if (!outBytes || (ikmLen && !ikm)) return false;
+
+    const unsigned char zeros[HMAC_MAX_OUT_BYTES] = {};
+    HmacKey saltKey;
+    if (!hmac_key_init(&saltKey, hash, saltLen ? salt : zeros, saltLen ? saltLen : outBytes)) {
+        return false;
+    }
+
+    unsigned char prkBytes[HMAC_MAX_OUT_BYTES];
+    hmac(&saltKey, ikm, ikmLen, prkBytes);
+    bool ok = hmac_key_init(prk, hash, prkBytes, outBytes);
+
+    // A salt may be secret too
+    secure_wipe_vectorized(&saltKey, sizeof(saltKey));
+    secure_wipe_vectorized(prkBytes, sizeof(prkBytes));
+    return ok;
+}
+
+bool hkdf_expand(const HmacKey *prk, const void *info, size_t infoLen, unsigned char *out,
+                 size_t outLen) {
+    size_t outBytes = hmac_out_bytes(prk->hash);
+    if (!outBytes || outLen > HKDF_MAX_BLOCKS * outBytes || (infoLen && !info)) return false;
+
+    unsigned char t[HMAC_MAX_OUT_BYTES];
+    size_t tLen = 0;
+    HmacState state;
+    for (unsigned char i = 1; outLen > 0; i++) {
+        hmac_init(&state, prk);
+        hmac_update(&state, t, tLen);
+        hmac_update(&state, info, infoLen);
+        hmac_update(&state, &i, 1);
+        hmac_final(&state, t);
+        tLen = outBytes;
+
+        size_t n = outLen < outBytes ? outLen : outBytes;
+        memcpy(out, t, n);
+        out += n;
+        outLen -= n;
+    }
+
+    secure_wipe_vectorized(t, sizeof(t));
+    return true;
+}
+
+bool hkdf(HmacHash hash, const void *salt, size_t saltLen, const void *ikm, size_t ikmLen,
+          const void *info, size_t infoLen, unsigned char *out, size_t outLen) {
+    HmacKey prk;
+    bool ok = hkdf_extract(&prk, hash, salt, saltLen, ikm, ikmLen) &&
+              hkdf_expand(&prk, info, infoLen, out, outLen);
+    secure_wipe_vectorized(&prk, sizeof(prk));
+    return ok;
+}
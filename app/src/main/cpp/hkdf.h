@@ -0,0 +1,42 @@
+#ifndef FUZZME_V3_HKDF_H
+#define FUZZME_V3_HKDF_H
+
+#include <cstddef>
+
+#include "hmac.h"
+
+// ========== HKDF ==========
+// HKDF (RFC 5869) on HMAC-SHA-1 or HMAC-SHA-256: extract concentrates input
+// keying material into a pseudorandom key (PRK), expand stretches the PRK
+// into as many bytes as needed, bound to an info string, so one secret can
+// feed a hierarchy of independent keys. The PRK is kept as a prepared
+// HmacKey: like one, it is a secret and belongs in locked memory.
+
+// Longest expand output, in hash lengths
+static const size_t HKDF_MAX_BLOCKS = 255;
+
+/**
+ * HKDF-Extract: PRK = HMAC(salt, ikm)
+ *
+ * @param salt NULL / 0 for none (a hash length of zeros, per the RFC)
+ * @return false on an unknown hash
+ */
+bool hkdf_extract(HmacKey *prk, HmacHash hash, const void *salt, size_t saltLen,
+                  const void *ikm, size_t ikmLen);
+
+/**
+ * HKDF-Expand: the first outLen bytes of T(1) | T(2) | ..., where
+ * T(i) = HMAC(PRK, T(i - 1) | info | i)
+ *
+ * @return false if outLen is over HKDF_MAX_BLOCKS hash lengths
+ */
+bool hkdf_expand(const HmacKey *prk, const void *info, size_t infoLen, unsigned char *out,
+                 size_t outLen);
+
+/**
+ * Extract then expand; the PRK never leaves the stack and is wiped
+ */
+bool hkdf(HmacHash hash, const void *salt, size_t saltLen, const void *ikm, size_t ikmLen,
+          const void *info, size_t infoLen, unsigned char *out, size_t outLen);
+
+#endif // FUZZME_V3_HKDF_H
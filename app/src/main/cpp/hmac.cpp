@@ -0,0 +1,252 @@
+#include "hmac.h"
+
+#include <cstring>
+
+#include "secure_util.h"
+
+// Both hashes share the block size and the big-endian length field
+static const size_t HMAC_BLOCK_BYTES = 64;
+
+typedef void (*HmacBlocksFn)(uint32_t *h, const unsigned char *blocks, size_t count);
+
+/**
+ * What HMAC needs of a hash
+ */
+struct HmacHashInfo {
+    size_t outBytes;
+    size_t words;           // Chain value words
+    HmacBlocksFn blocks;
+};
+
+static const HmacHashInfo HMAC_HASHES[HMAC_HASH_COUNT] = {
+    {SHA1_OUT_BYTES, 5, sha1_blocks},
+    {SHA256_OUT_BYTES, 8, sha256_blocks},
+};
+
+static inline void store32_be(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char) (v >> 24);
+    p[1] = (unsigned char) (v >> 16);
+    p[2] = (unsigned char) (v >> 8);
+    p[3] = (unsigned char) v;
+}
+
+/**
+ * Writes the message length in bits to the end of a final block
+ * @param totalLen Bytes hashed in all, earlier blocks included
+ */
+static void put_length(unsigned char *block, uint64_t totalLen) {
+    uint64_t bits = totalLen * 8;
+    store32_be(block + HMAC_BLOCK_BYTES - 8, (uint32_t) (bits >> 32));
+    store32_be(block + HMAC_BLOCK_BYTES - 4, (uint32_t) bits);
+}
+
+/**
+ * Pads a final block that holds len message bytes (at most 55)
+ */
+static void pad_block(unsigned char *block, size_t len, uint64_t totalLen) {
+    block[len] = 0x80;
+    memset(block + len + 1, 0, HMAC_BLOCK_BYTES - 8 - len - 1);
+    put_length(block, totalLen);
+}
+
+size_t hmac_out_bytes(HmacHash hash) {
+    return hash < HMAC_HASH_COUNT ? HMAC_HASHES[hash].outBytes : 0;
+}
+
+bool hmac_key_init(HmacKey *key, HmacHash hash, const void *secret, size_t len) {
+    if (hash >= HMAC_HASH_COUNT || (len && !secret)) return false;
+    const HmacHashInfo *info = &HMAC_HASHES[hash];
+
+    // Keys longer than a block are replaced by their digest
+    unsigned char block[HMAC_BLOCK_BYTES];
+    memset(block, 0, sizeof(block));
+    if (len > HMAC_BLOCK_BYTES) {
+        if (hash == HMAC_SHA1) {
+            sha1(block, secret, len);
+        } else {
+            sha256(block, secret, len);
+        }
+    } else if (len) {
+        memcpy(block, secret, len);
+    }
+
+    memset(key, 0, sizeof(*key));
+    key->hash = hash;
+    Sha1State sha1State;
+    Sha256State sha256State;
+    uint32_t *iv;
+    if (hash == HMAC_SHA1) {
+        sha1_init(&sha1State);
+        iv = sha1State.h;
+    } else {
+        sha256_init(&sha256State);
+        iv = sha256State.h;
+    }
+    memcpy(key->inner, iv, info->words * sizeof(uint32_t));
+    memcpy(key->outer, iv, info->words * sizeof(uint32_t));
+
+    for (size_t i = 0; i < HMAC_BLOCK_BYTES; i++) block[i] ^= 0x36;
+    info->blocks(key->inner, block, 1);
+    for (size_t i = 0; i < HMAC_BLOCK_BYTES; i++) block[i] ^= 0x36 ^ 0x5C;
+    info->blocks(key->outer, block, 1);
+
+    secure_wipe_vectorized(block, sizeof(block));
+    return true;
+}
+
+/**
+ * Finishes a MAC: the outer hash of the inner one
+ *
+ * @param chain      Inner hash's chain value, overwritten
+ * @param outerBlock Padded for a digest (see pad_block()); the digest is
+ *                   written into it
+ */
+static void hmac_outer(const HmacKey *key, const HmacHashInfo *info, uint32_t *chain,
+                       unsigned char *outerBlock, unsigned char *out) {
+    for (size_t i = 0; i < info->words; i++) store32_be(outerBlock + 4 * i, chain[i]);
+    memcpy(chain, key->outer, info->words * sizeof(uint32_t));
+    info->blocks(chain, outerBlock, 1);
+    for (size_t i = 0; i < info->words; i++) store32_be(out + 4 * i, chain[i]);
+}
+
+void hmac(const HmacKey *key, const void *msg, size_t len, unsigned char *out) {
+    const HmacHashInfo *info = &HMAC_HASHES[key->hash];
+    const unsigned char *p = (const unsigned char *) msg;
+    uint64_t total = HMAC_BLOCK_BYTES + (uint64_t) len;
+
+    // Inner hash: whole blocks straight from the message, then the padded tail
+    uint32_t chain[8];
+    unsigned char block[HMAC_BLOCK_BYTES];
+    memcpy(chain, key->inner, info->words * sizeof(uint32_t));
+    size_t whole = len / HMAC_BLOCK_BYTES;
+    if (whole) info->blocks(chain, p, whole);
+    size_t tail = len - whole * HMAC_BLOCK_BYTES;
+    memcpy(block, p + whole * HMAC_BLOCK_BYTES, tail);
+    if (tail > HMAC_SHORT_MAX_BYTES) {
+        // No room left for the length: it takes a block of its own
+        block[tail] = 0x80;
+        memset(block + tail + 1, 0, HMAC_BLOCK_BYTES - tail - 1);
+        info->blocks(chain, block, 1);
+        memset(block, 0, HMAC_BLOCK_BYTES);
+        put_length(block, total);
+    } else {
+        pad_block(block, tail, total);
+    }
+    info->blocks(chain, block, 1);
+
+    pad_block(block, info->outBytes, HMAC_BLOCK_BYTES + info->outBytes);
+    hmac_outer(key, info, chain, block, out);
+
+    secure_wipe_vectorized(chain, sizeof(chain));
+    secure_wipe_vectorized(block, sizeof(block));
+}
+
+void hmac_init(HmacState *state, const HmacKey *key) {
+    state->key = key;
+    const HmacHashInfo *info = &HMAC_HASHES[key->hash];
+    uint32_t *h;
+    if (key->hash == HMAC_SHA1) {
+        sha1_init(&state->sha1);
+        state->sha1.length = HMAC_BLOCK_BYTES;
+        h = state->sha1.h;
+    } else {
+        sha256_init(&state->sha256);
+        state->sha256.length = HMAC_BLOCK_BYTES;
+        h = state->sha256.h;
+    }
+    // As if the padded key block had been absorbed
+    memcpy(h, key->inner, info->words * sizeof(uint32_t));
+}
+
+void hmac_update(HmacState *state, const void *msg, size_t len) {
+    if (state->key->hash == HMAC_SHA1) {
+        sha1_update(&state->sha1, msg, len);
+    } else {
+        sha256_update(&state->sha256, msg, len);
+    }
+}
+
+void hmac_final(HmacState *state, unsigned char *out) {
+    const HmacKey *key = state->key;
+    const HmacHashInfo *info = &HMAC_HASHES[key->hash];
+    uint32_t chain[8];
+    unsigned char block[HMAC_BLOCK_BYTES];
+
+    // The inner digest, padded as the outer hash's only block
+    pad_block(block, info->outBytes, HMAC_BLOCK_BYTES + info->outBytes);
+    if (key->hash == HMAC_SHA1) {
+        sha1_final(&state->sha1, block);
+    } else {
+        sha256_final(&state->sha256, block);
+    }
+    memcpy(chain, key->outer, info->words * sizeof(uint32_t));
+    info->blocks(chain, block, 1);
+    for (size_t i = 0; i < info->words; i++) store32_be(out + 4 * i, chain[i]);
+
+    secure_wipe_vectorized(chain, sizeof(chain));
+    secure_wipe_vectorized(block, sizeof(block));
+    state->key = NULL;
+}
+
+/**
+ * hmac_short_batch() for SHA-256 keys: both compressions of up to
+ * SHA256_LANES messages at once
+ */
+static void short_batch_multi(const HmacKey *key, const unsigned char *msgs, size_t len,
+                              size_t count, unsigned char *out) {
+    uint32_t chain[SHA256_LANES][8];
+    unsigned char blocks[SHA256_LANES][HMAC_BLOCK_BYTES];
+    const unsigned char *lanePtrs[SHA256_LANES];
+    for (size_t l = 0; l < SHA256_LANES; l++) lanePtrs[l] = blocks[l];
+
+    for (size_t first = 0; first < count; first += SHA256_LANES) {
+        size_t lanes = count - first < SHA256_LANES ? count - first : SHA256_LANES;
+        for (size_t l = 0; l < lanes; l++) {
+            pad_block(blocks[l], len, HMAC_BLOCK_BYTES + len);
+            memcpy(blocks[l], msgs + (first + l) * len, len);
+            memcpy(chain[l], key->inner, sizeof(chain[l]));
+        }
+        sha256_blocks_multi(chain, lanePtrs, lanes, 1);
+
+        for (size_t l = 0; l < lanes; l++) {
+            pad_block(blocks[l], SHA256_OUT_BYTES, HMAC_BLOCK_BYTES + SHA256_OUT_BYTES);
+            for (size_t i = 0; i < 8; i++) store32_be(blocks[l] + 4 * i, chain[l][i]);
+            memcpy(chain[l], key->outer, sizeof(chain[l]));
+        }
+        sha256_blocks_multi(chain, lanePtrs, lanes, 1);
+
+        for (size_t l = 0; l < lanes; l++) {
+            unsigned char *mac = out + (first + l) * SHA256_OUT_BYTES;
+            for (size_t i = 0; i < 8; i++) store32_be(mac + 4 * i, chain[l][i]);
+        }
+    }
+
+    secure_wipe_vectorized(chain, sizeof(chain));
+    secure_wipe_vectorized(blocks, sizeof(blocks));
+}
+
+void hmac_short_batch(const HmacKey *key, const unsigned char *msgs, size_t len, size_t count,
+                      unsigned char *out) {
+    if (key->hash == HMAC_SHA256) {
+        short_batch_multi(key, msgs, len, count, out);
+        return;
+    }
+
+    const HmacHashInfo *info = &HMAC_HASHES[key->hash];
+    uint32_t chain[8];
+    unsigned char inner[HMAC_BLOCK_BYTES], outer[HMAC_BLOCK_BYTES];
+
+    // Padding is the same for every message: only the bytes before it change
+    pad_block(inner, len, HMAC_BLOCK_BYTES + len);
+    pad_block(outer, info->outBytes, HMAC_BLOCK_BYTES + info->outBytes);
+    for (size_t m = 0; m < count; m++) {
+        memcpy(inner, msgs + m * len, len);
+        memcpy(chain, key->inner, info->words * sizeof(uint32_t));
+        info->blocks(chain, inner, 1);
+        hmac_outer(key, info, chain, outer, out + m * info->outBytes);
+    }
+
+    secure_wipe_vectorized(chain, sizeof(chain));
+    secure_wipe_vectorized(inner, sizeof(inner));
+    secure_wipe_vectorized(outer, sizeof(outer));
+}
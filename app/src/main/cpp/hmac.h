@@ -0,0 +1,93 @@
+#ifndef FUZZME_V3_HMAC_H
+#define FUZZME_V3_HMAC_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "sha1.h"
+#include "sha256.h"
+
+// ========== HMAC ==========
+// HMAC (RFC 2104) over SHA-1 or SHA-256. A key is prepared once and kept as
+// the chain values after its two padded key blocks, so every MAC skips two
+// compressions and the key bytes themselves need not be kept. Those chain
+// values MAC as well as the key does: an HmacKey is a secret and belongs in
+// locked memory.
+
+enum HmacHash {
+    HMAC_SHA1 = 0,
+    HMAC_SHA256,
+    HMAC_HASH_COUNT
+};
+
+static const size_t HMAC_MAX_OUT_BYTES = 32;
+
+// Longest message hmac_short_batch() takes: one block with its padding
+static const size_t HMAC_SHORT_MAX_BYTES = 55;
+
+struct HmacKey {
+    HmacHash hash;
+    uint32_t inner[8];      // Chain value after key ^ ipad
+    uint32_t outer[8];      // Chain value after key ^ opad
+};
+
+/**
+ * A MAC in progress, for messages that come in pieces (see hkdf.cpp)
+ * Buffers message bytes, so it is wiped by hmac_final()
+ */
+struct HmacState {
+    const HmacKey *key;
+    union {
+        Sha1State sha1;
+        Sha256State sha256;
+    };                      // Inner hash, by key->hash
+};
+
+/**
+ * Digest (and MAC) length of a hash
+ */
+size_t hmac_out_bytes(HmacHash hash);
+
+/**
+ * Prepares a key
+ *
+ * @param secret Key bytes (hashed first if longer than a block); the
+ *               caller still owns and wipes them
+ * @return false on an unknown hash
+ */
+bool hmac_key_init(HmacKey *key, HmacHash hash, const void *secret, size_t len);
+
+/**
+ * MACs one message
+ * @param out hmac_out_bytes(key->hash) bytes
+ */
+void hmac(const HmacKey *key, const void *msg, size_t len, unsigned char *out);
+
+/**
+ * Starts a MAC; the key must outlive the state
+ */
+void hmac_init(HmacState *state, const HmacKey *key);
+
+/**
+ * Absorbs more message; any split gives the same MAC
+ */
+void hmac_update(HmacState *state, const void *msg, size_t len);
+
+/**
+ * Writes the MAC (hmac_out_bytes(key->hash) bytes) and wipes the state
+ */
+void hmac_final(HmacState *state, unsigned char *out);
+
+/**
+ * MACs count messages of the same short length in one pass
+ * Each takes exactly two compressions (no buffering, no length checks per
+ * message), SHA-256 ones SHA256_LANES at a time (see sha256_blocks_multi()):
+ * the fast path for HOTP windows
+ *
+ * @param msgs count messages of len (<= HMAC_SHORT_MAX_BYTES) bytes, back to back
+ * @param out  count MACs of hmac_out_bytes(key->hash) bytes, back to back
+ */
+void hmac_short_batch(const HmacKey *key, const unsigned char *msgs, size_t len, size_t count,
+                      unsigned char *out);
+
+#endif // FUZZME_V3_HMAC_H
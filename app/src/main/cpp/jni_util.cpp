@@ -0,0 +1,38 @@
+#include "jni_util.h"
+
+#include <atomic>
+#include <cstddef>
+
+#include "secure_util.h"
+
+static std::atomic<JavaVM *> g_vm{nullptr};
+
+void jni_set_vm(JavaVM *vm) {
+    g_vm.store(vm, std::memory_order_release);
+}
+
+JavaVM *jni_vm() {
+    return g_vm.load(std::memory_order_acquire);
+}
+
+JNIEnv *jni_attach_current_thread() {
+    JavaVM *vm = jni_vm();
+    if (!vm) return NULL;
+
+    JNIEnv *env = NULL;
+    jint rc = vm->GetEnv((void **) &env, JNI_VERSION_1_6);
+    if (rc == JNI_OK) return env;
+    if (rc != JNI_EDETACHED) return NULL;
+
+    if (vm->AttachCurrentThread(&env, NULL) != JNI_OK) return NULL;
+    return env;
+}
+
+void jni_wipe_char_array(JNIEnv *env, jcharArray array) {
+    jsize length = env->GetArrayLength(array);
+    void *chars = env->GetPrimitiveArrayCritical(array, NULL);
+    if (!chars) return;
+    secure_memzero(chars, (size_t) length * sizeof(jchar));
+    // Mode 0: if the VM handed us a copy, the zeros must reach the real array
+    env->ReleasePrimitiveArrayCritical(array, chars, 0);
+}
@@ -0,0 +1,32 @@
+#ifndef FUZZME_V3_JNI_UTIL_H
+#define FUZZME_V3_JNI_UTIL_H
+
+#include <jni.h>
+
+// ========== JNI HELPERS ==========
+
+/**
+ * Caches the JavaVM (called once from JNI_OnLoad)
+ */
+void jni_set_vm(JavaVM *vm);
+
+/**
+ * Returns the cached JavaVM, or NULL before JNI_OnLoad ran
+ */
+JavaVM *jni_vm();
+
+/**
+ * Returns a JNIEnv for the calling thread, attaching it to the VM if needed
+ * Native threads stay attached for their lifetime
+ *
+ * @return JNIEnv, or NULL if the VM is unknown or attaching failed
+ */
+JNIEnv *jni_attach_current_thread();
+
+/**
+ * Zeroes a Java char[] in place (through a copy if the VM hands one out)
+ * Usable from any attached thread
+ */
+void jni_wipe_char_array(JNIEnv *env, jcharArray array);
+
+#endif // FUZZME_V3_JNI_UTIL_H
@@ -0,0 +1,211 @@
+#include "kdf_speculation.h"
+
+#include <cstring>
+#include <pthread.h>
+
+#include "lock_budget.h"
+#include "secure_util.h"
+
+enum SpeculationState : uint8_t {
+    SPEC_IDLE = 0,
+    SPEC_QUEUED,
+    SPEC_RUNNING,
+    SPEC_DONE
+};
+
+struct Speculation {
+    SpeculationState state;
+    uint64_t stream;            // 0 once adopted (edits no longer matter)
+    uint32_t version;
+    uint64_t ticket;            // Bumped on every start so stale tickets miss
+    bool adopted;
+    bool ok;
+    std::atomic<bool> cancelled;
+    SpeculationHashFn hash;
+    LockedRegion input;         // Normalized password snapshot
+    size_t inputLen;
+    LockedRegion result;        // KDF_OUT_BYTES, written by the thread while RUNNING
+};
+
+// ========== SLOT STATE (guarded by g_lock) ==========
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_work = PTHREAD_COND_INITIALIZER;   // Thread sleeps on this
+static pthread_cond_t g_done = PTHREAD_COND_INITIALIZER;   // Collect and restart wait here
+static pthread_once_t g_startOnce = PTHREAD_ONCE_INIT;
+static bool g_started = false;
+
+static Speculation g_spec;
+
+// Stream being speculated on (0 = none), read without the lock on every edit
+static std::atomic<uint64_t> g_watched{0};
+
+/**
+ * Cancels the current speculation and frees what it holds (g_lock held)
+ * A running hash only gets flagged; the thread wipes it when it notices
+ */
+static void discard_locked() {
+    g_watched.store(0, std::memory_order_relaxed);
+    g_spec.stream = 0;
+    switch (g_spec.state) {
+        case SPEC_QUEUED:
+            locked_free(&g_spec.input);
+            g_spec.state = SPEC_IDLE;
+            break;
+        case SPEC_RUNNING:
+            g_spec.cancelled.store(true, std::memory_order_relaxed);
+            break;
+        case SPEC_DONE:
+            secure_memzero(g_spec.result.ptr, KDF_OUT_BYTES);
+            g_spec.state = SPEC_IDLE;
+            break;
+        case SPEC_IDLE:
+            break;
+    }
+    if (g_spec.state == SPEC_IDLE) g_spec.adopted = false;
+}
+
+static void *speculation_main(void *) {
+    pthread_mutex_lock(&g_lock);
+    for (;;) {
+        while (g_spec.state != SPEC_QUEUED) pthread_cond_wait(&g_work, &g_lock);
+        g_spec.state = SPEC_RUNNING;
+        SpeculationHashFn hash = g_spec.hash;
+        const unsigned char *input = (const unsigned char *) g_spec.input.ptr;
+        size_t inputLen = g_spec.inputLen;
+        unsigned char *result = (unsigned char *) g_spec.result.ptr;
+        pthread_mutex_unlock(&g_lock);
+
+        bool ok = hash(input, inputLen, &g_spec.cancelled, result);
+
+        pthread_mutex_lock(&g_lock);
+        locked_free(&g_spec.input);
+        if (g_spec.cancelled.load(std::memory_order_relaxed) || !ok) {
+            secure_memzero(result, KDF_OUT_BYTES);
+        }
+        if (g_spec.cancelled.load(std::memory_order_relaxed)) {
+            g_spec.state = SPEC_IDLE;
+            g_spec.adopted = false;
+        } else {
+            g_spec.ok = ok;
+            g_spec.state = SPEC_DONE;
+        }
+        pthread_cond_broadcast(&g_done);
+    }
+    return nullptr;
+}
+
+static void start_thread() {
+    if (!locked_alloc(&g_spec.result, KDF_OUT_BYTES, LOCK_PRIO_CRITICAL)) return;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, speculation_main, NULL) == 0) {
+        pthread_detach(thread);
+        g_started = true;
+    }
+}
+
+// ========== PUBLIC API ==========
+
+bool speculation_start(uint64_t stream, uint32_t version, const unsigned char *utf8,
+                       size_t len, SpeculationHashFn hash) {
+    pthread_once(&g_startOnce, start_thread);
+    if (!g_started || !stream || !hash) return false;
+
+    pthread_mutex_lock(&g_lock);
+    // A check is waiting for the slot's hash: leave it alone
+    if (g_spec.state != SPEC_IDLE && g_spec.adopted) {
+        pthread_mutex_unlock(&g_lock);
+        return false;
+    }
+    // Already hashing exactly this text
+    if (g_spec.state != SPEC_IDLE && g_spec.stream == stream && g_spec.version == version &&
+        g_spec.hash == hash && !g_spec.cancelled.load(std::memory_order_relaxed)) {
+        pthread_mutex_unlock(&g_lock);
+        return true;
+    }
+
+    discard_locked();
+    // A cancelled hash stops within KDF_CANCEL_STRIDE blocks
+    while (g_spec.state == SPEC_RUNNING) pthread_cond_wait(&g_done, &g_lock);
+
+    if (!locked_alloc(&g_spec.input, len ? len : 1, LOCK_PRIO_CRITICAL)) {
+        pthread_mutex_unlock(&g_lock);
+        return false;
+    }
+    if (len) memcpy(g_spec.input.ptr, utf8, len);
+    g_spec.inputLen = len;
+    g_spec.stream = stream;
+    g_spec.version = version;
+    g_spec.hash = hash;
+    g_spec.ticket++;
+    g_spec.adopted = false;
+    g_spec.ok = false;
+    g_spec.cancelled.store(false, std::memory_order_relaxed);
+    g_spec.state = SPEC_QUEUED;
+    g_watched.store(stream, std::memory_order_relaxed);
+    pthread_cond_signal(&g_work);
+    pthread_mutex_unlock(&g_lock);
+    return true;
+}
+
+void speculation_invalidate(uint64_t stream) {
+    if (!stream || g_watched.load(std::memory_order_relaxed) != stream) return;
+
+    pthread_mutex_lock(&g_lock);
+    if (!g_spec.adopted && g_spec.stream == stream) discard_locked();
+    pthread_mutex_unlock(&g_lock);
+}
+
+uint64_t speculation_adopt(uint64_t stream, uint32_t version) {
+    if (!g_started || !stream) return 0;
+
+    pthread_mutex_lock(&g_lock);
+    uint64_t ticket = 0;
+    if (g_spec.state != SPEC_IDLE && !g_spec.adopted && g_spec.stream == stream &&
+        g_spec.version == version && !g_spec.cancelled.load(std::memory_order_relaxed) &&
+        (g_spec.state != SPEC_DONE || g_spec.ok)) {
+        g_spec.adopted = true;
+        g_spec.stream = 0;
+        g_watched.store(0, std::memory_order_relaxed);
+        ticket = g_spec.ticket;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return ticket;
+}
+
+bool speculation_collect(uint64_t ticket, unsigned char *out) {
+    if (!ticket) return false;
+
+    pthread_mutex_lock(&g_lock);
+    while (g_spec.ticket == ticket && g_spec.adopted &&
+           (g_spec.state == SPEC_QUEUED || g_spec.state == SPEC_RUNNING)) {
+        pthread_cond_wait(&g_done, &g_lock);
+    }
+    bool ok = false;
+    if (g_spec.ticket == ticket && g_spec.adopted && g_spec.state == SPEC_DONE) {
+        ok = g_spec.ok;
+        if (ok) memcpy(out, g_spec.result.ptr, KDF_OUT_BYTES);
+        discard_locked();
+    }
+    pthread_mutex_unlock(&g_lock);
+    return ok;
+}
+
+void speculation_drop(uint64_t ticket) {
+    if (!ticket) return;
+
+    pthread_mutex_lock(&g_lock);
+    if (g_spec.ticket == ticket && g_spec.adopted) discard_locked();
+    pthread_mutex_unlock(&g_lock);
+}
+
+void speculation_cancel_all() {
+    if (!g_started) return;
+
+    pthread_mutex_lock(&g_lock);
+    discard_locked();
+    // A cancelled hash stops within KDF_CANCEL_STRIDE blocks
+    while (g_spec.state == SPEC_RUNNING) pthread_cond_wait(&g_done, &g_lock);
+    pthread_mutex_unlock(&g_lock);
+}
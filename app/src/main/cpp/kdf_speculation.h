@@ -0,0 +1,68 @@
+#ifndef FUZZME_V3_KDF_SPECULATION_H
+#define FUZZME_V3_KDF_SPECULATION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "password_kdf.h"
+
+// ========== KDF SPECULATION ==========
+// Starts the password KDF while the user is still at the form (focus left
+// the field, or typing paused) so that Login only has to collect the hash.
+// One speculation runs at a time on a background thread, on a snapshot of a
+// keystroke stream (see keystroke_stream.h) taken at a known edit version.
+// Any later edit cancels and wipes it; a check adopts it only if the version
+// still matches, otherwise it hashes from scratch.
+
+/**
+ * Hashes a normalized password (KDF_OUT_BYTES out)
+ * Polls cancelled; returns false when cancelled or on failure
+ */
+typedef bool (*SpeculationHashFn)(const unsigned char *utf8, size_t len,
+                                  const std::atomic<bool> *cancelled, unsigned char *out);
+
+/**
+ * Queues a speculative hash of a stream's text (producer thread)
+ * Replaces a speculation of any other text; the bytes are copied into
+ * locked memory, the caller wipes its copy
+ *
+ * @return false if nothing was queued (no memory, or a check owns the slot)
+ */
+bool speculation_start(uint64_t stream, uint32_t version, const unsigned char *utf8,
+                       size_t len, SpeculationHashFn hash);
+
+/**
+ * Cancels and wipes a speculation of this stream (call on every edit)
+ * Cheap when the stream is not being speculated on
+ */
+void speculation_invalidate(uint64_t stream);
+
+/**
+ * Hands a matching speculation over to a check; later edits of the stream
+ * no longer affect it
+ *
+ * @return Ticket for speculation_collect() / speculation_drop(), 0 if none matches
+ */
+uint64_t speculation_adopt(uint64_t stream, uint32_t version);
+
+/**
+ * Waits for an adopted speculation and takes its hash
+ *
+ * @return false if it failed or was cancelled: hash the password directly
+ */
+bool speculation_collect(uint64_t ticket, unsigned char *out);
+
+/**
+ * Gives up an adopted speculation without collecting it
+ */
+void speculation_drop(uint64_t ticket);
+
+/**
+ * Cancels whatever is queued, running or finished (KDF parameters changed,
+ * emergency wipe); a running hash is waited for, so on return the thread
+ * holds no password material
+ */
+void speculation_cancel_all();
+
+#endif // FUZZME_V3_KDF_SPECULATION_H
@@ -0,0 +1,437 @@
+#include "keystroke_stream.h"
+
+#include <atomic>
+#include <cstring>
+#include <pthread.h>
+
+#include "credential_text.h"
+#include "lock_budget.h"
+#include "sealed_memory.h"
+#include "secure_util.h"
+#include "stack_scrub.h"
+
+// ========== EDIT ENCODING ==========
+// One ring slot per edit: op in bits 28-31, stream index in bits 20-27,
+// payload (code unit or delete count) in bits 0-15. A zero slot is no edit.
+
+enum KeystrokeOp : uint32_t {
+    OP_NONE = 0,
+    OP_APPEND,
+    OP_DELETE,
+    OP_CLEAR,
+    OP_CLOSE
+};
+
+static const uint32_t DELETE_MAX = 0xFFFF;
+
+static inline uint32_t edit_pack(KeystrokeOp op, uint32_t index, uint32_t payload) {
+    return ((uint32_t) op << 28) | (index << 20) | (payload & 0xFFFF);
+}
+
+// ========== STREAM STATE ==========
+
+// Set while a field is intact; an emergency wipe (wipeAllSecrets) zeroes it
+// along with the text and the field stays invalid until it is cleared
+static const uint32_t FIELD_MAGIC = 0x4B455953;
+
+/**
+ * Everything known about a field's text, in one locked region
+ * Owned by the absorber; the producer reads it only after keystroke_sync()
+ */
+struct StreamField {
+    uint32_t magic;
+    uint32_t count;             // Code units typed (may exceed KEYSTROKE_MAX_UNITS)
+    uint32_t stable;            // units[0, stable) are absorbed; units[stable] is ASCII
+    bool invalid;               // Absorbed text was not valid UTF-16
+    Blake2sState absorbed;      // Keyed hash of NFKC(units[0, stable))
+    Blake2sState final;         // Finalized by keystroke_digest()
+    uint16_t units[KEYSTROKE_MAX_UNITS];
+};
+
+enum StreamState : uint8_t {
+    STREAM_FREE = 0,
+    STREAM_OPEN,
+    STREAM_CLOSING      // Close queued, the absorber frees the region
+};
+
+struct Stream {
+    std::atomic<uint8_t> state;
+    uint32_t generation;        // Producer only; bumped on every open
+    uint32_t version;           // Producer only; bumped on every edit
+    LockedRegion region;        // StreamField
+};
+
+static Stream g_streams[KEYSTROKE_MAX_STREAMS];
+
+// ========== RING ==========
+// Producer and absorber each write their own index on their own cache line
+// and keep a cached copy of the other's, so a push or pop only touches the
+// other side's line when the cache says the ring is full or empty.
+
+struct alignas(64) RingIndex {
+    std::atomic<uint32_t> value;    // Free-running, slot = value % KEYSTROKE_RING_SLOTS
+    uint32_t peer;                  // Owner's last view of the other index
+};
+
+static RingIndex g_head;                    // Next slot the producer fills
+static RingIndex g_tail;                    // Next slot the absorber reads
+static std::atomic<uint32_t> *g_slots;      // In g_ringRegion (locked)
+static LockedRegion g_ringRegion;
+
+// The absorber sleeps on g_wake when the ring is empty; g_parked tells the
+// producer whether a push has to signal
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_drained = PTHREAD_COND_INITIALIZER;   // keystroke_sync() waits here
+static std::atomic<bool> g_parked{false};
+static pthread_once_t g_startOnce = PTHREAD_ONCE_INIT;
+static bool g_started = false;
+
+static LockedRegion g_keyRegion;            // BLAKE2s key, per process
+static LockedRegion g_utf8Region;           // Absorber's normalization output
+static LockedRegion g_codePointRegion;      // Absorber's normalization scratch
+
+// ========== ABSORBER ==========
+
+static bool field_reset(StreamField *field) {
+    secure_memzero(field->units, sizeof(field->units));
+    field->count = 0;
+    field->stable = 0;
+    field->invalid = false;
+    field->magic = FIELD_MAGIC;
+    return blake2s_init(&field->absorbed, BLAKE2S_OUT_BYTES, g_keyRegion.ptr, BLAKE2S_KEY_BYTES);
+}
+
+/**
+ * Normalizes units[from, to) and hashes the result into state
+ * Only called with segment ends that start with ASCII (or at the end of the
+ * text), which never compose or reorder with what comes before them
+ */
+static bool absorb_units(Blake2sState *state, const uint16_t *units, uint32_t len,
+                         unsigned char *utf8, size_t utf8Cap,
+                         uint32_t *codePoints, size_t codePointCap) {
+    if (len == 0) return true;
+    long bytes = credential_to_utf8(units, len, utf8, utf8Cap, codePoints, codePointCap);
+    if (bytes < 0) return false;
+    blake2s_update(state, utf8, (size_t) bytes);
+    secure_memzero(utf8, (size_t) bytes);
+    return true;
+}
+
+static void field_absorb(StreamField *field, uint32_t to) {
+    if (!absorb_units(&field->absorbed, field->units + field->stable, to - field->stable,
+                      (unsigned char *) g_utf8Region.ptr, g_utf8Region.len,
+                      (uint32_t *) g_codePointRegion.ptr,
+                      g_codePointRegion.len / sizeof(uint32_t))) {
+        field->invalid = true;
+    }
+    field->stable = to;
+}
+
+static void field_append(StreamField *field, uint16_t unit) {
+    uint32_t n = field->count;
+    if (n >= KEYSTROKE_MAX_UNITS) {
+        // Overflow: only the length is tracked, deleting back makes it valid
+        if (n < DELETE_MAX) field->count++;
+        return;
+    }
+    // An ASCII unit closes the segment before it
+    if (unit < 0x80 && n > field->stable) field_absorb(field, n);
+    field->units[n] = unit;
+    field->count = n + 1;
+}
+
+static void field_delete(StreamField *field, uint32_t count) {
+    uint32_t newCount = count < field->count ? field->count - count : 0;
+    uint32_t kept = field->count < KEYSTROKE_MAX_UNITS ? field->count : KEYSTROKE_MAX_UNITS;
+    if (newCount < kept) secure_memzero(field->units + newCount, (kept - newCount) * sizeof(uint16_t));
+    field->count = newCount;
+    if (newCount > field->stable) return;
+
+    // The absorbed prefix lost its boundary: hashes cannot be rolled back,
+    // so re-absorb up to the last ASCII unit that is left
+    uint32_t stable = newCount;
+    while (stable > 0 && field->units[stable - 1] >= 0x80) stable--;
+    if (stable > 0) stable--;
+    blake2s_init(&field->absorbed, BLAKE2S_OUT_BYTES, g_keyRegion.ptr, BLAKE2S_KEY_BYTES);
+    field->invalid = false;
+    field->stable = 0;
+    field_absorb(field, stable);
+}
+
+/**
+ * Applies one edit to its field
+ * Out of line so the absorber can scrub the stack it used (hash words and
+ * normalization temporaries hold typed text)
+ */
+__attribute__((noinline)) static void apply_keystroke_edit(uint32_t edit) {
+    KeystrokeOp op = (KeystrokeOp) (edit >> 28);
+    uint32_t index = (edit >> 20) & 0xFF;
+    if (op == OP_NONE || index >= (uint32_t) KEYSTROKE_MAX_STREAMS) return;
+
+    Stream *stream = &g_streams[index];
+    StreamField *field = (StreamField *) stream->region.ptr;
+    if (op == OP_CLOSE) {
+        locked_free(&stream->region);
+        stream->state.store(STREAM_FREE, std::memory_order_release);
+        return;
+    }
+    if (op == OP_CLEAR) {
+        field_reset(field);
+        return;
+    }
+    // Wiped under us: leave it invalid until the field is cleared
+    if (field->magic != FIELD_MAGIC) return;
+
+    if (op == OP_APPEND) field_append(field, (uint16_t) edit);
+    else field_delete(field, edit & 0xFFFF);
+}
+
+static void park_absorber() {
+    pthread_mutex_lock(&g_lock);
+    g_parked.store(true, std::memory_order_seq_cst);
+    for (;;) {
+        g_tail.peer = g_head.value.load(std::memory_order_seq_cst);
+        if (g_tail.peer != g_tail.value.load(std::memory_order_relaxed)) break;
+        pthread_cond_broadcast(&g_drained);
+        pthread_cond_wait(&g_wake, &g_lock);
+    }
+    g_parked.store(false, std::memory_order_relaxed);
+    pthread_mutex_unlock(&g_lock);
+}
+
+static void *absorber_main(void *) {
+    uint32_t tail = g_tail.value.load(std::memory_order_relaxed);
+    for (;;) {
+        if (tail == g_tail.peer) {
+            g_tail.peer = g_head.value.load(std::memory_order_acquire);
+            if (tail == g_tail.peer) {
+                park_absorber();
+                continue;
+            }
+        }
+        while (tail != g_tail.peer) {
+            std::atomic<uint32_t> *slot = &g_slots[tail & (KEYSTROKE_RING_SLOTS - 1)];
+            uint32_t edit = slot->load(std::memory_order_relaxed);
+            slot->store(0, std::memory_order_relaxed);  // Consumed slots hold no keystroke
+            apply_keystroke_edit(edit);
+            tail++;
+            g_tail.value.store(tail, std::memory_order_release);
+        }
+        stack_scrub(STACK_DEPTH_APPLY_KEYSTROKE_EDIT);
+    }
+    return nullptr;
+}
+
+static void start_absorber() {
+    size_t utf8Cap = credential_utf8_capacity(KEYSTROKE_MAX_UNITS);
+    size_t codePointCap = credential_scratch_capacity(KEYSTROKE_MAX_UNITS);
+    if (!locked_alloc(&g_keyRegion, BLAKE2S_KEY_BYTES, LOCK_PRIO_CRITICAL, SECRET_CLASS_KEY)) return;
+    // Key = keystream under the process key: random, never stored elsewhere
+    if (!sealed_xor_keystream(g_keyRegion.ptr, BLAKE2S_KEY_BYTES, sealed_next_nonce())) {
+        locked_free(&g_keyRegion);
+        return;
+    }
+    // Slots are wiped as they are consumed; a pause wipe must not turn a
+    // queued close into a no-op (the stream would never be freed)
+    if (!locked_alloc(&g_ringRegion, KEYSTROKE_RING_SLOTS * sizeof(std::atomic<uint32_t>),
+                      LOCK_PRIO_CRITICAL, SECRET_CLASS_KEY) ||
+        !locked_alloc(&g_utf8Region, utf8Cap, LOCK_PRIO_CRITICAL) ||
+        !locked_alloc(&g_codePointRegion, codePointCap * sizeof(uint32_t), LOCK_PRIO_CRITICAL)) {
+        locked_free(&g_keyRegion);
+        locked_free(&g_ringRegion);
+        locked_free(&g_utf8Region);
+        return;
+    }
+    g_slots = (std::atomic<uint32_t> *) g_ringRegion.ptr;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, absorber_main, NULL) == 0) {
+        pthread_detach(thread);
+        g_started = true;
+    }
+}
+
+// ========== PRODUCER ==========
+
+static bool ring_push(Stream *stream, uint32_t edit) {
+    stream->version++;
+
+    uint32_t head = g_head.value.load(std::memory_order_relaxed);
+    if (head - g_head.peer == KEYSTROKE_RING_SLOTS) {
+        g_head.peer = g_tail.value.load(std::memory_order_acquire);
+        // Full: the absorber is far behind, let it catch up rather than drop a keystroke
+        if (head - g_head.peer == KEYSTROKE_RING_SLOTS) {
+            keystroke_sync();
+            g_head.peer = g_tail.value.load(std::memory_order_acquire);
+        }
+    }
+    g_slots[head & (KEYSTROKE_RING_SLOTS - 1)].store(edit, std::memory_order_relaxed);
+    g_head.value.store(head + 1, std::memory_order_seq_cst);
+
+    // Pairs with park_absorber(): either it sees the new head or we see it parked
+    if (g_parked.load(std::memory_order_seq_cst)) {
+        pthread_mutex_lock(&g_lock);
+        pthread_cond_signal(&g_wake);
+        pthread_mutex_unlock(&g_lock);
+    }
+    return true;
+}
+
+static Stream *stream_lookup(uint64_t handle, uint32_t *index) {
+    *index = (uint32_t) handle;
+    if (!g_started || *index >= (uint32_t) KEYSTROKE_MAX_STREAMS) return nullptr;
+    Stream *stream = &g_streams[*index];
+    if (stream->generation != (uint32_t) (handle >> 32) ||
+        stream->state.load(std::memory_order_relaxed) != STREAM_OPEN) {
+        return nullptr;
+    }
+    return stream;
+}
+
+// ========== PUBLIC API ==========
+
+uint64_t keystroke_open() {
+    pthread_once(&g_startOnce, start_absorber);
+    if (!g_started) return 0;
+
+    for (uint32_t i = 0; i < (uint32_t) KEYSTROKE_MAX_STREAMS; i++) {
+        Stream *stream = &g_streams[i];
+        if (stream->state.load(std::memory_order_acquire) != STREAM_FREE) continue;
+
+        if (!locked_alloc(&stream->region, sizeof(StreamField), LOCK_PRIO_CRITICAL)) return 0;
+        // Published to the absorber by the ring: it sees the field with the first edit
+        if (!field_reset((StreamField *) stream->region.ptr)) {
+            locked_free(&stream->region);
+            return 0;
+        }
+        stream->generation++;
+        stream->state.store(STREAM_OPEN, std::memory_order_relaxed);
+        return ((uint64_t) stream->generation << 32) | i;
+    }
+    return 0;
+}
+
+bool keystroke_append(uint64_t handle, uint16_t unit) {
+    uint32_t index;
+    Stream *stream = stream_lookup(handle, &index);
+    if (!stream) return false;
+    return ring_push(stream, edit_pack(OP_APPEND, index, unit));
+}
+
+bool keystroke_delete(uint64_t handle, uint32_t count) {
+    uint32_t index;
+    Stream *stream = stream_lookup(handle, &index);
+    if (!stream) return false;
+    if (count == 0) return true;
+    return ring_push(stream, count >= DELETE_MAX ? edit_pack(OP_CLEAR, index, 0)
+                                                 : edit_pack(OP_DELETE, index, count));
+}
+
+bool keystroke_clear(uint64_t handle) {
+    uint32_t index;
+    Stream *stream = stream_lookup(handle, &index);
+    if (!stream) return false;
+    return ring_push(stream, edit_pack(OP_CLEAR, index, 0));
+}
+
+void keystroke_close(uint64_t handle) {
+    uint32_t index;
+    Stream *stream = stream_lookup(handle, &index);
+    if (!stream) return;
+    stream->state.store(STREAM_CLOSING, std::memory_order_relaxed);
+    ring_push(stream, edit_pack(OP_CLOSE, index, 0));
+}
+
+void keystroke_sync() {
+    if (!g_started) return;
+    uint32_t target = g_head.value.load(std::memory_order_relaxed);
+    if (g_tail.value.load(std::memory_order_acquire) == target) return;
+
+    pthread_mutex_lock(&g_lock);
+    while ((int32_t) (g_tail.value.load(std::memory_order_acquire) - target) < 0) {
+        pthread_cond_wait(&g_drained, &g_lock);
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+/**
+ * A stream's field once every edit pushed so far is applied
+ *
+ * @return NULL on a stale handle or an invalid stream
+ */
+static StreamField *synced_field(uint64_t handle) {
+    uint32_t index;
+    Stream *stream = stream_lookup(handle, &index);
+    if (!stream) return NULL;
+    keystroke_sync();
+
+    StreamField *field = (StreamField *) stream->region.ptr;
+    if (field->magic != FIELD_MAGIC || field->invalid || field->count > KEYSTROKE_MAX_UNITS) {
+        return NULL;
+    }
+    return field;
+}
+
+bool keystroke_digest(uint64_t handle, unsigned char *out) {
+    StreamField *field = synced_field(handle);
+    if (!field) return false;
+
+    // The segment after the last boundary is still open: normalize it into
+    // a copy of the state so the stream can keep growing
+    uint32_t tail = field->count - field->stable;
+    size_t utf8Cap = credential_utf8_capacity(tail);
+    size_t codePointCap = credential_scratch_capacity(tail);
+    LockedRegion utf8Region = {}, codePointRegion = {};
+    bool ok = locked_alloc(&utf8Region, utf8Cap ? utf8Cap : 1, LOCK_PRIO_CRITICAL) &&
+              locked_alloc(&codePointRegion, (codePointCap ? codePointCap : 1) * sizeof(uint32_t),
+                           LOCK_PRIO_CRITICAL);
+    if (ok) {
+        field->final = field->absorbed;
+        ok = absorb_units(&field->final, field->units + field->stable, tail,
+                          (unsigned char *) utf8Region.ptr, utf8Cap,
+                          (uint32_t *) codePointRegion.ptr, codePointCap);
+        if (ok) blake2s_final(&field->final, out);
+        else secure_memzero(&field->final, sizeof(field->final));
+    }
+    locked_free(&utf8Region);
+    locked_free(&codePointRegion);
+    return ok;
+}
+
+uint32_t keystroke_version(uint64_t handle) {
+    uint32_t index;
+    Stream *stream = stream_lookup(handle, &index);
+    return stream ? stream->version : 0;
+}
+
+size_t keystroke_utf8_capacity() {
+    return credential_utf8_capacity(KEYSTROKE_MAX_UNITS);
+}
+
+long keystroke_utf8(uint64_t handle, unsigned char *out, size_t cap) {
+    StreamField *field = synced_field(handle);
+    if (!field) return -1;
+    size_t codePointCap = credential_scratch_capacity(field->count);
+    LockedRegion codePointRegion = {};
+    if (!locked_alloc(&codePointRegion, (codePointCap ? codePointCap : 1) * sizeof(uint32_t),
+                      LOCK_PRIO_CRITICAL)) {
+        return -1;
+    }
+    long len = credential_to_utf8(field->units, field->count, out, cap,
+                                  (uint32_t *) codePointRegion.ptr, codePointCap);
+    locked_free(&codePointRegion);
+    return len;
+}
+
+long keystroke_utf8_raw(uint64_t handle, unsigned char *out, size_t cap) {
+    StreamField *field = synced_field(handle);
+    if (!field) return -1;
+    return utf16_to_utf8(field->units, field->count, out, cap);
+}
+
+bool keystroke_digest_bytes(const void *utf8, size_t len, unsigned char *out) {
+    pthread_once(&g_startOnce, start_absorber);
+    if (!g_started) return false;
+    return blake2s(out, BLAKE2S_OUT_BYTES, g_keyRegion.ptr, BLAKE2S_KEY_BYTES, utf8, len);
+}
@@ -0,0 +1,107 @@
+#ifndef FUZZME_V3_KEYSTROKE_STREAM_H
+#define FUZZME_V3_KEYSTROKE_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "blake2s.h"
+
+// ========== KEYSTROKE STREAMS ==========
+// Text fields send every edit to native code as it is typed instead of
+// collecting the characters in a Java array. Edits travel through a
+// single-producer/single-consumer ring in locked memory; an absorber thread
+// applies them to the field's locked state and wipes each ring slot as it
+// reads it. The state keeps a keyed BLAKE2s of the field's NFKC-normalized
+// UTF-8 (see credential_text.h), so a check only finalizes a digest.
+//
+// Streams have a single producer: every call below except
+// keystroke_digest_bytes() must come from the same thread (the UI thread).
+
+// Streams open at once
+static const int KEYSTROKE_MAX_STREAMS = 8;
+
+// UTF-16 code units a stream holds; longer input makes the stream invalid
+static const uint32_t KEYSTROKE_MAX_UNITS = 256;
+
+// Edits in flight between producer and absorber (power of two)
+static const uint32_t KEYSTROKE_RING_SLOTS = 256;
+
+/**
+ * Opens an empty stream
+ *
+ * @return Stream handle, 0 if every stream is in use or memory ran out
+ */
+uint64_t keystroke_open();
+
+/**
+ * Appends one UTF-16 code unit
+ *
+ * Waits for the absorber if the ring is full, so no edit is ever dropped
+ *
+ * @return false on a stale handle
+ */
+bool keystroke_append(uint64_t stream, uint16_t unit);
+
+/**
+ * Removes the last count code units
+ */
+bool keystroke_delete(uint64_t stream, uint32_t count);
+
+/**
+ * Empties the stream (and makes an invalid stream usable again)
+ */
+bool keystroke_clear(uint64_t stream);
+
+/**
+ * Wipes and releases a stream; the handle is dead on return
+ */
+void keystroke_close(uint64_t stream);
+
+/**
+ * Waits until the absorber has applied every edit pushed so far
+ */
+void keystroke_sync();
+
+/**
+ * Keyed digest of a stream's current text (after keystroke_sync())
+ *
+ * @param out BLAKE2S_OUT_BYTES bytes
+ * @return false on a stale handle or an invalid stream (wiped by
+ *         wipeAllSecrets, over KEYSTROKE_MAX_UNITS, or not valid UTF-16)
+ */
+bool keystroke_digest(uint64_t stream, unsigned char *out);
+
+/**
+ * Edits pushed to a stream so far; any edit changes it
+ */
+uint32_t keystroke_version(uint64_t stream);
+
+/**
+ * Bytes keystroke_utf8() may write
+ */
+size_t keystroke_utf8_capacity();
+
+/**
+ * Copies a stream's text, NFKC-normalized UTF-8 (after keystroke_sync())
+ *
+ * @param out Locked memory, keystroke_utf8_capacity() bytes
+ * @return Bytes written, -1 on a stale handle or an invalid stream
+ */
+long keystroke_utf8(uint64_t stream, unsigned char *out, size_t cap);
+
+/**
+ * Copies a stream's text as typed: UTF-8 without normalization, for
+ * lookups in corpora of raw passwords (see breach_filter.h)
+ *
+ * @param out Locked memory, keystroke_utf8_capacity() bytes
+ * @return Bytes written, -1 on a stale handle or an invalid stream
+ */
+long keystroke_utf8_raw(uint64_t stream, unsigned char *out, size_t cap);
+
+/**
+ * Digest of already-normalized UTF-8 under the same key, for comparing
+ * against keystroke_digest() (callable from any thread)
+ */
+bool keystroke_digest_bytes(const void *utf8, size_t len, unsigned char *out);
+
+#endif // FUZZME_V3_KEYSTROKE_STREAM_H
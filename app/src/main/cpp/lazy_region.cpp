@@ -0,0 +1,481 @@
+#include "lazy_region.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <new>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <linux/userfaultfd.h>
+
+#include "lock_budget.h"
+#include "native_stats.h"
+#include "sealed_memory.h"
+#include "secret_registry.h"
+#include "secure_util.h"
+
+#ifndef UFFD_USER_MODE_ONLY
+#define UFFD_USER_MODE_ONLY 1
+#endif
+#ifndef MLOCK_ONFAULT
+#define MLOCK_ONFAULT 1
+#endif
+#ifndef MREMAP_DONTUNMAP
+#define MREMAP_DONTUNMAP 4
+#endif
+#ifndef MADV_DONTDUMP
+#define MADV_DONTDUMP 16
+#endif
+#ifndef MADV_WIPEONFORK
+#define MADV_WIPEONFORK 18
+#endif
+
+struct LazyRegion {
+    unsigned char *base;     // Registered mapping (lazy) or eager.ptr
+    size_t len;
+    size_t mapLen;
+    size_t pages;
+    uint32_t idleMs;
+    bool lazy;
+    bool locked;             // Budget admitted mapLen and mlock2 succeeded
+
+    unsigned char *cipher;   // pages * page_size() bytes of sealed contents
+    uint64_t *nonces;        // One nonce per page so pages decrypt independently
+    uint64_t *residentMs;    // Fault-in time per page, 0 = not resident
+    SecretNode *nodes;       // One per page, registered while the page is resident
+    std::atomic<size_t> residentPages;
+
+    LockedRegion eager;      // Fallback when userfaultfd is unavailable
+    LazyRegion *next;
+};
+
+// ========== FAULT HANDLER STATE ==========
+// One handler thread serves every region. g_lock is held while it services a
+// batch of faults or scans for idle pages, and by create/destroy, so a region
+// is never freed under the handler.
+
+static int g_uffd = -1;
+static int g_wakeFd = -1;
+static LockedRegion g_staging = {};   // Locked page where faults are decrypted
+static LazyRegion *g_regions = NULL;
+static bool g_uffdReady = false;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t g_initOnce = PTHREAD_ONCE_INIT;
+
+static uint64_t monotonic_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000ull + (uint64_t) ts.tv_nsec / 1000000ull;
+}
+
+static LazyRegion *region_for(uintptr_t addr) {
+    for (LazyRegion *r = g_regions; r; r = r->next) {
+        uintptr_t base = (uintptr_t) r->base;
+        if (addr >= base && addr < base + r->mapLen) return r;
+    }
+    return NULL;
+}
+
+/**
+ * Decrypts one page into the staging page and installs it atomically
+ */
+static void handle_fault(uintptr_t addr) {
+    size_t ps = page_size();
+    uintptr_t page = addr & ~(uintptr_t) (ps - 1);
+    LazyRegion *r = region_for(page);
+
+    if (!r) {
+        // Region destroyed while the fault was queued: just let the thread go
+        struct uffdio_range range = {page, ps};
+        ioctl(g_uffd, UFFDIO_WAKE, &range);
+        return;
+    }
+
+    size_t i = (page - (uintptr_t) r->base) / ps;
+    unsigned char *staging = (unsigned char *) g_staging.ptr;
+    memcpy(staging, r->cipher + i * ps, ps);
+    sealed_xor_keystream(staging, ps, r->nonces[i]);
+
+    struct uffdio_copy copy;
+    copy.dst = page;
+    copy.src = (uintptr_t) staging;
+    copy.len = ps;
+    copy.mode = UFFDIO_COPY_MODE_DONTWAKE;
+    copy.copy = 0;
+    // EEXIST: another fault on the same page was already served
+    bool installed = ioctl(g_uffd, UFFDIO_COPY, &copy) == 0 || errno == EEXIST;
+
+    // Accounted and registered before the faulting thread is woken, so its
+    // plaintext is never out of reach of pause and crash wipes. Not before
+    // the copy: a wipe touching a missing page would fault into this thread
+    if (installed && !r->residentMs[i]) {
+        r->residentPages.fetch_add(1, std::memory_order_relaxed);
+        secret_registry_add(&r->nodes[i], (void *) page, ps, SECRET_CLASS_PLAINTEXT);
+    }
+    if (installed) r->residentMs[i] = monotonic_ms();
+    struct uffdio_range range = {page, ps};
+    ioctl(g_uffd, UFFDIO_WAKE, &range);
+
+    secure_wipe_vectorized(staging, ps);
+}
+
+/**
+ * Moves the page tables of [start, start + len) to a new mapping, leaving the
+ * range mapped but empty
+ * The destination is reserved first: some kernels refuse MREMAP_DONTUNMAP
+ * unless MREMAP_FIXED gives it a target
+ * @return The moved-out mapping, or MAP_FAILED
+ */
+static void *move_out(void *start, size_t len) {
+    void *dst = mmap(NULL, len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (dst == MAP_FAILED) return MAP_FAILED;
+    void *moved = mremap(start, len, len, MREMAP_MAYMOVE | MREMAP_FIXED | MREMAP_DONTUNMAP, dst);
+    if (moved == MAP_FAILED) munmap(dst, len);
+    return moved;
+}
+
+/**
+ * Removes count resident pages starting at page index first
+ * The page tables are moved out with MREMAP_DONTUNMAP, which leaves the
+ * registered range empty in one step: a reader touching it meanwhile simply
+ * faults and gets a freshly decrypted page. The moved-out plaintext is wiped
+ * before its frames go back to the kernel. The pages leave the secret
+ * registry first, since a wipe must never touch a missing page. If the move
+ * fails the pages stay resident (and registered) until the next scan
+ */
+static void drop_pages(LazyRegion *r, size_t first, size_t count) {
+    size_t ps = page_size();
+    unsigned char *start = r->base + first * ps;
+    size_t len = count * ps;
+
+    for (size_t i = first; i < first + count; i++) secret_registry_remove(&r->nodes[i]);
+
+    void *moved = move_out(start, len);
+    if (moved == MAP_FAILED) {
+        for (size_t i = first; i < first + count; i++) {
+            secret_registry_add(&r->nodes[i], start + (i - first) * ps, ps, SECRET_CLASS_PLAINTEXT);
+        }
+        return;
+    }
+    secure_wipe_vectorized(moved, len);
+    stats_add(STAT_BYTES_WIPED, len);
+    munmap(moved, len);
+    // The source range lost VM_LOCKED in the move
+    if (r->locked) syscall(__NR_mlock2, start, len, MLOCK_ONFAULT);
+
+    for (size_t i = first; i < first + count; i++) r->residentMs[i] = 0;
+    r->residentPages.fetch_sub(count, std::memory_order_relaxed);
+}
+
+/**
+ * Wipes every resident page in place and unregisters it (region teardown)
+ */
+static void wipe_resident(LazyRegion *r) {
+    size_t ps = page_size();
+    for (size_t i = 0; i < r->pages; i++) {
+        if (!r->residentMs[i]) continue;
+        secret_registry_remove(&r->nodes[i]);
+        secure_wipe_vectorized(r->base + i * ps, ps);
+        stats_add(STAT_BYTES_WIPED, ps);
+        r->residentMs[i] = 0;
+    }
+    r->residentPages.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * True if the kernel can move page tables out with MREMAP_DONTUNMAP (5.7+)
+ * Without it a page could only be dropped by wiping it where readers see
+ * it, so such kernels get the eager fallback instead
+ */
+static bool dontunmap_supported() {
+    size_t ps = page_size();
+    void *probe = mmap(NULL, ps, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (probe == MAP_FAILED) return false;
+    void *moved = move_out(probe, ps);
+    if (moved != MAP_FAILED) munmap(moved, ps);
+    munmap(probe, ps);
+    return moved != MAP_FAILED;
+}
+
+/**
+ * Drops resident pages whose fault-in is older than cutoffMs (all if 0)
+ * The kernel gives us no access bits, so "idle" means time since the page was
+ * decrypted; a page still in use just faults back in
+ */
+static void drop_older_than(LazyRegion *r, uint64_t cutoffMs) {
+    size_t runStart = 0, runLen = 0;
+    for (size_t i = 0; i <= r->pages; i++) {
+        bool drop = i < r->pages && r->residentMs[i] != 0 &&
+                    (cutoffMs == 0 || r->residentMs[i] <= cutoffMs);
+        if (drop) {
+            if (runLen == 0) runStart = i;
+            runLen++;
+        } else if (runLen > 0) {
+            drop_pages(r, runStart, runLen);
+            runLen = 0;
+        }
+    }
+}
+
+/**
+ * Poll timeout for the next idle scan: half the shortest idle timeout
+ */
+static int scan_interval_ms() {
+    uint32_t shortest = 0;
+    for (LazyRegion *r = g_regions; r; r = r->next) {
+        if (r->idleMs && r->residentPages.load(std::memory_order_relaxed) &&
+            (!shortest || r->idleMs < shortest)) {
+            shortest = r->idleMs;
+        }
+    }
+    if (!shortest) return -1;
+    return shortest / 2 < 5 ? 5 : (int) (shortest / 2);
+}
+
+static void *fault_thread_main(void *) {
+    struct pollfd fds[2];
+    fds[0].fd = g_uffd;
+    fds[0].events = POLLIN;
+    fds[1].fd = g_wakeFd;
+    fds[1].events = POLLIN;
+
+    pthread_mutex_lock(&g_lock);
+    for (;;) {
+        int timeout = scan_interval_ms();
+        pthread_mutex_unlock(&g_lock);
+
+        int rc = poll(fds, 2, timeout);
+        if (rc > 0 && (fds[1].revents & POLLIN)) {
+            uint64_t drain;
+            if (read(g_wakeFd, &drain, sizeof(drain)) < 0) { /* Already drained */ }
+        }
+
+        pthread_mutex_lock(&g_lock);
+        struct uffd_msg msg;
+        while (read(g_uffd, &msg, sizeof(msg)) == (ssize_t) sizeof(msg)) {
+            if (msg.event == UFFD_EVENT_PAGEFAULT) handle_fault((uintptr_t) msg.arg.pagefault.address);
+        }
+
+        uint64_t now = monotonic_ms();
+        for (LazyRegion *r = g_regions; r; r = r->next) {
+            if (r->idleMs && r->residentPages.load(std::memory_order_relaxed) && now > r->idleMs) {
+                drop_older_than(r, now - r->idleMs);
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Opens the userfaultfd and starts the handler thread
+ * Unprivileged processes only get user-mode faults (UFFD_USER_MODE_ONLY,
+ * Linux 5.11+) unless vm.unprivileged_userfaultfd is set; that is all we
+ * need, but it means a lazy region must not be passed to a syscall directly
+ */
+static void uffd_init() {
+#ifdef __NR_userfaultfd
+    if (!dontunmap_supported()) return;
+
+    int fd = (int) syscall(__NR_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY);
+    if (fd < 0) fd = (int) syscall(__NR_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+    if (fd < 0) return;
+
+    struct uffdio_api api;
+    memset(&api, 0, sizeof(api));
+    api.api = UFFD_API;
+    if (ioctl(fd, UFFDIO_API, &api) != 0) {
+        close(fd);
+        return;
+    }
+
+    int wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeFd < 0) {
+        close(fd);
+        return;
+    }
+    // Crash wipes only: a pause wipe would race a fault decrypting into it,
+    // and the handler wipes it after every fault anyway
+    if (!locked_alloc(&g_staging, page_size(), LOCK_PRIO_NORMAL, SECRET_CLASS_KEY)) {
+        close(wakeFd);
+        close(fd);
+        return;
+    }
+
+    g_uffd = fd;
+    g_wakeFd = wakeFd;
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, fault_thread_main, NULL) == 0) {
+        pthread_detach(thread);
+        g_uffdReady = true;
+    }
+#endif
+}
+
+static void wake_handler() {
+    uint64_t one = 1;
+    if (write(g_wakeFd, &one, sizeof(one)) < 0) { /* Counter saturated: already awake */ }
+}
+
+// ========== CREATION ==========
+
+/**
+ * Maps and registers the missing-page range, sealing each page's contents
+ */
+static bool create_lazy(LazyRegion *r, const unsigned char *plaintext) {
+    size_t ps = page_size();
+
+    r->cipher = (unsigned char *) malloc(r->mapLen);
+    r->nonces = (uint64_t *) calloc(r->pages, sizeof(uint64_t));
+    r->residentMs = (uint64_t *) calloc(r->pages, sizeof(uint64_t));
+    r->nodes = new (std::nothrow) SecretNode[r->pages];
+    if (!r->cipher || !r->nonces || !r->residentMs || !r->nodes) return false;
+
+    for (size_t i = 0; i < r->pages; i++) {
+        size_t n = i + 1 < r->pages ? ps : r->len - i * ps;
+        memcpy(r->cipher + i * ps, plaintext + i * ps, n);
+        memset(r->cipher + i * ps + n, 0, ps - n);
+        r->nonces[i] = sealed_next_nonce();
+        if (!sealed_xor_keystream(r->cipher + i * ps, ps, r->nonces[i])) return false;
+    }
+
+    void *mem = mmap(NULL, r->mapLen, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mem == MAP_FAILED) return false;
+    r->base = (unsigned char *) mem;
+
+    // Page-granular faults and drops; no plaintext in core dumps or children
+    madvise(mem, r->mapLen, MADV_NOHUGEPAGE);
+    madvise(mem, r->mapLen, MADV_DONTDUMP);
+    madvise(mem, r->mapLen, MADV_WIPEONFORK);
+
+    struct uffdio_register reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.range.start = (uintptr_t) mem;
+    reg.range.len = r->mapLen;
+    reg.mode = UFFDIO_REGISTER_MODE_MISSING;
+    if (ioctl(g_uffd, UFFDIO_REGISTER, &reg) != 0) {
+        munmap(mem, r->mapLen);
+        r->base = NULL;
+        return false;
+    }
+
+    // Lock pages as they fault in rather than populating them all now
+    if (lock_budget_acquire(r->mapLen, LOCK_PRIO_BULK)) {
+        r->locked = syscall(__NR_mlock2, mem, r->mapLen, MLOCK_ONFAULT) == 0;
+        stats_mlock(r->locked ? 0 : -1);
+        if (!r->locked) lock_budget_release(r->mapLen);
+    }
+    return true;
+}
+
+static void free_lazy_parts(LazyRegion *r) {
+    free(r->cipher);
+    free(r->nonces);
+    free(r->residentMs);
+    delete[] r->nodes;
+    r->cipher = NULL;
+    r->nonces = r->residentMs = NULL;
+    r->nodes = NULL;
+}
+
+LazyRegion *lazy_region_create(const void *plaintext, size_t len, uint32_t idleMs) {
+    if (!plaintext || len == 0) return NULL;
+
+    LazyRegion *r = (LazyRegion *) calloc(1, sizeof(LazyRegion));
+    if (!r) return NULL;
+    r->len = len;
+    r->mapLen = page_round_up(len);
+    r->pages = r->mapLen / page_size();
+    r->idleMs = idleMs;
+
+    pthread_once(&g_initOnce, uffd_init);
+    if (g_uffdReady) {
+        pthread_mutex_lock(&g_lock);
+        r->lazy = create_lazy(r, (const unsigned char *) plaintext);
+        if (r->lazy) {
+            r->next = g_regions;
+            g_regions = r;
+        }
+        pthread_mutex_unlock(&g_lock);
+        if (r->lazy) {
+            wake_handler();  // Recompute the scan interval
+            return r;
+        }
+        free_lazy_parts(r);
+    }
+
+    // Eager fallback: the whole blob is plaintext for the region's lifetime
+    if (!locked_alloc(&r->eager, len, LOCK_PRIO_BULK)) {
+        free(r);
+        return NULL;
+    }
+    memcpy(r->eager.ptr, plaintext, len);
+    r->base = (unsigned char *) r->eager.ptr;
+    r->residentPages.store(r->pages, std::memory_order_relaxed);
+    return r;
+}
+
+// ========== ACCESSORS ==========
+
+const void *lazy_region_data(const LazyRegion *region) {
+    return region->base;
+}
+
+size_t lazy_region_len(const LazyRegion *region) {
+    return region->len;
+}
+
+bool lazy_region_is_lazy(const LazyRegion *region) {
+    return region->lazy;
+}
+
+size_t lazy_region_resident(const LazyRegion *region) {
+    size_t bytes = region->residentPages.load(std::memory_order_relaxed) * page_size();
+    return bytes < region->len ? bytes : region->len;
+}
+
+void lazy_region_drop_all(LazyRegion *region) {
+    if (!region->lazy) return;
+    pthread_mutex_lock(&g_lock);
+    drop_older_than(region, 0);
+    pthread_mutex_unlock(&g_lock);
+}
+
+// ========== DESTRUCTION ==========
+
+void lazy_region_destroy(LazyRegion *region) {
+    if (!region) return;
+
+    if (!region->lazy) {
+        locked_free(&region->eager);
+        free(region);
+        return;
+    }
+
+    pthread_mutex_lock(&g_lock);
+    for (LazyRegion **link = &g_regions; *link; link = &(*link)->next) {
+        if (*link == region) {
+            *link = region->next;
+            break;
+        }
+    }
+    wipe_resident(region);
+
+    struct uffdio_range range = {(uintptr_t) region->base, region->mapLen};
+    ioctl(g_uffd, UFFDIO_UNREGISTER, &range);
+    pthread_mutex_unlock(&g_lock);
+
+    munmap(region->base, region->mapLen);
+    if (region->locked) lock_budget_release(region->mapLen);
+    free_lazy_parts(region);
+    free(region);
+}
@@ -0,0 +1,59 @@
+#ifndef FUZZME_V3_LAZY_REGION_H
+#define FUZZME_V3_LAZY_REGION_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ========== LAZY SECRET REGIONS ==========
+// Read-only views of large secret blobs (key bundles, certificate chains)
+// that are kept sealed page by page. Pages start missing; the first touch
+// faults into a userfaultfd handler thread that decrypts just that page.
+// Pages that stay resident longer than the idle timeout are dropped again,
+// so only the working set is ever plaintext. Resident pages are registered
+// as plaintext, so a pause wipe zeroes them like any other; they read as
+// zeros until dropped and faulted back in. Without userfaultfd (old kernel,
+// seccomp, no permission) or MREMAP_DONTUNMAP (before Linux 5.7) the whole
+// blob is decrypted up front instead.
+
+struct LazyRegion;
+
+/**
+ * Seals a blob into a new lazy region
+ * The caller still owns (and should wipe) the plaintext
+ *
+ * @param plaintext Blob contents
+ * @param len       Blob length
+ * @param idleMs    Resident pages older than this are dropped (0 = never)
+ * @return Region, or NULL if memory could not be obtained
+ */
+LazyRegion *lazy_region_create(const void *plaintext, size_t len, uint32_t idleMs);
+
+/**
+ * Read-only plaintext view; pages decrypt on access
+ * Must not be touched from a signal handler
+ */
+const void *lazy_region_data(const LazyRegion *region);
+
+size_t lazy_region_len(const LazyRegion *region);
+
+/**
+ * True if pages are decrypted on demand, false if the eager fallback is in use
+ */
+bool lazy_region_is_lazy(const LazyRegion *region);
+
+/**
+ * Bytes currently decrypted in memory
+ */
+size_t lazy_region_resident(const LazyRegion *region);
+
+/**
+ * Drops every resident page right away (e.g. after a pause wipe zeroed them)
+ */
+void lazy_region_drop_all(LazyRegion *region);
+
+/**
+ * Wipes and unmaps the region
+ */
+void lazy_region_destroy(LazyRegion *region);
+
+#endif // FUZZME_V3_LAZY_REGION_H
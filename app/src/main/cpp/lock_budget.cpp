@@ -0,0 +1,258 @@
+#include "lock_budget.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <pthread.h>
+#include <sys/resource.h>
+
+#include "native_stats.h"
+#include "secure_backend.h"
+#include "secure_slab.h"
+#include "secure_util.h"
+#include "wipe_queue.h"
+
+// ========== BUDGET ACCOUNTING ==========
+
+static uint64_t g_limit = UINT64_MAX;
+static std::atomic<uint64_t> g_locked{0};
+static std::atomic<uint64_t> g_denied{0};
+static pthread_once_t g_initOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Reads RLIMIT_MEMLOCK once per process
+ */
+static void budget_init() {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_MEMLOCK, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY) {
+        g_limit = (uint64_t) rl.rlim_cur;
+    }
+}
+
+/**
+ * Ceiling for a priority, in bytes
+ */
+static uint64_t priority_ceiling(LockPriority prio) {
+    if (g_limit == UINT64_MAX) return UINT64_MAX;
+    switch (prio) {
+        case LOCK_PRIO_CRITICAL: return g_limit;
+        case LOCK_PRIO_NORMAL:   return g_limit / 4 * 3;
+        default:                 return g_limit / 2;
+    }
+}
+
+bool lock_budget_acquire(size_t bytes, LockPriority prio) {
+    pthread_once(&g_initOnce, budget_init);
+
+    uint64_t ceiling = priority_ceiling(prio);
+    uint64_t cur = g_locked.load(std::memory_order_relaxed);
+    do {
+        if (cur + bytes > ceiling || cur + bytes < cur) {
+            g_denied.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!g_locked.compare_exchange_weak(cur, cur + bytes, std::memory_order_relaxed));
+    return true;
+}
+
+void lock_budget_release(size_t bytes) {
+    g_locked.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+/**
+ * Whether prio may take over locked memory that is already counted (a
+ * cached mapping): the total must be within its ceiling, as a new lock's would
+ */
+static bool budget_admits_held(LockPriority prio) {
+    pthread_once(&g_initOnce, budget_init);
+    return g_locked.load(std::memory_order_relaxed) <= priority_ceiling(prio);
+}
+
+void lock_budget_info(LockBudgetInfo *out) {
+    pthread_once(&g_initOnce, budget_init);
+
+    out->limitBytes = g_limit;
+    out->lockedBytes = g_locked.load(std::memory_order_relaxed);
+    out->deniedRequests = g_denied.load(std::memory_order_relaxed);
+    out->pressurePermille = g_limit == UINT64_MAX || g_limit == 0
+                            ? 0 : (int) (out->lockedBytes * 1000 / g_limit);
+}
+
+// ========== SHARED PAGE POOL ==========
+// Requests up to a quarter page are carved out of shared locked pages, so a
+// 32-byte key costs 1/64 of a page of budget instead of a whole page.
+
+// Every pool page is split into 64 chunks so one uint64_t tracks it
+static const int POOL_CHUNKS = 64;
+
+struct PoolPage {
+    unsigned char *mem;
+    uint64_t used;      // Bit i set = chunk i handed out
+    SecureBackendKind backend;
+    PoolPage *next;
+};
+
+static PoolPage *g_pool = nullptr;
+static pthread_mutex_t g_poolLock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t chunk_size() {
+    return page_size() / POOL_CHUNKS;
+}
+
+/**
+ * Finds a run of n free chunks in a page bitmap
+ * @return First chunk index, or -1
+ */
+static int find_run(uint64_t used, int n) {
+    uint64_t mask = n == 64 ? ~0ull : ((1ull << n) - 1);
+    for (int i = 0; i + n <= POOL_CHUNKS; i++) {
+        if ((used & (mask << i)) == 0) return i;
+    }
+    return -1;
+}
+
+static bool pool_alloc(LockedRegion *out, size_t len, LockPriority prio) {
+    size_t cs = chunk_size();
+    int n = (int) ((len + cs - 1) / cs);
+    uint64_t mask = n == 64 ? ~0ull : ((1ull << n) - 1);
+
+    pthread_mutex_lock(&g_poolLock);
+
+    PoolPage *page = g_pool;
+    int idx = -1;
+    for (; page; page = page->next) {
+        idx = find_run(page->used, n);
+        if (idx >= 0) break;
+    }
+
+    if (!page) {
+        // No room: lock one more page, or give up and let the caller go unpooled
+        // (pool pages are always locked, unlocked chunks would defeat the point)
+        bool locked = false;
+        SecureBackendKind backend;
+        void *mem = backend_map(page_size(), prio, &locked, &backend);
+        if (mem && !locked) {
+            backend_unmap(mem, page_size(), false, backend);
+            mem = NULL;
+        }
+        if (!mem) {
+            pthread_mutex_unlock(&g_poolLock);
+            return false;
+        }
+        page = (PoolPage *) calloc(1, sizeof(PoolPage));
+        if (!page) {
+            backend_unmap(mem, page_size(), true, backend);
+            pthread_mutex_unlock(&g_poolLock);
+            return false;
+        }
+        page->mem = (unsigned char *) mem;
+        page->backend = backend;
+        page->next = g_pool;
+        g_pool = page;
+        idx = 0;
+    }
+
+    page->used |= mask << idx;
+    pthread_mutex_unlock(&g_poolLock);
+
+    out->ptr = page->mem + (size_t) idx * cs;
+    out->len = len;
+    out->mapLen = (size_t) n * cs;
+    out->locked = true;
+    out->pooled = true;
+    out->slab = false;
+    out->backend = page->backend;
+    return true;
+}
+
+static void pool_free(LockedRegion *region) {
+    size_t cs = chunk_size();
+    unsigned char *p = (unsigned char *) region->ptr;
+
+    // Wiped while still registered, unregistered before the chunk can be
+    // reused or its page unmapped
+    secure_memzero(p, region->mapLen);
+    secret_registry_remove(&region->registryNode);
+
+    pthread_mutex_lock(&g_poolLock);
+    PoolPage **link = &g_pool;
+    for (PoolPage *page = g_pool; page; link = &page->next, page = page->next) {
+        if (p < page->mem || p >= page->mem + page_size()) continue;
+
+        int idx = (int) ((size_t) (p - page->mem) / cs);
+        int n = (int) (region->mapLen / cs);
+        uint64_t mask = n == 64 ? ~0ull : ((1ull << n) - 1);
+        page->used &= ~(mask << idx);
+
+        // Hand empty pages (and their budget) back
+        if (page->used == 0) {
+            *link = page->next;
+            backend_unmap(page->mem, page_size(), true, page->backend);
+            free(page);
+        }
+        break;
+    }
+    pthread_mutex_unlock(&g_poolLock);
+}
+
+// ========== PUBLIC ALLOCATION ==========
+
+bool locked_alloc(LockedRegion *out, size_t len, LockPriority prio, SecretClass secretClass) {
+    if (!out || len == 0) return false;
+
+    if (len <= SLAB_MAX_OBJECT) {
+        void *slot = slab_alloc(len, prio, secretClass);
+        if (slot) {
+            out->ptr = slot;
+            out->len = len;
+            out->mapLen = slab_usable_size(slot);
+            out->locked = true;
+            out->pooled = false;
+            out->slab = true;
+            out->backend = BACKEND_COUNT;  // No mapping of its own
+            return true;
+        }
+    }
+
+    if (len <= page_size() / 4 && pool_alloc(out, len, prio)) {
+        secret_registry_add(&out->registryNode, out->ptr, out->mapLen, secretClass);
+        return true;
+    }
+
+    size_t mapLen = page_round_up(len);
+    bool locked = false;
+    SecureBackendKind backend;
+    void *mem = budget_admits_held(prio) ? wipe_queue_take_clean(mapLen, &locked, &backend) : NULL;
+    if (!mem) mem = backend_map(mapLen, prio, &locked, &backend);
+    if (!mem) return false;
+
+    out->ptr = mem;
+    out->len = len;
+    out->mapLen = mapLen;
+    out->locked = locked;
+    out->pooled = false;
+    out->slab = false;
+    out->backend = backend;
+    secret_registry_add(&out->registryNode, mem, mapLen, secretClass);
+    return true;
+}
+
+void locked_free(LockedRegion *region) {
+    if (!region || !region->ptr) return;
+
+    if (region->slab) {
+        slab_free(region->ptr);
+    } else if (region->pooled) {
+        pool_free(region);
+    } else if (!wipe_queue_defer(region->ptr, region->mapLen, region->locked,
+                                 (SecureBackendKind) region->backend, &region->registryNode)) {
+        // Wipe, then unregister (removing a node twice is harmless), then unmap
+        backend_wipe(region->ptr, region->mapLen);
+        secret_registry_remove(&region->registryNode);
+        backend_unmap(region->ptr, region->mapLen, region->locked,
+                      (SecureBackendKind) region->backend);
+    }
+
+    region->ptr = nullptr;
+    region->len = region->mapLen = 0;
+    region->locked = region->pooled = region->slab = false;
+}
@@ -0,0 +1,86 @@
+#ifndef FUZZME_V3_LOCK_BUDGET_H
+#define FUZZME_V3_LOCK_BUDGET_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "secret_registry.h"
+
+// ========== LOCKED-MEMORY BUDGET ==========
+// Tracks every byte we mlock() against RLIMIT_MEMLOCK so that a small limit
+// degrades gracefully (lower priorities lose their lock first) instead of
+// mlock() failing silently in the middle of a sensitive operation.
+
+/**
+ * Priority of a lock request
+ * Each priority may only fill the budget up to its own ceiling
+ */
+enum LockPriority {
+    LOCK_PRIO_CRITICAL = 0,  // Credentials and keys: may use the whole budget
+    LOCK_PRIO_NORMAL,        // Short-lived plaintext: up to 75%
+    LOCK_PRIO_BULK           // Large caches and scratch: up to 50%
+};
+
+/**
+ * A secret-holding allocation handed out by locked_alloc()
+ * locked is false when the budget denied the request or mlock() failed,
+ * the memory is still usable but may be swapped out
+ * While allocated the region is in the live-secret registry (not copyable)
+ */
+struct LockedRegion {
+    void *ptr;
+    size_t len;      // Usable length requested by the caller
+    size_t mapLen;   // Bytes actually reserved (chunk or page rounded)
+    bool locked;
+    bool pooled;     // Carved out of a shared locked page
+    bool slab;       // Slot of the slab allocator (its slab is registered, not the region)
+    int backend;     // SecureBackendKind that produced the pages
+    SecretNode registryNode;
+};
+
+/**
+ * Allocates memory for secrets, locked if the budget admits it
+ * Small requests share locked pages instead of locking a page each:
+ * up to SLAB_MAX_OBJECT bytes from the slab allocator, up to a quarter
+ * page from the chunk pool
+ *
+ * @param out         Receives the region on success
+ * @param len         Bytes needed
+ * @param prio        Priority used for admission
+ * @param secretClass When an emergency wipe may clear it (see secret_registry.h)
+ * @return false only if no memory could be obtained at all
+ */
+bool locked_alloc(LockedRegion *out, size_t len, LockPriority prio,
+                  SecretClass secretClass = SECRET_CLASS_PLAINTEXT);
+
+/**
+ * Wipes, unlocks and returns a region from locked_alloc()
+ * Large regions may be wiped by the deferred wipe queue (see wipe_queue.h);
+ * either way the memory is unreadable once this returns
+ */
+void locked_free(LockedRegion *region);
+
+/**
+ * Reserves budget for a lock the caller performs itself
+ * @return true if the bytes were admitted at this priority
+ */
+bool lock_budget_acquire(size_t bytes, LockPriority prio);
+
+/**
+ * Returns bytes previously admitted by lock_budget_acquire()
+ */
+void lock_budget_release(size_t bytes);
+
+/**
+ * Budget snapshot for diagnostics
+ */
+struct LockBudgetInfo {
+    uint64_t limitBytes;      // RLIMIT_MEMLOCK at startup (UINT64_MAX if unlimited)
+    uint64_t lockedBytes;     // Bytes currently admitted
+    uint64_t deniedRequests;  // Requests that had to run unlocked
+    int pressurePermille;     // lockedBytes / limitBytes * 1000
+};
+
+void lock_budget_info(LockBudgetInfo *out);
+
+#endif // FUZZME_V3_LOCK_BUDGET_H
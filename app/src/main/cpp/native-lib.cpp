@@ -2,29 +2,47 @@
 #include <jni.h>
 #include <cstring>
 #include <cstdlib>
+#include <pthread.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <time.h>
 
-// ========== SECURE UTILITY FUNCTIONS ==========
+#include "breach_filter.h"
+#include "cpu_dispatch.h"
+#include "credential_text.h"
+#include "jni_util.h"
+#include "kdf_speculation.h"
+#include "keystroke_stream.h"
+#include "lock_budget.h"
+#include "native_stats.h"
+#include "otp.h"
+#include "parallel_pool.h"
+#include "password_kdf.h"
+#include "sealed_memory.h"
+#include "secret_registry.h"
+#include "secret_shares.h"
+#include "secret_timer.h"
+#include "secure_backend.h"
+#include "secure_slab.h"
+#include "secure_util.h"
+#include "stack_scrub.h"
+#include "strength_dict.h"
+#include "strength_estimate.h"
+#include "wipe_queue.h"
+#include "worker_pool.h"
+
+// ========== LIBRARY LIFECYCLE ==========
 
 /**
- * Securely zeroes memory to prevent data recovery
- * Uses volatile to prevent compiler optimization
- * @param ptr Pointer to memory to zero
- * @param len Number of bytes to zero
+ * Called by the VM when System.loadLibrary() loads us
+ * Caches the JavaVM so native worker threads (e.g. the wipe thread) can attach
+ * and hooks fatal signals so a crash wipes every registered secret first
  */
-static void secure_memzero(void *ptr, size_t len) {
-    if (!ptr || len == 0) return;
-
-    // Use volatile pointer to prevent compiler from optimizing away the writes
-    volatile unsigned char *p = (volatile unsigned char *) ptr;
-
-    // Write zeros to each byte
-    while (len--) *p++ = 0;
-
-    // Memory barrier: ensures writes complete before continuing
-    // Prevents reordering and ensures zeros are actually written
-    __asm__ __volatile__("" : : "r"(ptr) : "memory");
+extern "C" JNIEXPORT jint JNICALL
+JNI_OnLoad(JavaVM *vm, void *reserved) {
+    jni_set_vm(vm);
+    secret_registry_install_handlers();
+    return JNI_VERSION_1_6;
 }
 
 // ========== CREDENTIAL STORAGE ==========
@@ -32,127 +50,324 @@ static void secure_memzero(void *ptr, size_t len) {
 // Encrypted credentials stored in memory (XOR encryption for simplicity)
 // XOR with 0x5A transforms "admin" (ASCII) to these bytes
 // In production, use proper encryption like AES-256
+// Plaintext is the NFKC-normalized UTF-8 form (what credential_to_utf8 produces)
 static const unsigned char ENC_USER[] = {0x3B, 0x3E, 0x37, 0x33, 0x34}; // "username" ^ 0x5A
 static const unsigned char ENC_PASS[] = {0x3B, 0x3E, 0x37, 0x33, 0x34}; // "password" ^ 0x5A
 static const unsigned char XOR_KEY = 0x5A;  // Simple XOR key
 
-// ========== CREDENTIAL CHECKING FUNCTION ==========
-
 /**
- * JNI function to check user credentials
- * Called from Java: NativeBridge.checkCredentials()
- * Returns JNI_TRUE if credentials match, JNI_FALSE otherwise
- *
- * SECURITY NOTES:
- * - Locks memory to prevent swapping to disk
- * - Wipes all sensitive data after use
- * - Minimizes data exposure time
- * - Handles all error cases securely
+ * Decodes an XOR-obfuscated constant into locked scratch
+ * Callers turn it into protected storage and free the scratch right away
  */
-extern "C" JNIEXPORT jboolean JNICALL
-Java_com_example_fuzzme_1v3_NativeBridge_checkCredentials(
-        JNIEnv *env, jclass clazz,
-        jcharArray juser, jcharArray jpass,
-        jint userLen, jint passLen) {
+static bool decode_obfuscated(LockedRegion *out, const unsigned char *enc, size_t len,
+                              unsigned char key) {
+    if (!locked_alloc(out, len, LOCK_PRIO_CRITICAL)) return false;
+    unsigned char *plain = (unsigned char *) out->ptr;
+    for (size_t i = 0; i < len; i++) plain[i] = enc[i] ^ key;
+    return true;
+}
 
-    // === STEP 1: LOCK MEMORY ===
-    // Allocate and lock memory to prevent sensitive data from being paged to disk
-    // This is a best-effort security measure
-    void *locked_mem = malloc(1024);
-    if (locked_mem) {
-        mlock(locked_mem, 1024);  // Lock pages in RAM
-    }
+static bool seal_obfuscated(SealedSecret *out, const unsigned char *enc, size_t len,
+                            unsigned char key) {
+    LockedRegion tmp = {};
+    if (!decode_obfuscated(&tmp, enc, len, key)) return false;
+    bool ok = sealed_seal(out, tmp.ptr, len);
+    locked_free(&tmp);
+    return ok;
+}
 
-    // === STEP 2: GET JAVA ARRAY DATA ===
-    // Get direct pointers to Java char arrays (no copying if possible)
-    // NULL as second parameter: get pointer, don't make copy if possible
-    jchar *userChars = env->GetCharArrayElements(juser, NULL);
-    jchar *passChars = env->GetCharArrayElements(jpass, NULL);
+static SharedSecret *share_obfuscated(const unsigned char *enc, size_t len, unsigned char key) {
+    LockedRegion tmp = {};
+    if (!decode_obfuscated(&tmp, enc, len, key)) return NULL;
+    SharedSecret *secret = shares_create(tmp.ptr, len);
+    locked_free(&tmp);
+    return secret;
+}
 
-    // Check for allocation failures
-    if (!userChars || !passChars) {
-        // Release arrays with JNI_ABORT: don't copy changes back
-        if (userChars) env->ReleaseCharArrayElements(juser, userChars, JNI_ABORT);
-        if (passChars) env->ReleaseCharArrayElements(jpass, passChars, JNI_ABORT);
-        if (locked_mem) {
-            secure_memzero(locked_mem, 1024);
-            free(locked_mem);
+// Expected user name as two re-randomized shares, split on first use
+// (no single key or page recovers it; plaintext only while comparing)
+static SharedSecret *g_userShares = NULL;
+static pthread_once_t g_credentialsOnce = PTHREAD_ONCE_INIT;
+
+static void share_credentials() {
+    g_userShares = share_obfuscated(ENC_USER, sizeof(ENC_USER), XOR_KEY);
+}
+
+// ========== PASSWORD VERIFIER ==========
+// The password is only kept as a salted memory-hard hash (see password_kdf.h):
+// a check hashes what was typed and compares the result. The verifier is
+// derived on first use with a fresh salt, and again after the cost changes.
+
+struct PasswordVerifier {
+    PasswordKdfParams params;
+    unsigned char hash[KDF_OUT_BYTES];
+    bool ready;
+};
+
+static pthread_mutex_t g_verifierLock = PTHREAD_MUTEX_INITIALIZER;
+static LockedRegion g_verifierRegion = {};                 // PasswordVerifier
+static uint32_t g_kdfMemoryKiB = KDF_DEFAULT_MEMORY_KIB;   // Guarded by g_verifierLock
+static uint32_t g_kdfPasses = KDF_DEFAULT_PASSES;
+
+/**
+ * Returns the verifier, deriving it first if needed (g_verifierLock held)
+ *
+ * @return NULL if memory ran out
+ */
+static PasswordVerifier *verifier_locked() {
+    if (!g_verifierRegion.ptr) {
+        if (!locked_alloc(&g_verifierRegion, sizeof(PasswordVerifier), LOCK_PRIO_CRITICAL,
+                          SECRET_CLASS_KEY)) {
+            return NULL;
         }
-        return JNI_FALSE;
+        memset(g_verifierRegion.ptr, 0, sizeof(PasswordVerifier));
     }
+    PasswordVerifier *verifier = (PasswordVerifier *) g_verifierRegion.ptr;
+    if (verifier->ready) return verifier;
+
+    // Salt: process-key keystream under a fresh nonce
+    memset(verifier->params.salt, 0, KDF_SALT_BYTES);
+    verifier->params.memoryKiB = g_kdfMemoryKiB;
+    verifier->params.passes = g_kdfPasses;
+    LockedRegion plain = {};
+    verifier->ready =
+            sealed_xor_keystream(verifier->params.salt, KDF_SALT_BYTES, sealed_next_nonce()) &&
+            decode_obfuscated(&plain, ENC_PASS, sizeof(ENC_PASS), XOR_KEY) &&
+            password_kdf(plain.ptr, sizeof(ENC_PASS), &verifier->params, NULL, verifier->hash);
+    locked_free(&plain);
+    return verifier->ready ? verifier : NULL;
+}
+
+/**
+ * Hashes a normalized password with the verifier's salt and cost
+ * Out of line so the stack it used can be scrubbed once it returns
+ */
+__attribute__((noinline)) static bool hash_password_impl(
+        const unsigned char *utf8, size_t len, const std::atomic<bool> *cancelled,
+        unsigned char *out) {
+
+    PasswordKdfParams params;
+    pthread_mutex_lock(&g_verifierLock);
+    PasswordVerifier *verifier = verifier_locked();
+    if (verifier) params = verifier->params;
+    pthread_mutex_unlock(&g_verifierLock);
+
+    return verifier && password_kdf(utf8, len, &params, cancelled, out);
+}
+
+/**
+ * hash_password_impl() plus stack scrubbing (also the speculation hash, see
+ * kdf_speculation.h)
+ */
+static bool hash_password(const unsigned char *utf8, size_t len,
+                          const std::atomic<bool> *cancelled, unsigned char *out) {
+    bool ok = hash_password_impl(utf8, len, cancelled, out);
+    stack_scrub(STACK_DEPTH_HASH_PASSWORD_IMPL);
+    return ok;
+}
+
+/**
+ * Compares a hash with the verifier in constant time
+ * A hash taken under an older salt or cost (setPasswordKdfCost() raced the
+ * check) simply does not match
+ */
+static bool password_matches(const unsigned char *hash) {
+    pthread_mutex_lock(&g_verifierLock);
+    PasswordVerifier *verifier = verifier_locked();
+    bool match = verifier && secure_equal(hash, verifier->hash, KDF_OUT_BYTES);
+    pthread_mutex_unlock(&g_verifierLock);
+    return match;
+}
+
+// ========== CREDENTIAL CHECKING FUNCTION ==========
+
+/**
+ * Checks the arguments of a credential call and clamps the lengths
+ * The lengths come from Java and may exceed the arrays (e.g. a stale
+ * length after the text was edited): never read or wipe past the end
+ */
+static bool clamp_credential_lengths(JNIEnv *env, jcharArray juser, jcharArray jpass,
+                                     jint *userLen, jint *passLen) {
+    if (!juser || !jpass || *userLen < 0 || *passLen < 0) return false;
+    jsize userArrayLen = env->GetArrayLength(juser);
+    jsize passArrayLen = env->GetArrayLength(jpass);
+    if (*userLen > userArrayLen) *userLen = userArrayLen;
+    if (*passLen > passArrayLen) *passLen = passArrayLen;
+    return true;
+}
+
+/**
+ * Compares UTF-16 credentials with the stored ones
+ * Shared by checkCredentials() and the worker pool; wipes everything it
+ * derives, the caller wipes the input. Out of line so the stack it used can
+ * be scrubbed once it returns
+ *
+ * @param cancelled Polled by the password hash (NULL = never); a cancelled
+ *                  check gives up early and does not match
+ */
+__attribute__((noinline)) static bool verify_credentials_impl(
+        const jchar *userChars, jint userLen, const jchar *passChars, jint passLen,
+        const std::atomic<bool> *cancelled, StatsScope &stats) {
 
-    // === STEP 3: CONVERT jchar TO unsigned char ===
-    // jchar is 16-bit (Unicode), but we need 8-bit for comparison
-    // Create temporary buffers for the comparison
-    unsigned char *userBytes = (unsigned char *) malloc(userLen);
-    unsigned char *passBytes = (unsigned char *) malloc(passLen);
+    // Nobody waits for the answer any more: skip the hash altogether
+    if (cancelled && cancelled->load(std::memory_order_relaxed)) return false;
 
-    if (!userBytes || !passBytes) {
+    // === STEP 2: CONVERT UTF-16 TO NORMALIZED UTF-8 ===
+    // jchar is UTF-16; credentials are compared as NFKC-normalized UTF-8 so every
+    // code point counts (no more narrowing to the low byte) and equivalent
+    // spellings (fullwidth, ligatures, precomposed vs combining) match
+    // Temporary buffers come from locked memory so plaintext can't be paged to disk
+    // (critical priority: credentials keep their lock when the budget runs low)
+    size_t maxLen = userLen > passLen ? userLen : passLen;
+    size_t userCap = credential_utf8_capacity(userLen);
+    size_t passCap = credential_utf8_capacity(passLen);
+    size_t scratchCap = credential_scratch_capacity(maxLen);
+    LockedRegion userRegion = {}, passRegion = {}, scratchRegion = {};
+    bool allocated = locked_alloc(&userRegion, userCap, LOCK_PRIO_CRITICAL) &&
+                     locked_alloc(&passRegion, passCap, LOCK_PRIO_CRITICAL) &&
+                     locked_alloc(&scratchRegion, scratchCap * sizeof(uint32_t), LOCK_PRIO_CRITICAL);
+
+    if (!allocated) {
+        stats.fail();
         // Cleanup on allocation failure
-        free(userBytes);
-        free(passBytes);
-        env->ReleaseCharArrayElements(juser, userChars, JNI_ABORT);
-        env->ReleaseCharArrayElements(jpass, passChars, JNI_ABORT);
-        if (locked_mem) {
-            secure_memzero(locked_mem, 1024);
-            free(locked_mem);
-        }
-        return JNI_FALSE;
+        locked_free(&userRegion);
+        locked_free(&passRegion);
+        locked_free(&scratchRegion);
+        return false;
     }
+    unsigned char *userBytes = (unsigned char *) userRegion.ptr;
+    unsigned char *passBytes = (unsigned char *) passRegion.ptr;
+
+    uint32_t *scratch = (uint32_t *) scratchRegion.ptr;
 
-    // Copy and convert jchar (16-bit) to unsigned char (8-bit)
-    // We only use the lower byte (assumes ASCII/Latin-1 characters)
-    for (int i = 0; i < userLen; i++) userBytes[i] = (unsigned char) userChars[i];
-    for (int i = 0; i < passLen; i++) passBytes[i] = (unsigned char) passChars[i];
+    // Transcode (SIMD on ASCII runs) and normalize; invalid UTF-16 never matches
+    long userBytesLen = credential_to_utf8(userChars, userLen, userBytes, userCap,
+                                           scratch, scratchCap);
+    long passBytesLen = credential_to_utf8(passChars, passLen, passBytes, passCap,
+                                           scratch, scratchCap);
+    locked_free(&scratchRegion);
 
-    // === STEP 4: DECRYPT STORED CREDENTIALS ===
-    // Decrypt the stored credentials for comparison
-    // Using stack arrays for automatic cleanup
-    unsigned char decryptedUser[sizeof(ENC_USER)];
-    unsigned char decryptedPass[sizeof(ENC_PASS)];
+    // === STEP 3: RECOMBINE THE STORED USER NAME ===
+    // The expected user name lives as two shares; recombine them (SIMD XOR)
+    // into locked scratch instead of the stack
+    pthread_once(&g_credentialsOnce, share_credentials);
+    LockedRegion expectedRegion = {};
+    const unsigned char *decryptedUser = NULL;
+    if (g_userShares && locked_alloc(&expectedRegion, sizeof(ENC_USER), LOCK_PRIO_CRITICAL)) {
+        shares_combine(g_userShares, expectedRegion.ptr, sizeof(ENC_USER));
+        decryptedUser = (const unsigned char *) expectedRegion.ptr;
+    }
+    if (!decryptedUser) stats.fail();
 
-    // Simple XOR decryption (in production, use proper authenticated encryption)
-    for (size_t i = 0; i < sizeof(ENC_USER); i++) decryptedUser[i] = ENC_USER[i] ^ XOR_KEY;
-    for (size_t i = 0; i < sizeof(ENC_PASS); i++) decryptedPass[i] = ENC_PASS[i] ^ XOR_KEY;
+    // === STEP 4: HASH THE PASSWORD ===
+    // Always hashed (even for a wrong user name) so the time taken says nothing;
+    // only a cancellation, which the caller asked for, cuts it short
+    unsigned char passHash[KDF_OUT_BYTES] = {};
+    bool hashed = passBytesLen >= 0 &&
+                  hash_password(passBytes, (size_t) passBytesLen, cancelled, passHash);
 
     // === STEP 5: COMPARE CREDENTIALS ===
-    // Use constant-time comparison to prevent timing attacks
     bool match = false;
-    if (userLen == sizeof(ENC_USER) && passLen == sizeof(ENC_PASS)) {
-        // memcmp is not constant-time! In production, use constant-time comparison
-        match = (memcmp(userBytes, decryptedUser, userLen) == 0) &&
-                (memcmp(passBytes, decryptedPass, passLen) == 0);
+    if (decryptedUser && userBytesLen == sizeof(ENC_USER)) {
+        match = secure_equal(userBytes, decryptedUser, sizeof(ENC_USER));
     }
+    match = password_matches(passHash) && hashed && match;
 
     // === STEP 6: SECURE CLEANUP - MOST IMPORTANT PART! ===
     // All sensitive data must be wiped before returning
 
-    // 6a: Wipe decrypted credentials from stack
-    secure_memzero(decryptedUser, sizeof(decryptedUser));
-    secure_memzero(decryptedPass, sizeof(decryptedPass));
+    // 6a: Wipe the recombined user name and the password hash
+    locked_free(&expectedRegion);
+    secure_memzero(passHash, sizeof(passHash));
+
+    // 6b: Wipe, unlock and free temporary buffers
+    locked_free(&userRegion);
+    locked_free(&passRegion);
+
+    return match;
+}
+
+/**
+ * Body of checkCredentials(), kept out of line so the stack it used can be
+ * scrubbed once it returns (its depth is measured at build time by name)
+ */
+__attribute__((noinline)) static jboolean check_credentials_impl(
+        JNIEnv *env, jcharArray juser, jcharArray jpass,
+        jint userLen, jint passLen, StatsScope &stats) {
+
+    // === STEP 1: GET JAVA ARRAY DATA ===
+    if (!clamp_credential_lengths(env, juser, jpass, &userLen, &passLen)) {
+        stats.fail();
+        return JNI_FALSE;
+    }
+
+    // Get direct pointers to Java char arrays (no copying if possible)
+    // isCopy tells us whether the VM had to duplicate the array (counted in stats)
+    jboolean userCopy = JNI_FALSE, passCopy = JNI_FALSE;
+    jchar *userChars = env->GetCharArrayElements(juser, &userCopy);
+    jchar *passChars = env->GetCharArrayElements(jpass, &passCopy);
+    stats_jni_copy(userCopy);
+    stats_jni_copy(passCopy);
+
+    // Check for allocation failures
+    if (!userChars || !passChars) {
+        stats.fail();
+        // Release arrays with JNI_ABORT: don't copy changes back
+        if (userChars) {
+            secure_memzero(userChars, userLen * sizeof(jchar));
+            env->ReleaseCharArrayElements(juser, userChars, JNI_ABORT);
+        }
+        if (passChars) {
+            secure_memzero(passChars, passLen * sizeof(jchar));
+            env->ReleaseCharArrayElements(jpass, passChars, JNI_ABORT);
+        }
+        return JNI_FALSE;
+    }
+
+    // Register the (possibly copied) array contents so a crash mid-call wipes them
+    SecretNode userNode, passNode;
+    secret_registry_add(&userNode, userChars, userLen * sizeof(jchar), SECRET_CLASS_PLAINTEXT);
+    secret_registry_add(&passNode, passChars, passLen * sizeof(jchar), SECRET_CLASS_PLAINTEXT);
 
-    // 6b: Wipe and free temporary buffers
-    secure_memzero(userBytes, userLen);
-    secure_memzero(passBytes, passLen);
-    free(userBytes);
-    free(passBytes);
+    bool match = verify_credentials_impl(userChars, userLen, passChars, passLen, NULL, stats);
 
-    // 6c: Wipe and release Java arrays
+    // === STEP 6c: WIPE AND RELEASE JAVA ARRAYS ===
     // JNI_ABORT: don't copy the zeros back to Java (we already wiped in Java)
     secure_memzero(userChars, userLen * sizeof(jchar));
     secure_memzero(passChars, passLen * sizeof(jchar));
+    secret_registry_remove(&userNode);
+    secret_registry_remove(&passNode);
     env->ReleaseCharArrayElements(juser, userChars, JNI_ABORT);
     env->ReleaseCharArrayElements(jpass, passChars, JNI_ABORT);
 
-    // 6d: Wipe and free locked memory
-    if (locked_mem) {
-        secure_memzero(locked_mem, 1024);
-        free(locked_mem);
-    }
-
     return match ? JNI_TRUE : JNI_FALSE;
 }
 
+/**
+ * JNI function to check user credentials
+ * Called from Java: NativeBridge.checkCredentials()
+ * Returns JNI_TRUE if credentials match, JNI_FALSE otherwise
+ *
+ * SECURITY NOTES:
+ * - Locks memory to prevent swapping to disk
+ * - Wipes all sensitive data after use
+ * - Minimizes data exposure time
+ * - Handles all error cases securely
+ * - Scrubs the stack the check used, spilled plaintext included
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_checkCredentials(
+        JNIEnv *env, jclass clazz,
+        jcharArray juser, jcharArray jpass,
+        jint userLen, jint passLen) {
+
+    StatsScope stats(STAT_EP_CHECK_CREDENTIALS);
+
+    jboolean result = check_credentials_impl(env, juser, jpass, userLen, passLen, stats);
+    stack_scrub(STACK_DEPTH_CHECK_CREDENTIALS_IMPL);
+    return result;
+}
+
 // ========== FLAG METHODS (SEPARATE IMPLEMENTATION) ==========
 
 // Encrypted flag stored in memory
@@ -166,6 +381,15 @@ static const unsigned char ENC_FLAG[] = {
 static const size_t FLAG_LEN = sizeof(ENC_FLAG);
 static const unsigned char FLAG_KEY = 0x5A;
 
+// The flag, sealed on first use
+static SealedSecret g_sealedFlag;
+static bool g_flagSealed = false;
+static pthread_once_t g_flagOnce = PTHREAD_ONCE_INIT;
+
+static void seal_flag() {
+    g_flagSealed = seal_obfuscated(&g_sealedFlag, ENC_FLAG, FLAG_LEN, FLAG_KEY);
+}
+
 /**
  * Get flag length for buffer allocation in Java
  * Allows Java to allocate correct buffer size before decryption
@@ -175,65 +399,56 @@ static const unsigned char FLAG_KEY = 0x5A;
 extern "C" JNIEXPORT jint JNICALL
 Java_com_example_fuzzme_1v3_NativeBridge_getFlagLength(
         JNIEnv *env, jclass clazz) {
+    StatsScope stats(STAT_EP_GET_FLAG_LENGTH);
+
     // Return as jint (Java int)
     return (jint) FLAG_LEN;
 }
 
 /**
- * Decrypt flag into EXISTING Java buffer
- * Java must allocate buffer with correct size first
- * Uses minimal temporary storage and wipes immediately
- *
- * @param jbuffer Java char array to receive decrypted flag
+ * Body of decryptFlagIntoBuffer(), out of line for stack scrubbing
+ * @return true if the flag was written to the buffer
  */
-extern "C" JNIEXPORT void JNICALL
-Java_com_example_fuzzme_1v3_NativeBridge_decryptFlagIntoBuffer(
-        JNIEnv *env, jclass clazz, jcharArray jbuffer) {
+__attribute__((noinline)) static bool decrypt_flag_impl(
+        JNIEnv *env, jcharArray jbuffer, StatsScope &stats) {
 
     // Null check
     if (!jbuffer) {
         // In production, throw exception
-        return;
+        stats.fail();
+        return false;
     }
 
     // Get direct pointer to Java array
-    jchar *buffer = env->GetCharArrayElements(jbuffer, NULL);
+    jboolean isCopy = JNI_FALSE;
+    jchar *buffer = env->GetCharArrayElements(jbuffer, &isCopy);
     if (!buffer) {
-        return;
+        stats.fail();
+        return false;
     }
+    stats_jni_copy(isCopy);
 
     // Check buffer size
     jsize bufferSize = env->GetArrayLength(jbuffer);
     if (bufferSize < FLAG_LEN) {
         // Buffer too small - abort without copying
+        stats.fail();
         env->ReleaseCharArrayElements(jbuffer, buffer, JNI_ABORT);
-        return;
+        return false;
     }
 
-    // === LOCK MEMORY FOR SENSITIVE OPERATION ===
-    void *lockedMem = malloc(1024);
-    if (lockedMem) {
-        mlock(lockedMem, 1024);  // Prevent swapping
-    }
-
-    // === CREATE TEMPORARY DECRYPTION BUFFER ===
-    // Decrypt into temporary buffer first, then copy to Java
+    // === UNSEAL INTO LOCKED SCRATCH ===
+    // Decrypt into a locked scratch slot first, then copy to Java
     // This prevents exposing decrypted data in Java buffer if decryption fails
-    char *tempDecrypt = (char *) malloc(FLAG_LEN);
+    pthread_once(&g_flagOnce, seal_flag);
+    SealedSlot *slot = NULL;
+    const char *tempDecrypt = g_flagSealed
+                              ? (const char *) sealed_unseal(&g_sealedFlag, &slot) : NULL;
     if (!tempDecrypt) {
-        // Cleanup on allocation failure
-        if (lockedMem) {
-            munlock(lockedMem, 1024);
-            free(lockedMem);
-        }
+        // Cleanup on failure
+        stats.fail();
         env->ReleaseCharArrayElements(jbuffer, buffer, JNI_ABORT);
-        return;
-    }
-
-    // === PERFORM DECRYPTION ===
-    // XOR decryption (simple example - use proper encryption in production)
-    for (size_t i = 0; i < FLAG_LEN; i++) {
-        tempDecrypt[i] = ENC_FLAG[i] ^ FLAG_KEY;
+        return false;
     }
 
     // === COPY TO JAVA BUFFER ===
@@ -244,20 +459,31 @@ Java_com_example_fuzzme_1v3_NativeBridge_decryptFlagIntoBuffer(
 
     // === CRITICAL: IMMEDIATELY WIPE TEMPORARY BUFFER ===
     // The decrypted flag should exist in memory for minimal time
-    secure_memzero(tempDecrypt, FLAG_LEN);
-    free(tempDecrypt);
-
-    // === CLEANUP LOCKED MEMORY ===
-    if (lockedMem) {
-        secure_memzero(lockedMem, 1024);
-        munlock(lockedMem, 1024);  // Unlock before freeing
-        free(lockedMem);
-    }
+    // sealed_reseal wipes the slot before recycling it
+    sealed_reseal(slot);
 
     // === RELEASE JAVA ARRAY ===
     // Mode 0: copy changes back to Java
     // The decrypted flag is now in the Java buffer
     env->ReleaseCharArrayElements(jbuffer, buffer, 0);
+    return true;
+}
+
+/**
+ * Decrypt flag into EXISTING Java buffer
+ * Java must allocate buffer with correct size first
+ * Uses minimal temporary storage and wipes immediately
+ *
+ * @param jbuffer Java char array to receive decrypted flag
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_decryptFlagIntoBuffer(
+        JNIEnv *env, jclass clazz, jcharArray jbuffer) {
+
+    StatsScope stats(STAT_EP_DECRYPT_FLAG);
+
+    decrypt_flag_impl(env, jbuffer, stats);
+    stack_scrub(STACK_DEPTH_DECRYPT_FLAG_IMPL);
 }
 
 /**
@@ -270,11 +496,21 @@ extern "C" JNIEXPORT void JNICALL
 Java_com_example_fuzzme_1v3_NativeBridge_wipeFlagBuffer(
         JNIEnv *env, jclass clazz, jcharArray jbuffer) {
 
-    if (!jbuffer) return;
+    StatsScope stats(STAT_EP_WIPE_FLAG);
+
+    if (!jbuffer) {
+        stats.fail();
+        return;
+    }
 
     // Get direct pointer to Java array
-    jchar *buffer = env->GetCharArrayElements(jbuffer, NULL);
-    if (!buffer) return;
+    jboolean isCopy = JNI_FALSE;
+    jchar *buffer = env->GetCharArrayElements(jbuffer, &isCopy);
+    if (!buffer) {
+        stats.fail();
+        return;
+    }
+    stats_jni_copy(isCopy);
 
     // Get array length
     jsize length = env->GetArrayLength(jbuffer);
@@ -286,4 +522,1306 @@ Java_com_example_fuzzme_1v3_NativeBridge_wipeFlagBuffer(
     // Release with JNI_ABORT: don't copy zeros back to Java
     // Java already wiped its copy, we just wiped the native copy
     env->ReleaseCharArrayElements(jbuffer, buffer, JNI_ABORT);
-}
\ No newline at end of file
+}
+
+// ========== ASYNC REQUESTS ==========
+// Worker-pool versions of checkCredentials() and decryptFlagIntoBuffer()
+// (see worker_pool.h). The work is counted under the synchronous entry
+// point; the submit calls only measure the hand-off.
+
+/**
+ * Second-factor code submitted with a login, read at submit (see SECOND
+ * FACTOR below)
+ */
+struct LoginCode {
+    LockedRegion text;      // UTF-8 as typed
+    long len;               // -1: none given, or unreadable
+};
+
+static void login_code_read(JNIEnv *env, jlong codeStream, jcharArray jcode, jint codeLen,
+                            LoginCode *code);
+static bool login_code_passes(const LoginCode *code);
+
+struct CredentialRequest {
+    LockedRegion chars;     // User then password, copied out of Java at submit
+    jint userLen;
+    jint passLen;
+    LoginCode code;
+};
+
+static bool run_check_credentials(JNIEnv *env, void *state, const std::atomic<bool> *cancelled) {
+    CredentialRequest *req = (CredentialRequest *) state;
+    StatsScope stats(STAT_EP_CHECK_CREDENTIALS);
+
+    const jchar *chars = (const jchar *) req->chars.ptr;
+    bool match = verify_credentials_impl(chars, req->userLen, chars + req->userLen,
+                                         req->passLen, cancelled, stats);
+    stack_scrub(STACK_DEPTH_VERIFY_CREDENTIALS_IMPL);
+    // Tried (and used up) whatever the credentials gave: one result for both
+    bool codeOk = login_code_passes(&req->code);
+    stack_scrub(STACK_DEPTH_VERIFY_OTP_IMPL);
+    return match && codeOk;
+}
+
+static void cleanup_check_credentials(JNIEnv *env, void *state, bool cancelled) {
+    CredentialRequest *req = (CredentialRequest *) state;
+    locked_free(&req->chars);
+    locked_free(&req->code.text);
+    free(req);
+}
+
+/**
+ * Queues a login check on the worker pool: the credentials, and the
+ * second-factor code once a seed is enrolled. A single result covers both,
+ * so a wrong code looks like a wrong password
+ * The characters are copied into locked memory before this returns, so Java
+ * can wipe its arrays (and clear a streamed code field) right away
+ *
+ * @param codeStream Keystroke stream of the code field, 0 to use jcode
+ * @param jcode      Code as typed (NULL if streamed, or not asked for)
+ * @param jcallback  NativeBridge.ResultCallback, called on a worker thread
+ * @return Request handle for cancelRequest(), 0 on failure (no callback)
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_submitCheckCredentials(
+        JNIEnv *env, jclass clazz,
+        jcharArray juser, jcharArray jpass,
+        jint userLen, jint passLen,
+        jlong codeStream, jcharArray jcode, jint codeLen, jobject jcallback) {
+
+    StatsScope stats(STAT_EP_SUBMIT_CHECK_CREDENTIALS);
+
+    if (!jcallback || !clamp_credential_lengths(env, juser, jpass, &userLen, &passLen)) {
+        stats.fail();
+        return 0;
+    }
+
+    CredentialRequest *req = (CredentialRequest *) calloc(1, sizeof(CredentialRequest));
+    size_t bytes = ((size_t) userLen + passLen) * sizeof(jchar);
+    if (!req || !locked_alloc(&req->chars, bytes ? bytes : 1, LOCK_PRIO_CRITICAL)) {
+        stats.fail();
+        free(req);
+        return 0;
+    }
+    req->userLen = userLen;
+    req->passLen = passLen;
+
+    // Straight into locked memory: no VM copy of the elements to wipe
+    jchar *chars = (jchar *) req->chars.ptr;
+    env->GetCharArrayRegion(juser, 0, userLen, chars);
+    env->GetCharArrayRegion(jpass, 0, passLen, chars + userLen);
+    login_code_read(env, codeStream, jcode, codeLen, &req->code);
+
+    uint64_t handle = worker_submit(env, jcallback, run_check_credentials,
+                                    cleanup_check_credentials, req);
+    if (!handle) stats.fail();
+    return (jlong) handle;
+}
+
+struct FlagRequest {
+    jcharArray buffer;      // Global reference
+};
+
+static bool run_decrypt_flag(JNIEnv *env, void *state, const std::atomic<bool> *cancelled) {
+    FlagRequest *req = (FlagRequest *) state;
+    StatsScope stats(STAT_EP_DECRYPT_FLAG);
+
+    if (!env) {
+        stats.fail();
+        return false;
+    }
+    bool ok = decrypt_flag_impl(env, req->buffer, stats);
+    stack_scrub(STACK_DEPTH_DECRYPT_FLAG_IMPL);
+    return ok;
+}
+
+static void cleanup_decrypt_flag(JNIEnv *env, void *state, bool cancelled) {
+    FlagRequest *req = (FlagRequest *) state;
+    if (env) {
+        // Cancelled after the flag may have been written: nobody will show it
+        if (cancelled) jni_wipe_char_array(env, req->buffer);
+        env->DeleteGlobalRef(req->buffer);
+    }
+    free(req);
+}
+
+/**
+ * Queues decryptFlagIntoBuffer() on the worker pool
+ * Java must not read the buffer before the callback reports success
+ *
+ * @param jcallback NativeBridge.ResultCallback, called on a worker thread
+ * @return Request handle for cancelRequest(), 0 on failure (no callback)
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_submitDecryptFlag(
+        JNIEnv *env, jclass clazz, jcharArray jbuffer, jobject jcallback) {
+
+    StatsScope stats(STAT_EP_SUBMIT_DECRYPT_FLAG);
+
+    if (!jbuffer || !jcallback) {
+        stats.fail();
+        return 0;
+    }
+    FlagRequest *req = (FlagRequest *) calloc(1, sizeof(FlagRequest));
+    if (!req) {
+        stats.fail();
+        return 0;
+    }
+    req->buffer = (jcharArray) env->NewGlobalRef(jbuffer);
+    if (!req->buffer) {
+        stats.fail();
+        free(req);
+        return 0;
+    }
+
+    uint64_t handle = worker_submit(env, jcallback, run_decrypt_flag, cleanup_decrypt_flag, req);
+    if (!handle) stats.fail();
+    return (jlong) handle;
+}
+
+/**
+ * Cancels a submitted request
+ * Waits if it is running right now; on return its intermediate state (and,
+ * for a decrypt, the target buffer) has been wiped
+ *
+ * @return true if cancelled (no callback will come), false if it already finished
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_cancelRequest(
+        JNIEnv *env, jclass clazz, jlong handle) {
+
+    StatsScope stats(STAT_EP_CANCEL_REQUEST);
+
+    return worker_cancel(env, (uint64_t) handle) ? JNI_TRUE : JNI_FALSE;
+}
+
+// ========== KEYSTROKE STREAMS ==========
+// SecureEditText sends each edit here as it is typed (see keystroke_stream.h)
+// instead of keeping the characters in a Java array. All of these are
+// called on the UI thread. Every edit cancels a speculative hash of the
+// stream it changes.
+
+/**
+ * Opens a stream for one text field
+ *
+ * @return Stream handle, 0 if none is available (keep the text in Java then)
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_openKeystrokeStream(
+        JNIEnv *env, jclass clazz) {
+
+    StatsScope stats(STAT_EP_OPEN_KEYSTROKE_STREAM);
+
+    uint64_t handle = keystroke_open();
+    if (!handle) stats.fail();
+    return (jlong) handle;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_appendKeystroke(
+        JNIEnv *env, jclass clazz, jlong stream, jchar unit) {
+
+    StatsScope stats(STAT_EP_APPEND_KEYSTROKE);
+
+    speculation_invalidate((uint64_t) stream);
+    if (!keystroke_append((uint64_t) stream, unit)) {
+        stats.fail();
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+/**
+ * Removes the last count characters of a stream
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_deleteKeystrokes(
+        JNIEnv *env, jclass clazz, jlong stream, jint count) {
+
+    StatsScope stats(STAT_EP_DELETE_KEYSTROKES);
+
+    speculation_invalidate((uint64_t) stream);
+    if (count < 0 || !keystroke_delete((uint64_t) stream, (uint32_t) count)) {
+        stats.fail();
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_clearKeystrokes(
+        JNIEnv *env, jclass clazz, jlong stream) {
+
+    StatsScope stats(STAT_EP_CLEAR_KEYSTROKES);
+
+    speculation_invalidate((uint64_t) stream);
+    if (!keystroke_clear((uint64_t) stream)) {
+        stats.fail();
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_closeKeystrokeStream(
+        JNIEnv *env, jclass clazz, jlong stream) {
+
+    StatsScope stats(STAT_EP_CLOSE_KEYSTROKE_STREAM);
+
+    speculation_invalidate((uint64_t) stream);
+    keystroke_close((uint64_t) stream);
+}
+
+/**
+ * Asks for the password to be hashed ahead of the check (focus left the
+ * field, or typing paused): hashes a snapshot of the stream in the
+ * background, so Login only has to collect the result (see kdf_speculation.h)
+ * Out of line so the stack that held the snapshot can be scrubbed
+ */
+__attribute__((noinline)) static bool speculate_keystrokes_impl(uint64_t stream,
+                                                                StatsScope &stats) {
+    size_t cap = keystroke_utf8_capacity();
+    LockedRegion textRegion = {};
+    if (!locked_alloc(&textRegion, cap, LOCK_PRIO_CRITICAL)) {
+        stats.fail();
+        return false;
+    }
+    unsigned char *text = (unsigned char *) textRegion.ptr;
+    long len = keystroke_utf8(stream, text, cap);
+    bool started = len >= 0 &&
+                   speculation_start(stream, keystroke_version(stream), text, (size_t) len,
+                                     hash_password);
+    locked_free(&textRegion);
+    if (!started) stats.fail();
+    return started;
+}
+
+/**
+ * Starts hashing a password stream in the background
+ * Any later edit of the stream cancels and wipes the hash
+ *
+ * @return false on a stale handle, an invalid stream or no memory
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_speculateKeystrokes(
+        JNIEnv *env, jclass clazz, jlong stream) {
+
+    StatsScope stats(STAT_EP_SPECULATE_KEYSTROKES);
+
+    bool started = speculate_keystrokes_impl((uint64_t) stream, stats);
+    stack_scrub(STACK_DEPTH_SPECULATE_KEYSTROKES_IMPL);
+    return started ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * A streamed check, split so the slow half can run on a worker thread:
+ * the streams are read on the UI thread (their producer), the password
+ * hash is taken or collected wherever the check finishes
+ */
+struct StreamedCheck {
+    LockedRegion secrets;   // User digest, then the password's normalized UTF-8
+    long passLen;           // -1: the password stream is invalid
+    bool userOk;            // User digest taken
+    uint64_t ticket;        // Adopted speculation (0: hash when finishing)
+    LoginCode code;         // Submitted checks only
+};
+
+/**
+ * Reads both streams into a check (UI thread)
+ * Adopts the password's speculation if nothing was typed since it started.
+ * Out of line so the stack it used can be scrubbed once it returns
+ *
+ * @return false if memory ran out
+ */
+__attribute__((noinline)) static bool prepare_streamed_check_impl(
+        uint64_t userStream, uint64_t passStream, StreamedCheck *check, StatsScope &stats) {
+
+    size_t cap = keystroke_utf8_capacity();
+    if (!locked_alloc(&check->secrets, BLAKE2S_OUT_BYTES + cap, LOCK_PRIO_CRITICAL)) {
+        stats.fail();
+        return false;
+    }
+    unsigned char *secrets = (unsigned char *) check->secrets.ptr;
+    check->userOk = keystroke_digest(userStream, secrets);
+    check->passLen = keystroke_utf8(passStream, secrets + BLAKE2S_OUT_BYTES, cap);
+    check->ticket = check->passLen >= 0
+                    ? speculation_adopt(passStream, keystroke_version(passStream)) : 0;
+    return true;
+}
+
+/**
+ * Compares a prepared check with the stored credentials
+ * The user name is compared as keyed BLAKE2s digests (the typed text was
+ * absorbed as it arrived); the password hash comes from the adopted
+ * speculation, or is computed here. Everything derived stays in locked memory
+ *
+ * @param cancelled Polled by the password hash (NULL = never)
+ */
+__attribute__((noinline)) static bool verify_streamed_credentials_impl(
+        StreamedCheck *check, const std::atomic<bool> *cancelled, StatsScope &stats) {
+
+    // Expected user name, its digest, then the password hash
+    LockedRegion workRegion = {};
+    if (!locked_alloc(&workRegion, sizeof(ENC_USER) + BLAKE2S_OUT_BYTES + KDF_OUT_BYTES,
+                      LOCK_PRIO_CRITICAL)) {
+        stats.fail();
+        return false;
+    }
+    unsigned char *expected = (unsigned char *) workRegion.ptr;
+    unsigned char *expectedDigest = expected + sizeof(ENC_USER);
+    unsigned char *passHash = expectedDigest + BLAKE2S_OUT_BYTES;
+    const unsigned char *secrets = (const unsigned char *) check->secrets.ptr;
+
+    pthread_once(&g_credentialsOnce, share_credentials);
+    bool userOk = check->userOk && g_userShares &&
+                  shares_combine(g_userShares, expected, sizeof(ENC_USER)) &&
+                  keystroke_digest_bytes(expected, sizeof(ENC_USER), expectedDigest);
+    if (check->userOk && !userOk) stats.fail();
+
+    // A collected speculation is the hash of exactly the text read at prepare.
+    // wipeAllSecrets() cancels speculations before requests, so a failed
+    // collect may mean this check is being cancelled too: don't start over then
+    bool hashed = false;
+    if (check->ticket) {
+        hashed = speculation_collect(check->ticket, passHash);
+        check->ticket = 0;
+    }
+    bool abandoned = cancelled && cancelled->load(std::memory_order_relaxed);
+    if (!hashed && !abandoned && check->passLen >= 0) {
+        hashed = hash_password(secrets + BLAKE2S_OUT_BYTES, (size_t) check->passLen,
+                               cancelled, passHash);
+    }
+
+    // Fixed-length digests, compared without an early exit
+    bool userMatch = secure_equal(secrets, expectedDigest, BLAKE2S_OUT_BYTES);
+    bool match = password_matches(passHash) && hashed && userOk && userMatch;
+
+    locked_free(&workRegion);
+    return match;
+}
+
+/**
+ * Wipes a check; an adopted speculation that was never collected is dropped
+ */
+static void release_streamed_check(StreamedCheck *check) {
+    speculation_drop(check->ticket);
+    check->ticket = 0;
+    locked_free(&check->secrets);
+    locked_free(&check->code.text);
+}
+
+/**
+ * checkCredentials() for streamed fields
+ * Waits for the absorber to apply everything typed so far; a stream that
+ * lost its text (emergency wipe, too long, invalid UTF-16) never matches
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_checkStreamedCredentials(
+        JNIEnv *env, jclass clazz, jlong userStream, jlong passStream) {
+
+    StatsScope stats(STAT_EP_CHECK_STREAMED_CREDENTIALS);
+
+    StreamedCheck check = {};
+    bool prepared = prepare_streamed_check_impl((uint64_t) userStream, (uint64_t) passStream,
+                                                &check, stats);
+    stack_scrub(STACK_DEPTH_PREPARE_STREAMED_CHECK_IMPL);
+
+    bool match = prepared && verify_streamed_credentials_impl(&check, NULL, stats);
+    stack_scrub(STACK_DEPTH_VERIFY_STREAMED_CREDENTIALS_IMPL);
+    release_streamed_check(&check);
+    return match ? JNI_TRUE : JNI_FALSE;
+}
+
+static bool run_check_streamed_credentials(JNIEnv *env, void *state,
+                                           const std::atomic<bool> *cancelled) {
+    StreamedCheck *check = (StreamedCheck *) state;
+    StatsScope stats(STAT_EP_CHECK_STREAMED_CREDENTIALS);
+
+    bool match = verify_streamed_credentials_impl(check, cancelled, stats);
+    stack_scrub(STACK_DEPTH_VERIFY_STREAMED_CREDENTIALS_IMPL);
+    bool codeOk = login_code_passes(&check->code);
+    stack_scrub(STACK_DEPTH_VERIFY_OTP_IMPL);
+    return match && codeOk;
+}
+
+static void cleanup_check_streamed_credentials(JNIEnv *env, void *state, bool cancelled) {
+    StreamedCheck *check = (StreamedCheck *) state;
+    release_streamed_check(check);
+    free(check);
+}
+
+/**
+ * Queues checkStreamedCredentials() on the worker pool, with the code as in
+ * submitCheckCredentials()
+ * The streams are read before this returns (later edits don't affect the
+ * check); hashing, or waiting for the speculative hash, happens on a worker
+ *
+ * @param jcallback NativeBridge.ResultCallback, called on a worker thread
+ * @return Request handle for cancelRequest(), 0 on failure (no callback)
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_submitCheckStreamedCredentials(
+        JNIEnv *env, jclass clazz, jlong userStream, jlong passStream,
+        jlong codeStream, jcharArray jcode, jint codeLen, jobject jcallback) {
+
+    StatsScope stats(STAT_EP_SUBMIT_CHECK_STREAMED_CREDENTIALS);
+
+    StreamedCheck *check = jcallback ? (StreamedCheck *) calloc(1, sizeof(StreamedCheck)) : NULL;
+    if (!check) {
+        stats.fail();
+        return 0;
+    }
+    bool prepared = prepare_streamed_check_impl((uint64_t) userStream, (uint64_t) passStream,
+                                                check, stats);
+    stack_scrub(STACK_DEPTH_PREPARE_STREAMED_CHECK_IMPL);
+    if (!prepared) {
+        free(check);
+        return 0;
+    }
+    login_code_read(env, codeStream, jcode, codeLen, &check->code);
+
+    uint64_t handle = worker_submit(env, jcallback, run_check_streamed_credentials,
+                                    cleanup_check_streamed_credentials, check);
+    if (!handle) stats.fail();
+    return (jlong) handle;
+}
+
+// ========== PASSWORD KDF COST ==========
+
+/**
+ * Sets the cost of the password hash
+ * The verifier is derived again (fresh salt) on the next check; speculative
+ * hashes taken under the old cost are cancelled
+ *
+ * @param memoryKiB Memory per hash, KDF_MIN_MEMORY_KIB to KDF_MAX_MEMORY_KIB
+ * @param passes    Mixing passes, 1 to KDF_MAX_PASSES
+ * @return false on invalid arguments
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_setPasswordKdfCost(
+        JNIEnv *env, jclass clazz, jint memoryKiB, jint passes) {
+
+    StatsScope stats(STAT_EP_SET_PASSWORD_KDF_COST);
+
+    if (memoryKiB < (jint) KDF_MIN_MEMORY_KIB || memoryKiB > (jint) KDF_MAX_MEMORY_KIB ||
+        passes < 1 || passes > (jint) KDF_MAX_PASSES) {
+        stats.fail();
+        return JNI_FALSE;
+    }
+
+    pthread_mutex_lock(&g_verifierLock);
+    g_kdfMemoryKiB = (uint32_t) memoryKiB;
+    g_kdfPasses = (uint32_t) passes;
+    if (g_verifierRegion.ptr) secure_memzero(g_verifierRegion.ptr, sizeof(PasswordVerifier));
+    pthread_mutex_unlock(&g_verifierLock);
+
+    speculation_cancel_all();
+    return JNI_TRUE;
+}
+
+// ========== BREACHED PASSWORDS ==========
+// Offline lookups in a filter of breached-password hashes (see
+// breach_filter.h). Corpora hash passwords exactly as typed, so these use
+// plain UTF-8 instead of the normalized form credentials are compared in.
+
+/**
+ * Maps a breach filter file built by tools/build_breach_filter
+ *
+ * @return Passwords in the filter, -1 if the file is missing or malformed
+ *         (a filter loaded earlier stays in use)
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_loadBreachFilter(
+        JNIEnv *env, jclass clazz, jstring jpath) {
+
+    StatsScope stats(STAT_EP_LOAD_BREACH_FILTER);
+
+    const char *path = jpath ? env->GetStringUTFChars(jpath, NULL) : NULL;
+    if (!path) {
+        stats.fail();
+        return -1;
+    }
+    long long keys = breach_filter_open(path);
+    env->ReleaseStringUTFChars(jpath, path);
+    if (keys < 0) stats.fail();
+    return (jlong) keys;
+}
+
+/**
+ * Looks up UTF-16 text in the breach filter, by way of locked scratch
+ *
+ * @return 1 breached, 0 not found, -1 no filter or not valid UTF-16
+ */
+static jint breached_utf16(const jchar *chars, size_t len, StatsScope &stats) {
+    size_t cap = credential_utf8_capacity(len);
+    LockedRegion utf8Region = {};
+    if (!locked_alloc(&utf8Region, cap ? cap : 1, LOCK_PRIO_CRITICAL)) {
+        stats.fail();
+        return -1;
+    }
+    long utf8Len = utf16_to_utf8(chars, len, (unsigned char *) utf8Region.ptr, cap);
+    int found = utf8Len >= 0 ? breach_filter_contains(utf8Region.ptr, (size_t) utf8Len) : -1;
+    locked_free(&utf8Region);
+    if (found < 0) stats.fail();
+    return found;
+}
+
+/**
+ * Body of checkPasswordBreached(), out of line so the stack it used can be
+ * scrubbed once it returns
+ */
+__attribute__((noinline)) static jint password_breached_impl(
+        JNIEnv *env, jcharArray jpass, jint passLen, StatsScope &stats) {
+
+    if (!jpass || passLen < 0) {
+        stats.fail();
+        return -1;
+    }
+    jsize arrayLen = env->GetArrayLength(jpass);
+    if (passLen > arrayLen) passLen = arrayLen;
+
+    // Straight into locked memory: no VM copy of the elements to wipe
+    LockedRegion charsRegion = {};
+    size_t bytes = (size_t) passLen * sizeof(jchar);
+    if (!locked_alloc(&charsRegion, bytes ? bytes : 1, LOCK_PRIO_CRITICAL)) {
+        stats.fail();
+        return -1;
+    }
+    jchar *chars = (jchar *) charsRegion.ptr;
+    env->GetCharArrayRegion(jpass, 0, passLen, chars);
+    jint found = breached_utf16(chars, (size_t) passLen, stats);
+    locked_free(&charsRegion);
+    return found;
+}
+
+/**
+ * Checks a password against the breach filter
+ * The caller still owns (and wipes) the array
+ *
+ * @return 1 if the password is in the corpus (false positives: 2^-16 with
+ *         the builder's defaults), 0 if not, -1 if no filter is loaded or
+ *         the text is not valid UTF-16
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_checkPasswordBreached(
+        JNIEnv *env, jclass clazz, jcharArray jpass, jint passLen) {
+
+    StatsScope stats(STAT_EP_CHECK_PASSWORD_BREACHED);
+
+    jint found = password_breached_impl(env, jpass, passLen, stats);
+    stack_scrub(STACK_DEPTH_PASSWORD_BREACHED_IMPL);
+    return found;
+}
+
+/**
+ * Body of checkKeystrokesBreached(), scrubbed like password_breached_impl()
+ */
+__attribute__((noinline)) static jint keystrokes_breached_impl(uint64_t stream,
+                                                               StatsScope &stats) {
+    size_t cap = keystroke_utf8_capacity();
+    LockedRegion utf8Region = {};
+    if (!locked_alloc(&utf8Region, cap, LOCK_PRIO_CRITICAL)) {
+        stats.fail();
+        return -1;
+    }
+    long len = keystroke_utf8_raw(stream, (unsigned char *) utf8Region.ptr, cap);
+    int found = len >= 0 ? breach_filter_contains(utf8Region.ptr, (size_t) len) : -1;
+    locked_free(&utf8Region);
+    if (found < 0) stats.fail();
+    return found;
+}
+
+/**
+ * checkPasswordBreached() for a streamed field (UI thread)
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_checkKeystrokesBreached(
+        JNIEnv *env, jclass clazz, jlong stream) {
+
+    StatsScope stats(STAT_EP_CHECK_KEYSTROKES_BREACHED);
+
+    jint found = keystrokes_breached_impl((uint64_t) stream, stats);
+    stack_scrub(STACK_DEPTH_KEYSTROKES_BREACHED_IMPL);
+    return found;
+}
+
+// ========== PASSWORD STRENGTH ==========
+
+/**
+ * Maps the strength estimator's dictionaries (see strength_dict.h)
+ *
+ * @param jpath File built by tools/build_strength_dict
+ * @return Words in it, -1 if it could not be loaded (the current
+ *         dictionaries then stay)
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_loadStrengthDictionary(
+        JNIEnv *env, jclass clazz, jstring jpath) {
+
+    StatsScope stats(STAT_EP_LOAD_STRENGTH_DICTIONARY);
+
+    const char *path = jpath ? env->GetStringUTFChars(jpath, NULL) : NULL;
+    if (!path) {
+        stats.fail();
+        return -1;
+    }
+    long long words = strength_dict_open(path);
+    env->ReleaseStringUTFChars(jpath, path);
+    if (words < 0) stats.fail();
+    return (jlong) words;
+}
+
+/**
+ * Packs an estimate for Java (see NativeBridge.strengthScore() and friends):
+ * score in bits 0-2, feedback in bits 3-7, log10(guesses) * 100 above
+ */
+static jint pack_strength(const StrengthEstimate &estimate) {
+    double centi = estimate.log10Guesses * 100;
+    jint packedGuesses = centi < 0 ? 0 : centi > 0x7FFFFF ? 0x7FFFFF : (jint) centi;
+    return (jint) estimate.score | ((jint) estimate.feedback << 3) | (packedGuesses << 8);
+}
+
+/**
+ * Copies the first len chars of a Java array into locked memory as UTF-8
+ *
+ * @param out Receives the region (to locked_free()) on success
+ * @return UTF-8 length, -1 if out of memory or not valid UTF-16
+ */
+static long chars_to_locked_utf8(JNIEnv *env, jcharArray array, jint len, LockedRegion *out) {
+    jsize arrayLen = env->GetArrayLength(array);
+    if (len > arrayLen) len = arrayLen;
+
+    // Straight into locked memory: no VM copy of the elements to wipe
+    LockedRegion charsRegion = {};
+    size_t bytes = (size_t) len * sizeof(jchar);
+    if (!locked_alloc(&charsRegion, bytes ? bytes : 1, LOCK_PRIO_CRITICAL)) return -1;
+    jchar *chars = (jchar *) charsRegion.ptr;
+    env->GetCharArrayRegion(array, 0, len, chars);
+
+    size_t cap = credential_utf8_capacity((size_t) len);
+    long utf8Len = -1;
+    if (locked_alloc(out, cap ? cap : 1, LOCK_PRIO_CRITICAL)) {
+        utf8Len = utf16_to_utf8(chars, (size_t) len, (unsigned char *) out->ptr, cap);
+        if (utf8Len < 0) locked_free(out);
+    }
+    locked_free(&charsRegion);
+    return utf8Len;
+}
+
+/**
+ * Body of estimatePasswordStrength(), out of line so the stack it used can
+ * be scrubbed once it returns
+ */
+__attribute__((noinline)) static jint password_strength_impl(
+        JNIEnv *env, jcharArray jpass, jint passLen, jcharArray juser, jint userLen,
+        StatsScope &stats) {
+
+    if (!jpass || passLen < 0 || (juser && userLen < 0)) {
+        stats.fail();
+        return -1;
+    }
+    LockedRegion passRegion = {}, userRegion = {};
+    long passUtf8 = chars_to_locked_utf8(env, jpass, passLen, &passRegion);
+    if (passUtf8 < 0) {
+        stats.fail();
+        return -1;
+    }
+    long userUtf8 = juser ? chars_to_locked_utf8(env, juser, userLen, &userRegion) : -1;
+
+    StrengthEstimate estimate;
+    bool ok = strength_estimate((const unsigned char *) passRegion.ptr, (size_t) passUtf8,
+                                userUtf8 > 0 ? (const unsigned char *) userRegion.ptr : NULL,
+                                userUtf8 > 0 ? (size_t) userUtf8 : 0, &estimate);
+    locked_free(&passRegion);
+    if (userUtf8 >= 0) locked_free(&userRegion);
+    if (!ok) {
+        stats.fail();
+        return -1;
+    }
+    return pack_strength(estimate);
+}
+
+/**
+ * Estimates how hard a password is to guess (cheap enough for every keystroke)
+ * The caller still owns (and wipes) the arrays
+ *
+ * @param juser   The user name, matched as part of the password (may be null)
+ * @return Packed estimate (see pack_strength()), -1 on failure or text that
+ *         is not valid UTF-16
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_estimatePasswordStrength(
+        JNIEnv *env, jclass clazz, jcharArray jpass, jint passLen, jcharArray juser,
+        jint userLen) {
+
+    StatsScope stats(STAT_EP_ESTIMATE_PASSWORD_STRENGTH);
+
+    jint packed = password_strength_impl(env, jpass, passLen, juser, userLen, stats);
+    stack_scrub(STACK_DEPTH_PASSWORD_STRENGTH_IMPL);
+    return packed;
+}
+
+/**
+ * Body of estimateKeystrokesStrength(), scrubbed like password_strength_impl()
+ */
+__attribute__((noinline)) static jint keystrokes_strength_impl(uint64_t passStream,
+                                                               uint64_t userStream,
+                                                               StatsScope &stats) {
+    size_t cap = keystroke_utf8_capacity();
+    LockedRegion utf8Region = {};
+    if (!locked_alloc(&utf8Region, 2 * cap, LOCK_PRIO_CRITICAL)) {
+        stats.fail();
+        return -1;
+    }
+    unsigned char *pass = (unsigned char *) utf8Region.ptr;
+    unsigned char *user = pass + cap;
+    long passLen = keystroke_utf8_raw(passStream, pass, cap);
+    long userLen = userStream ? keystroke_utf8_raw(userStream, user, cap) : -1;
+
+    StrengthEstimate estimate;
+    bool ok = passLen >= 0 &&
+              strength_estimate(pass, (size_t) passLen, userLen > 0 ? user : NULL,
+                                userLen > 0 ? (size_t) userLen : 0, &estimate);
+    locked_free(&utf8Region);
+    if (!ok) {
+        stats.fail();
+        return -1;
+    }
+    return pack_strength(estimate);
+}
+
+/**
+ * estimatePasswordStrength() for streamed fields (UI thread)
+ *
+ * @param userStream Stream of the user name field, 0 if there is none
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_estimateKeystrokesStrength(
+        JNIEnv *env, jclass clazz, jlong passStream, jlong userStream) {
+
+    StatsScope stats(STAT_EP_ESTIMATE_KEYSTROKES_STRENGTH);
+
+    jint packed = keystrokes_strength_impl((uint64_t) passStream, (uint64_t) userStream, stats);
+    stack_scrub(STACK_DEPTH_KEYSTROKES_STRENGTH_IMPL);
+    return packed;
+}
+
+// ========== SECOND FACTOR ==========
+// A TOTP code (see otp.h) submitted with the credentials and checked
+// alongside them, so a login only reports whether both matched. There is no
+// built-in seed: until one is enrolled the second factor is off and
+// isOtpEnrolled() tells the login screen to skip it. Enrolling takes two
+// calls: provisionOtp() stages a seed and confirmOtp() puts it in use once
+// a code from the authenticator matches it, so a mistyped seed never
+// replaces a working one. Only the seeds' HMAC keys are kept, in locked
+// memory and for the life of the process; the seed bytes are wiped once
+// they are derived.
+
+static pthread_mutex_t g_otpLock = PTHREAD_MUTEX_INITIALIZER;
+static LockedRegion g_otpRegion = {};                      // OtpKey in use, if enrolled
+static LockedRegion g_otpPendingRegion = {};               // OtpKey awaiting confirmOtp()
+
+/**
+ * Copies a key into one of the regions above, allocating it first if needed
+ * (g_otpLock held)
+ *
+ * @return false if memory ran out
+ */
+static bool otp_store_locked(LockedRegion *region, const OtpKey *key) {
+    if (!region->ptr &&
+        !locked_alloc(region, sizeof(OtpKey), LOCK_PRIO_CRITICAL, SECRET_CLASS_KEY)) {
+        return false;
+    }
+    memcpy(region->ptr, key, sizeof(OtpKey));
+    return true;
+}
+
+/**
+ * Checks a typed code against the current time step and its window
+ *
+ * @param pending Check the staged key, and put it in use if the code matches
+ * @return false if no such key is provisioned
+ */
+static bool otp_check(const unsigned char *code, size_t len, bool pending) {
+    struct timespec now;
+    if (clock_gettime(CLOCK_REALTIME, &now) != 0 || now.tv_sec < 0) return false;
+
+    pthread_mutex_lock(&g_otpLock);
+    LockedRegion *region = pending ? &g_otpPendingRegion : &g_otpRegion;
+    OtpKey *key = (OtpKey *) region->ptr;
+    bool ok = key && otp_verify(key, code, len, totp_counter(key, (uint64_t) now.tv_sec));
+    if (ok && pending) {
+        // Its counter moved past the confirming code, which stays used up
+        ok = otp_store_locked(&g_otpRegion, key);
+        if (ok) locked_free(&g_otpPendingRegion);
+    }
+    pthread_mutex_unlock(&g_otpLock);
+    return ok;
+}
+
+/**
+ * Body of provisionOtp(), out of line so the stack it used (the prepared
+ * key is built there) can be scrubbed once it returns
+ */
+__attribute__((noinline)) static jboolean provision_otp_impl(
+        JNIEnv *env, jcharArray jseed, jint seedLen, jint hash, jint digits, jint period,
+        jint window, StatsScope &stats) {
+
+    if (!jseed || seedLen < 0 || hash < 0 || hash >= HMAC_HASH_COUNT || period <= 0 ||
+        window < 0) {
+        stats.fail();
+        return JNI_FALSE;
+    }
+    LockedRegion textRegion = {}, seedRegion = {};
+    long textLen = chars_to_locked_utf8(env, jseed, seedLen, &textRegion);
+    if (textLen < 0) {
+        stats.fail();
+        return JNI_FALSE;
+    }
+
+    OtpKey fresh;
+    long len = -1;
+    if (locked_alloc(&seedRegion, OTP_MAX_SEED_BYTES, LOCK_PRIO_CRITICAL)) {
+        len = otp_base32_decode((const unsigned char *) textRegion.ptr, (size_t) textLen,
+                                (unsigned char *) seedRegion.ptr, OTP_MAX_SEED_BYTES);
+    }
+    bool ok = len > 0 && otp_key_init(&fresh, (HmacHash) hash, seedRegion.ptr, (size_t) len,
+                                      digits, (uint32_t) period, (uint32_t) window);
+    locked_free(&seedRegion);
+    locked_free(&textRegion);
+
+    if (ok) {
+        pthread_mutex_lock(&g_otpLock);
+        ok = otp_store_locked(&g_otpPendingRegion, &fresh);
+        pthread_mutex_unlock(&g_otpLock);
+    }
+    secure_wipe_vectorized(&fresh, sizeof(fresh));
+    if (!ok) stats.fail();
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Stages a second-factor seed (e.g. from an otpauth:// enrollment)
+ * It is not used for logins until confirmOtp() accepts a code from it;
+ * staging again replaces a seed not confirmed yet
+ *
+ * @param jseed   Base32 seed; the caller still owns (and wipes) the array
+ * @param hash    NativeBridge.OTP_HASH_*
+ * @param digits  6 to 8
+ * @param period  Seconds per time step (30 in most authenticator apps)
+ * @param window  Time steps also accepted on either side, 0 to 10
+ * @return false on invalid parameters or seed
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_provisionOtp(
+        JNIEnv *env, jclass clazz, jcharArray jseed, jint seedLen, jint hash, jint digits,
+        jint period, jint window) {
+
+    StatsScope stats(STAT_EP_PROVISION_OTP);
+
+    jboolean ok = provision_otp_impl(env, jseed, seedLen, hash, digits, period, window, stats);
+    stack_scrub(STACK_DEPTH_PROVISION_OTP_IMPL);
+    return ok;
+}
+
+/**
+ * Whether a seed is in use (the login screen asks for a code only then)
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_isOtpEnrolled(
+        JNIEnv *env, jclass clazz) {
+
+    StatsScope stats(STAT_EP_IS_OTP_ENROLLED);
+
+    pthread_mutex_lock(&g_otpLock);
+    bool enrolled = g_otpRegion.ptr != NULL;
+    pthread_mutex_unlock(&g_otpLock);
+    return enrolled ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Body of verifyOtp() and confirmOtp(), scrubbed like provision_otp_impl()
+ * (the window's MACs and codes pass through its stack)
+ */
+__attribute__((noinline)) static jboolean verify_otp_impl(JNIEnv *env, jcharArray jcode,
+                                                          jint codeLen, bool pending,
+                                                          StatsScope &stats) {
+    if (!jcode || codeLen < 0) {
+        stats.fail();
+        return JNI_FALSE;
+    }
+    LockedRegion codeRegion = {};
+    long len = chars_to_locked_utf8(env, jcode, codeLen, &codeRegion);
+    if (len < 0) {
+        stats.fail();
+        return JNI_FALSE;
+    }
+    bool ok = otp_check((const unsigned char *) codeRegion.ptr, (size_t) len, pending);
+    locked_free(&codeRegion);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Checks a second-factor code on its own (logins submit theirs with the
+ * credentials instead)
+ * A code is accepted once: the time step it belongs to, and every earlier
+ * one, are then used up. The caller still owns (and wipes) the array
+ *
+ * @return true if the code is valid now, false as well if no seed is enrolled
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_verifyOtp(
+        JNIEnv *env, jclass clazz, jcharArray jcode, jint codeLen) {
+
+    StatsScope stats(STAT_EP_VERIFY_OTP);
+
+    jboolean ok = verify_otp_impl(env, jcode, codeLen, false, stats);
+    stack_scrub(STACK_DEPTH_VERIFY_OTP_IMPL);
+    return ok;
+}
+
+/**
+ * Puts the seed staged by provisionOtp() in use if a code from it is valid
+ * now; the seed used so far (if any) is wiped then
+ *
+ * @return false on a wrong code or if nothing is staged
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_confirmOtp(
+        JNIEnv *env, jclass clazz, jcharArray jcode, jint codeLen) {
+
+    StatsScope stats(STAT_EP_CONFIRM_OTP);
+
+    jboolean ok = verify_otp_impl(env, jcode, codeLen, true, stats);
+    stack_scrub(STACK_DEPTH_VERIFY_OTP_IMPL);
+    return ok;
+}
+
+/**
+ * Body of verifyKeystrokesOtp() and confirmKeystrokesOtp(), scrubbed like
+ * verify_otp_impl()
+ */
+__attribute__((noinline)) static jboolean verify_keystrokes_otp_impl(uint64_t stream,
+                                                                     bool pending,
+                                                                     StatsScope &stats) {
+    size_t cap = keystroke_utf8_capacity();
+    LockedRegion codeRegion = {};
+    if (!locked_alloc(&codeRegion, cap, LOCK_PRIO_CRITICAL)) {
+        stats.fail();
+        return JNI_FALSE;
+    }
+    long len = keystroke_utf8_raw(stream, (unsigned char *) codeRegion.ptr, cap);
+    bool ok = len >= 0 && otp_check((const unsigned char *) codeRegion.ptr, (size_t) len, pending);
+    locked_free(&codeRegion);
+    if (len < 0) stats.fail();
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * verifyOtp() for a streamed field (its text never reached Java)
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_verifyKeystrokesOtp(
+        JNIEnv *env, jclass clazz, jlong stream) {
+
+    StatsScope stats(STAT_EP_VERIFY_KEYSTROKES_OTP);
+
+    jboolean ok = verify_keystrokes_otp_impl((uint64_t) stream, false, stats);
+    stack_scrub(STACK_DEPTH_VERIFY_KEYSTROKES_OTP_IMPL);
+    return ok;
+}
+
+/**
+ * confirmOtp() for a streamed field
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_confirmKeystrokesOtp(
+        JNIEnv *env, jclass clazz, jlong stream) {
+
+    StatsScope stats(STAT_EP_CONFIRM_KEYSTROKES_OTP);
+
+    jboolean ok = verify_keystrokes_otp_impl((uint64_t) stream, true, stats);
+    stack_scrub(STACK_DEPTH_VERIFY_KEYSTROKES_OTP_IMPL);
+    return ok;
+}
+
+/**
+ * Reads the code submitted with a login into locked memory (UI thread)
+ * Leaves len at -1 if none was given or it can't be read, which only fails
+ * the login once a seed is enrolled
+ */
+static void login_code_read(JNIEnv *env, jlong codeStream, jcharArray jcode, jint codeLen,
+                            LoginCode *code) {
+    code->len = -1;
+    if (codeStream) {
+        size_t cap = keystroke_utf8_capacity();
+        if (!locked_alloc(&code->text, cap, LOCK_PRIO_CRITICAL)) return;
+        code->len = keystroke_utf8_raw((uint64_t) codeStream, (unsigned char *) code->text.ptr,
+                                       cap);
+    } else if (jcode && codeLen >= 0) {
+        code->len = chars_to_locked_utf8(env, jcode, codeLen, &code->text);
+    }
+    if (code->len < 0) locked_free(&code->text);
+}
+
+/**
+ * Checks a submitted code like verifyOtp(), on the worker finishing the
+ * login (scrub STACK_DEPTH_VERIFY_OTP_IMPL after it)
+ *
+ * @return true if the code is valid now, or if no seed is enrolled
+ */
+__attribute__((noinline)) static bool login_code_passes(const LoginCode *code) {
+    pthread_mutex_lock(&g_otpLock);
+    bool enrolled = g_otpRegion.ptr != NULL;
+    pthread_mutex_unlock(&g_otpLock);
+    if (!enrolled) return true;
+    return code->len >= 0 &&
+           otp_check((const unsigned char *) code->text.ptr, (size_t) code->len, false);
+}
+
+// ========== EMERGENCY WIPE ==========
+
+/**
+ * Wipes every registered in-flight plaintext region
+ * Called from onPause (the UI thread, which also feeds the keystroke
+ * streams); long-lived key material is left alone (crash handlers wipe that
+ * too)
+ *
+ * @return Number of bytes wiped
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_wipeAllSecrets(
+        JNIEnv *env, jclass clazz) {
+
+    StatsScope stats(STAT_EP_WIPE_ALL_SECRETS);
+
+    // Quiesce the threads that work on plaintext first: zeroing a buffer
+    // under a running request would only corrupt its result, and an edit the
+    // absorber applies after the wipe would put typed text back
+    // A speculative hash is of text the wipe is about to destroy
+    speculation_cancel_all();
+    worker_cancel_all(env);
+    keystroke_sync();
+    size_t wiped = secret_registry_wipe_all(SECRET_CLASS_PLAINTEXT);
+    stats_add(STAT_BYTES_WIPED, wiped);
+    return (jlong) wiped;
+}
+
+// ========== SHARE RE-RANDOMIZATION ==========
+
+/**
+ * Tunes the background thread that re-randomizes credential shares
+ *
+ * @param intervalMillis Time between passes (0 stops re-randomization)
+ * @param cpuPermille    CPU share the thread may use during a pass (1-1000)
+ * @return false on invalid arguments
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_setShareRefresh(
+        JNIEnv *env, jclass clazz, jlong intervalMillis, jint cpuPermille) {
+
+    StatsScope stats(STAT_EP_SET_SHARE_REFRESH);
+
+    if (intervalMillis < 0 || intervalMillis > UINT32_MAX || cpuPermille < 1 || cpuPermille > 1000) {
+        stats.fail();
+        return JNI_FALSE;
+    }
+    shares_set_refresh((uint32_t) intervalMillis, (uint32_t) cpuPermille);
+    return JNI_TRUE;
+}
+
+// ========== DEFERRED WIPING ==========
+
+/**
+ * Moves wiping of large released native buffers to a background thread
+ * Released buffers become inaccessible at once and are zeroed within
+ * WIPE_QUEUE_MAX_LAG_MS; Java arrays (wipeFlagBuffer) are always wiped inline
+ *
+ * @param enabled true to defer, false to flush the queue and wipe inline again
+ * @return Previous setting
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_setDeferredWipe(
+        JNIEnv *env, jclass clazz, jboolean enabled) {
+
+    StatsScope stats(STAT_EP_SET_DEFERRED_WIPE);
+
+    return wipe_queue_set_enabled(enabled == JNI_TRUE) ? JNI_TRUE : JNI_FALSE;
+}
+
+// ========== MEMORY PRESSURE ==========
+
+/**
+ * Gives locked memory back under memory pressure (call from onTrimMemory)
+ * Every level drops the reuse caches (wiped mappings, sealed, strength and
+ * parallel scratch) and unmaps empty slabs
+ *
+ * @param level ComponentCallbacks2 trim level
+ * @return Locked bytes released
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_trimSecureMemory(
+        JNIEnv *env, jclass clazz, jint level) {
+
+    StatsScope stats(STAT_EP_TRIM_SECURE_MEMORY);
+
+    if (level < 0) {
+        stats.fail();
+        return 0;
+    }
+    // Order matters: cached scratch first (its mapping may go to the wipe
+    // queue), then cached mappings, which free up slab slots
+    size_t released = sealed_trim();
+    released += strength_trim();
+    released += parallel_trim();
+    released += wipe_queue_trim();
+    released += slab_trim();
+    return (jlong) released;
+}
+
+// ========== SECRET EXPIRY ==========
+
+/**
+ * Schedules a native wipe of a Java char[] after ttlMillis
+ * Runs on the native wipe thread, so it happens even if the UI thread stalls
+ *
+ * @param jbuffer   Array to zero at the deadline
+ * @param ttlMillis Delay before wiping (clamped to the wheel range, ~4.6 h)
+ * @return Handle for cancelWipe(), or 0 on failure
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_scheduleWipe(
+        JNIEnv *env, jclass clazz, jcharArray jbuffer, jlong ttlMillis) {
+
+    StatsScope stats(STAT_EP_SCHEDULE_WIPE);
+
+    if (!jbuffer || ttlMillis < 0) {
+        stats.fail();
+        return 0;
+    }
+
+    uint32_t ttl = ttlMillis > UINT32_MAX ? UINT32_MAX : (uint32_t) ttlMillis;
+    uint64_t handle = secret_timer_add_java(env, jbuffer, ttl);
+    if (!handle) stats.fail();
+    return (jlong) handle;
+}
+
+/**
+ * Cancels a wipe scheduled with scheduleWipe()
+ * Waits if the wipe is running right now
+ *
+ * @return true if the wipe had not happened yet
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_cancelWipe(
+        JNIEnv *env, jclass clazz, jlong handle) {
+
+    StatsScope stats(STAT_EP_CANCEL_WIPE);
+
+    return secret_timer_cancel((uint64_t) handle) ? JNI_TRUE : JNI_FALSE;
+}
+
+// ========== DIAGNOSTICS ==========
+
+/**
+ * Returns aggregated per-entry-point counters and latency histograms
+ * Layout is described in native_stats.h and mirrored by NativeBridge.STATS_* constants
+ *
+ * @return Packed long[] snapshot, or null if the array could not be allocated
+ */
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_getNativeStats(
+        JNIEnv *env, jclass clazz) {
+
+    StatsScope stats(STAT_EP_GET_NATIVE_STATS);
+
+    jlongArray result = env->NewLongArray(STAT_PACKED_LEN);
+    if (!result) {
+        stats.fail();
+        return NULL;
+    }
+
+    // Counters are not sensitive, a plain stack snapshot is fine
+    int64_t packed[STAT_PACKED_LEN];
+    stats_snapshot(packed);
+    env->SetLongArrayRegion(result, 0, STAT_PACKED_LEN, (const jlong *) packed);
+    return result;
+}
+
+/**
+ * Reports the locked-memory budget so callers can see when secrets run unlocked
+ *
+ * @return long[] {limitBytes (-1 if unlimited), lockedBytes, deniedRequests, pressurePermille}
+ */
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_getLockBudget(
+        JNIEnv *env, jclass clazz) {
+
+    StatsScope stats(STAT_EP_GET_LOCK_BUDGET);
+
+    jlongArray result = env->NewLongArray(4);
+    if (!result) {
+        stats.fail();
+        return NULL;
+    }
+
+    LockBudgetInfo info;
+    lock_budget_info(&info);
+    jlong packed[4] = {
+            info.limitBytes == UINT64_MAX ? -1 : (jlong) info.limitBytes,
+            (jlong) info.lockedBytes,
+            (jlong) info.deniedRequests,
+            (jlong) info.pressurePermille
+    };
+    env->SetLongArrayRegion(result, 0, 4, packed);
+    return result;
+}
+
+/**
+ * Name of the backend new secret mappings try first
+ * ("memfd_secret", "map_locked" or "mlock"); not sensitive, so a String is fine
+ */
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_getSecureBackend(
+        JNIEnv *env, jclass clazz) {
+
+    StatsScope stats(STAT_EP_GET_SECURE_BACKEND);
+
+    return env->NewStringUTF(backend_name(backend_selected()));
+}
+
+/**
+ * Times every wipe, compare, ChaCha20 and SHA kernel variant this CPU can
+ * run and formats a comparison table (see cpu_dispatch_bench())
+ * Blocks the caller for about 2 * millisPerRun per variant
+ */
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_benchmarkKernels(
+        JNIEnv *env, jclass clazz, jint millisPerRun) {
+
+    StatsScope stats(STAT_EP_BENCHMARK_KERNELS);
+
+    char table[2048];
+    cpu_dispatch_bench(table, sizeof(table), millisPerRun > 0 ? (uint32_t) millisPerRun : 1);
+    return env->NewStringUTF(table);
+}
+
+/**
+ * Binds a kernel to one of its variants, or back to the fastest with "auto"
+ *
+ * @return false if the kernel or variant is unknown or this CPU cannot run it
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_fuzzme_1v3_NativeBridge_selectKernel(
+        JNIEnv *env, jclass clazz, jstring jkernel, jstring jvariant) {
+
+    StatsScope stats(STAT_EP_SELECT_KERNEL);
+
+    const char *kernel = jkernel ? env->GetStringUTFChars(jkernel, NULL) : NULL;
+    const char *variant = jvariant ? env->GetStringUTFChars(jvariant, NULL) : NULL;
+    bool selected = kernel && variant && cpu_dispatch_select(kernel, variant);
+    if (kernel) env->ReleaseStringUTFChars(jkernel, kernel);
+    if (variant) env->ReleaseStringUTFChars(jvariant, variant);
+    if (!selected) stats.fail();
+    return selected ? JNI_TRUE : JNI_FALSE;
+}
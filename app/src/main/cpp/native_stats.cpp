@@ -0,0 +1,122 @@
+#include "native_stats.h"
+
+#include <atomic>
+#include <ctime>
+
+// ========== PER-THREAD SLOTS ==========
+
+// Threads beyond this share the last slot (still correct, just contended)
+static const int STAT_MAX_THREADS = 64;
+
+struct ThreadStats {
+    std::atomic<uint64_t> counters[STAT_EP_COUNT][STAT_COUNTER_COUNT];
+    std::atomic<uint64_t> buckets[STAT_EP_COUNT][STAT_HIST_BUCKETS];
+};
+
+// Zero-initialized static storage: no allocation on the hot path
+static ThreadStats g_slots[STAT_MAX_THREADS];
+static std::atomic<int> g_slotsUsed{0};
+
+static thread_local ThreadStats *t_slot = nullptr;
+static thread_local int t_entry = -1;
+
+/**
+ * Returns this thread's slot, claiming one on first use
+ */
+static ThreadStats *thread_slot() {
+    if (!t_slot) {
+        int idx = g_slotsUsed.fetch_add(1, std::memory_order_relaxed);
+        if (idx >= STAT_MAX_THREADS) idx = STAT_MAX_THREADS - 1;
+        t_slot = &g_slots[idx];
+    }
+    return t_slot;
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * Maps a latency to its log2 histogram bucket
+ */
+static int latency_bucket(uint64_t ns) {
+    if (ns < 1024) return 0;
+    int bucket = (63 - __builtin_clzll(ns)) - 9;
+    return bucket < STAT_HIST_BUCKETS ? bucket : STAT_HIST_BUCKETS - 1;
+}
+
+// ========== RECORDING ==========
+
+void stats_add(StatCounter counter, uint64_t value) {
+    if (t_entry < 0 || value == 0) return;
+    // Only this thread writes the slot, relaxed ordering is enough
+    thread_slot()->counters[t_entry][counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+void stats_mlock(int rc) {
+    stats_add(STAT_MLOCK_CALLS, 1);
+    if (rc != 0) stats_add(STAT_MLOCK_FAILURES, 1);
+}
+
+void stats_jni_copy(jboolean isCopy) {
+    if (isCopy == JNI_TRUE) stats_add(STAT_JNI_COPIES, 1);
+}
+
+StatsScope::StatsScope(StatEntry entry) : entry(entry), prevEntry(t_entry) {
+    t_entry = entry;
+    stats_add(STAT_CALLS, 1);
+    startNs = now_ns();
+}
+
+StatsScope::~StatsScope() {
+    uint64_t elapsed = now_ns() - startNs;
+    ThreadStats *slot = thread_slot();
+
+    if (failed) stats_add(STAT_FAILURES, 1);
+    slot->counters[entry][STAT_LATENCY_SUM_NS].fetch_add(elapsed, std::memory_order_relaxed);
+    slot->buckets[entry][latency_bucket(elapsed)].fetch_add(1, std::memory_order_relaxed);
+
+    // Max is the only read-modify-write that needs a loop (shared last slot)
+    std::atomic<uint64_t> &maxNs = slot->counters[entry][STAT_LATENCY_MAX_NS];
+    uint64_t seen = maxNs.load(std::memory_order_relaxed);
+    while (elapsed > seen &&
+           !maxNs.compare_exchange_weak(seen, elapsed, std::memory_order_relaxed)) {
+    }
+
+    t_entry = prevEntry;
+}
+
+// ========== AGGREGATION ==========
+
+void stats_snapshot(int64_t *out) {
+    out[0] = STAT_LAYOUT_VERSION;
+    out[1] = STAT_EP_COUNT;
+    out[2] = STAT_COUNTER_COUNT;
+    out[3] = STAT_HIST_BUCKETS;
+
+    int used = g_slotsUsed.load(std::memory_order_relaxed);
+    if (used > STAT_MAX_THREADS) used = STAT_MAX_THREADS;
+
+    for (int e = 0; e < STAT_EP_COUNT; e++) {
+        int64_t *dst = out + STAT_HEADER_LEN + e * STAT_ENTRY_STRIDE;
+        for (int i = 0; i < STAT_ENTRY_STRIDE; i++) dst[i] = 0;
+
+        for (int s = 0; s < used; s++) {
+            const ThreadStats &slot = g_slots[s];
+            for (int c = 0; c < STAT_COUNTER_COUNT; c++) {
+                uint64_t v = slot.counters[e][c].load(std::memory_order_relaxed);
+                if (c == STAT_LATENCY_MAX_NS) {
+                    if ((int64_t) v > dst[c]) dst[c] = (int64_t) v;
+                } else {
+                    dst[c] += (int64_t) v;
+                }
+            }
+            for (int b = 0; b < STAT_HIST_BUCKETS; b++) {
+                dst[STAT_COUNTER_COUNT + b] +=
+                        (int64_t) slot.buckets[e][b].load(std::memory_order_relaxed);
+            }
+        }
+    }
+}
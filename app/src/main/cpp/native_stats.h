@@ -0,0 +1,133 @@
+#ifndef FUZZME_V3_NATIVE_STATS_H
+#define FUZZME_V3_NATIVE_STATS_H
+
+#include <jni.h>
+#include <cstddef>
+#include <cstdint>
+
+// ========== NATIVE STATS ==========
+// Cheap per-thread counters and latency histograms for every JNI entry point.
+// Each thread writes only its own slot; slots are summed when Java reads them.
+
+/**
+ * JNI entry points that are instrumented
+ * Order is part of the getNativeStats() layout - append only
+ */
+enum StatEntry {
+    STAT_EP_CHECK_CREDENTIALS = 0,
+    STAT_EP_GET_FLAG_LENGTH,
+    STAT_EP_DECRYPT_FLAG,
+    STAT_EP_WIPE_FLAG,
+    STAT_EP_GET_NATIVE_STATS,
+    STAT_EP_GET_LOCK_BUDGET,
+    STAT_EP_GET_SECURE_BACKEND,
+    STAT_EP_SCHEDULE_WIPE,
+    STAT_EP_CANCEL_WIPE,
+    STAT_EP_WIPE_ALL_SECRETS,
+    STAT_EP_SET_SHARE_REFRESH,
+    STAT_EP_SET_DEFERRED_WIPE,
+    STAT_EP_TRIM_SECURE_MEMORY,
+    STAT_EP_SUBMIT_CHECK_CREDENTIALS,
+    STAT_EP_SUBMIT_DECRYPT_FLAG,
+    STAT_EP_CANCEL_REQUEST,
+    STAT_EP_OPEN_KEYSTROKE_STREAM,
+    STAT_EP_APPEND_KEYSTROKE,
+    STAT_EP_DELETE_KEYSTROKES,
+    STAT_EP_CLEAR_KEYSTROKES,
+    STAT_EP_CLOSE_KEYSTROKE_STREAM,
+    STAT_EP_CHECK_STREAMED_CREDENTIALS,
+    STAT_EP_SUBMIT_CHECK_STREAMED_CREDENTIALS,
+    STAT_EP_SPECULATE_KEYSTROKES,
+    STAT_EP_SET_PASSWORD_KDF_COST,
+    STAT_EP_LOAD_BREACH_FILTER,
+    STAT_EP_CHECK_PASSWORD_BREACHED,
+    STAT_EP_CHECK_KEYSTROKES_BREACHED,
+    STAT_EP_LOAD_STRENGTH_DICTIONARY,
+    STAT_EP_ESTIMATE_PASSWORD_STRENGTH,
+    STAT_EP_ESTIMATE_KEYSTROKES_STRENGTH,
+    STAT_EP_PROVISION_OTP,
+    STAT_EP_VERIFY_OTP,
+    STAT_EP_VERIFY_KEYSTROKES_OTP,
+    STAT_EP_BENCHMARK_KERNELS,
+    STAT_EP_SELECT_KERNEL,
+    STAT_EP_IS_OTP_ENROLLED,
+    STAT_EP_CONFIRM_OTP,
+    STAT_EP_CONFIRM_KEYSTROKES_OTP,
+    STAT_EP_COUNT
+};
+
+/**
+ * Per-entry-point counters
+ * Order is part of the getNativeStats() layout - append only
+ */
+enum StatCounter {
+    STAT_CALLS = 0,          // Times the entry point was entered
+    STAT_FAILURES,           // Calls that bailed out on an error path
+    STAT_BYTES_WIPED,        // Bytes zeroed by secure_memzero, stack scrubs, backend_wipe,
+                             // sealed slot reseals and wipeAllSecrets; the shared vector
+                             // kernels (secure_wipe*) are not counted: they must stay
+                             // TLS-free for the crash handler
+    STAT_MLOCK_CALLS,        // mlock() attempts
+    STAT_MLOCK_FAILURES,     // mlock() attempts that returned an error
+    STAT_JNI_COPIES,         // Get*ArrayElements calls that reported isCopy
+    STAT_LATENCY_SUM_NS,     // Total time spent inside the entry point
+    STAT_LATENCY_MAX_NS,     // Slowest single call
+    STAT_COUNTER_COUNT
+};
+
+// Latency histogram: bucket 0 is < 1 us, bucket i covers [2^(9+i), 2^(10+i)) ns,
+// the last bucket is open-ended (~4 s and above)
+static const int STAT_HIST_BUCKETS = 24;
+
+// Packed layout returned by getNativeStats():
+//   [0] layout version, [1] entry count, [2] counters per entry, [3] histogram buckets
+//   then for each entry: STAT_COUNTER_COUNT counters followed by STAT_HIST_BUCKETS buckets
+static const int STAT_LAYOUT_VERSION = 1;
+static const int STAT_HEADER_LEN = 4;
+static const int STAT_ENTRY_STRIDE = STAT_COUNTER_COUNT + STAT_HIST_BUCKETS;
+static const int STAT_PACKED_LEN = STAT_HEADER_LEN + STAT_EP_COUNT * STAT_ENTRY_STRIDE;
+
+/**
+ * Adds to a counter of the entry point currently running on this thread
+ * Calls made outside any StatsScope are attributed to no entry point and dropped
+ */
+void stats_add(StatCounter counter, uint64_t value);
+
+/**
+ * Records the outcome of an mlock() call
+ * @param rc Return value of mlock()
+ */
+void stats_mlock(int rc);
+
+/**
+ * Records whether the JVM handed us a copy of an array
+ * @param isCopy Value written by Get*ArrayElements
+ */
+void stats_jni_copy(jboolean isCopy);
+
+/**
+ * Sums all thread slots into the packed layout described above
+ * @param out Array of at least STAT_PACKED_LEN elements
+ */
+void stats_snapshot(int64_t *out);
+
+/**
+ * Times one entry point call and makes it the target of stats_add() on this thread
+ * Declare one at the top of every JNI function
+ */
+class StatsScope {
+public:
+    explicit StatsScope(StatEntry entry);
+    ~StatsScope();
+
+    // Marks the call as failed (counted once, on scope exit)
+    void fail() { failed = true; }
+
+private:
+    StatEntry entry;
+    int prevEntry;
+    uint64_t startNs;
+    bool failed = false;
+};
+
+#endif // FUZZME_V3_NATIVE_STATS_H
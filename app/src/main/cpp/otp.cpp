@@ -0,0 +1,163 @@
+#include "otp.h"
+
+#include <cstring>
+
+#include "secure_util.h"
+
+// Largest window: the expected counter and OTP_MAX_WINDOW either side
+static const size_t OTP_MAX_BATCH = 2 * OTP_MAX_WINDOW + 1;
+
+static const size_t OTP_COUNTER_BYTES = 8;
+
+/**
+ * All ones if a == b, zero otherwise, without a branch
+ */
+static inline uint32_t ct_eq_mask(uint32_t a, uint32_t b) {
+    return (uint32_t) (((uint64_t) (a ^ b) - 1) >> 32);
+}
+
+/**
+ * All ones if a >= b (both below 2^63), zero otherwise, without a branch
+ */
+static inline uint64_t ct_ge_mask(uint64_t a, uint64_t b) {
+    return ~(uint64_t) ((int64_t) (a - b) >> 63);
+}
+
+/**
+ * Dynamic truncation (RFC 4226 5.3): 31 bits at the offset the last byte
+ * names, selected by masking every candidate so the (secret) offset
+ * decides no address
+ */
+static uint32_t dynamic_truncate(const unsigned char *mac, size_t macLen) {
+    uint32_t offset = mac[macLen - 1] & 0x0F;
+    uint32_t bin = 0;
+    for (uint32_t o = 0; o < 16; o++) {
+        uint32_t word = ((uint32_t) mac[o] << 24) | ((uint32_t) mac[o + 1] << 16) |
+                        ((uint32_t) mac[o + 2] << 8) | (uint32_t) mac[o + 3];
+        bin |= word & ct_eq_mask(o, offset);
+    }
+    return bin & 0x7FFFFFFF;
+}
+
+/**
+ * bin mod 10^digits, a decimal digit at a time: division by the constant
+ * 10 compiles to a multiplication, where a division by 10^digits would
+ * take data-dependent time on some cores
+ */
+static uint32_t decimal_code(uint32_t bin, int digits) {
+    uint32_t code = 0, scale = 1;
+    for (int i = 0; i < digits; i++) {
+        code += (bin % 10) * scale;
+        bin /= 10;
+        scale *= 10;
+    }
+    return code;
+}
+
+bool otp_key_init(OtpKey *key, HmacHash hash, const void *seed, size_t len, int digits,
+                  uint32_t period, uint32_t window) {
+    if (len > OTP_MAX_SEED_BYTES || digits < OTP_MIN_DIGITS || digits > OTP_MAX_DIGITS ||
+        period == 0 || window > OTP_MAX_WINDOW) {
+        return false;
+    }
+    memset(key, 0, sizeof(*key));
+    if (!hmac_key_init(&key->hmac, hash, seed, len)) return false;
+    key->digits = digits;
+    key->period = period;
+    key->window = window;
+    key->nextCounter = 0;
+    return true;
+}
+
+void hotp_codes(const OtpKey *key, uint64_t first, size_t count, uint32_t *codes) {
+    unsigned char counters[OTP_MAX_BATCH * OTP_COUNTER_BYTES];
+    unsigned char macs[OTP_MAX_BATCH * HMAC_MAX_OUT_BYTES];
+    size_t macLen = hmac_out_bytes(key->hmac.hash);
+    if (count > OTP_MAX_BATCH) count = OTP_MAX_BATCH;
+
+    for (size_t i = 0; i < count; i++) {
+        uint64_t counter = first + i;
+        for (size_t b = 0; b < OTP_COUNTER_BYTES; b++) {
+            counters[i * OTP_COUNTER_BYTES + b] = (unsigned char) (counter >> (56 - 8 * b));
+        }
+    }
+    hmac_short_batch(&key->hmac, counters, OTP_COUNTER_BYTES, count, macs);
+    for (size_t i = 0; i < count; i++) {
+        codes[i] = decimal_code(dynamic_truncate(macs + i * macLen, macLen), key->digits);
+    }
+
+    secure_wipe_vectorized(macs, sizeof(macs));
+}
+
+uint64_t totp_counter(const OtpKey *key, uint64_t unixSeconds) {
+    return unixSeconds / key->period;
+}
+
+bool otp_verify(OtpKey *key, const unsigned char *code, size_t len, uint64_t counter) {
+    // Parse without branching on the digits; a bad one only clears valid
+    uint32_t valid = ct_eq_mask((uint32_t) len, (uint32_t) key->digits);
+    uint32_t value = 0;
+    for (size_t i = 0; i < len && i < (size_t) OTP_MAX_DIGITS; i++) {
+        int digit = (int) code[i] - '0';
+        valid &= ~(uint32_t) ((digit | (9 - digit)) >> 31);    // Clears unless 0..9
+        value = value * 10 + (uint32_t) (digit & 0x0F);
+    }
+
+    // The window, clipped at counter 0 (its bounds are public)
+    uint64_t first = counter > key->window ? counter - key->window : 0;
+    size_t count = (size_t) (counter + key->window - first + 1);
+    uint32_t codes[OTP_MAX_BATCH];
+    hotp_codes(key, first, count, codes);
+
+    // Compare all of them; the last match wins
+    uint32_t found = 0;
+    uint64_t matched = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t c = first + i;
+        uint32_t hit = ct_eq_mask(codes[i], value) & (uint32_t) ct_ge_mask(c, key->nextCounter);
+        uint64_t hit64 = (uint64_t) 0 - (hit & 1);
+        found |= hit;
+        matched = (matched & ~hit64) | (c & hit64);
+    }
+    found &= valid;
+
+    secure_wipe_vectorized(codes, sizeof(codes));
+    secure_wipe_vectorized(&value, sizeof(value));
+    if (!found) return false;
+    key->nextCounter = matched + 1;
+    return true;
+}
+
+/**
+ * Value of a base32 character, -1 if it is not one; arithmetic rather
+ * than a table lookup indexed by seed characters
+ */
+static int base32_value(unsigned char c) {
+    int lower = c | 0x20;
+    int letter = ((('a' - 1) - lower) & (lower - ('z' + 1))) >> 8;    // -1 if a..z
+    int digit = ((('2' - 1) - (int) c) & ((int) c - ('7' + 1))) >> 8; // -1 if 2..7
+    return (letter & (lower - 'a')) | (digit & ((int) c - '2' + 26)) | ~(letter | digit);
+}
+
+long otp_base32_decode(const unsigned char *in, size_t len, unsigned char *out, size_t cap) {
+    uint32_t buffer = 0;
+    int bits = 0, bad = 0;
+    size_t written = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == ' ' || in[i] == '=') continue;
+        int v = base32_value(in[i]);
+        bad |= v;
+        buffer = (buffer << 5) | (uint32_t) (v & 31);
+        bits += 5;
+        if (bits >= 8) {
+            bits -= 8;
+            if (written == cap) {
+                bad = -1;
+                break;
+            }
+            out[written++] = (unsigned char) (buffer >> bits);
+        }
+    }
+    secure_wipe_vectorized(&buffer, sizeof(buffer));
+    return bad < 0 ? -1 : (long) written;
+}
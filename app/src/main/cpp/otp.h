@@ -0,0 +1,78 @@
+#ifndef FUZZME_V3_OTP_H
+#define FUZZME_V3_OTP_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "hmac.h"
+
+// ========== ONE-TIME PASSWORDS ==========
+// HOTP (RFC 4226) and TOTP (RFC 6238: HOTP over the number of time steps
+// since the epoch). A code is the HMAC of the 8-byte big-endian counter
+// under the shared seed, dynamically truncated to 31 bits, mod 10^digits.
+//
+// Verification accepts a window of counters around the expected one (clock
+// drift, a code typed as it rolled over). Every code of the window is
+// computed and compared in one pass, with no branch or memory access that
+// depends on the seed, the codes or which of them matched. A counter at or
+// below the last one accepted is refused: a code is only good once
+// (RFC 6238 section 5.2).
+
+static const int OTP_MIN_DIGITS = 6;
+static const int OTP_MAX_DIGITS = 8;
+static const uint32_t OTP_DEFAULT_PERIOD = 30;      // Seconds per TOTP step
+static const uint32_t OTP_DEFAULT_WINDOW = 1;       // Steps accepted either side
+static const uint32_t OTP_MAX_WINDOW = 10;
+static const size_t OTP_MAX_SEED_BYTES = 64;
+
+/**
+ * A provisioned seed and its verification state
+ * Holds the seed's HMAC key: keep it in locked memory
+ */
+struct OtpKey {
+    HmacKey hmac;
+    int digits;
+    uint32_t period;
+    uint32_t window;
+    uint64_t nextCounter;   // Lowest counter still accepted
+};
+
+/**
+ * Prepares a key from a seed (the caller still owns and wipes the seed)
+ *
+ * @return false on an unknown hash, a seed longer than OTP_MAX_SEED_BYTES
+ *         or digits / period / window out of range
+ */
+bool otp_key_init(OtpKey *key, HmacHash hash, const void *seed, size_t len, int digits,
+                  uint32_t period, uint32_t window);
+
+/**
+ * Codes for count consecutive counters, from first on
+ * codes may hold 2 * OTP_MAX_WINDOW + 1 codes at most per call
+ */
+void hotp_codes(const OtpKey *key, uint64_t first, size_t count, uint32_t *codes);
+
+/**
+ * TOTP counter (time step) of a moment
+ */
+uint64_t totp_counter(const OtpKey *key, uint64_t unixSeconds);
+
+/**
+ * Checks a code against the window around a counter
+ * Accepting a code consumes its counter and every one before it
+ *
+ * @param code Digits as typed (ASCII); the wrong length or a non-digit
+ *             fails, in the same time as a wrong code
+ * @return true if a counter of the window not yet used gives this code
+ */
+bool otp_verify(OtpKey *key, const unsigned char *code, size_t len, uint64_t counter);
+
+/**
+ * Decodes a base32 seed (RFC 4648, as in otpauth:// URIs)
+ * Either case; spaces and '=' padding are skipped
+ *
+ * @return Bytes written, -1 on an invalid character or if cap is too small
+ */
+long otp_base32_decode(const unsigned char *in, size_t len, unsigned char *out, size_t cap);
+
+#endif // FUZZME_V3_OTP_H
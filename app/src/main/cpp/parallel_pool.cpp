@@ -0,0 +1,368 @@
+#include "parallel_pool.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <pthread.h>
+#include <sched.h>
+
+#include "lock_budget.h"
+#include "secure_util.h"
+
+// Binary splitting leaves at most ~log2(count) ranges in a deque; when one
+// is full the participant simply stops splitting
+static const int64_t DEQUE_SLOTS = 64;
+
+static const int MAX_PARTICIPANTS = PARALLEL_MAX_WORKERS + 1;
+
+// Job ranges pack [begin, end) into one word so deque slots stay atomic
+static const uint64_t RANGE_EMPTY = 0;
+
+static uint64_t range_pack(uint32_t begin, uint32_t end) {
+    return ((uint64_t) begin << 32) | end;
+}
+
+// ========== CHASE-LEV DEQUE ==========
+// Lê, Pop, Cohen, Zappa Nardelli, "Correct and Efficient Work-Stealing for
+// Weak Memory Models" (PPoPP 2013), fixed-size variant. The owner pushes and
+// takes at the bottom, thieves steal at the top.
+
+struct alignas(64) Participant {
+    std::atomic<int64_t> top;
+    char pad[64 - sizeof(std::atomic<int64_t>)];   // Thieves hammer top, the owner bottom
+    std::atomic<int64_t> bottom;
+    std::atomic<uint64_t> ranges[DEQUE_SLOTS];
+    LockedRegion scratch;
+    uint64_t rng;                                  // Victim selection
+};
+
+static bool deque_push(Participant *p, uint64_t range) {
+    int64_t b = p->bottom.load(std::memory_order_relaxed);
+    int64_t t = p->top.load(std::memory_order_acquire);
+    if (b - t >= DEQUE_SLOTS) return false;
+    p->ranges[b & (DEQUE_SLOTS - 1)].store(range, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    p->bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+static uint64_t deque_take(Participant *p) {
+    int64_t b = p->bottom.load(std::memory_order_relaxed) - 1;
+    p->bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = p->top.load(std::memory_order_relaxed);
+    if (t > b) {
+        p->bottom.store(b + 1, std::memory_order_relaxed);
+        return RANGE_EMPTY;
+    }
+    uint64_t range = p->ranges[b & (DEQUE_SLOTS - 1)].load(std::memory_order_relaxed);
+    if (t == b) {
+        // Last range: race the thieves for it
+        if (!p->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                            std::memory_order_relaxed)) {
+            range = RANGE_EMPTY;
+        }
+        p->bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return range;
+}
+
+static uint64_t deque_steal(Participant *p) {
+    int64_t t = p->top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = p->bottom.load(std::memory_order_acquire);
+    if (t >= b) return RANGE_EMPTY;
+    uint64_t range = p->ranges[t & (DEQUE_SLOTS - 1)].load(std::memory_order_relaxed);
+    if (!p->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        return RANGE_EMPTY;  // Lost the race; the caller tries elsewhere
+    }
+    return range;
+}
+
+// ========== POOL STATE ==========
+
+static Participant g_parts[MAX_PARTICIPANTS];  // [0] belongs to the caller
+static int g_workerCount = 0;
+static std::atomic<int> g_limit{0};
+static pthread_once_t g_startOnce = PTHREAD_ONCE_INIT;
+
+static pthread_mutex_t g_jobLock = PTHREAD_MUTEX_INITIALIZER;  // One job at a time
+
+// Job description (written under g_lock before the generation bump)
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_start = PTHREAD_COND_INITIALIZER;     // Workers wait for a job
+static pthread_cond_t g_checkedIn = PTHREAD_COND_INITIALIZER; // Caller waits for workers
+static uint64_t g_generation = 0;
+static int g_jobWorkers = 0;        // Workers taking part in the current job
+static int g_pendingWorkers = 0;    // ...that have not finished with it yet
+static ParallelItemFn g_fn;
+static void *g_arg;
+static size_t g_grain;
+static size_t g_scratchLen;
+static std::atomic<uint64_t> g_remaining{0};  // Items not yet finished
+
+static thread_local bool t_inJob = false;
+
+/**
+ * Makes a participant's scratch at least len bytes (zeroed, locked)
+ */
+static bool grow_scratch(Participant *p, size_t len) {
+    if (len == 0 || p->scratch.len >= len) return true;
+    locked_free(&p->scratch);
+    return locked_alloc(&p->scratch, len, LOCK_PRIO_NORMAL);
+}
+
+/**
+ * Runs a range: splits the top halves off for thieves down to the grain,
+ * then processes what is left, wiping the scratch after every item
+ * (plain vector stores: the scratch is reused at once, so flushing it out
+ * of the cache would only cost the next item a refill)
+ */
+static void run_range(Participant *self, uint64_t range) {
+    uint32_t begin = (uint32_t) (range >> 32), end = (uint32_t) range;
+    while (end - begin > g_grain) {
+        uint32_t mid = begin + (end - begin) / 2;
+        if (!deque_push(self, range_pack(mid, end))) break;
+        end = mid;
+    }
+
+    void *scratch = g_scratchLen ? self->scratch.ptr : NULL;
+    for (uint32_t i = begin; i < end; i++) {
+        g_fn(g_arg, i, scratch, g_scratchLen);
+        if (scratch) secure_wipe_vectorized(scratch, g_scratchLen);
+    }
+    g_remaining.fetch_sub(end - begin, std::memory_order_acq_rel);
+}
+
+static uint64_t steal_any(Participant *self, int participants) {
+    self->rng ^= self->rng << 13;
+    self->rng ^= self->rng >> 7;
+    self->rng ^= self->rng << 17;
+    int first = (int) (self->rng % (uint64_t) participants);
+    for (int i = 0; i < participants; i++) {
+        Participant *victim = &g_parts[(first + i) % participants];
+        if (victim == self) continue;
+        uint64_t range = deque_steal(victim);
+        if (range != RANGE_EMPTY) return range;
+    }
+    return RANGE_EMPTY;
+}
+
+/**
+ * Works on the current job until every item is finished
+ */
+static void participate(Participant *self, int participants) {
+    t_inJob = true;
+    for (;;) {
+        uint64_t range = deque_take(self);
+        if (range == RANGE_EMPTY) range = steal_any(self, participants);
+        if (range != RANGE_EMPTY) {
+            run_range(self, range);
+            continue;
+        }
+        if (g_remaining.load(std::memory_order_acquire) == 0) break;
+        sched_yield();
+    }
+    t_inJob = false;
+}
+
+// ========== WORKERS ==========
+
+/**
+ * Relative speed of a CPU: scheduler capacity, else its top frequency
+ * @return 0 if unknown
+ */
+static unsigned long cpu_speed(int cpu) {
+    static const char *const FILES[] = {
+            "/sys/devices/system/cpu/cpu%d/cpu_capacity",
+            "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq"
+    };
+    for (const char *pattern : FILES) {
+        char path[96];
+        snprintf(path, sizeof(path), pattern, cpu);
+        FILE *f = fopen(path, "re");
+        if (!f) continue;
+        unsigned long value = 0;
+        int n = fscanf(f, "%lu", &value);
+        fclose(f);
+        if (n == 1 && value) return value;
+    }
+    return 0;
+}
+
+/**
+ * Picks the big cores: every allowed CPU at least half as fast as the
+ * fastest one (drops LITTLE cores, keeps prime and big ones)
+ *
+ * @return Number of CPUs in set
+ */
+static int pick_big_cores(cpu_set_t *set, bool *pin) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    CPU_ZERO(set);
+    *pin = false;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return 1;
+
+    unsigned long speed[CPU_SETSIZE] = {}, fastest = 0;
+    bool known = true;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        speed[cpu] = cpu_speed(cpu);
+        if (!speed[cpu]) known = false;
+        if (speed[cpu] > fastest) fastest = speed[cpu];
+    }
+
+    int count = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        if (known && speed[cpu] * 2 < fastest) {
+            *pin = true;
+            continue;
+        }
+        CPU_SET(cpu, set);
+        count++;
+    }
+    return count ? count : 1;
+}
+
+static cpu_set_t g_bigCores;
+static bool g_pin = false;
+
+static void *worker_main(void *argp) {
+    int index = (int) (intptr_t) argp;
+    Participant *self = &g_parts[index];
+    if (g_pin) sched_setaffinity(0, sizeof(g_bigCores), &g_bigCores);
+
+    uint64_t seen = 0;
+    pthread_mutex_lock(&g_lock);
+    for (;;) {
+        while (g_generation == seen) pthread_cond_wait(&g_start, &g_lock);
+        seen = g_generation;
+        bool join = index <= g_jobWorkers;
+        int participants = g_jobWorkers + 1;
+        size_t scratchLen = g_scratchLen;
+        pthread_mutex_unlock(&g_lock);
+
+        // A worker without scratch only skips stealing; the others finish the job
+        if (join && grow_scratch(self, scratchLen)) participate(self, participants);
+
+        pthread_mutex_lock(&g_lock);
+        if (join && --g_pendingWorkers == 0) pthread_cond_signal(&g_checkedIn);
+    }
+    return nullptr;
+}
+
+static void start_pool() {
+    int cpus = pick_big_cores(&g_bigCores, &g_pin);
+    int wanted = cpus - 1;  // The caller is a participant too
+    if (wanted > PARALLEL_MAX_WORKERS) wanted = PARALLEL_MAX_WORKERS;
+
+    for (int i = 0; i < MAX_PARTICIPANTS; i++) g_parts[i].rng = 0x9E3779B97F4A7C15ull * (i + 1);
+    for (int i = 1; i <= wanted; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, worker_main, (void *) (intptr_t) i) != 0) break;
+        pthread_detach(thread);
+        g_workerCount = i;
+    }
+}
+
+// ========== PUBLIC API ==========
+
+/**
+ * Runs a job on the calling thread alone (no workers, or nested in an item)
+ */
+static bool run_serial(size_t count, ParallelItemFn fn, void *arg, LockedRegion *scratch,
+                       size_t scratchLen) {
+    // Jobs started from these items must not wait for the job lock we may hold
+    bool outer = t_inJob;
+    t_inJob = true;
+    void *buf = scratchLen ? scratch->ptr : NULL;
+    for (size_t i = 0; i < count; i++) {
+        fn(arg, i, buf, scratchLen);
+        if (buf) secure_wipe_vectorized(buf, scratchLen);
+    }
+    t_inJob = outer;
+    return true;
+}
+
+bool parallel_for(size_t count, ParallelItemFn fn, void *arg,
+                  size_t grain, size_t scratchLen) {
+    if (count == 0) return true;
+    if (count > UINT32_MAX) return false;  // Ranges are packed into 32 bits
+
+    // Nested job: the pool is busy with the outer one
+    if (t_inJob) {
+        LockedRegion scratch = {};
+        if (scratchLen && !locked_alloc(&scratch, scratchLen, LOCK_PRIO_NORMAL)) return false;
+        run_serial(count, fn, arg, &scratch, scratchLen);
+        locked_free(&scratch);
+        return true;
+    }
+
+    pthread_once(&g_startOnce, start_pool);
+    pthread_mutex_lock(&g_jobLock);
+    Participant *self = &g_parts[0];
+    if (!grow_scratch(self, scratchLen)) {
+        pthread_mutex_unlock(&g_jobLock);
+        return false;
+    }
+
+    int workers = g_workerCount;
+    int limit = g_limit.load(std::memory_order_relaxed);
+    if (limit > 0 && limit - 1 < workers) workers = limit - 1;
+
+    if (workers == 0) {
+        run_serial(count, fn, arg, &self->scratch, scratchLen);
+        pthread_mutex_unlock(&g_jobLock);
+        return true;
+    }
+
+    size_t autoGrain = count / ((size_t) (workers + 1) * 8);
+    pthread_mutex_lock(&g_lock);
+    g_fn = fn;
+    g_arg = arg;
+    g_grain = grain ? grain : (autoGrain ? autoGrain : 1);
+    g_scratchLen = scratchLen;
+    g_remaining.store(count, std::memory_order_relaxed);
+    g_jobWorkers = workers;
+    g_pendingWorkers = workers;
+    deque_push(self, range_pack(0, (uint32_t) count));
+    g_generation++;
+    pthread_cond_broadcast(&g_start);
+    pthread_mutex_unlock(&g_lock);
+
+    participate(self, workers + 1);
+
+    // Workers may still be looking at the deques; wait until they let go
+    pthread_mutex_lock(&g_lock);
+    while (g_pendingWorkers > 0) pthread_cond_wait(&g_checkedIn, &g_lock);
+    pthread_mutex_unlock(&g_lock);
+
+    pthread_mutex_unlock(&g_jobLock);
+    return true;
+}
+
+int parallel_concurrency() {
+    pthread_once(&g_startOnce, start_pool);
+    return g_workerCount + 1;
+}
+
+void parallel_set_limit(int participants) {
+    g_limit.store(participants < 0 ? 0 : participants, std::memory_order_relaxed);
+}
+
+size_t parallel_trim() {
+    // Between jobs no worker touches its scratch: they only grow it after
+    // a generation bump, which needs this lock
+    pthread_mutex_lock(&g_jobLock);
+    size_t released = 0;
+    for (int i = 0; i < MAX_PARTICIPANTS; i++) {
+        Participant *p = &g_parts[i];
+        if (!p->scratch.ptr) continue;
+        released += p->scratch.mapLen;
+        locked_free(&p->scratch);
+    }
+    pthread_mutex_unlock(&g_jobLock);
+    return released;
+}
@@ -0,0 +1,65 @@
+#ifndef FUZZME_V3_PARALLEL_POOL_H
+#define FUZZME_V3_PARALLEL_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ========== PARALLEL POOL ==========
+// Fork-join parallelism for bulk secret work (batch verification, re-keying
+// a vault, bulk re-encryption, KDF lanes). The index range of a job is split
+// in halves on demand: each participant keeps a Chase-Lev deque of ranges,
+// runs the bottom of its own and steals the top of others' when it runs
+// dry. Workers are pinned to the big cores when the CPU has several kinds.
+// Every participant gets locked scratch that is wiped after each item and
+// kept for later jobs until parallel_trim().
+// Unlike the worker pool (worker_pool.h) the caller blocks and helps.
+
+// Most pool threads, whatever the core count
+static const int PARALLEL_MAX_WORKERS = 8;
+
+/**
+ * Processes one item of a job
+ *
+ * @param arg        Job argument given to parallel_for()
+ * @param index      Item index, 0 .. count - 1
+ * @param scratch    Locked scratch private to this call, zeroed (NULL if scratchLen was 0)
+ * @param scratchLen Scratch size requested by the job
+ */
+typedef void (*ParallelItemFn)(void *arg, size_t index, void *scratch, size_t scratchLen);
+
+/**
+ * Runs fn for every index in [0, count), spread over the pool
+ * The caller takes part and returns when every item is done. Jobs from
+ * different threads run one after another; a job started from inside an
+ * item runs serially on that thread
+ *
+ * @param count      At most UINT32_MAX items
+ * @param grain      Items a participant runs before it splits off work (0 = pick)
+ * @param scratchLen Locked scratch each item gets
+ * @return false (and nothing ran) if count is too large or scratch could
+ *         not be allocated
+ */
+bool parallel_for(size_t count, ParallelItemFn fn, void *arg,
+                  size_t grain, size_t scratchLen);
+
+/**
+ * Threads that take part in a job, the caller included
+ */
+int parallel_concurrency();
+
+/**
+ * Caps the participants of later jobs (benchmarks, thermal back-off)
+ *
+ * @param participants 1 .. parallel_concurrency(), 0 = no cap
+ */
+void parallel_set_limit(int participants);
+
+/**
+ * Frees the scratch kept between jobs (memory pressure)
+ * Waits for a running job to finish
+ *
+ * @return Bytes of locked regions handed back to locked_free()
+ */
+size_t parallel_trim();
+
+#endif // FUZZME_V3_PARALLEL_POOL_H
@@ -0,0 +1,94 @@
+#include "password_kdf.h"
+
+#include <cstring>
+
+#include "blake2s.h"
+#include "lock_budget.h"
+#include "secure_util.h"
+
+// Blocks each block is mixed with per pass
+static const uint32_t KDF_DELTA = 3;
+
+// Blocks mixed between two looks at the cancel flag
+static const uint32_t KDF_CANCEL_STRIDE = 256;
+
+/**
+ * out = H(counter || a || b), b optional; counter is bumped
+ * Every call gets a distinct counter, as the construction requires
+ */
+static void balloon_hash(uint64_t *counter, const void *a, size_t aLen,
+                         const void *b, size_t bLen, unsigned char *out) {
+    unsigned char ctr[8];
+    for (int i = 0; i < 8; i++) ctr[i] = (unsigned char) (*counter >> (8 * i));
+    (*counter)++;
+
+    Blake2sState state;
+    blake2s_init(&state, KDF_BLOCK_BYTES, NULL, 0);
+    blake2s_update(&state, ctr, sizeof(ctr));
+    blake2s_update(&state, a, aLen);
+    if (bLen) blake2s_update(&state, b, bLen);
+    blake2s_final(&state, out);
+}
+
+/**
+ * Picks the partner block for (pass, block, i)
+ * Depends on the salt only, not on the password
+ */
+static uint32_t balloon_other(uint64_t *counter, const unsigned char *salt,
+                              uint32_t pass, uint32_t block, uint32_t i, uint32_t blocks) {
+    unsigned char index[12], digest[KDF_BLOCK_BYTES];
+    uint32_t words[3] = {pass, block, i};
+    for (int w = 0; w < 3; w++) {
+        for (int b = 0; b < 4; b++) index[4 * w + b] = (unsigned char) (words[w] >> (8 * b));
+    }
+    balloon_hash(counter, salt, KDF_SALT_BYTES, index, sizeof(index), digest);
+    uint64_t pick = 0;
+    for (int b = 0; b < 8; b++) pick |= (uint64_t) digest[b] << (8 * b);
+    return (uint32_t) (pick % blocks);
+}
+
+bool password_kdf(const void *password, size_t len, const PasswordKdfParams *params,
+                  const std::atomic<bool> *cancelled, unsigned char *out) {
+    if (!params || (len && !password) || !out ||
+        params->memoryKiB < KDF_MIN_MEMORY_KIB || params->memoryKiB > KDF_MAX_MEMORY_KIB ||
+        params->passes == 0 || params->passes > KDF_MAX_PASSES) {
+        return false;
+    }
+
+    uint32_t blocks = (uint32_t) (params->memoryKiB * 1024ull / KDF_BLOCK_BYTES);
+    LockedRegion region = {};
+    if (!locked_alloc(&region, (size_t) blocks * KDF_BLOCK_BYTES, LOCK_PRIO_NORMAL)) return false;
+    unsigned char *buf = (unsigned char *) region.ptr;
+    uint64_t counter = 0;
+
+    // Expand: buf[0] = H(password, salt), buf[m] = H(buf[m - 1])
+    balloon_hash(&counter, password, len, params->salt, KDF_SALT_BYTES, buf);
+    for (uint32_t m = 1; m < blocks; m++) {
+        balloon_hash(&counter, buf + (size_t) (m - 1) * KDF_BLOCK_BYTES, KDF_BLOCK_BYTES,
+                     NULL, 0, buf + (size_t) m * KDF_BLOCK_BYTES);
+    }
+
+    // Mix: each block absorbs its predecessor and KDF_DELTA others
+    bool ok = true;
+    for (uint32_t pass = 0; pass < params->passes && ok; pass++) {
+        for (uint32_t m = 0; m < blocks; m++) {
+            if (cancelled && (m % KDF_CANCEL_STRIDE) == 0 &&
+                cancelled->load(std::memory_order_relaxed)) {
+                ok = false;
+                break;
+            }
+            unsigned char *cur = buf + (size_t) m * KDF_BLOCK_BYTES;
+            const unsigned char *prev = buf + (size_t) (m ? m - 1 : blocks - 1) * KDF_BLOCK_BYTES;
+            balloon_hash(&counter, prev, KDF_BLOCK_BYTES, cur, KDF_BLOCK_BYTES, cur);
+            for (uint32_t i = 0; i < KDF_DELTA; i++) {
+                uint32_t other = balloon_other(&counter, params->salt, pass, m, i, blocks);
+                balloon_hash(&counter, cur, KDF_BLOCK_BYTES,
+                             buf + (size_t) other * KDF_BLOCK_BYTES, KDF_BLOCK_BYTES, cur);
+            }
+        }
+    }
+
+    if (ok) memcpy(out, buf + (size_t) (blocks - 1) * KDF_BLOCK_BYTES, KDF_OUT_BYTES);
+    locked_free(&region);
+    return ok;
+}
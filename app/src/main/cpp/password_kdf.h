@@ -0,0 +1,50 @@
+#ifndef FUZZME_V3_PASSWORD_KDF_H
+#define FUZZME_V3_PASSWORD_KDF_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// ========== PASSWORD KDF ==========
+// Memory-hard password hashing: Balloon hashing (Boneh, Corrigan-Gibbs and
+// Schechter, single-buffer variant) over BLAKE2s. The buffer is filled from
+// the password and salt, then mixed for a number of passes in which every
+// block also absorbs delta pseudo-randomly chosen others, so computing the
+// hash with less memory costs a lot more time. The buffer is derived from
+// the password and is allocated, wiped and freed like any other plaintext.
+
+static const size_t KDF_SALT_BYTES = 16;
+static const size_t KDF_OUT_BYTES = 32;
+static const size_t KDF_BLOCK_BYTES = 32;
+
+// Defaults: ~0.2 s on current phones
+static const uint32_t KDF_DEFAULT_MEMORY_KIB = 1024;
+static const uint32_t KDF_DEFAULT_PASSES = 2;
+
+// Bounds accepted by password_kdf()
+static const uint32_t KDF_MIN_MEMORY_KIB = 1;
+static const uint32_t KDF_MAX_MEMORY_KIB = 256 * 1024;
+static const uint32_t KDF_MAX_PASSES = 64;
+
+/**
+ * Salt and cost of one hash
+ */
+struct PasswordKdfParams {
+    unsigned char salt[KDF_SALT_BYTES];
+    uint32_t memoryKiB;
+    uint32_t passes;
+};
+
+/**
+ * Hashes a password
+ *
+ * @param password  Already normalized bytes (see credential_text.h)
+ * @param cancelled Polled while mixing (NULL = never); a cancelled hash
+ *                  wipes its buffer and returns false
+ * @param out       KDF_OUT_BYTES bytes
+ * @return false on invalid parameters, no memory or cancellation
+ */
+bool password_kdf(const void *password, size_t len, const PasswordKdfParams *params,
+                  const std::atomic<bool> *cancelled, unsigned char *out);
+
+#endif // FUZZME_V3_PASSWORD_KDF_H
@@ -0,0 +1,546 @@
+#include "sealed_memory.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "cpu_dispatch.h"
+#include "native_stats.h"
+#include "secret_registry.h"
+#include "secure_backend.h"
+#include "secure_util.h"
+
+// ========== PROCESS KEY ==========
+
+static const size_t KEY_WORDS = 8;  // 256-bit ChaCha20 key
+
+static uint32_t *g_key = NULL;      // Points into the guarded key page
+static SecretNode g_keyNode;
+static std::atomic<uint64_t> g_nonce{1};
+static pthread_once_t g_keyOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Fills buf from the kernel CSPRNG
+ * getrandom(2) is called through syscall() because bionic only exposes it
+ * from API 28; /dev/urandom covers kernels older than 3.17
+ */
+static bool random_bytes(void *buf, size_t len) {
+    unsigned char *p = (unsigned char *) buf;
+    size_t done = 0;
+#ifdef SYS_getrandom
+    while (done < len) {
+        long rc = syscall(SYS_getrandom, p + done, len - done, 0);
+        if (rc > 0) {
+            done += (size_t) rc;
+        } else if (rc < 0 && errno != EINTR) {
+            break;
+        }
+    }
+    if (done == len) return true;
+#endif
+    int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    while (done < len) {
+        ssize_t rc = read(fd, p + done, len - done);
+        if (rc > 0) {
+            done += (size_t) rc;
+        } else if (rc == 0 || errno != EINTR) {
+            break;
+        }
+    }
+    close(fd);
+    return done == len;
+}
+
+/**
+ * Maps [guard][key][guard] and fills the key page's first 32 bytes
+ * All three pages come from one backend mapping (so the key page gets the
+ * selected backend's protections); the outer two are then made inaccessible
+ * so a linear overrun from a neighbouring mapping faults instead of reading it
+ */
+static void key_init() {
+    size_t ps = page_size();
+    bool locked = false;
+    SecureBackendKind kind;
+    unsigned char *mem = (unsigned char *) backend_map(3 * ps, LOCK_PRIO_CRITICAL, &locked, &kind);
+    if (!mem) return;
+
+    if (mprotect(mem, ps, PROT_NONE) != 0 || mprotect(mem + 2 * ps, ps, PROT_NONE) != 0) {
+        backend_unmap(mem, 3 * ps, locked, kind);
+        return;
+    }
+
+    uint32_t *key = (uint32_t *) (mem + ps);
+    if (!random_bytes(key, KEY_WORDS * sizeof(uint32_t))) {
+        secure_wipe_vectorized(key, KEY_WORDS * sizeof(uint32_t));
+        mprotect(mem, 3 * ps, PROT_READ | PROT_WRITE);
+        backend_unmap(mem, 3 * ps, locked, kind);
+        return;
+    }
+
+    // Key material: wiped by crash handlers, but not by onPause
+    secret_registry_add(&g_keyNode, key, KEY_WORDS * sizeof(uint32_t), SECRET_CLASS_KEY);
+    g_key = key;
+}
+
+static const uint32_t *process_key() {
+    pthread_once(&g_keyOnce, key_init);
+    return g_key;
+}
+
+// ========== CHACHA20 ==========
+// Keystream kernels bound through cpu_dispatch.h: one block at a time in
+// scalar code, four blocks in parallel in 16-byte vectors, eight with AVX2.
+
+// Four blocks in parallel, one per vector lane (SSE2 on x86, NEON on ARM)
+typedef uint32_t chacha_vec __attribute__((vector_size(16)));
+typedef unsigned char byte_vec16 __attribute__((vector_size(16)));
+
+static const size_t CHACHA_BLOCK = 64;
+static const size_t CHACHA_LANES = 4;
+static const size_t CHACHA_CHUNK = CHACHA_BLOCK * CHACHA_LANES;
+
+#define CHACHA_ROTL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define CHACHA_QR(a, b, c, d)                            \
+    do {                                                 \
+        a += b; d ^= a; d = CHACHA_ROTL(d, 16);          \
+        c += d; b ^= c; b = CHACHA_ROTL(b, 12);          \
+        a += b; d ^= a; d = CHACHA_ROTL(d, 8);           \
+        c += d; b ^= c; b = CHACHA_ROTL(b, 7);           \
+    } while (0)
+
+/**
+ * Transposes a 4x4 matrix of 32-bit words held as four row vectors
+ */
+static inline void transpose4(chacha_vec &a, chacha_vec &b, chacha_vec &c, chacha_vec &d) {
+#if defined(__SSE2__)
+    __m128i t0 = _mm_unpacklo_epi32((__m128i) a, (__m128i) b);
+    __m128i t1 = _mm_unpacklo_epi32((__m128i) c, (__m128i) d);
+    __m128i t2 = _mm_unpackhi_epi32((__m128i) a, (__m128i) b);
+    __m128i t3 = _mm_unpackhi_epi32((__m128i) c, (__m128i) d);
+    a = (chacha_vec) _mm_unpacklo_epi64(t0, t1);
+    b = (chacha_vec) _mm_unpackhi_epi64(t0, t1);
+    c = (chacha_vec) _mm_unpacklo_epi64(t2, t3);
+    d = (chacha_vec) _mm_unpackhi_epi64(t2, t3);
+#elif defined(__aarch64__)
+    uint64x2_t t0 = vreinterpretq_u64_u32(vzip1q_u32((uint32x4_t) a, (uint32x4_t) b));
+    uint64x2_t t1 = vreinterpretq_u64_u32(vzip1q_u32((uint32x4_t) c, (uint32x4_t) d));
+    uint64x2_t t2 = vreinterpretq_u64_u32(vzip2q_u32((uint32x4_t) a, (uint32x4_t) b));
+    uint64x2_t t3 = vreinterpretq_u64_u32(vzip2q_u32((uint32x4_t) c, (uint32x4_t) d));
+    a = (chacha_vec) vzip1q_u64(t0, t1);
+    b = (chacha_vec) vzip2q_u64(t0, t1);
+    c = (chacha_vec) vzip1q_u64(t2, t3);
+    d = (chacha_vec) vzip2q_u64(t2, t3);
+#else
+    chacha_vec r[4] = {a, b, c, d};
+    for (int i = 0; i < 4; i++) {
+        chacha_vec col = {r[0][i], r[1][i], r[2][i], r[3][i]};
+        if (i == 0) a = col;
+        else if (i == 1) b = col;
+        else if (i == 2) c = col;
+        else d = col;
+    }
+#endif
+}
+
+/**
+ * Loads constants, key and nonce into a lane-splatted state
+ * Word layout is the original 64-bit counter / 64-bit nonce variant
+ */
+static void chacha20_setup(chacha_vec in[16], const uint32_t *key, uint64_t nonce) {
+    in[0] = (chacha_vec) {0x61707865, 0x61707865, 0x61707865, 0x61707865};
+    in[1] = (chacha_vec) {0x3320646e, 0x3320646e, 0x3320646e, 0x3320646e};
+    in[2] = (chacha_vec) {0x79622d32, 0x79622d32, 0x79622d32, 0x79622d32};
+    in[3] = (chacha_vec) {0x6b206574, 0x6b206574, 0x6b206574, 0x6b206574};
+    for (int i = 0; i < 8; i++) in[4 + i] = (chacha_vec) {key[i], key[i], key[i], key[i]};
+    uint32_t lo = (uint32_t) nonce, hi = (uint32_t) (nonce >> 32);
+    in[14] = (chacha_vec) {lo, lo, lo, lo};
+    in[15] = (chacha_vec) {hi, hi, hi, hi};
+}
+
+/**
+ * Produces four consecutive keystream blocks starting at block counter
+ */
+static void chacha20_blocks4(chacha_vec in[16], uint64_t counter,
+                             unsigned char out[CHACHA_CHUNK]) {
+    for (size_t lane = 0; lane < CHACHA_LANES; lane++) {
+        uint64_t c = counter + lane;
+        in[12][lane] = (uint32_t) c;
+        in[13][lane] = (uint32_t) (c >> 32);
+    }
+
+    chacha_vec x[16];
+    memcpy(x, in, sizeof(x));
+    for (int round = 0; round < 10; round++) {
+        CHACHA_QR(x[0], x[4], x[8], x[12]);
+        CHACHA_QR(x[1], x[5], x[9], x[13]);
+        CHACHA_QR(x[2], x[6], x[10], x[14]);
+        CHACHA_QR(x[3], x[7], x[11], x[15]);
+        CHACHA_QR(x[0], x[5], x[10], x[15]);
+        CHACHA_QR(x[1], x[6], x[11], x[12]);
+        CHACHA_QR(x[2], x[7], x[8], x[13]);
+        CHACHA_QR(x[3], x[4], x[9], x[14]);
+    }
+
+    // Lanes hold one block each: transpose 4x4 word groups back to block order
+    for (int i = 0; i < 16; i += 4) {
+        chacha_vec a = x[i] + in[i], b = x[i + 1] + in[i + 1];
+        chacha_vec c = x[i + 2] + in[i + 2], d = x[i + 3] + in[i + 3];
+        transpose4(a, b, c, d);
+        memcpy(out + 0 * CHACHA_BLOCK + i * 4, &a, 16);
+        memcpy(out + 1 * CHACHA_BLOCK + i * 4, &b, 16);
+        memcpy(out + 2 * CHACHA_BLOCK + i * 4, &c, 16);
+        memcpy(out + 3 * CHACHA_BLOCK + i * 4, &d, 16);
+    }
+}
+
+/**
+ * dst = src ^ keystream, 256 bytes at a time (dst may equal src)
+ */
+static void chacha20_xor_vec4(const uint32_t *key, uint64_t nonce,
+                              const unsigned char *src, unsigned char *dst, size_t len) {
+    chacha_vec state[16];
+    unsigned char ks[CHACHA_CHUNK] __attribute__((aligned(16)));
+    uint64_t counter = 0;
+
+    chacha20_setup(state, key, nonce);
+    while (len > 0) {
+        chacha20_blocks4(state, counter, ks);
+        counter += CHACHA_LANES;
+
+        size_t n = len < CHACHA_CHUNK ? len : CHACHA_CHUNK;
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            byte_vec16 v;
+            memcpy(&v, src + i, 16);
+            v ^= *(const byte_vec16 *) (ks + i);
+            memcpy(dst + i, &v, 16);
+        }
+        for (; i < n; i++) dst[i] = src[i] ^ ks[i];
+
+        src += n;
+        dst += n;
+        len -= n;
+    }
+
+    // The state holds the key, the buffer the last keystream chunk
+    secure_wipe_vectorized(state, sizeof(state));
+    secure_wipe_vectorized(ks, sizeof(ks));
+}
+
+/**
+ * One block at a time in 32-bit words: the reference for the vector kernels
+ */
+static void chacha20_xor_scalar(const uint32_t *key, uint64_t nonce,
+                                const unsigned char *src, unsigned char *dst, size_t len) {
+    uint32_t in[16] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+    uint32_t x[16];
+    unsigned char ks[CHACHA_BLOCK];
+    uint64_t counter = 0;
+
+    memcpy(in + 4, key, 8 * sizeof(uint32_t));
+    in[14] = (uint32_t) nonce;
+    in[15] = (uint32_t) (nonce >> 32);
+    while (len > 0) {
+        in[12] = (uint32_t) counter;
+        in[13] = (uint32_t) (counter >> 32);
+        counter++;
+
+        memcpy(x, in, sizeof(x));
+        for (int round = 0; round < 10; round++) {
+            CHACHA_QR(x[0], x[4], x[8], x[12]);
+            CHACHA_QR(x[1], x[5], x[9], x[13]);
+            CHACHA_QR(x[2], x[6], x[10], x[14]);
+            CHACHA_QR(x[3], x[7], x[11], x[15]);
+            CHACHA_QR(x[0], x[5], x[10], x[15]);
+            CHACHA_QR(x[1], x[6], x[11], x[12]);
+            CHACHA_QR(x[2], x[7], x[8], x[13]);
+            CHACHA_QR(x[3], x[4], x[9], x[14]);
+        }
+        for (int i = 0; i < 16; i++) {
+            uint32_t word = x[i] + in[i];
+            memcpy(ks + 4 * i, &word, 4);
+        }
+
+        size_t n = len < CHACHA_BLOCK ? len : CHACHA_BLOCK;
+        for (size_t i = 0; i < n; i++) dst[i] = src[i] ^ ks[i];
+
+        src += n;
+        dst += n;
+        len -= n;
+    }
+
+    secure_wipe_vectorized(in, sizeof(in));
+    secure_wipe_vectorized(x, sizeof(x));
+    secure_wipe_vectorized(ks, sizeof(ks));
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Eight blocks in parallel, one per 32-bit lane of a 256-bit vector
+typedef uint32_t chacha_vec8 __attribute__((vector_size(32)));
+typedef unsigned char byte_vec32 __attribute__((vector_size(32)));
+
+static const size_t CHACHA_CHUNK8 = CHACHA_BLOCK * 8;
+
+#define CHACHA_AVX2 __attribute__((target("avx2")))
+
+/**
+ * transpose4() within each 128-bit half: the low halves then hold words of
+ * blocks 0-3, the high halves of blocks 4-7
+ */
+CHACHA_AVX2
+static inline void transpose4x2(chacha_vec8 &a, chacha_vec8 &b, chacha_vec8 &c, chacha_vec8 &d) {
+    __m256i t0 = _mm256_unpacklo_epi32((__m256i) a, (__m256i) b);
+    __m256i t1 = _mm256_unpacklo_epi32((__m256i) c, (__m256i) d);
+    __m256i t2 = _mm256_unpackhi_epi32((__m256i) a, (__m256i) b);
+    __m256i t3 = _mm256_unpackhi_epi32((__m256i) c, (__m256i) d);
+    a = (chacha_vec8) _mm256_unpacklo_epi64(t0, t1);
+    b = (chacha_vec8) _mm256_unpackhi_epi64(t0, t1);
+    c = (chacha_vec8) _mm256_unpacklo_epi64(t2, t3);
+    d = (chacha_vec8) _mm256_unpackhi_epi64(t2, t3);
+}
+
+CHACHA_AVX2
+static void chacha20_xor_avx2(const uint32_t *key, uint64_t nonce,
+                              const unsigned char *src, unsigned char *dst, size_t len) {
+    chacha_vec8 in[16], x[16];
+    unsigned char ks[CHACHA_CHUNK8] __attribute__((aligned(32)));
+    uint64_t counter = 0;
+
+    const uint32_t sigma[4] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+    for (int i = 0; i < 4; i++) in[i] = (chacha_vec8) _mm256_set1_epi32((int) sigma[i]);
+    for (int i = 0; i < 8; i++) in[4 + i] = (chacha_vec8) _mm256_set1_epi32((int) key[i]);
+    in[14] = (chacha_vec8) _mm256_set1_epi32((int) (uint32_t) nonce);
+    in[15] = (chacha_vec8) _mm256_set1_epi32((int) (uint32_t) (nonce >> 32));
+
+    while (len > 0) {
+        for (int lane = 0; lane < 8; lane++) {
+            uint64_t c = counter + lane;
+            in[12][lane] = (uint32_t) c;
+            in[13][lane] = (uint32_t) (c >> 32);
+        }
+        counter += 8;
+
+        memcpy(x, in, sizeof(x));
+        for (int round = 0; round < 10; round++) {
+            CHACHA_QR(x[0], x[4], x[8], x[12]);
+            CHACHA_QR(x[1], x[5], x[9], x[13]);
+            CHACHA_QR(x[2], x[6], x[10], x[14]);
+            CHACHA_QR(x[3], x[7], x[11], x[15]);
+            CHACHA_QR(x[0], x[5], x[10], x[15]);
+            CHACHA_QR(x[1], x[6], x[11], x[12]);
+            CHACHA_QR(x[2], x[7], x[8], x[13]);
+            CHACHA_QR(x[3], x[4], x[9], x[14]);
+        }
+        for (int i = 0; i < 16; i += 4) {
+            chacha_vec8 a = x[i] + in[i], b = x[i + 1] + in[i + 1];
+            chacha_vec8 c = x[i + 2] + in[i + 2], d = x[i + 3] + in[i + 3];
+            transpose4x2(a, b, c, d);
+            const chacha_vec8 rows[4] = {a, b, c, d};
+            for (int r = 0; r < 4; r++) {
+                memcpy(ks + r * CHACHA_BLOCK + i * 4, &rows[r], 16);
+                memcpy(ks + (4 + r) * CHACHA_BLOCK + i * 4, (const unsigned char *) &rows[r] + 16, 16);
+            }
+        }
+
+        size_t n = len < CHACHA_CHUNK8 ? len : CHACHA_CHUNK8;
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            byte_vec32 v;
+            memcpy(&v, src + i, 32);
+            v ^= *(const byte_vec32 *) (ks + i);
+            memcpy(dst + i, &v, 32);
+        }
+        for (; i < n; i++) dst[i] = src[i] ^ ks[i];
+
+        src += n;
+        dst += n;
+        len -= n;
+    }
+
+    secure_wipe_vectorized(in, sizeof(in));
+    secure_wipe_vectorized(x, sizeof(x));
+    secure_wipe_vectorized(ks, sizeof(ks));
+}
+
+#endif
+
+extern const KernelVariant CHACHA20_KERNELS[] = {
+        {"scalar", 0, (KernelFn) chacha20_xor_scalar},
+        {"vec4", 0, (KernelFn) chacha20_xor_vec4},
+#if defined(__x86_64__) || defined(__i386__)
+        {"avx2", CPU_X86_AVX2, (KernelFn) chacha20_xor_avx2},
+#endif
+};
+extern const size_t CHACHA20_KERNEL_COUNT = sizeof(CHACHA20_KERNELS) / sizeof(CHACHA20_KERNELS[0]);
+
+static void chacha20_xor(const uint32_t *key, uint64_t nonce,
+                         const unsigned char *src, unsigned char *dst, size_t len) {
+    cpu_chacha20_kernel()(key, nonce, src, dst, len);
+}
+
+// ========== SEAL / UNSEAL ==========
+
+uint64_t sealed_next_nonce() {
+    return g_nonce.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool sealed_xor_keystream(void *buf, size_t len, uint64_t nonce) {
+    const uint32_t *key = process_key();
+    if (!key) return false;
+    chacha20_xor(key, nonce, (const unsigned char *) buf, (unsigned char *) buf, len);
+    return true;
+}
+
+bool sealed_seal(SealedSecret *out, const void *plaintext, size_t len) {
+    out->data = NULL;
+    out->len = 0;
+    out->nonce = 0;
+
+    const uint32_t *key = process_key();
+    if (!key) return false;
+
+    // malloc(0) may return NULL; keep a valid pointer for empty secrets
+    unsigned char *data = (unsigned char *) malloc(len ? len : 1);
+    if (!data) return false;
+
+    out->nonce = sealed_next_nonce();
+    chacha20_xor(key, out->nonce, (const unsigned char *) plaintext, data, len);
+    out->data = data;
+    out->len = len;
+    return true;
+}
+
+void sealed_free(SealedSecret *secret) {
+    if (!secret->data) return;
+    free(secret->data);
+    secret->data = NULL;
+    secret->len = 0;
+}
+
+// ========== SCRATCH SLOTS ==========
+// Mapping and locking a fresh region costs far more than decrypting a small
+// secret, so wiped slots are kept for reuse. Only a few are cached and only up
+// to a bounded size, so the locked budget they pin stays small.
+
+static const int SLOT_CACHE_MAX = 4;
+static const size_t SLOT_CACHE_BYTES = 64 * 1024;
+
+struct SealedSlot {
+    LockedRegion region;
+    size_t used;          // Plaintext bytes currently in the slot
+    SealedSlot *nextFree;
+};
+
+static SealedSlot *g_freeSlots = NULL;
+static int g_freeSlotCount = 0;
+static pthread_mutex_t g_slotLock = PTHREAD_MUTEX_INITIALIZER;
+
+static SealedSlot *slot_get(size_t len, LockPriority prio) {
+    pthread_mutex_lock(&g_slotLock);
+    SealedSlot **link = &g_freeSlots;
+    for (SealedSlot *slot = g_freeSlots; slot; link = &slot->nextFree, slot = slot->nextFree) {
+        if (slot->region.len >= len) {
+            *link = slot->nextFree;
+            g_freeSlotCount--;
+            pthread_mutex_unlock(&g_slotLock);
+            return slot;
+        }
+    }
+    pthread_mutex_unlock(&g_slotLock);
+
+    SealedSlot *slot = (SealedSlot *) calloc(1, sizeof(SealedSlot));
+    if (!slot) return NULL;
+    // Round small slots up so one cached slot serves every short secret
+    size_t want = len < 256 ? 256 : len;
+    if (!locked_alloc(&slot->region, want, prio)) {
+        free(slot);
+        return NULL;
+    }
+    return slot;
+}
+
+void *sealed_unseal(const SealedSecret *secret, SealedSlot **slot, LockPriority prio) {
+    *slot = NULL;
+    const uint32_t *key = process_key();
+    if (!key || !secret->data) return NULL;
+
+    SealedSlot *s = slot_get(secret->len, prio);
+    if (!s) return NULL;
+
+    chacha20_xor(key, secret->nonce, secret->data, (unsigned char *) s->region.ptr, secret->len);
+    s->used = secret->len;
+    *slot = s;
+    return s->region.ptr;
+}
+
+void sealed_reseal(SealedSlot *slot) {
+    if (!slot) return;
+
+    secure_wipe(slot->region.ptr, slot->used);
+    stats_add(STAT_BYTES_WIPED, slot->used);
+    slot->used = 0;
+
+    if (slot->region.len <= SLOT_CACHE_BYTES) {
+        SealedSlot *evict = slot;
+        pthread_mutex_lock(&g_slotLock);
+        if (g_freeSlotCount == SLOT_CACHE_MAX) {
+            // Full: swap out the smallest cached slot if this one is bigger
+            // (a big slot also serves small secrets, not the other way round)
+            SealedSlot **smallest = &g_freeSlots;
+            for (SealedSlot **link = &g_freeSlots; *link; link = &(*link)->nextFree) {
+                if ((*link)->region.len < (*smallest)->region.len) smallest = link;
+            }
+            if ((*smallest)->region.len < slot->region.len) {
+                evict = *smallest;
+                *smallest = evict->nextFree;
+                g_freeSlotCount--;
+            }
+        } else {
+            evict = NULL;
+        }
+        if (evict != slot) {
+            slot->nextFree = g_freeSlots;
+            g_freeSlots = slot;
+            g_freeSlotCount++;
+        }
+        pthread_mutex_unlock(&g_slotLock);
+        if (!evict) return;
+        slot = evict;
+    }
+
+    locked_free(&slot->region);
+    free(slot);
+}
+
+size_t sealed_trim() {
+    pthread_mutex_lock(&g_slotLock);
+    SealedSlot *slots = g_freeSlots;
+    g_freeSlots = NULL;
+    g_freeSlotCount = 0;
+    pthread_mutex_unlock(&g_slotLock);
+
+    size_t released = 0;
+    while (slots) {
+        SealedSlot *next = slots->nextFree;
+        released += slots->region.mapLen;
+        locked_free(&slots->region);
+        free(slots);
+        slots = next;
+    }
+    return released;
+}
@@ -0,0 +1,79 @@
+#ifndef FUZZME_V3_SEALED_MEMORY_H
+#define FUZZME_V3_SEALED_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "lock_budget.h"
+
+// ========== SEALED MEMORY ==========
+// Long-lived secrets are kept encrypted with ChaCha20 under a per-process key.
+// The key lives alone on a locked page between two PROT_NONE guard pages and
+// never leaves native code. Plaintext only exists in a locked scratch slot
+// between sealed_unseal() and sealed_reseal().
+
+/**
+ * A sealed secret: ciphertext plus the nonce it was sealed under
+ * The ciphertext is in ordinary heap memory, it is useless without the key
+ */
+struct SealedSecret {
+    unsigned char *data;
+    size_t len;
+    uint64_t nonce;  // Unique per seal, never reused within the process
+};
+
+/**
+ * Encrypts plaintext into a new sealed secret
+ * The caller still owns (and should wipe) the plaintext
+ *
+ * @return false if the key page or the ciphertext could not be allocated
+ */
+bool sealed_seal(SealedSecret *out, const void *plaintext, size_t len);
+
+/**
+ * Releases a sealed secret's ciphertext
+ */
+void sealed_free(SealedSecret *secret);
+
+/**
+ * Locked scratch slot holding unsealed plaintext (opaque)
+ */
+struct SealedSlot;
+
+/**
+ * Decrypts a sealed secret into a locked scratch slot
+ * Slots are recycled (already mapped and locked) so short unseals skip mmap;
+ * the slot is registered as in-flight plaintext while it is out
+ *
+ * @param slot Receives the slot to hand to sealed_reseal()
+ * @param prio Budget priority if a new slot has to be mapped
+ * @return Plaintext pointer, or NULL on failure
+ */
+void *sealed_unseal(const SealedSecret *secret, SealedSlot **slot,
+                    LockPriority prio = LOCK_PRIO_NORMAL);
+
+/**
+ * Wipes a slot returned by sealed_unseal() and gives it back
+ */
+void sealed_reseal(SealedSlot *slot);
+
+/**
+ * Frees every cached scratch slot (memory pressure)
+ * @return Bytes of locked regions handed back to locked_free()
+ */
+size_t sealed_trim();
+
+/**
+ * XORs len bytes of ChaCha20 keystream (process key, given nonce) into buf
+ * Exposed so other modules can encrypt in place without an extra copy
+ *
+ * @return false if the key page is unavailable
+ */
+bool sealed_xor_keystream(void *buf, size_t len, uint64_t nonce);
+
+/**
+ * Returns a fresh nonce for sealed_xor_keystream()
+ */
+uint64_t sealed_next_nonce();
+
+#endif // FUZZME_V3_SEALED_MEMORY_H
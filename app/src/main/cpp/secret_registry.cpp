@@ -0,0 +1,190 @@
+#include "secret_registry.h"
+
+#include <csignal>
+#include <cstring>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include "secure_util.h"
+
+// ========== LIST STATE ==========
+
+static std::atomic<SecretNode *> g_head{nullptr};
+// Wipes currently walking the list; removers wait for this to drain
+static std::atomic<int> g_walkers{0};
+// Serializes removers (never taken by the wipe path)
+static std::atomic_flag g_removeLock = ATOMIC_FLAG_INIT;
+
+// Busy polls before a waiting remover starts yielding the CPU
+static const int REMOVE_SPINS = 64;
+
+/**
+ * One step of a remover's wait: spin briefly (a wipe or an unlink is short),
+ * then yield so a preempted holder can run
+ */
+static void remove_backoff(int *spins) {
+    if (*spins < REMOVE_SPINS) {
+        (*spins)++;
+    } else {
+        sched_yield();
+    }
+}
+
+/**
+ * Publishes a filled-in node at the head of the list
+ */
+static void link_node(SecretNode *node) {
+    node->linked = true;
+
+    SecretNode *head = g_head.load(std::memory_order_relaxed);
+    do {
+        node->next.store(head, std::memory_order_relaxed);
+    } while (!g_head.compare_exchange_weak(head, node, std::memory_order_release,
+                                           std::memory_order_relaxed));
+}
+
+void secret_registry_add(SecretNode *node, void *ptr, size_t len, SecretClass secretClass,
+                         bool guarded) {
+    if (!node || !ptr || len == 0) return;
+
+    node->secretClass = secretClass;
+    node->guarded = guarded;
+    node->stride = 0;
+    node->width = 0;
+    node->ptr.store(ptr, std::memory_order_relaxed);
+    node->len.store(len, std::memory_order_relaxed);
+    link_node(node);
+}
+
+void secret_registry_add_strided(SecretNode *node, void *ptr, size_t len, size_t stride,
+                                 size_t width, SecretClass secretClass) {
+    if (!node || !ptr || len == 0 || stride == 0 || width == 0 || width > stride) return;
+
+    node->secretClass = secretClass;
+    node->guarded = false;
+    node->stride = stride;
+    node->width = width;
+    node->ptr.store(ptr, std::memory_order_relaxed);
+    node->len.store(len, std::memory_order_relaxed);
+    link_node(node);
+}
+
+void secret_registry_remove(SecretNode *node) {
+    if (!node || !node->linked) return;
+
+    // Tombstone first: a wipe that reaches the node from now on skips it
+    node->len.store(0, std::memory_order_release);
+    node->ptr.store(nullptr, std::memory_order_release);
+
+    int spins = 0;
+    while (g_removeLock.test_and_set(std::memory_order_acquire)) {
+        remove_backoff(&spins);
+    }
+
+    SecretNode *next = node->next.load(std::memory_order_relaxed);
+    SecretNode *expected = node;
+    if (!g_head.compare_exchange_strong(expected, next, std::memory_order_acq_rel)) {
+        // Not the head (or a push just landed in front): unlink from the predecessor.
+        // Pushes only ever touch g_head, other removers are excluded by the lock
+        SecretNode *prev = g_head.load(std::memory_order_acquire);
+        while (prev && prev->next.load(std::memory_order_acquire) != node) {
+            prev = prev->next.load(std::memory_order_acquire);
+        }
+        if (prev) prev->next.store(next, std::memory_order_release);
+    }
+
+    g_removeLock.clear(std::memory_order_release);
+    node->linked = false;
+
+    // Pairs with the fence in secret_registry_wipe_all(): either this load
+    // sees the wipe's increment, or the wipe's traversal sees the unlink and
+    // the tombstone. Release/acquire alone would allow both to miss
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // A wipe may still be standing on this node; the owner frees it after we return
+    spins = 0;
+    while (g_walkers.load(std::memory_order_acquire) != 0) {
+        remove_backoff(&spins);
+    }
+}
+
+// ========== EMERGENCY WIPE ==========
+
+size_t secret_registry_wipe_all(int classMask) {
+    g_walkers.fetch_add(1, std::memory_order_acq_rel);
+    // See secret_registry_remove(): a remover that misses the increment
+    // has its unlink visible to the loads below
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    size_t total = 0;
+    for (SecretNode *node = g_head.load(std::memory_order_acquire); node;
+         node = node->next.load(std::memory_order_acquire)) {
+        if (!(node->secretClass & classMask)) continue;
+
+        void *ptr = node->ptr.load(std::memory_order_acquire);
+        size_t len = node->len.load(std::memory_order_acquire);
+        if (!ptr || !len) continue;
+        // A queued mapping is PROT_NONE; its owner never makes it so again
+        if (node->guarded && mprotect(ptr, len, PROT_READ | PROT_WRITE) != 0) continue;
+
+        if (!node->stride) {
+            secure_wipe(ptr, len);
+            total += len;
+            continue;
+        }
+        for (size_t off = 0; off < len; off += node->stride) {
+            size_t n = len - off < node->width ? len - off : node->width;
+            secure_wipe((unsigned char *) ptr + off, n);
+            total += n;
+        }
+    }
+
+    g_walkers.fetch_sub(1, std::memory_order_acq_rel);
+    return total;
+}
+
+// ========== SIGNAL HOOKS ==========
+
+static const int WIPE_SIGNALS[] = {SIGSEGV, SIGABRT, SIGTERM};
+static const int WIPE_SIGNAL_COUNT = sizeof(WIPE_SIGNALS) / sizeof(WIPE_SIGNALS[0]);
+static struct sigaction g_previous[WIPE_SIGNAL_COUNT];
+static std::atomic<bool> g_installed{false};
+
+/**
+ * Wipes every secret, then hands the signal to whoever had it before us
+ * On Android, ART's sigchain runs its own fault handler (implicit null checks,
+ * stack overflow) first, so we only see faults that are real crashes
+ */
+static void wipe_signal_handler(int sig, siginfo_t *info, void *ucontext) {
+    secret_registry_wipe_all(SECRET_CLASS_ALL);
+
+    int idx = 0;
+    while (idx < WIPE_SIGNAL_COUNT && WIPE_SIGNALS[idx] != sig) idx++;
+    if (idx == WIPE_SIGNAL_COUNT) return;
+
+    const struct sigaction &prev = g_previous[idx];
+    if (prev.sa_flags & SA_SIGINFO) {
+        if (prev.sa_sigaction) prev.sa_sigaction(sig, info, ucontext);
+    } else if (prev.sa_handler == SIG_DFL) {
+        // Default action: restore it and re-deliver (faults simply re-trigger on return)
+        sigaction(sig, &prev, NULL);
+        if (sig != SIGSEGV) raise(sig);
+    } else if (prev.sa_handler != SIG_IGN) {
+        prev.sa_handler(sig);
+    }
+}
+
+void secret_registry_install_handlers() {
+    bool expected = false;
+    if (!g_installed.compare_exchange_strong(expected, true)) return;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = wipe_signal_handler;
+    sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&sa.sa_mask);
+
+    for (int i = 0; i < WIPE_SIGNAL_COUNT; i++) {
+        sigaction(WIPE_SIGNALS[i], &sa, &g_previous[i]);
+    }
+}
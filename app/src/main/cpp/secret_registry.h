@@ -0,0 +1,73 @@
+#ifndef FUZZME_V3_SECRET_REGISTRY_H
+#define FUZZME_V3_SECRET_REGISTRY_H
+
+#include <atomic>
+#include <cstddef>
+
+// ========== LIVE SECRET REGISTRY ==========
+// Every region that currently holds plaintext or key material is linked into
+// one global intrusive list, so a crash, a kill or onPause can wipe them all.
+// Insertion is a lock-free push; wipe traversal takes no locks and is
+// async-signal-safe. Removals are serialized among themselves and wait for a
+// running wipe to finish, so the node's memory can be released right after.
+
+enum SecretClass {
+    SECRET_CLASS_PLAINTEXT = 1,  // In-flight plaintext: wiped on pause and on crash
+    SECRET_CLASS_KEY = 2         // Long-lived key material: wiped on crash only
+};
+
+static const int SECRET_CLASS_ALL = SECRET_CLASS_PLAINTEXT | SECRET_CLASS_KEY;
+
+/**
+ * Intrusive registry link, embedded in whatever owns the secret
+ * Must not be copied or moved while registered
+ */
+struct SecretNode {
+    std::atomic<SecretNode *> next{nullptr};
+    std::atomic<void *> ptr{nullptr};
+    std::atomic<size_t> len{0};
+    int secretClass = 0;
+    bool guarded = false;   // May be PROT_NONE: wipes mprotect it back first
+    size_t stride = 0;      // Non-zero: only the first width bytes of every stride are secret
+    size_t width = 0;
+    bool linked = false;
+};
+
+/**
+ * Registers a region (lock-free)
+ *
+ * @param guarded The region is page-aligned and may be PROT_NONE (a mapping
+ *                waiting in the wipe queue)
+ */
+void secret_registry_add(SecretNode *node, void *ptr, size_t len, SecretClass secretClass,
+                         bool guarded = false);
+
+/**
+ * Registers a table of records of which only a prefix is secret (lock-free)
+ * Wipes clear the first width bytes of every stride bytes and leave the
+ * rest, such as an allocator's per-slot canaries, intact
+ */
+void secret_registry_add_strided(SecretNode *node, void *ptr, size_t len, size_t stride,
+                                 size_t width, SecretClass secretClass);
+
+/**
+ * Unregisters a region; on return no wipe is touching it
+ */
+void secret_registry_remove(SecretNode *node);
+
+/**
+ * Zeroes every registered region whose class is in classMask
+ * Async-signal-safe: no locks, no allocation, no TLS (guarded regions are
+ * made writable with mprotect, a plain syscall)
+ *
+ * @return Bytes wiped
+ */
+size_t secret_registry_wipe_all(int classMask);
+
+/**
+ * Installs SIGSEGV/SIGABRT/SIGTERM handlers that wipe everything, then chain
+ * to the previously installed handler (debuggerd, ART's sigchain, ...)
+ */
+void secret_registry_install_handlers();
+
+#endif // FUZZME_V3_SECRET_REGISTRY_H
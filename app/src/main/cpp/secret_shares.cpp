@@ -0,0 +1,268 @@
+#include "secret_shares.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "lock_budget.h"
+#include "native_stats.h"
+#include "sealed_memory.h"
+#include "secure_util.h"
+
+struct SharedSecret {
+    LockedRegion shareA;      // Each share is a whole-page region of its own
+    LockedRegion shareB;
+    size_t len;
+    pthread_mutex_t lock;     // Held while combining or refreshing a chunk
+    bool refreshing;          // The refresh thread is working on it (g_lock)
+    bool unlinked;            // Destroy has started (g_lock)
+    SharedSecret *next;
+};
+
+// ========== SIMD XOR ==========
+
+// GCC/Clang vector extension: lowers to SSE2 on x86 and NEON on ARM
+typedef unsigned char xor_vec16 __attribute__((vector_size(16)));
+
+/**
+ * dst = a ^ b, 64 bytes per iteration (dst may alias a)
+ */
+static void xor_bytes(unsigned char *dst, const unsigned char *a, const unsigned char *b,
+                      size_t len) {
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+        xor_vec16 v[4], w[4];
+        memcpy(v, a + i, 64);
+        memcpy(w, b + i, 64);
+        v[0] ^= w[0];
+        v[1] ^= w[1];
+        v[2] ^= w[2];
+        v[3] ^= w[3];
+        memcpy(dst + i, v, 64);
+    }
+    for (; i + 16 <= len; i += 16) {
+        xor_vec16 v, w;
+        memcpy(&v, a + i, 16);
+        memcpy(&w, b + i, 16);
+        v ^= w;
+        memcpy(dst + i, &v, 16);
+    }
+    for (; i < len; i++) dst[i] = a[i] ^ b[i];
+}
+
+// ========== REFRESH THREAD STATE ==========
+
+// Mask bytes generated per step; also the granularity of the CPU budget
+static const size_t REFRESH_CHUNK = 4096;
+static const uint32_t DEFAULT_INTERVAL_MS = 1000;
+static const uint32_t DEFAULT_CPU_PERMILLE = 10;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_wake;       // Config changed, or a budget sleep
+static pthread_cond_t g_idle;       // A secret stopped being refreshed
+static pthread_once_t g_startOnce = PTHREAD_ONCE_INIT;
+static bool g_started = false;
+static SharedSecret *g_secrets = NULL;
+static uint32_t g_intervalMs = DEFAULT_INTERVAL_MS;
+static uint32_t g_cpuPermille = DEFAULT_CPU_PERMILLE;
+
+static uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * Sleeps on g_wake until the CLOCK_MONOTONIC deadline (g_lock held)
+ */
+static void wait_until(uint64_t deadlineNs) {
+    struct timespec ts;
+    ts.tv_sec = (time_t) (deadlineNs / 1000000000ull);
+    ts.tv_nsec = (long) (deadlineNs % 1000000000ull);
+    pthread_cond_timedwait(&g_wake, &g_lock, &ts);
+}
+
+/**
+ * Re-randomizes one chunk: A ^= R, B ^= R keeps A ^ B unchanged
+ */
+static void refresh_chunk(SharedSecret *s, size_t off, size_t n) {
+    unsigned char mask[REFRESH_CHUNK] __attribute__((aligned(16)));
+    memset(mask, 0, n);
+    sealed_xor_keystream(mask, n, sealed_next_nonce());
+
+    unsigned char *a = (unsigned char *) s->shareA.ptr + off;
+    unsigned char *b = (unsigned char *) s->shareB.ptr + off;
+    pthread_mutex_lock(&s->lock);
+    xor_bytes(a, a, mask, n);
+    xor_bytes(b, b, mask, n);
+    pthread_mutex_unlock(&s->lock);
+
+    secure_wipe_vectorized(mask, n);
+}
+
+/**
+ * One pass over every secret (g_lock held, released while sleeping)
+ * After each chunk the pass sleeps as long as needed to stay within
+ * g_cpuPermille of thread CPU time over the pass's wall time
+ */
+static void refresh_pass() {
+    uint64_t wallStart = clock_ns(CLOCK_MONOTONIC);
+    uint64_t cpuStart = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+
+    SharedSecret *s = g_secrets;
+    while (s && g_intervalMs) {
+        s->refreshing = true;
+        for (size_t off = 0; off < s->len && !s->unlinked; off += REFRESH_CHUNK) {
+            size_t n = s->len - off < REFRESH_CHUNK ? s->len - off : REFRESH_CHUNK;
+            pthread_mutex_unlock(&g_lock);
+            refresh_chunk(s, off, n);
+            pthread_mutex_lock(&g_lock);
+
+            uint64_t cpu = clock_ns(CLOCK_THREAD_CPUTIME_ID) - cpuStart;
+            uint64_t wall = clock_ns(CLOCK_MONOTONIC) - wallStart;
+            uint64_t allowedWall = cpu * 1000 / (g_cpuPermille ? g_cpuPermille : 1);
+            if (allowedWall > wall) {
+                uint64_t deadline = wallStart + allowedWall;
+                while (!s->unlinked && g_intervalMs && clock_ns(CLOCK_MONOTONIC) < deadline) {
+                    wait_until(deadline);
+                }
+            }
+        }
+        // g_lock was dropped for every chunk: the secret may have been
+        // destroyed meanwhile (and its successor too), so s->next is stale
+        bool restart = s->unlinked;
+        s->refreshing = false;
+        pthread_cond_broadcast(&g_idle);
+        s = restart ? g_secrets : s->next;
+    }
+}
+
+static void *refresh_thread_main(void *) {
+    // Background work: run at lower priority than the UI and JNI callers
+    setpriority(PRIO_PROCESS, (id_t) syscall(__NR_gettid), 10);
+
+    pthread_mutex_lock(&g_lock);
+    for (;;) {
+        if (g_intervalMs == 0 || !g_secrets) {
+            pthread_cond_wait(&g_wake, &g_lock);
+            continue;
+        }
+        uint64_t passStart = clock_ns(CLOCK_MONOTONIC);
+        refresh_pass();
+
+        // Sleep out the interval; a config change restarts the wait
+        uint32_t interval = g_intervalMs;
+        uint64_t next = passStart + (uint64_t) interval * 1000000ull;
+        while (interval && g_intervalMs == interval && clock_ns(CLOCK_MONOTONIC) < next) {
+            wait_until(next);
+        }
+    }
+    return NULL;
+}
+
+static void start_refresh_thread() {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_wake, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_cond_init(&g_idle, NULL);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, refresh_thread_main, NULL) == 0) {
+        pthread_detach(thread);
+        g_started = true;
+    }
+}
+
+// ========== PUBLIC API ==========
+
+SharedSecret *shares_create(const void *plaintext, size_t len) {
+    if (!plaintext || len == 0) return NULL;
+
+    SharedSecret *s = (SharedSecret *) calloc(1, sizeof(SharedSecret));
+    if (!s) return NULL;
+
+    // Page-sized requests bypass the shared chunk pool, so the shares never
+    // sit on the same page; both are key material (wiped on crash, not pause)
+    size_t mapLen = page_round_up(len);
+    if (!locked_alloc(&s->shareA, mapLen, LOCK_PRIO_CRITICAL, SECRET_CLASS_KEY) ||
+        !locked_alloc(&s->shareB, mapLen, LOCK_PRIO_CRITICAL, SECRET_CLASS_KEY)) {
+        locked_free(&s->shareA);
+        free(s);
+        return NULL;
+    }
+
+    // A = random, B = secret ^ A
+    unsigned char *a = (unsigned char *) s->shareA.ptr;
+    unsigned char *b = (unsigned char *) s->shareB.ptr;
+    if (!sealed_xor_keystream(a, len, sealed_next_nonce())) {
+        locked_free(&s->shareA);
+        locked_free(&s->shareB);
+        free(s);
+        return NULL;
+    }
+    xor_bytes(b, (const unsigned char *) plaintext, a, len);
+
+    s->len = len;
+    pthread_mutex_init(&s->lock, NULL);
+
+    pthread_once(&g_startOnce, start_refresh_thread);
+    pthread_mutex_lock(&g_lock);
+    s->next = g_secrets;
+    g_secrets = s;
+    pthread_cond_broadcast(&g_wake);
+    pthread_mutex_unlock(&g_lock);
+    return s;
+}
+
+void shares_destroy(SharedSecret *secret) {
+    if (!secret) return;
+
+    pthread_mutex_lock(&g_lock);
+    for (SharedSecret **link = &g_secrets; *link; link = &(*link)->next) {
+        if (*link == secret) {
+            *link = secret->next;
+            break;
+        }
+    }
+    secret->unlinked = true;
+    pthread_cond_broadcast(&g_wake);  // Cut a budget sleep short
+    while (secret->refreshing) pthread_cond_wait(&g_idle, &g_lock);
+    pthread_mutex_unlock(&g_lock);
+
+    locked_free(&secret->shareA);
+    locked_free(&secret->shareB);
+    pthread_mutex_destroy(&secret->lock);
+    free(secret);
+}
+
+size_t shares_len(const SharedSecret *secret) {
+    return secret->len;
+}
+
+bool shares_combine(SharedSecret *secret, void *dst, size_t dstLen) {
+    if (!secret || !dst || dstLen < secret->len) return false;
+
+    pthread_mutex_lock(&secret->lock);
+    xor_bytes((unsigned char *) dst, (const unsigned char *) secret->shareA.ptr,
+              (const unsigned char *) secret->shareB.ptr, secret->len);
+    pthread_mutex_unlock(&secret->lock);
+    return true;
+}
+
+void shares_set_refresh(uint32_t intervalMs, uint32_t cpuPermille) {
+    if (cpuPermille == 0) cpuPermille = 1;
+    if (cpuPermille > 1000) cpuPermille = 1000;
+
+    pthread_once(&g_startOnce, start_refresh_thread);
+    pthread_mutex_lock(&g_lock);
+    g_intervalMs = intervalMs;
+    g_cpuPermille = cpuPermille;
+    pthread_cond_broadcast(&g_wake);
+    pthread_mutex_unlock(&g_lock);
+}
@@ -0,0 +1,47 @@
+#ifndef FUZZME_V3_SECRET_SHARES_H
+#define FUZZME_V3_SECRET_SHARES_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ========== TWO-SHARE SECRET STORAGE ==========
+// A secret is held as two random shares A and B with A ^ B = secret, each on
+// its own locked page, so no single page (or single key) gives it away. The
+// shares are recombined only at use. A low-priority background thread keeps
+// re-randomizing them (A ^= R, B ^= R for fresh random R), so a scraper has
+// to capture both pages within the same refresh interval.
+
+struct SharedSecret;
+
+/**
+ * Splits plaintext into two fresh shares
+ * The caller still owns (and should wipe) the plaintext
+ *
+ * @return Secret, or NULL if the share pages could not be mapped
+ */
+SharedSecret *shares_create(const void *plaintext, size_t len);
+
+/**
+ * Wipes both shares and releases their pages
+ */
+void shares_destroy(SharedSecret *secret);
+
+size_t shares_len(const SharedSecret *secret);
+
+/**
+ * Recombines the secret into dst (SIMD XOR of the two shares)
+ * dst should be locked scratch; the caller wipes it after use
+ *
+ * @return false if dstLen is smaller than the secret
+ */
+bool shares_combine(SharedSecret *secret, void *dst, size_t dstLen);
+
+/**
+ * Configures the background re-randomizer
+ *
+ * @param intervalMs  Time between full passes over all secrets (0 = stop)
+ * @param cpuPermille CPU share the thread may use while a pass runs (1-1000)
+ */
+void shares_set_refresh(uint32_t intervalMs, uint32_t cpuPermille);
+
+#endif // FUZZME_V3_SECRET_SHARES_H
@@ -0,0 +1,359 @@
+#include "secret_timer.h"
+
+#include <cstdlib>
+#include <ctime>
+#include <pthread.h>
+
+#include "jni_util.h"
+#include "secure_util.h"
+
+// ========== WHEEL GEOMETRY ==========
+
+static const int WHEEL_LEVELS = 4;
+static const int WHEEL_BITS = 6;
+static const int WHEEL_SLOTS = 1 << WHEEL_BITS;
+static const uint64_t WHEEL_MASK = WHEEL_SLOTS - 1;
+static const uint64_t WHEEL_RANGE = 1ull << (WHEEL_LEVELS * WHEEL_BITS);
+
+// Timer nodes live in fixed-size chunks so their addresses never move
+static const uint32_t CHUNK_BITS = 10;
+static const uint32_t CHUNK_NODES = 1u << CHUNK_BITS;
+static const uint32_t MAX_CHUNKS = 256;  // 262144 concurrent timers
+
+enum TimerState : uint8_t {
+    TIMER_FREE = 0,
+    TIMER_PENDING,
+    TIMER_FIRING
+};
+
+enum TimerKind : uint8_t {
+    TIMER_WIPE_REGION = 0,
+    TIMER_WIPE_JAVA
+};
+
+struct TimerNode {
+    TimerNode *prev;
+    TimerNode *next;        // Slot list link, or free list link when TIMER_FREE
+    uint64_t expires;       // Tick (ms since wheel start)
+    uint32_t index;
+    uint32_t generation;    // Bumped on every reuse so stale handles miss
+    TimerState state;
+    TimerKind kind;
+    void *ptr;              // Native region, or global ref to a char[]
+    size_t len;
+};
+
+// ========== WHEEL STATE (guarded by g_lock) ==========
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_wake;       // Wipe thread sleeps on this
+static pthread_cond_t g_fired;      // Cancel waits here for an in-flight wipe
+static pthread_once_t g_startOnce = PTHREAD_ONCE_INIT;
+static bool g_started = false;
+
+static TimerNode g_slots[WHEEL_LEVELS][WHEEL_SLOTS];  // List sentinels
+static TimerNode *g_chunks[MAX_CHUNKS];
+static uint32_t g_chunkCount = 0;
+static TimerNode *g_freeList = nullptr;
+static size_t g_pending = 0;
+static bool g_firing = false;       // A wipe is running with g_lock dropped
+
+static uint64_t g_tick = 0;         // Last processed tick
+static uint64_t g_originNs = 0;     // CLOCK_MONOTONIC at tick 0
+
+static uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static uint64_t current_tick() {
+    return (monotonic_ns() - g_originNs) / 1000000ull;
+}
+
+// ========== INTRUSIVE LISTS ==========
+
+static void list_init(TimerNode *head) {
+    head->prev = head->next = head;
+}
+
+static bool list_empty(const TimerNode *head) {
+    return head->next == head;
+}
+
+static void list_push(TimerNode *head, TimerNode *node) {
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+static void list_unlink(TimerNode *node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = node->next = nullptr;
+}
+
+// ========== NODE POOL ==========
+
+static TimerNode *node_alloc() {
+    if (!g_freeList) {
+        if (g_chunkCount == MAX_CHUNKS) return nullptr;
+        TimerNode *chunk = (TimerNode *) calloc(CHUNK_NODES, sizeof(TimerNode));
+        if (!chunk) return nullptr;
+        for (uint32_t i = CHUNK_NODES; i-- > 0;) {
+            chunk[i].index = (g_chunkCount << CHUNK_BITS) | i;
+            chunk[i].next = g_freeList;
+            g_freeList = &chunk[i];
+        }
+        g_chunks[g_chunkCount++] = chunk;
+    }
+    TimerNode *node = g_freeList;
+    g_freeList = node->next;
+    node->generation++;
+    return node;
+}
+
+static void node_free(TimerNode *node) {
+    node->state = TIMER_FREE;
+    node->ptr = nullptr;
+    node->len = 0;
+    node->next = g_freeList;
+    g_freeList = node;
+}
+
+static uint64_t node_handle(const TimerNode *node) {
+    return ((uint64_t) node->generation << 32) | node->index;
+}
+
+static TimerNode *node_lookup(uint64_t handle) {
+    uint32_t index = (uint32_t) handle;
+    uint32_t chunk = index >> CHUNK_BITS;
+    if (chunk >= g_chunkCount) return nullptr;
+    TimerNode *node = &g_chunks[chunk][index & (CHUNK_NODES - 1)];
+    return node->generation == (uint32_t) (handle >> 32) ? node : nullptr;
+}
+
+// ========== WHEEL OPERATIONS ==========
+
+/**
+ * Files a node into the level whose span covers its remaining delay
+ * The delay is measured from the next tick to be processed, which keeps a
+ * cascaded node from landing back in the slot that is being emptied
+ */
+static void wheel_insert(TimerNode *node) {
+    uint64_t base = g_tick + 1;
+    if (node->expires < base) node->expires = base;
+    uint64_t delta = node->expires - base;
+    if (delta >= WHEEL_RANGE) {
+        node->expires = base + WHEEL_RANGE - 1;
+        delta = WHEEL_RANGE - 1;
+    }
+
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >= (1ull << ((level + 1) * WHEEL_BITS))) {
+        level++;
+    }
+    uint64_t slot = (node->expires >> (level * WHEEL_BITS)) & WHEEL_MASK;
+    list_push(&g_slots[level][slot], node);
+}
+
+/**
+ * Moves every node of a higher-level slot down now that its span has begun
+ */
+static void wheel_cascade(int level, uint64_t slot) {
+    TimerNode *head = &g_slots[level][slot];
+    while (!list_empty(head)) {
+        TimerNode *node = head->next;
+        list_unlink(node);
+        wheel_insert(node);
+    }
+}
+
+/**
+ * Runs the wipe for one expired node (called without g_lock held)
+ */
+static void fire(TimerNode *node) {
+    if (node->kind == TIMER_WIPE_REGION) {
+        secure_memzero(node->ptr, node->len);
+        return;
+    }
+
+    JNIEnv *env = jni_attach_current_thread();
+    if (!env) return;
+    jcharArray array = (jcharArray) node->ptr;
+    jni_wipe_char_array(env, array);
+    env->DeleteGlobalRef(array);
+}
+
+/**
+ * Advances the wheel by one tick and fires that tick's slot
+ */
+static void wheel_advance() {
+    uint64_t t = g_tick + 1;
+
+    // Cascade while g_tick still points at the previous tick, so nodes due
+    // exactly at t land in level 0 and fire below
+    for (int level = 1; level < WHEEL_LEVELS; level++) {
+        if ((t & ((1ull << (level * WHEEL_BITS)) - 1)) != 0) break;
+        wheel_cascade(level, (t >> (level * WHEEL_BITS)) & WHEEL_MASK);
+    }
+    g_tick = t;
+
+    TimerNode *head = &g_slots[0][t & WHEEL_MASK];
+    while (!list_empty(head)) {
+        TimerNode *node = head->next;
+        list_unlink(node);
+        node->state = TIMER_FIRING;
+        g_pending--;
+
+        g_firing = true;
+        pthread_mutex_unlock(&g_lock);
+        fire(node);
+        pthread_mutex_lock(&g_lock);
+        g_firing = false;
+
+        node_free(node);
+        pthread_cond_broadcast(&g_fired);
+    }
+}
+
+/**
+ * Tick at which the wipe thread must next wake up
+ * Scans level 0 for the nearest timer, otherwise sleeps to the next cascade
+ */
+static uint64_t next_wake_tick() {
+    for (uint64_t t = g_tick + 1; t <= g_tick + WHEEL_SLOTS; t++) {
+        if (!list_empty(&g_slots[0][t & WHEEL_MASK])) return t;
+        if ((t & WHEEL_MASK) == 0) return t;
+    }
+    return g_tick + WHEEL_SLOTS;
+}
+
+static void *wipe_thread_main(void *) {
+    pthread_mutex_lock(&g_lock);
+    for (;;) {
+        uint64_t now = current_tick();
+        while (g_tick < now && g_pending > 0) wheel_advance();
+        if (g_tick < now) g_tick = now;  // Nothing queued: skip idle ticks
+
+        if (g_pending == 0) {
+            pthread_cond_wait(&g_wake, &g_lock);
+            continue;
+        }
+
+        uint64_t wakeNs = g_originNs + next_wake_tick() * 1000000ull;
+        struct timespec deadline;
+        deadline.tv_sec = (time_t) (wakeNs / 1000000000ull);
+        deadline.tv_nsec = (long) (wakeNs % 1000000000ull);
+        pthread_cond_timedwait(&g_wake, &g_lock, &deadline);
+    }
+    return nullptr;
+}
+
+static void start_wipe_thread() {
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < WHEEL_SLOTS; slot++) list_init(&g_slots[level][slot]);
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_wake, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_cond_init(&g_fired, NULL);
+
+    g_originNs = monotonic_ns();
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, wipe_thread_main, NULL) == 0) {
+        pthread_detach(thread);
+        g_started = true;
+    }
+}
+
+// ========== PUBLIC API ==========
+
+static uint64_t timer_add(TimerKind kind, void *ptr, size_t len, uint32_t ttlMs) {
+    pthread_once(&g_startOnce, start_wipe_thread);
+    if (!g_started) return 0;
+
+    pthread_mutex_lock(&g_lock);
+    TimerNode *node = node_alloc();
+    if (!node) {
+        pthread_mutex_unlock(&g_lock);
+        return 0;
+    }
+    node->kind = kind;
+    node->ptr = ptr;
+    node->len = len;
+    node->state = TIMER_PENDING;
+    // An idle wheel stops at its last fire and may be hours behind, further
+    // than WHEEL_RANGE: bring it to now so the deadline is not clamped into
+    // the past (and the wipe thread has no idle ticks to walk through)
+    if (g_pending == 0 && !g_firing) g_tick = current_tick();
+    // Deadline is measured from now, not from the (possibly lagging) wheel tick
+    node->expires = current_tick() + (ttlMs ? ttlMs : 1);
+    wheel_insert(node);
+    g_pending++;
+    uint64_t handle = node_handle(node);
+    pthread_cond_signal(&g_wake);
+    pthread_mutex_unlock(&g_lock);
+    return handle;
+}
+
+uint64_t secret_timer_add_region(void *ptr, size_t len, uint32_t ttlMs) {
+    if (!ptr || len == 0) return 0;
+    return timer_add(TIMER_WIPE_REGION, ptr, len, ttlMs);
+}
+
+uint64_t secret_timer_add_java(JNIEnv *env, jcharArray array, uint32_t ttlMs) {
+    if (!env || !array || !jni_vm()) return 0;
+
+    jobject ref = env->NewGlobalRef(array);
+    if (!ref) return 0;
+
+    uint64_t handle = timer_add(TIMER_WIPE_JAVA, ref, 0, ttlMs);
+    if (!handle) env->DeleteGlobalRef(ref);
+    return handle;
+}
+
+bool secret_timer_cancel(uint64_t handle) {
+    if (!handle || !g_started) return false;
+
+    pthread_mutex_lock(&g_lock);
+    TimerNode *node = node_lookup(handle);
+    if (!node || node->state == TIMER_FREE) {
+        pthread_mutex_unlock(&g_lock);
+        return false;
+    }
+
+    // Already wiping: wait so the caller can safely free the memory afterwards
+    if (node->state == TIMER_FIRING) {
+        while (node->generation == (uint32_t) (handle >> 32) && node->state == TIMER_FIRING) {
+            pthread_cond_wait(&g_fired, &g_lock);
+        }
+        pthread_mutex_unlock(&g_lock);
+        return false;
+    }
+
+    list_unlink(node);
+    g_pending--;
+    TimerKind kind = node->kind;
+    void *ptr = node->ptr;
+    node_free(node);
+    pthread_mutex_unlock(&g_lock);
+
+    if (kind == TIMER_WIPE_JAVA) {
+        JNIEnv *env = jni_attach_current_thread();
+        if (env) env->DeleteGlobalRef((jobject) ptr);
+    }
+    return true;
+}
+
+size_t secret_timer_pending() {
+    pthread_mutex_lock(&g_lock);
+    size_t pending = g_pending;
+    pthread_mutex_unlock(&g_lock);
+    return pending;
+}
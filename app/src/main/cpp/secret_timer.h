@@ -0,0 +1,43 @@
+#ifndef FUZZME_V3_SECRET_TIMER_H
+#define FUZZME_V3_SECRET_TIMER_H
+
+#include <jni.h>
+#include <cstddef>
+#include <cstdint>
+
+// ========== SECRET TTL TIMERS ==========
+// A hierarchical timer wheel (1 ms ticks, 4 levels x 64 slots, ~4.6 h range)
+// driven by a dedicated native wipe thread. A registered buffer is wiped when
+// its deadline passes even if the UI thread is stalled.
+// Registration and cancellation are O(1); handles are never reused (0 = invalid).
+
+/**
+ * Wipes native memory after ttlMs
+ * The caller must cancel the timer before freeing the memory
+ *
+ * @return Timer handle, or 0 if no timer could be allocated
+ */
+uint64_t secret_timer_add_region(void *ptr, size_t len, uint32_t ttlMs);
+
+/**
+ * Wipes a Java char[] after ttlMs (a global reference keeps it alive until then)
+ *
+ * @return Timer handle, or 0 on failure
+ */
+uint64_t secret_timer_add_java(JNIEnv *env, jcharArray array, uint32_t ttlMs);
+
+/**
+ * Cancels a pending timer
+ * If the wipe is running right now this waits for it to finish, so the memory
+ * may be released as soon as this returns
+ *
+ * @return true if the timer was still pending (nothing was wiped)
+ */
+bool secret_timer_cancel(uint64_t handle);
+
+/**
+ * Number of timers waiting to fire
+ */
+size_t secret_timer_pending();
+
+#endif // FUZZME_V3_SECRET_TIMER_H
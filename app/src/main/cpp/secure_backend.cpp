@@ -0,0 +1,213 @@
+#include "secure_backend.h"
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "native_stats.h"
+#include "secure_util.h"
+
+#ifndef __NR_memfd_secret
+#define __NR_memfd_secret 447
+#endif
+#ifndef MADV_DONTDUMP
+#define MADV_DONTDUMP 16
+#endif
+#ifndef MADV_WIPEONFORK
+#define MADV_WIPEONFORK 18
+#endif
+
+// Regions this large ask for transparent huge pages (fewer TLB entries)
+static const size_t HUGEPAGE_HINT_BYTES = 2 * 1024 * 1024;
+
+/**
+ * Attributes every secret mapping gets, regardless of backend
+ * Errors are ignored: WIPEONFORK is rejected on shared (memfd_secret) mappings,
+ * which are not inherited readable by children anyway
+ */
+static void apply_common_advice(void *ptr, size_t len) {
+    madvise(ptr, len, MADV_DONTDUMP);
+    madvise(ptr, len, MADV_WIPEONFORK);
+}
+
+// ========== memfd_secret ==========
+
+/**
+ * Tries the syscall once
+ * On Android an unknown syscall trips the app seccomp filter (SIGSYS), so the
+ * first attempt is made in a throwaway child process
+ */
+static bool memfd_secret_probe() {
+#ifdef __ANDROID__
+    pid_t pid = fork();
+    if (pid == 0) {
+        signal(SIGSYS, SIG_DFL);
+        long fd = syscall(__NR_memfd_secret, O_CLOEXEC);
+        _exit(fd >= 0 ? 0 : 1);
+    }
+    if (pid < 0) return false;
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid) return false;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#else
+    long fd = syscall(__NR_memfd_secret, O_CLOEXEC);
+    if (fd < 0) return false;
+    close((int) fd);
+    return true;
+#endif
+}
+
+static void *memfd_secret_map(size_t len, bool wantLock, bool *locked) {
+    // Secret memory is always pinned and charged to RLIMIT_MEMLOCK; going over
+    // the limit would SIGBUS on first touch, so it needs an admitted budget
+    if (!wantLock) return NULL;
+
+    long fd = syscall(__NR_memfd_secret, O_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    void *mem = MAP_FAILED;
+    if (ftruncate((int) fd, (off_t) len) == 0) {
+        mem = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, (int) fd, 0);
+    }
+    close((int) fd);  // The mapping keeps the file alive
+
+    // Pinned by the kernel without an mlock() call, so STAT_MLOCK_CALLS stays put
+    if (mem == MAP_FAILED) return NULL;
+    *locked = true;
+    return mem;
+}
+
+static void memfd_secret_unmap(void *ptr, size_t len, bool locked) {
+    munmap(ptr, len);
+}
+
+// ========== MAP_LOCKED | MAP_POPULATE ==========
+
+static bool map_locked_probe() {
+    return true;
+}
+
+static void *map_locked_map(size_t len, bool wantLock, bool *locked) {
+    if (!wantLock) return NULL;
+
+    void *mem = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_LOCKED | MAP_POPULATE, -1, 0);
+    stats_mlock(mem == MAP_FAILED ? -1 : 0);
+    if (mem == MAP_FAILED) return NULL;
+    if (len >= HUGEPAGE_HINT_BYTES) madvise(mem, len, MADV_HUGEPAGE);
+    *locked = true;
+    return mem;
+}
+
+static void map_locked_unmap(void *ptr, size_t len, bool locked) {
+    munmap(ptr, len);
+}
+
+// ========== mmap + mlock ==========
+
+static bool mlock_probe() {
+    return true;
+}
+
+/**
+ * Last resort: always returns memory if the kernel has any, locked if possible
+ */
+static void *mlock_map(size_t len, bool wantLock, bool *locked) {
+    void *mem = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return NULL;
+
+    *locked = false;
+    if (wantLock) {
+        int rc = mlock(mem, len);
+        stats_mlock(rc);
+        *locked = rc == 0;
+    }
+    return mem;
+}
+
+static void mlock_unmap(void *ptr, size_t len, bool locked) {
+    if (locked) munlock(ptr, len);
+    munmap(ptr, len);
+}
+
+// ========== SELECTION ==========
+
+static const SecureBackend BACKENDS[BACKEND_COUNT] = {
+        {"memfd_secret", memfd_secret_probe, memfd_secret_map, memfd_secret_unmap},
+        {"map_locked",   map_locked_probe,   map_locked_map,   map_locked_unmap},
+        {"mlock",        mlock_probe,        mlock_map,        mlock_unmap},
+};
+
+static bool g_supported[BACKEND_COUNT];
+static std::atomic<int> g_selected{BACKEND_MLOCK};
+static pthread_once_t g_probeOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Probes every backend once and selects the strongest one available
+ */
+static void probe_backends() {
+    int best = BACKEND_MLOCK;
+    for (int k = BACKEND_COUNT - 1; k >= 0; k--) {
+        g_supported[k] = BACKENDS[k].probe();
+        if (g_supported[k]) best = k;
+    }
+    g_selected.store(best, std::memory_order_relaxed);
+}
+
+SecureBackendKind backend_selected() {
+    pthread_once(&g_probeOnce, probe_backends);
+    return (SecureBackendKind) g_selected.load(std::memory_order_relaxed);
+}
+
+bool backend_select(SecureBackendKind kind) {
+    pthread_once(&g_probeOnce, probe_backends);
+    if (kind < 0 || kind >= BACKEND_COUNT || !g_supported[kind]) return false;
+    g_selected.store(kind, std::memory_order_relaxed);
+    return true;
+}
+
+const char *backend_name(SecureBackendKind kind) {
+    return kind >= 0 && kind < BACKEND_COUNT ? BACKENDS[kind].name : "unknown";
+}
+
+void *backend_map(size_t len, LockPriority prio, bool *locked, SecureBackendKind *kind) {
+    // One admission per mapping; backends that can only hand out pinned pages
+    // step aside when the budget says no
+    bool admitted = lock_budget_acquire(len, prio);
+
+    for (int k = backend_selected(); k < BACKEND_COUNT; k++) {
+        if (!g_supported[k]) continue;
+
+        bool isLocked = false;
+        void *mem = BACKENDS[k].map(len, admitted, &isLocked);
+        if (!mem) continue;
+
+        if (admitted && !isLocked) lock_budget_release(len);
+        apply_common_advice(mem, len);
+        *locked = isLocked;
+        *kind = (SecureBackendKind) k;
+        return mem;
+    }
+
+    if (admitted) lock_budget_release(len);
+    return NULL;
+}
+
+void backend_unmap(void *ptr, size_t len, bool locked, SecureBackendKind kind) {
+    if (!ptr || kind < 0 || kind >= BACKEND_COUNT) return;
+    BACKENDS[kind].unmap(ptr, len, locked);
+    if (locked) lock_budget_release(len);
+}
+
+void backend_wipe(void *ptr, size_t len) {
+    if (!ptr || len == 0) return;
+    stats_add(STAT_BYTES_WIPED, len);
+    secure_wipe(ptr, len);
+}
@@ -0,0 +1,68 @@
+#ifndef FUZZME_V3_SECURE_BACKEND_H
+#define FUZZME_V3_SECURE_BACKEND_H
+
+#include <cstddef>
+
+#include "lock_budget.h"
+
+// ========== SECURE MEMORY BACKENDS ==========
+// How pages that hold secrets are obtained and pinned. The best backend the
+// kernel supports is picked once at runtime; each map call still falls back
+// down the list when its preferred backend fails (e.g. over budget).
+
+enum SecureBackendKind {
+    BACKEND_MEMFD_SECRET = 0,  // Pages removed from the kernel direct map (Linux 5.14+)
+    BACKEND_MAP_LOCKED,        // mmap(MAP_LOCKED | MAP_POPULATE), faulted in up front
+    BACKEND_MLOCK,             // Plain anonymous mmap + mlock
+    BACKEND_COUNT
+};
+
+/**
+ * One way of mapping locked memory
+ * map() returns page-aligned memory (len is already page rounded) or NULL
+ * and reports through *locked whether the pages are pinned; wantLock is false
+ * when the budget refused the request. Budget accounting stays in backend_map()
+ */
+struct SecureBackend {
+    const char *name;
+    bool (*probe)();
+    void *(*map)(size_t len, bool wantLock, bool *locked);
+    void (*unmap)(void *ptr, size_t len, bool locked);
+};
+
+/**
+ * Maps secret memory with the selected backend, falling back to the next ones
+ * MADV_DONTDUMP and MADV_WIPEONFORK are applied whichever backend succeeds
+ *
+ * @param len     Page-rounded length
+ * @param prio    Budget priority
+ * @param locked  Receives whether the pages are locked
+ * @param kind    Receives the backend that produced the mapping
+ * @return Mapping, or NULL if even an unlocked mapping failed
+ */
+void *backend_map(size_t len, LockPriority prio, bool *locked, SecureBackendKind *kind);
+
+/**
+ * Releases a mapping made by backend_map() (caller wipes first)
+ */
+void backend_unmap(void *ptr, size_t len, bool locked, SecureBackendKind kind);
+
+/**
+ * Wipes [ptr, ptr + len) inside a mapping from backend_map(), which stays usable
+ * (byte writes, whatever the backend)
+ */
+void backend_wipe(void *ptr, size_t len);
+
+/**
+ * Backend that new mappings try first
+ */
+SecureBackendKind backend_selected();
+
+/**
+ * Forces a backend (e.g. to compare them); fails if the kernel lacks it
+ */
+bool backend_select(SecureBackendKind kind);
+
+const char *backend_name(SecureBackendKind kind);
+
+#endif // FUZZME_V3_SECURE_BACKEND_H
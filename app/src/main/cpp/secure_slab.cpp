@@ -0,0 +1,383 @@
+#include "secure_slab.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "secure_backend.h"
+#include "secure_util.h"
+
+// ========== LAYOUT ==========
+// A slab is one locked page: header, then slots of stride size + canary.
+// Only the payloads are registered (strided), so an emergency wipe clears
+// them but never the canaries or the header's bookkeeping.
+
+static const size_t SIZE_CLASSES[] = {16, 32, 48, 64, 96, 128, 192, 256};
+static const int CLASS_COUNT = sizeof(SIZE_CLASSES) / sizeof(SIZE_CLASSES[0]);
+// PLAINTEXT and KEY slots never share a slab (they are wiped at different times)
+static const int KIND_COUNT = 2;
+
+static const size_t CANARY_BYTES = sizeof(uint64_t);
+// Canary of a slot sitting in a magazine or the depot
+static const uint64_t FREED_TAG = 0xf4eef4eef4eef4eeull;
+static const uint64_t SLAB_MAGIC = 0x5ecb51ab5ecb51abull;
+
+// Slots a thread caches per class; refills and flushes move half of this
+static const int MAGAZINE_SLOTS = 32;
+
+struct SlabCache;
+
+struct SlabHeader {
+    uint64_t magic;
+    SlabCache *cache;
+    unsigned char *slots;
+    uint32_t slotCount;
+    SecureBackendKind backend;
+    SlabHeader *next;
+    uint8_t *freeMap;       // Scratch for slab_trim(): slot is in the depot
+    uint32_t freeCount;     // Scratch for slab_trim()
+    SecretNode registryNode;
+};
+
+struct SlabCache {
+    pthread_mutex_t lock;
+    size_t size;            // Object size of this class
+    size_t stride;          // size + canary
+    SecretClass secretClass;
+    void **depot;           // Free slots not held by any thread
+    size_t depotCount;
+    size_t depotCap;
+    SlabHeader *slabs;
+};
+
+struct Magazine {
+    int count;
+    void *slots[MAGAZINE_SLOTS];
+};
+
+struct ThreadMagazines {
+    Magazine mags[KIND_COUNT][CLASS_COUNT];
+    uint32_t epoch;         // Trim epoch the magazines were last returned in
+};
+
+static SlabCache g_caches[KIND_COUNT][CLASS_COUNT];
+static pthread_once_t g_initOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t g_magKey;
+static uint64_t g_canarySecret = 0;
+// Bumped by slab_trim(): every thread returns its magazines on its next call
+static std::atomic<uint32_t> g_trimEpoch{0};
+
+static thread_local ThreadMagazines *t_mags = nullptr;
+
+// ========== CANARIES ==========
+
+/**
+ * Expected canary of a live slot: unguessable and different for every slot
+ */
+static uint64_t canary_for(const unsigned char *slot) {
+    return g_canarySecret ^ (uint64_t) (uintptr_t) slot;
+}
+
+static uint64_t canary_read(const unsigned char *slot, size_t size) {
+    uint64_t v;
+    memcpy(&v, slot + size, CANARY_BYTES);
+    return v;
+}
+
+static void canary_write(unsigned char *slot, size_t size, uint64_t v) {
+    memcpy(slot + size, &v, CANARY_BYTES);
+}
+
+// ========== DEPOT ==========
+
+static void flush_magazine(SlabCache *cache, Magazine *mag, int keep);
+
+/**
+ * Returns a thread's magazines to the depots when it exits
+ */
+static void return_magazines(ThreadMagazines *mags) {
+    for (int k = 0; k < KIND_COUNT; k++) {
+        for (int c = 0; c < CLASS_COUNT; c++) {
+            flush_magazine(&g_caches[k][c], &mags->mags[k][c], 0);
+        }
+    }
+    mags->epoch = g_trimEpoch.load(std::memory_order_acquire);
+}
+
+static void release_thread_magazines(void *arg) {
+    return_magazines((ThreadMagazines *) arg);
+    t_mags = nullptr;
+    free(arg);
+}
+
+static void slab_init() {
+    if (syscall(SYS_getrandom, &g_canarySecret, sizeof(g_canarySecret), 0) !=
+        (long) sizeof(g_canarySecret)) {
+        // Canaries catch overflows, they guard no secret: a weaker seed will do
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        g_canarySecret = ((uint64_t) ts.tv_nsec << 32) ^ (uint64_t) (uintptr_t) &ts ^ SLAB_MAGIC;
+    }
+
+    for (int k = 0; k < KIND_COUNT; k++) {
+        for (int c = 0; c < CLASS_COUNT; c++) {
+            SlabCache *cache = &g_caches[k][c];
+            pthread_mutex_init(&cache->lock, NULL);
+            cache->size = SIZE_CLASSES[c];
+            cache->stride = SIZE_CLASSES[c] + CANARY_BYTES;
+            cache->secretClass = k ? SECRET_CLASS_KEY : SECRET_CLASS_PLAINTEXT;
+        }
+    }
+    pthread_key_create(&g_magKey, release_thread_magazines);
+}
+
+static bool depot_reserve(SlabCache *cache, size_t extra) {
+    if (cache->depotCount + extra <= cache->depotCap) return true;
+    size_t cap = cache->depotCap ? cache->depotCap * 2 : 256;
+    while (cap < cache->depotCount + extra) cap *= 2;
+    void **grown = (void **) realloc(cache->depot, cap * sizeof(void *));
+    if (!grown) return false;
+    cache->depot = grown;
+    cache->depotCap = cap;
+    return true;
+}
+
+/**
+ * Maps and carves one more slab into the depot (cache lock held)
+ */
+static bool grow_cache(SlabCache *cache, LockPriority prio) {
+    size_t ps = page_size();
+    size_t hdr = (sizeof(SlabHeader) + 15) & ~(size_t) 15;
+    uint32_t count = (uint32_t) ((ps - hdr) / cache->stride);
+    if (!depot_reserve(cache, count)) return false;
+
+    uint8_t *freeMap = (uint8_t *) calloc(count, sizeof(uint8_t));
+    if (!freeMap) return false;
+
+    // Slots are only worth it locked; the caller falls back otherwise
+    bool locked = false;
+    SecureBackendKind backend;
+    unsigned char *page = (unsigned char *) backend_map(ps, prio, &locked, &backend);
+    if (page && !locked) {
+        backend_unmap(page, ps, false, backend);
+        page = NULL;
+    }
+    if (!page) {
+        free(freeMap);
+        return false;
+    }
+
+    SlabHeader *slab = new (page) SlabHeader();
+    slab->magic = SLAB_MAGIC;
+    slab->cache = cache;
+    slab->slots = page + hdr;
+    slab->slotCount = count;
+    slab->backend = backend;
+    slab->freeMap = freeMap;
+    slab->next = cache->slabs;
+    cache->slabs = slab;
+
+    for (uint32_t i = count; i-- > 0;) {
+        unsigned char *slot = slab->slots + (size_t) i * cache->stride;
+        canary_write(slot, cache->size, canary_for(slot) ^ FREED_TAG);
+        cache->depot[cache->depotCount++] = slot;
+    }
+    secret_registry_add_strided(&slab->registryNode, slab->slots, (size_t) count * cache->stride,
+                                cache->stride, cache->size, cache->secretClass);
+    return true;
+}
+
+/**
+ * Fills an empty magazine with half a magazine from the depot
+ */
+static bool refill_magazine(SlabCache *cache, Magazine *mag, LockPriority prio) {
+    pthread_mutex_lock(&cache->lock);
+    if (cache->depotCount == 0 && !grow_cache(cache, prio)) {
+        pthread_mutex_unlock(&cache->lock);
+        return false;
+    }
+    int n = MAGAZINE_SLOTS / 2;
+    if ((size_t) n > cache->depotCount) n = (int) cache->depotCount;
+    cache->depotCount -= n;
+    memcpy(mag->slots, cache->depot + cache->depotCount, n * sizeof(void *));
+    mag->count = n;
+    pthread_mutex_unlock(&cache->lock);
+    return true;
+}
+
+/**
+ * Moves all but keep slots of a magazine to the depot
+ */
+static void flush_magazine(SlabCache *cache, Magazine *mag, int keep) {
+    int n = mag->count - keep;
+    if (n <= 0) return;
+
+    pthread_mutex_lock(&cache->lock);
+    // The depot was sized for every slot ever carved, so this cannot fail
+    depot_reserve(cache, n);
+    memcpy(cache->depot + cache->depotCount, mag->slots + keep, n * sizeof(void *));
+    cache->depotCount += n;
+    pthread_mutex_unlock(&cache->lock);
+    mag->count = keep;
+}
+
+static ThreadMagazines *thread_magazines() {
+    if (!t_mags) {
+        t_mags = (ThreadMagazines *) calloc(1, sizeof(ThreadMagazines));
+        if (!t_mags) return NULL;
+        t_mags->epoch = g_trimEpoch.load(std::memory_order_acquire);
+        pthread_setspecific(g_magKey, t_mags);
+    } else if (t_mags->epoch != g_trimEpoch.load(std::memory_order_relaxed)) {
+        return_magazines(t_mags);
+    }
+    return t_mags;
+}
+
+static int class_index(size_t len) {
+    for (int c = 0; c < CLASS_COUNT; c++) {
+        if (len <= SIZE_CLASSES[c]) return c;
+    }
+    return -1;
+}
+
+/**
+ * Finds the slab a slot belongs to; aborts on pointers we never handed out
+ */
+static SlabHeader *slab_of(const void *ptr) {
+    SlabHeader *slab = (SlabHeader *) ((uintptr_t) ptr & ~(uintptr_t) (page_size() - 1));
+    if (slab->magic != SLAB_MAGIC) abort();
+    size_t off = (size_t) ((const unsigned char *) ptr - slab->slots);
+    if ((const unsigned char *) ptr < slab->slots || off % slab->cache->stride != 0) abort();
+    return slab;
+}
+
+static uint32_t slot_index(const SlabHeader *slab, const void *slot) {
+    return (uint32_t) ((size_t) ((const unsigned char *) slot - slab->slots) / slab->cache->stride);
+}
+
+// ========== PUBLIC API ==========
+
+void *slab_alloc(size_t len, LockPriority prio, SecretClass secretClass) {
+    int c = class_index(len);
+    if (len == 0 || c < 0) return NULL;
+
+    pthread_once(&g_initOnce, slab_init);
+    ThreadMagazines *mags = thread_magazines();
+    if (!mags) return NULL;
+
+    int kind = secretClass == SECRET_CLASS_KEY ? 1 : 0;
+    SlabCache *cache = &g_caches[kind][c];
+    Magazine *mag = &mags->mags[kind][c];
+    if (mag->count == 0 && !refill_magazine(cache, mag, prio)) return NULL;
+
+    // Payload is already zero: fresh pages are, and free wipes
+    unsigned char *slot = (unsigned char *) mag->slots[--mag->count];
+    canary_write(slot, cache->size, canary_for(slot));
+    return slot;
+}
+
+void slab_free(void *ptr) {
+    if (!ptr) return;
+
+    SlabHeader *slab = slab_of(ptr);
+    SlabCache *cache = slab->cache;
+    unsigned char *slot = (unsigned char *) ptr;
+
+    // Anything but the live value is an overflow or a double free (emergency
+    // wipes leave canaries alone, so a wiped live slot still passes)
+    uint64_t canary = canary_read(slot, cache->size);
+    uint64_t live = canary_for(slot);
+    if (canary != live) abort();
+
+    // Vector stores: a per-line flush would triple the cost of a small free
+    secure_wipe_vectorized(slot, cache->size);
+    canary_write(slot, cache->size, live ^ FREED_TAG);
+
+    ThreadMagazines *mags = thread_magazines();
+    int kind = cache->secretClass == SECRET_CLASS_KEY ? 1 : 0;
+    int c = (int) (cache - g_caches[kind]);
+    if (!mags) {
+        // Out of memory for a magazine: hand the slot straight to the depot
+        Magazine single;
+        single.count = 1;
+        single.slots[0] = slot;
+        flush_magazine(cache, &single, 0);
+        return;
+    }
+
+    Magazine *mag = &mags->mags[kind][c];
+    if (mag->count == MAGAZINE_SLOTS) flush_magazine(cache, mag, MAGAZINE_SLOTS / 2);
+    mag->slots[mag->count++] = slot;
+}
+
+size_t slab_usable_size(const void *ptr) {
+    return slab_of(ptr)->cache->size;
+}
+
+// ========== TRIMMING ==========
+
+/**
+ * Unmaps fully free slabs (cache lock held)
+ */
+static size_t trim_cache(SlabCache *cache) {
+    if (!cache->slabs) return 0;
+
+    for (SlabHeader *slab = cache->slabs; slab; slab = slab->next) {
+        slab->freeCount = 0;
+        memset(slab->freeMap, 0, slab->slotCount);
+    }
+    for (size_t j = 0; j < cache->depotCount; j++) {
+        SlabHeader *slab = slab_of(cache->depot[j]);
+        slab->freeMap[slot_index(slab, cache->depot[j])] = 1;
+        slab->freeCount++;
+    }
+
+    // Drop the slots of empty slabs from the depot, then the slabs themselves
+    size_t kept = 0;
+    for (size_t j = 0; j < cache->depotCount; j++) {
+        SlabHeader *slab = slab_of(cache->depot[j]);
+        if (slab->freeCount != slab->slotCount) cache->depot[kept++] = cache->depot[j];
+    }
+    cache->depotCount = kept;
+
+    size_t released = 0;
+    SlabHeader **link = &cache->slabs;
+    while (*link) {
+        SlabHeader *slab = *link;
+        if (slab->freeCount != slab->slotCount) {
+            link = &slab->next;
+            continue;
+        }
+        *link = slab->next;
+        secret_registry_remove(&slab->registryNode);
+        secure_wipe(slab->slots, (size_t) slab->slotCount * cache->stride);
+        free(slab->freeMap);
+        backend_unmap(slab, page_size(), true, slab->backend);
+        released += page_size();
+    }
+    return released;
+}
+
+size_t slab_trim() {
+    pthread_once(&g_initOnce, slab_init);
+
+    g_trimEpoch.fetch_add(1, std::memory_order_acq_rel);
+    if (t_mags) return_magazines(t_mags);
+
+    size_t released = 0;
+    for (int k = 0; k < KIND_COUNT; k++) {
+        for (int c = 0; c < CLASS_COUNT; c++) {
+            SlabCache *cache = &g_caches[k][c];
+            pthread_mutex_lock(&cache->lock);
+            released += trim_cache(cache);
+            pthread_mutex_unlock(&cache->lock);
+        }
+    }
+    return released;
+}
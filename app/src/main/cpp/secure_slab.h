@@ -0,0 +1,54 @@
+#ifndef FUZZME_V3_SECURE_SLAB_H
+#define FUZZME_V3_SECURE_SLAB_H
+
+#include <cstddef>
+
+#include "lock_budget.h"
+#include "secret_registry.h"
+
+// ========== SECURE SLAB ALLOCATOR ==========
+// Small secrets (tokens, keys, PIN digests) come from size-class slabs carved
+// out of locked pages. Each thread keeps a magazine of free slots per class,
+// so the common alloc/free touches no lock; magazines trade slots with a
+// per-class depot in batches. A slot freed on another thread simply joins
+// that thread's magazine. Every slot is followed by a canary that is checked
+// on free. Slot payloads are registered for emergency wipes.
+
+// Largest object served by the slab (locked_alloc() routes up to this size here)
+static const size_t SLAB_MAX_OBJECT = 256;
+
+/**
+ * Allocates a zeroed slot of at least len bytes from a locked slab
+ *
+ * @param len         1 to SLAB_MAX_OBJECT bytes
+ * @param prio        Budget priority used if a new slab page is needed
+ * @param secretClass When an emergency wipe may clear it
+ * @return Slot, or NULL if len is out of range or no locked page was available
+ */
+void *slab_alloc(size_t len, LockPriority prio, SecretClass secretClass);
+
+/**
+ * Wipes a slot and returns it to this thread's magazine
+ * Aborts on a damaged canary (buffer overflow) or a double free
+ */
+void slab_free(void *ptr);
+
+/**
+ * Usable size of a slot from slab_alloc()
+ */
+size_t slab_usable_size(const void *ptr);
+
+// ========== TRIMMING ==========
+
+/**
+ * Gives back locked pages the slab no longer needs
+ * Threads return their magazines first (this one at once, others on their
+ * next slab call, so their slots are released by a later trim). Slabs whose
+ * slots are all free are wiped and unmapped (slots never move, so one live
+ * slot keeps its slab)
+ *
+ * @return Locked bytes unmapped
+ */
+size_t slab_trim();
+
+#endif // FUZZME_V3_SECURE_SLAB_H
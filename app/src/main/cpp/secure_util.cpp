@@ -0,0 +1,333 @@
+#include "secure_util.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#include "cpu_dispatch.h"
+#include "native_stats.h"
+
+void secure_memzero(void *ptr, size_t len) {
+    if (!ptr || len == 0) return;
+
+    // Use volatile pointer to prevent compiler from optimizing away the writes
+    volatile unsigned char *p = (volatile unsigned char *) ptr;
+
+    stats_add(STAT_BYTES_WIPED, len);
+
+    // Write zeros to each byte
+    while (len--) *p++ = 0;
+
+    // Memory barrier: ensures writes complete before continuing
+    // Prevents reordering and ensures zeros are actually written
+    __asm__ __volatile__("" : : "r"(ptr) : "memory");
+}
+
+// ========== WIPE AND COMPARE KERNELS ==========
+// Variants bound through cpu_dispatch.h. Every wipe store is volatile and
+// every compare folds all bytes, so none of them can be shortened by the
+// compiler; their only difference is the width of the stores and loads.
+
+// GCC/Clang vector extension: lowers to SSE2 on x86 and NEON on ARM
+typedef unsigned char byte_vec16 __attribute__((vector_size(16)));
+
+static void wipe_scalar(void *ptr, size_t len) {
+    unsigned char *p = (unsigned char *) ptr;
+    unsigned char *end = p + len;
+
+    while (p < end && ((uintptr_t) p & 7)) *(volatile unsigned char *) p++ = 0;
+    while (end - p >= 8) {
+        *(volatile uint64_t *) p = 0;
+        p += 8;
+    }
+    while (p < end) *(volatile unsigned char *) p++ = 0;
+}
+
+static void wipe_vec16(void *ptr, size_t len) {
+    unsigned char *p = (unsigned char *) ptr;
+    unsigned char *end = p + len;
+
+    // Scalar head up to 16-byte alignment
+    while (p < end && ((uintptr_t) p & 15)) *(volatile unsigned char *) p++ = 0;
+
+    // Aligned body, four vectors per iteration
+    const byte_vec16 zero = {0};
+    while (end - p >= 64) {
+        ((volatile byte_vec16 *) p)[0] = zero;
+        ((volatile byte_vec16 *) p)[1] = zero;
+        ((volatile byte_vec16 *) p)[2] = zero;
+        ((volatile byte_vec16 *) p)[3] = zero;
+        p += 64;
+    }
+    while (end - p >= 16) {
+        *(volatile byte_vec16 *) p = zero;
+        p += 16;
+    }
+
+    // Scalar tail
+    while (p < end) *(volatile unsigned char *) p++ = 0;
+}
+
+static uint32_t compare_scalar(const void *a, const void *b, size_t len) {
+    const unsigned char *x = (const unsigned char *) a, *y = (const unsigned char *) b;
+    uint32_t diff = 0;
+    for (size_t i = 0; i < len; i++) diff |= x[i] ^ y[i];
+    return diff;
+}
+
+static uint32_t compare_vec16(const void *a, const void *b, size_t len) {
+    const unsigned char *x = (const unsigned char *) a, *y = (const unsigned char *) b;
+    byte_vec16 acc = {0};
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        byte_vec16 u, v;
+        memcpy(&u, x + i, 16);
+        memcpy(&v, y + i, 16);
+        acc |= u ^ v;
+    }
+    uint32_t diff = 0;
+    for (; i < len; i++) diff |= x[i] ^ y[i];
+    for (int lane = 0; lane < 16; lane++) diff |= acc[lane];
+    return diff;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2")))
+static void wipe_avx2(void *ptr, size_t len) {
+    unsigned char *p = (unsigned char *) ptr;
+    unsigned char *end = p + len;
+
+    while (p < end && ((uintptr_t) p & 31)) *(volatile unsigned char *) p++ = 0;
+
+    const __m256i zero = _mm256_setzero_si256();
+    while (end - p >= 128) {
+        ((volatile __m256i *) p)[0] = zero;
+        ((volatile __m256i *) p)[1] = zero;
+        ((volatile __m256i *) p)[2] = zero;
+        ((volatile __m256i *) p)[3] = zero;
+        p += 128;
+    }
+    while (end - p >= 32) {
+        *(volatile __m256i *) p = zero;
+        p += 32;
+    }
+
+    while (p < end) *(volatile unsigned char *) p++ = 0;
+}
+
+__attribute__((target("avx2")))
+static uint32_t compare_avx2(const void *a, const void *b, size_t len) {
+    const unsigned char *x = (const unsigned char *) a, *y = (const unsigned char *) b;
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i u = _mm256_loadu_si256((const __m256i *) (x + i));
+        __m256i v = _mm256_loadu_si256((const __m256i *) (y + i));
+        acc = _mm256_or_si256(acc, _mm256_xor_si256(u, v));
+    }
+    uint32_t diff = 0;
+    for (; i < len; i++) diff |= x[i] ^ y[i];
+    // Lanes that are all zero compare equal to zero: mask bit set
+    return diff | ~(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(acc, _mm256_setzero_si256()));
+}
+
+#endif
+
+extern const KernelVariant WIPE_KERNELS[] = {
+        {"scalar", 0, (KernelFn) wipe_scalar},
+        {"vec16", 0, (KernelFn) wipe_vec16},
+#if defined(__x86_64__) || defined(__i386__)
+        {"avx2", CPU_X86_AVX2, (KernelFn) wipe_avx2},
+#endif
+};
+extern const size_t WIPE_KERNEL_COUNT = sizeof(WIPE_KERNELS) / sizeof(WIPE_KERNELS[0]);
+
+extern const KernelVariant COMPARE_KERNELS[] = {
+        {"scalar", 0, (KernelFn) compare_scalar},
+        {"vec16", 0, (KernelFn) compare_vec16},
+#if defined(__x86_64__) || defined(__i386__)
+        {"avx2", CPU_X86_AVX2, (KernelFn) compare_avx2},
+#endif
+};
+extern const size_t COMPARE_KERNEL_COUNT = sizeof(COMPARE_KERNELS) / sizeof(COMPARE_KERNELS[0]);
+
+void secure_wipe_vectorized(void *ptr, size_t len) {
+    if (!ptr || len == 0) return;
+    cpu_wipe_kernel()(ptr, len);
+    __asm__ __volatile__("" : : "r"(ptr) : "memory");
+}
+
+bool secure_equal(const void *a, const void *b, size_t len) {
+    return cpu_compare_kernel()(a, b, len) == 0;
+}
+
+// ========== CACHE-AWARE WIPES ==========
+
+// Data cache line size, probed on first use
+// (a plain atomic so the probe stays async-signal-safe)
+static std::atomic<int> g_lineSize{0};
+
+#if defined(__x86_64__) || defined(__i386__)
+
+static void probe_cache() {
+    unsigned int eax, ebx, ecx, edx;
+    int line = 64;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && ((ebx >> 8) & 0xff)) {
+        line = (int) ((ebx >> 8) & 0xff) * 8;  // CLFLUSH line size, in 8-byte units
+    }
+    g_lineSize.store(line, std::memory_order_relaxed);
+}
+
+__attribute__((target("clflushopt")))
+static void flush_lines_opt(uintptr_t p, uintptr_t end, size_t line) {
+    for (; p < end; p += line) _mm_clflushopt((void *) p);
+}
+
+static void flush_lines(uintptr_t p, uintptr_t end, size_t line) {
+    if (cpu_features() & CPU_X86_CLFLUSHOPT) {
+        flush_lines_opt(p, end, line);
+    } else {
+        for (; p < end; p += line) _mm_clflush((void *) p);
+    }
+    _mm_sfence();
+}
+
+/**
+ * Aligned body of a non-temporal wipe, 64 bytes per iteration
+ */
+static void stream_zero(unsigned char *p, size_t len) {
+    const __m128i zero = _mm_setzero_si128();
+    for (size_t i = 0; i < len; i += 64) {
+        _mm_stream_si128((__m128i *) (p + i), zero);
+        _mm_stream_si128((__m128i *) (p + i + 16), zero);
+        _mm_stream_si128((__m128i *) (p + i + 32), zero);
+        _mm_stream_si128((__m128i *) (p + i + 48), zero);
+    }
+    _mm_sfence();
+}
+
+#define HAVE_CACHE_WIPES 1
+
+#elif defined(__aarch64__)
+
+static void probe_cache() {
+    uint64_t ctr;
+    __asm__ __volatile__("mrs %0, ctr_el0" : "=r"(ctr));
+    g_lineSize.store(4 << ((ctr >> 16) & 0xf), std::memory_order_relaxed);  // DminLine
+}
+
+static void flush_lines(uintptr_t p, uintptr_t end, size_t line) {
+    // Linux lets EL0 clean and invalidate to the point of coherency
+    for (; p < end; p += line) __asm__ __volatile__("dc civac, %0" : : "r"(p) : "memory");
+    __asm__ __volatile__("dsb ish" : : : "memory");
+}
+
+static void stream_zero(unsigned char *p, size_t len) {
+    for (size_t i = 0; i < len; i += 64) {
+        __asm__ __volatile__("stnp xzr, xzr, [%0]\n\t"
+                             "stnp xzr, xzr, [%0, #16]\n\t"
+                             "stnp xzr, xzr, [%0, #32]\n\t"
+                             "stnp xzr, xzr, [%0, #48]"
+                             : : "r"(p + i) : "memory");
+    }
+    __asm__ __volatile__("dsb ish" : : : "memory");
+}
+
+#define HAVE_CACHE_WIPES 1
+
+#endif
+
+#ifdef HAVE_CACHE_WIPES
+
+static size_t line_size() {
+    int line = g_lineSize.load(std::memory_order_relaxed);
+    if (!line) {
+        probe_cache();
+        line = g_lineSize.load(std::memory_order_relaxed);
+    }
+    return (size_t) line;
+}
+
+/**
+ * Writes back and evicts every line overlapping [ptr, ptr + len)
+ */
+static void flush_range(const void *ptr, size_t len) {
+    if (!len) return;
+    size_t line = line_size();
+    uintptr_t p = (uintptr_t) ptr & ~(uintptr_t) (line - 1);
+    flush_lines(p, (uintptr_t) ptr + len, line);
+}
+
+void secure_wipe_nontemporal(void *ptr, size_t len) {
+    if (!ptr || len == 0) return;
+
+    unsigned char *p = (unsigned char *) ptr;
+    unsigned char *end = p + len;
+    unsigned char *body = (unsigned char *) (((uintptr_t) p + 63) & ~(uintptr_t) 63);
+    unsigned char *bodyEnd = (unsigned char *) ((uintptr_t) end & ~(uintptr_t) 63);
+    if (body >= bodyEnd) {
+        secure_wipe_flush(ptr, len);
+        return;
+    }
+
+    // Partial lines at either end go through the cache, so flush them too
+    secure_wipe_vectorized(p, (size_t) (body - p));
+    secure_wipe_vectorized(bodyEnd, (size_t) (end - bodyEnd));
+    flush_range(p, (size_t) (body - p));
+    flush_range(bodyEnd, (size_t) (end - bodyEnd));
+
+    stream_zero(body, (size_t) (bodyEnd - body));
+}
+
+void secure_wipe_flush(void *ptr, size_t len) {
+    if (!ptr || len == 0) return;
+    secure_wipe_vectorized(ptr, len);
+    flush_range(ptr, len);
+}
+
+void secure_wipe(void *ptr, size_t len) {
+    if (len <= WIPE_FLUSH_MAX_BYTES) {
+        secure_wipe_flush(ptr, len);
+    } else if (len >= WIPE_NONTEMPORAL_MIN_BYTES) {
+        secure_wipe_nontemporal(ptr, len);
+    } else {
+        secure_wipe_vectorized(ptr, len);
+    }
+}
+
+#else
+
+void secure_wipe_nontemporal(void *ptr, size_t len) {
+    secure_wipe_vectorized(ptr, len);
+}
+
+void secure_wipe_flush(void *ptr, size_t len) {
+    secure_wipe_vectorized(ptr, len);
+}
+
+void secure_wipe(void *ptr, size_t len) {
+    secure_wipe_vectorized(ptr, len);
+}
+
+#endif
+
+size_t page_size() {
+    static size_t cached = 0;
+    if (!cached) {
+        long ps = sysconf(_SC_PAGESIZE);
+        cached = ps > 0 ? (size_t) ps : 4096;
+    }
+    return cached;
+}
+
+size_t page_round_up(size_t len) {
+    size_t ps = page_size();
+    return (len + ps - 1) & ~(ps - 1);
+}
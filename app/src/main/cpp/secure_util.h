@@ -0,0 +1,74 @@
+#ifndef FUZZME_V3_SECURE_UTIL_H
+#define FUZZME_V3_SECURE_UTIL_H
+
+#include <cstddef>
+
+// ========== SECURE UTILITY FUNCTIONS ==========
+
+/**
+ * Securely zeroes memory to prevent data recovery
+ * Uses volatile to prevent compiler optimization
+ * @param ptr Pointer to memory to zero
+ * @param len Number of bytes to zero
+ */
+void secure_memzero(void *ptr, size_t len);
+
+/**
+ * Zeroes memory with the bound wipe kernel (see cpu_dispatch.h): the widest
+ * vector stores the CPU has, four per iteration
+ * Async-signal-safe: touches no locks, TLS or stats, so crash handlers can use it
+ * @param ptr Pointer to memory to zero
+ * @param len Number of bytes to zero
+ */
+void secure_wipe_vectorized(void *ptr, size_t len);
+
+/**
+ * Compares two buffers in time that depends only on len
+ * For secrets and digests, where memcmp() would leak the first mismatch
+ */
+bool secure_equal(const void *a, const void *b, size_t len);
+
+// ========== CACHE-AWARE WIPES ==========
+// Plain stores leave the zeroed lines dirty in cache: DRAM keeps the old
+// plaintext until they are written back, and a big wipe evicts the caller's
+// hot data. These variants push the zeros past the cache.
+
+// From this size on secure_wipe() uses non-temporal stores
+static const size_t WIPE_NONTEMPORAL_MIN_BYTES = 8 * 1024 * 1024;
+
+// Up to this size secure_wipe() stores and then flushes every line
+static const size_t WIPE_FLUSH_MAX_BYTES = 4 * 1024;
+
+/**
+ * Zeroes memory with non-temporal stores (movntdq / stnp) and a store fence
+ * The zeros go straight to memory and the lines leave the cache
+ * (a hint only on ARM). Async-signal-safe
+ */
+void secure_wipe_nontemporal(void *ptr, size_t len);
+
+/**
+ * Zeroes memory with vector stores, then writes back and evicts every line
+ * (clflushopt / clflush, DC CIVAC). Async-signal-safe
+ */
+void secure_wipe_flush(void *ptr, size_t len);
+
+/**
+ * Zeroes memory with the variant that suits the size:
+ * stores + flush up to WIPE_FLUSH_MAX_BYTES, non-temporal stores from
+ * WIPE_NONTEMPORAL_MIN_BYTES, plain vector stores in between.
+ * Architectures without these instructions use plain vector stores.
+ * Async-signal-safe
+ */
+void secure_wipe(void *ptr, size_t len);
+
+/**
+ * System page size, cached after the first call
+ */
+size_t page_size();
+
+/**
+ * Rounds a length up to a whole number of pages
+ */
+size_t page_round_up(size_t len);
+
+#endif // FUZZME_V3_SECURE_UTIL_H
@@ -0,0 +1,142 @@
+#include "sha1.h"
+
+#include <cstring>
+
+#include "cpu_dispatch.h"
+#include "secure_util.h"
+#include "sha_accel.h"
+
+#define SHA1_ROTL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+static inline uint32_t load32_be(const unsigned char *p) {
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+           ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+static inline void store32_be(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char) (v >> 24);
+    p[1] = (unsigned char) (v >> 16);
+    p[2] = (unsigned char) (v >> 8);
+    p[3] = (unsigned char) v;
+}
+
+/**
+ * Portable block function, for CPUs without SHA instructions
+ * The schedule is kept as a rolling 16-word window; it holds message
+ * bytes and is wiped
+ */
+static void sha1_blocks_portable(uint32_t h[5], const unsigned char *blocks, size_t count) {
+    uint32_t w[16];
+    for (; count > 0; count--, blocks += SHA1_BLOCK_BYTES) {
+        for (int i = 0; i < 16; i++) w[i] = load32_be(blocks + 4 * i);
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            if (i >= 16) {
+                uint32_t x = w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15] ^ w[i & 15];
+                w[i & 15] = SHA1_ROTL(x, 1);
+            }
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t t = SHA1_ROTL(a, 5) + f + e + k + w[i & 15];
+            e = d;
+            d = c;
+            c = SHA1_ROTL(b, 30);
+            b = a;
+            a = t;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    secure_wipe_vectorized(w, sizeof(w));
+}
+
+extern const KernelVariant SHA1_KERNELS[] = {
+        {"portable", 0, (KernelFn) sha1_blocks_portable},
+#if defined(__x86_64__) || defined(__i386__)
+        {"shani", CPU_X86_SSSE3 | CPU_X86_SSE41 | CPU_X86_SHA, (KernelFn) sha1_blocks_shani},
+#elif defined(__aarch64__)
+        {"armv8ce", CPU_ARM_SHA1, (KernelFn) sha1_blocks_ce},
+#endif
+};
+extern const size_t SHA1_KERNEL_COUNT = sizeof(SHA1_KERNELS) / sizeof(SHA1_KERNELS[0]);
+
+void sha1_blocks(uint32_t h[5], const unsigned char *blocks, size_t count) {
+    cpu_sha1_kernel()(h, blocks, count);
+}
+
+void sha1_init(Sha1State *state) {
+    memset(state, 0, sizeof(*state));
+    state->h[0] = 0x67452301;
+    state->h[1] = 0xEFCDAB89;
+    state->h[2] = 0x98BADCFE;
+    state->h[3] = 0x10325476;
+    state->h[4] = 0xC3D2E1F0;
+}
+
+void sha1_update(Sha1State *state, const void *in, size_t len) {
+    const unsigned char *p = (const unsigned char *) in;
+    state->length += len;
+    while (len > 0) {
+        // Whole blocks straight from the input
+        if (state->bufLen == 0 && len >= SHA1_BLOCK_BYTES) {
+            size_t blocks = len / SHA1_BLOCK_BYTES;
+            sha1_blocks(state->h, p, blocks);
+            p += blocks * SHA1_BLOCK_BYTES;
+            len -= blocks * SHA1_BLOCK_BYTES;
+            continue;
+        }
+        size_t take = SHA1_BLOCK_BYTES - state->bufLen;
+        if (take > len) take = len;
+        memcpy(state->buf + state->bufLen, p, take);
+        state->bufLen += take;
+        p += take;
+        len -= take;
+        if (state->bufLen == SHA1_BLOCK_BYTES) {
+            sha1_blocks(state->h, state->buf, 1);
+            state->bufLen = 0;
+        }
+    }
+}
+
+void sha1_final(Sha1State *state, unsigned char *out) {
+    uint64_t bits = state->length * 8;
+
+    // 0x80, zeros, then the bit length in the last 8 bytes of a block
+    state->buf[state->bufLen++] = 0x80;
+    if (state->bufLen > SHA1_BLOCK_BYTES - 8) {
+        memset(state->buf + state->bufLen, 0, SHA1_BLOCK_BYTES - state->bufLen);
+        sha1_blocks(state->h, state->buf, 1);
+        state->bufLen = 0;
+    }
+    memset(state->buf + state->bufLen, 0, SHA1_BLOCK_BYTES - 8 - state->bufLen);
+    store32_be(state->buf + SHA1_BLOCK_BYTES - 8, (uint32_t) (bits >> 32));
+    store32_be(state->buf + SHA1_BLOCK_BYTES - 4, (uint32_t) bits);
+    sha1_blocks(state->h, state->buf, 1);
+
+    for (int i = 0; i < 5; i++) store32_be(out + 4 * i, state->h[i]);
+    secure_wipe_vectorized(state, sizeof(*state));
+}
+
+void sha1(unsigned char *out, const void *in, size_t len) {
+    Sha1State state;
+    sha1_init(&state);
+    sha1_update(&state, in, len);
+    sha1_final(&state, out);
+}
@@ -0,0 +1,47 @@
+#ifndef FUZZME_V3_SHA1_H
+#define FUZZME_V3_SHA1_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ========== SHA-1 ==========
+// Incremental SHA-1 (FIPS 180-4). Not for new designs: it is here because
+// breach corpora (see breach_filter.h) and RFC 4226 HOTP are defined over
+// it. Uses the CPU's SHA instructions where it has them (see sha_accel.h).
+// Like Blake2sState, a state buffers message bytes, so it is a secret and
+// is wiped by sha1_final().
+
+static const size_t SHA1_BLOCK_BYTES = 64;
+static const size_t SHA1_OUT_BYTES = 20;
+
+struct Sha1State {
+    uint32_t h[5];
+    uint64_t length;                            // Bytes absorbed so far
+    unsigned char buf[SHA1_BLOCK_BYTES];
+    size_t bufLen;
+};
+
+void sha1_init(Sha1State *state);
+
+/**
+ * Absorbs more input; any split of the message gives the same digest
+ */
+void sha1_update(Sha1State *state, const void *in, size_t len);
+
+/**
+ * Writes the SHA1_OUT_BYTES digest and wipes the state
+ */
+void sha1_final(Sha1State *state, unsigned char *out);
+
+/**
+ * One-shot hash
+ */
+void sha1(unsigned char *out, const void *in, size_t len);
+
+/**
+ * Compresses whole blocks into a chain value, without padding
+ * For callers that build their own final blocks (see hmac.cpp)
+ */
+void sha1_blocks(uint32_t h[5], const unsigned char *blocks, size_t count);
+
+#endif // FUZZME_V3_SHA1_H
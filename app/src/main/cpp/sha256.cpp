@@ -0,0 +1,379 @@
+#include "sha256.h"
+
+#include <cstring>
+
+#include "cpu_dispatch.h"
+#include "secure_util.h"
+#include "sha_accel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+const uint32_t SHA256_K[64] = {
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+#define SHA256_ROTR(v, n) (((v) >> (n)) | ((v) << (32 - (n))))
+
+static inline uint32_t load32_be(const unsigned char *p) {
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+           ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+static inline void store32_be(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char) (v >> 24);
+    p[1] = (unsigned char) (v >> 16);
+    p[2] = (unsigned char) (v >> 8);
+    p[3] = (unsigned char) v;
+}
+
+/**
+ * Portable block function, for CPUs without SHA instructions
+ * The schedule is kept as a rolling 16-word window; it holds message
+ * bytes and is wiped
+ */
+static void sha256_blocks_portable(uint32_t h[8], const unsigned char *blocks, size_t count) {
+    uint32_t w[16];
+    for (; count > 0; count--, blocks += SHA256_BLOCK_BYTES) {
+        for (int i = 0; i < 16; i++) w[i] = load32_be(blocks + 4 * i);
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3];
+        uint32_t e = h[4], f = h[5], g = h[6], hh = h[7];
+        for (int i = 0; i < 64; i++) {
+            if (i >= 16) {
+                uint32_t w15 = w[(i + 1) & 15], w2 = w[(i + 14) & 15];
+                uint32_t s0 = SHA256_ROTR(w15, 7) ^ SHA256_ROTR(w15, 18) ^ (w15 >> 3);
+                uint32_t s1 = SHA256_ROTR(w2, 17) ^ SHA256_ROTR(w2, 19) ^ (w2 >> 10);
+                w[i & 15] += s0 + w[(i + 9) & 15] + s1;
+            }
+            uint32_t t1 = hh + (SHA256_ROTR(e, 6) ^ SHA256_ROTR(e, 11) ^ SHA256_ROTR(e, 25)) +
+                          ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i & 15];
+            uint32_t t2 = (SHA256_ROTR(a, 2) ^ SHA256_ROTR(a, 13) ^ SHA256_ROTR(a, 22)) +
+                          ((a & b) ^ (a & c) ^ (b & c));
+            hh = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+        h[5] += f;
+        h[6] += g;
+        h[7] += hh;
+    }
+
+    secure_wipe_vectorized(w, sizeof(w));
+}
+
+extern const KernelVariant SHA256_KERNELS[] = {
+        {"portable", 0, (KernelFn) sha256_blocks_portable},
+#if defined(__x86_64__) || defined(__i386__)
+        {"shani", CPU_X86_SSSE3 | CPU_X86_SSE41 | CPU_X86_SHA, (KernelFn) sha256_blocks_shani},
+#elif defined(__aarch64__)
+        {"armv8ce", CPU_ARM_SHA2, (KernelFn) sha256_blocks_ce},
+#endif
+};
+extern const size_t SHA256_KERNEL_COUNT = sizeof(SHA256_KERNELS) / sizeof(SHA256_KERNELS[0]);
+
+void sha256_blocks(uint32_t h[8], const unsigned char *blocks, size_t count) {
+    cpu_sha256_kernel()(h, blocks, count);
+}
+
+// ========== MULTI-BUFFER ==========
+// Up to SHA256_LANES messages side by side, one per 32-bit vector lane: the
+// portable rounds with every word widened to a vector. Four lanes in
+// 16-byte vectors (SSE2, NEON), eight with AVX2. Where the CPU has SHA
+// instructions, hashing the lanes one after another on them is faster
+// still, so the "shani" / "armv8ce" variants come last.
+
+/**
+ * Compresses one block held in w[16] into chain values s[8], all vectors of
+ * vec; w is the rolling schedule, as in sha256_blocks_portable()
+ */
+#define SHA256_MULTI_BLOCK(vec, s, w)                                                      \
+    do {                                                                                   \
+        vec a = s[0], b = s[1], c = s[2], d = s[3];                                        \
+        vec e = s[4], f = s[5], g = s[6], hh = s[7];                                       \
+        for (int i = 0; i < 64; i++) {                                                     \
+            if (i >= 16) {                                                                 \
+                vec w15 = w[(i + 1) & 15], w2 = w[(i + 14) & 15];                          \
+                vec s0 = SHA256_ROTR(w15, 7) ^ SHA256_ROTR(w15, 18) ^ (w15 >> 3);          \
+                vec s1 = SHA256_ROTR(w2, 17) ^ SHA256_ROTR(w2, 19) ^ (w2 >> 10);           \
+                w[i & 15] += s0 + w[(i + 9) & 15] + s1;                                    \
+            }                                                                              \
+            vec t1 = hh + (SHA256_ROTR(e, 6) ^ SHA256_ROTR(e, 11) ^ SHA256_ROTR(e, 25)) +  \
+                     ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i & 15];                       \
+            vec t2 = (SHA256_ROTR(a, 2) ^ SHA256_ROTR(a, 13) ^ SHA256_ROTR(a, 22)) +       \
+                     ((a & b) ^ (a & c) ^ (b & c));                                        \
+            hh = g;                                                                        \
+            g = f;                                                                         \
+            f = e;                                                                         \
+            e = d + t1;                                                                    \
+            d = c;                                                                         \
+            c = b;                                                                         \
+            b = a;                                                                         \
+            a = t1 + t2;                                                                   \
+        }                                                                                  \
+        s[0] += a;                                                                         \
+        s[1] += b;                                                                         \
+        s[2] += c;                                                                         \
+        s[3] += d;                                                                         \
+        s[4] += e;                                                                         \
+        s[5] += f;                                                                         \
+        s[6] += g;                                                                         \
+        s[7] += hh;                                                                        \
+    } while (0)
+
+static void sha256_multi_serial(uint32_t h[][8], const unsigned char *const blocks[],
+                                size_t lanes, size_t count) {
+    for (size_t lane = 0; lane < lanes; lane++) sha256_blocks(h[lane], blocks[lane], count);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * Lanes one after another on SHA-NI: a single sha256rnds2 stream beats
+ * eight AVX2 lanes, so this is preferred wherever the CPU has it
+ */
+static void sha256_multi_shani(uint32_t h[][8], const unsigned char *const blocks[],
+                               size_t lanes, size_t count) {
+    for (size_t lane = 0; lane < lanes; lane++) sha256_blocks_shani(h[lane], blocks[lane], count);
+}
+
+#elif defined(__aarch64__)
+
+static void sha256_multi_ce(uint32_t h[][8], const unsigned char *const blocks[],
+                            size_t lanes, size_t count) {
+    for (size_t lane = 0; lane < lanes; lane++) sha256_blocks_ce(h[lane], blocks[lane], count);
+}
+
+#endif
+
+typedef uint32_t sha256_vec4 __attribute__((vector_size(16)));
+
+static void sha256_multi_vec4(uint32_t h[][8], const unsigned char *const blocks[],
+                              size_t lanes, size_t count) {
+    sha256_vec4 s[8], w[16];
+    for (size_t first = 0; first < lanes; first += 4) {
+        // Short groups repeat their first lane: every vector lane reads a real message
+        size_t n = lanes - first < 4 ? lanes - first : 4;
+        for (int k = 0; k < 8; k++) {
+            for (size_t l = 0; l < 4; l++) s[k][l] = h[first + (l < n ? l : 0)][k];
+        }
+        for (size_t block = 0; block < count; block++) {
+            for (int i = 0; i < 16; i++) {
+                for (size_t l = 0; l < 4; l++) {
+                    const unsigned char *p = blocks[first + (l < n ? l : 0)];
+                    w[i][l] = load32_be(p + block * SHA256_BLOCK_BYTES + 4 * i);
+                }
+            }
+            SHA256_MULTI_BLOCK(sha256_vec4, s, w);
+        }
+        for (int k = 0; k < 8; k++) {
+            for (size_t l = 0; l < n; l++) h[first + l][k] = s[k][l];
+        }
+    }
+
+    secure_wipe_vectorized(s, sizeof(s));
+    secure_wipe_vectorized(w, sizeof(w));
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+typedef uint32_t sha256_vec8 __attribute__((vector_size(32)));
+
+#define SHA256_AVX2 __attribute__((target("avx2")))
+
+/**
+ * Transposes an 8x8 matrix of 32-bit words held as eight row vectors:
+ * rows of eight message words, one per lane, become one word per vector
+ */
+SHA256_AVX2
+static inline void transpose8(__m256i r[8]) {
+    __m256i t[8], u[8];
+    for (int i = 0; i < 8; i += 4) {
+        t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+        t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+        t[i + 2] = _mm256_unpacklo_epi32(r[i + 2], r[i + 3]);
+        t[i + 3] = _mm256_unpackhi_epi32(r[i + 2], r[i + 3]);
+        u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+        u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+        u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+        u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+    for (int i = 0; i < 4; i++) {
+        r[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+        r[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+    }
+}
+
+SHA256_AVX2
+static void sha256_multi_avx2(uint32_t h[][8], const unsigned char *const blocks[],
+                              size_t lanes, size_t count) {
+    const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                           3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    sha256_vec8 s[8], w[16];
+    __m256i r[8];
+    for (int k = 0; k < 8; k++) {
+        for (size_t l = 0; l < 8; l++) s[k][l] = h[l < lanes ? l : 0][k];
+    }
+    for (size_t block = 0; block < count; block++) {
+        // Lane l's block as two rows of eight big-endian words, then transposed
+        for (int half = 0; half < 2; half++) {
+            for (size_t l = 0; l < 8; l++) {
+                const unsigned char *p = blocks[l < lanes ? l : 0] +
+                                         block * SHA256_BLOCK_BYTES + 32 * half;
+                r[l] = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *) p), bswap);
+            }
+            transpose8(r);
+            for (int i = 0; i < 8; i++) w[8 * half + i] = (sha256_vec8) r[i];
+        }
+        SHA256_MULTI_BLOCK(sha256_vec8, s, w);
+    }
+    for (int k = 0; k < 8; k++) {
+        for (size_t l = 0; l < lanes; l++) h[l][k] = s[k][l];
+    }
+
+    secure_wipe_vectorized(s, sizeof(s));
+    secure_wipe_vectorized(w, sizeof(w));
+    secure_wipe_vectorized(r, sizeof(r));
+}
+
+#endif
+
+extern const KernelVariant SHA256_MULTI_KERNELS[] = {
+        {"serial", 0, (KernelFn) sha256_multi_serial},
+        {"vec4", 0, (KernelFn) sha256_multi_vec4},
+#if defined(__x86_64__) || defined(__i386__)
+        {"avx2", CPU_X86_AVX2, (KernelFn) sha256_multi_avx2},
+        {"shani", CPU_X86_SSSE3 | CPU_X86_SSE41 | CPU_X86_SHA, (KernelFn) sha256_multi_shani},
+#elif defined(__aarch64__)
+        {"armv8ce", CPU_ARM_SHA2, (KernelFn) sha256_multi_ce},
+#endif
+};
+extern const size_t SHA256_MULTI_KERNEL_COUNT =
+        sizeof(SHA256_MULTI_KERNELS) / sizeof(SHA256_MULTI_KERNELS[0]);
+
+void sha256_blocks_multi(uint32_t h[][8], const unsigned char *const blocks[], size_t lanes,
+                         size_t count) {
+    if (lanes > SHA256_LANES) lanes = SHA256_LANES;
+    if (lanes && count) cpu_sha256_multi_kernel()(h, blocks, lanes, count);
+}
+
+void sha256_batch(const unsigned char *msgs, size_t len, size_t count, unsigned char *out) {
+    // Same length: every lane has the same whole blocks and the same padding
+    size_t whole = len / SHA256_BLOCK_BYTES;
+    size_t tail = len - whole * SHA256_BLOCK_BYTES;
+    size_t tailBlocks = tail > SHA256_BLOCK_BYTES - 9 ? 2 : 1;
+    uint64_t bits = (uint64_t) len * 8;
+
+    Sha256State iv;
+    sha256_init(&iv);
+    uint32_t h[SHA256_LANES][8];
+    unsigned char tails[SHA256_LANES][2 * SHA256_BLOCK_BYTES];
+    const unsigned char *ptrs[SHA256_LANES];
+    for (size_t first = 0; first < count; first += SHA256_LANES) {
+        size_t lanes = count - first < SHA256_LANES ? count - first : SHA256_LANES;
+        for (size_t l = 0; l < lanes; l++) {
+            const unsigned char *msg = msgs + (first + l) * len;
+            memcpy(h[l], iv.h, sizeof(h[l]));
+            ptrs[l] = msg;
+
+            unsigned char *t = tails[l];
+            memset(t, 0, tailBlocks * SHA256_BLOCK_BYTES);
+            memcpy(t, msg + whole * SHA256_BLOCK_BYTES, tail);
+            t[tail] = 0x80;
+            store32_be(t + tailBlocks * SHA256_BLOCK_BYTES - 8, (uint32_t) (bits >> 32));
+            store32_be(t + tailBlocks * SHA256_BLOCK_BYTES - 4, (uint32_t) bits);
+        }
+        sha256_blocks_multi(h, ptrs, lanes, whole);
+        for (size_t l = 0; l < lanes; l++) ptrs[l] = tails[l];
+        sha256_blocks_multi(h, ptrs, lanes, tailBlocks);
+
+        for (size_t l = 0; l < lanes; l++) {
+            unsigned char *digest = out + (first + l) * SHA256_OUT_BYTES;
+            for (int i = 0; i < 8; i++) store32_be(digest + 4 * i, h[l][i]);
+        }
+    }
+
+    secure_wipe_vectorized(h, sizeof(h));
+    secure_wipe_vectorized(tails, sizeof(tails));
+}
+
+void sha256_init(Sha256State *state) {
+    memset(state, 0, sizeof(*state));
+    state->h[0] = 0x6A09E667;
+    state->h[1] = 0xBB67AE85;
+    state->h[2] = 0x3C6EF372;
+    state->h[3] = 0xA54FF53A;
+    state->h[4] = 0x510E527F;
+    state->h[5] = 0x9B05688C;
+    state->h[6] = 0x1F83D9AB;
+    state->h[7] = 0x5BE0CD19;
+}
+
+void sha256_update(Sha256State *state, const void *in, size_t len) {
+    const unsigned char *p = (const unsigned char *) in;
+    state->length += len;
+    while (len > 0) {
+        // Whole blocks straight from the input
+        if (state->bufLen == 0 && len >= SHA256_BLOCK_BYTES) {
+            size_t blocks = len / SHA256_BLOCK_BYTES;
+            sha256_blocks(state->h, p, blocks);
+            p += blocks * SHA256_BLOCK_BYTES;
+            len -= blocks * SHA256_BLOCK_BYTES;
+            continue;
+        }
+        size_t take = SHA256_BLOCK_BYTES - state->bufLen;
+        if (take > len) take = len;
+        memcpy(state->buf + state->bufLen, p, take);
+        state->bufLen += take;
+        p += take;
+        len -= take;
+        if (state->bufLen == SHA256_BLOCK_BYTES) {
+            sha256_blocks(state->h, state->buf, 1);
+            state->bufLen = 0;
+        }
+    }
+}
+
+void sha256_final(Sha256State *state, unsigned char *out) {
+    uint64_t bits = state->length * 8;
+
+    // 0x80, zeros, then the bit length in the last 8 bytes of a block
+    state->buf[state->bufLen++] = 0x80;
+    if (state->bufLen > SHA256_BLOCK_BYTES - 8) {
+        memset(state->buf + state->bufLen, 0, SHA256_BLOCK_BYTES - state->bufLen);
+        sha256_blocks(state->h, state->buf, 1);
+        state->bufLen = 0;
+    }
+    memset(state->buf + state->bufLen, 0, SHA256_BLOCK_BYTES - 8 - state->bufLen);
+    store32_be(state->buf + SHA256_BLOCK_BYTES - 8, (uint32_t) (bits >> 32));
+    store32_be(state->buf + SHA256_BLOCK_BYTES - 4, (uint32_t) bits);
+    sha256_blocks(state->h, state->buf, 1);
+
+    for (int i = 0; i < 8; i++) store32_be(out + 4 * i, state->h[i]);
+    secure_wipe_vectorized(state, sizeof(*state));
+}
+
+void sha256(unsigned char *out, const void *in, size_t len) {
+    Sha256State state;
+    sha256_init(&state);
+    sha256_update(&state, in, len);
+    sha256_final(&state, out);
+}
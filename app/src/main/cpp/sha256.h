@@ -0,0 +1,73 @@
+#ifndef FUZZME_V3_SHA256_H
+#define FUZZME_V3_SHA256_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ========== SHA-256 ==========
+// Incremental SHA-256 (FIPS 180-4), on the CPU's SHA instructions where it
+// has them (see sha_accel.h). Like Sha1State, a state buffers message
+// bytes, so it is a secret and is wiped by sha256_final().
+
+static const size_t SHA256_BLOCK_BYTES = 64;
+static const size_t SHA256_OUT_BYTES = 32;
+
+// Round constants (also used by the block functions in sha_accel.cpp)
+extern const uint32_t SHA256_K[64];
+
+struct Sha256State {
+    uint32_t h[8];
+    uint64_t length;                            // Bytes absorbed so far
+    unsigned char buf[SHA256_BLOCK_BYTES];
+    size_t bufLen;
+};
+
+void sha256_init(Sha256State *state);
+
+/**
+ * Absorbs more input; any split of the message gives the same digest
+ */
+void sha256_update(Sha256State *state, const void *in, size_t len);
+
+/**
+ * Writes the SHA256_OUT_BYTES digest and wipes the state
+ */
+void sha256_final(Sha256State *state, unsigned char *out);
+
+/**
+ * One-shot hash
+ */
+void sha256(unsigned char *out, const void *in, size_t len);
+
+/**
+ * Compresses whole blocks into a chain value, without padding
+ * For callers that build their own final blocks (see hmac.cpp)
+ */
+void sha256_blocks(uint32_t h[8], const unsigned char *blocks, size_t count);
+
+// ========== MULTI-BUFFER ==========
+// Many short messages (HMACs over a TOTP window, keys of a hierarchy) are
+// latency bound one at a time; hashed side by side, one per vector lane,
+// they fill the vector units instead. The kernel is bound through
+// cpu_dispatch.h ("sha256x8"): it may also hash the lanes one after
+// another where the SHA instructions are faster than the lanes.
+
+// Messages hashed side by side
+static const size_t SHA256_LANES = 8;
+
+/**
+ * Hashes count messages of the same length, SHA256_LANES at a time
+ *
+ * @param msgs count messages of len bytes, back to back
+ * @param out  count digests of SHA256_OUT_BYTES, back to back
+ */
+void sha256_batch(const unsigned char *msgs, size_t len, size_t count, unsigned char *out);
+
+/**
+ * sha256_blocks() for up to SHA256_LANES chain values at once: blocks[i]
+ * holds count whole blocks for h[i]
+ */
+void sha256_blocks_multi(uint32_t h[][8], const unsigned char *const blocks[], size_t lanes,
+                         size_t count);
+
+#endif // FUZZME_V3_SHA256_H
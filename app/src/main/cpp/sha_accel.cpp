@@ -0,0 +1,206 @@
+#include "sha_accel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "sha256.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// ========== SHA-NI ==========
+
+#define SHANI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+
+/**
+ * Four SHA-1 rounds: group i (rounds 4i .. 4i + 3) of the 20
+ * m[i % 4] becomes W[4i .. 4i + 3] (from the previous four groups once i >=
+ * 4), e the E input of the group, prev the ABCD the group after needs for
+ * its own E
+ */
+#define SHA1_NI_GROUP(i)                                                                    \
+    do {                                                                                    \
+        if ((i) >= 4) {                                                                     \
+            m[(i) % 4] = _mm_sha1msg2_epu32(                                                \
+                    _mm_xor_si128(_mm_sha1msg1_epu32(m[(i) % 4], m[((i) + 1) % 4]),         \
+                                  m[((i) + 2) % 4]),                                        \
+                    m[((i) + 3) % 4]);                                                      \
+        }                                                                                   \
+        e = (i) == 0 ? _mm_add_epi32(e, m[0]) : _mm_sha1nexte_epu32(prev, m[(i) % 4]);      \
+        prev = abcd;                                                                        \
+        abcd = _mm_sha1rnds4_epu32(abcd, e, (i) / 5);                                       \
+    } while (0)
+
+SHANI_TARGET
+void sha1_blocks_shani(uint32_t h[5], const unsigned char *blocks, size_t count) {
+    // Lanes hold words in reverse: A in the top lane, E alone in the top lane
+    const __m128i reverse = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) h), 0x1B);
+    __m128i e0 = _mm_set_epi32((int) h[4], 0, 0, 0);
+
+    for (; count > 0; count--, blocks += 64) {
+        __m128i abcdSaved = abcd, e0Saved = e0;
+        __m128i m[4], e = e0, prev = abcd;
+        for (int i = 0; i < 4; i++) {
+            m[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (blocks + 16 * i)),
+                                    reverse);
+        }
+        SHA1_NI_GROUP(0);  SHA1_NI_GROUP(1);  SHA1_NI_GROUP(2);  SHA1_NI_GROUP(3);
+        SHA1_NI_GROUP(4);  SHA1_NI_GROUP(5);  SHA1_NI_GROUP(6);  SHA1_NI_GROUP(7);
+        SHA1_NI_GROUP(8);  SHA1_NI_GROUP(9);  SHA1_NI_GROUP(10); SHA1_NI_GROUP(11);
+        SHA1_NI_GROUP(12); SHA1_NI_GROUP(13); SHA1_NI_GROUP(14); SHA1_NI_GROUP(15);
+        SHA1_NI_GROUP(16); SHA1_NI_GROUP(17); SHA1_NI_GROUP(18); SHA1_NI_GROUP(19);
+        e0 = _mm_sha1nexte_epu32(prev, e0Saved);
+        abcd = _mm_add_epi32(abcd, abcdSaved);
+    }
+
+    _mm_storeu_si128((__m128i *) h, _mm_shuffle_epi32(abcd, 0x1B));
+    h[4] = (uint32_t) _mm_extract_epi32(e0, 3);
+}
+
+/**
+ * Four SHA-256 rounds: group i (rounds 4i .. 4i + 3) of the 16
+ */
+#define SHA256_NI_GROUP(i)                                                                  \
+    do {                                                                                    \
+        if ((i) >= 4) {                                                                     \
+            __m128i w7 = _mm_alignr_epi8(m[((i) + 3) % 4], m[((i) + 2) % 4], 4);           \
+            m[(i) % 4] = _mm_sha256msg2_epu32(                                              \
+                    _mm_add_epi32(_mm_sha256msg1_epu32(m[(i) % 4], m[((i) + 1) % 4]), w7),  \
+                    m[((i) + 3) % 4]);                                                      \
+        }                                                                                   \
+        __m128i wk = _mm_add_epi32(m[(i) % 4],                                              \
+                                   _mm_loadu_si128((const __m128i *) (SHA256_K + 4 * (i)))); \
+        cdgh = _mm_sha256rnds2_epu32(cdgh, abef, wk);                                       \
+        abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(wk, 0x0E));              \
+    } while (0)
+
+SHANI_TARGET
+void sha256_blocks_shani(uint32_t h[8], const unsigned char *blocks, size_t count) {
+    // sha256rnds2 wants the state as ABEF and CDGH
+    const __m128i swap32 = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i dcba = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) h), 0xB1);
+    __m128i hgfe = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) (h + 4)), 0x1B);
+    __m128i abef = _mm_alignr_epi8(dcba, hgfe, 8);
+    __m128i cdgh = _mm_blend_epi16(hgfe, dcba, 0xF0);
+
+    for (; count > 0; count--, blocks += 64) {
+        __m128i abefSaved = abef, cdghSaved = cdgh;
+        __m128i m[4];
+        for (int i = 0; i < 4; i++) {
+            m[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (blocks + 16 * i)),
+                                    swap32);
+        }
+        SHA256_NI_GROUP(0);  SHA256_NI_GROUP(1);  SHA256_NI_GROUP(2);  SHA256_NI_GROUP(3);
+        SHA256_NI_GROUP(4);  SHA256_NI_GROUP(5);  SHA256_NI_GROUP(6);  SHA256_NI_GROUP(7);
+        SHA256_NI_GROUP(8);  SHA256_NI_GROUP(9);  SHA256_NI_GROUP(10); SHA256_NI_GROUP(11);
+        SHA256_NI_GROUP(12); SHA256_NI_GROUP(13); SHA256_NI_GROUP(14); SHA256_NI_GROUP(15);
+        abef = _mm_add_epi32(abef, abefSaved);
+        cdgh = _mm_add_epi32(cdgh, cdghSaved);
+    }
+
+    __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+    __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+    _mm_storeu_si128((__m128i *) h, _mm_blend_epi16(feba, dchg, 0xF0));
+    _mm_storeu_si128((__m128i *) (h + 4), _mm_alignr_epi8(dchg, feba, 8));
+}
+
+#elif defined(__aarch64__)
+
+// ========== ARMv8 CRYPTOGRAPHY EXTENSION ==========
+
+// Clang takes extension names bare, GCC with a leading '+'
+#if defined(__clang__)
+#define ARMV8_SHA_TARGET __attribute__((target("crypto")))
+#else
+#define ARMV8_SHA_TARGET __attribute__((target("+crypto")))
+#endif
+
+/**
+ * Four SHA-1 rounds: group i (rounds 4i .. 4i + 3) of the 20, with round
+ * function op (sha1c, sha1p or sha1m) and constant k
+ */
+#define SHA1_CE_GROUP(i, op, k)                                                            \
+    do {                                                                                   \
+        if ((i) >= 4) {                                                                    \
+            m[(i) % 4] = vsha1su1q_u32(                                                    \
+                    vsha1su0q_u32(m[(i) % 4], m[((i) + 1) % 4], m[((i) + 2) % 4]),         \
+                    m[((i) + 3) % 4]);                                                     \
+        }                                                                                  \
+        uint32x4_t wk = vaddq_u32(m[(i) % 4], vdupq_n_u32(k));                             \
+        uint32_t eNext = vsha1h_u32(vgetq_lane_u32(abcd, 0));                              \
+        abcd = op(abcd, e, wk);                                                            \
+        e = eNext;                                                                         \
+    } while (0)
+
+ARMV8_SHA_TARGET
+void sha1_blocks_ce(uint32_t h[5], const unsigned char *blocks, size_t count) {
+    uint32x4_t abcd = vld1q_u32(h);
+    uint32_t e0 = h[4];
+
+    for (; count > 0; count--, blocks += 64) {
+        uint32x4_t abcdSaved = abcd;
+        uint32_t e = e0;
+        uint32x4_t m[4];
+        for (int i = 0; i < 4; i++) {
+            m[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 16 * i)));
+        }
+        SHA1_CE_GROUP(0, vsha1cq_u32, 0x5A827999);  SHA1_CE_GROUP(1, vsha1cq_u32, 0x5A827999);
+        SHA1_CE_GROUP(2, vsha1cq_u32, 0x5A827999);  SHA1_CE_GROUP(3, vsha1cq_u32, 0x5A827999);
+        SHA1_CE_GROUP(4, vsha1cq_u32, 0x5A827999);  SHA1_CE_GROUP(5, vsha1pq_u32, 0x6ED9EBA1);
+        SHA1_CE_GROUP(6, vsha1pq_u32, 0x6ED9EBA1);  SHA1_CE_GROUP(7, vsha1pq_u32, 0x6ED9EBA1);
+        SHA1_CE_GROUP(8, vsha1pq_u32, 0x6ED9EBA1);  SHA1_CE_GROUP(9, vsha1pq_u32, 0x6ED9EBA1);
+        SHA1_CE_GROUP(10, vsha1mq_u32, 0x8F1BBCDC); SHA1_CE_GROUP(11, vsha1mq_u32, 0x8F1BBCDC);
+        SHA1_CE_GROUP(12, vsha1mq_u32, 0x8F1BBCDC); SHA1_CE_GROUP(13, vsha1mq_u32, 0x8F1BBCDC);
+        SHA1_CE_GROUP(14, vsha1mq_u32, 0x8F1BBCDC); SHA1_CE_GROUP(15, vsha1pq_u32, 0xCA62C1D6);
+        SHA1_CE_GROUP(16, vsha1pq_u32, 0xCA62C1D6); SHA1_CE_GROUP(17, vsha1pq_u32, 0xCA62C1D6);
+        SHA1_CE_GROUP(18, vsha1pq_u32, 0xCA62C1D6); SHA1_CE_GROUP(19, vsha1pq_u32, 0xCA62C1D6);
+        abcd = vaddq_u32(abcd, abcdSaved);
+        e0 += e;
+    }
+
+    vst1q_u32(h, abcd);
+    h[4] = e0;
+}
+
+/**
+ * Four SHA-256 rounds: group i (rounds 4i .. 4i + 3) of the 16
+ */
+#define SHA256_CE_GROUP(i)                                                                 \
+    do {                                                                                   \
+        if ((i) >= 4) {                                                                    \
+            m[(i) % 4] = vsha256su1q_u32(vsha256su0q_u32(m[(i) % 4], m[((i) + 1) % 4]),    \
+                                         m[((i) + 2) % 4], m[((i) + 3) % 4]);              \
+        }                                                                                  \
+        uint32x4_t wk = vaddq_u32(m[(i) % 4], vld1q_u32(SHA256_K + 4 * (i)));             \
+        uint32x4_t abcdBefore = abcd;                                                      \
+        abcd = vsha256hq_u32(abcd, efgh, wk);                                              \
+        efgh = vsha256h2q_u32(efgh, abcdBefore, wk);                                       \
+    } while (0)
+
+ARMV8_SHA_TARGET
+void sha256_blocks_ce(uint32_t h[8], const unsigned char *blocks, size_t count) {
+    uint32x4_t abcd = vld1q_u32(h);
+    uint32x4_t efgh = vld1q_u32(h + 4);
+
+    for (; count > 0; count--, blocks += 64) {
+        uint32x4_t abcdSaved = abcd, efghSaved = efgh;
+        uint32x4_t m[4];
+        for (int i = 0; i < 4; i++) {
+            m[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 16 * i)));
+        }
+        SHA256_CE_GROUP(0);  SHA256_CE_GROUP(1);  SHA256_CE_GROUP(2);  SHA256_CE_GROUP(3);
+        SHA256_CE_GROUP(4);  SHA256_CE_GROUP(5);  SHA256_CE_GROUP(6);  SHA256_CE_GROUP(7);
+        SHA256_CE_GROUP(8);  SHA256_CE_GROUP(9);  SHA256_CE_GROUP(10); SHA256_CE_GROUP(11);
+        SHA256_CE_GROUP(12); SHA256_CE_GROUP(13); SHA256_CE_GROUP(14); SHA256_CE_GROUP(15);
+        abcd = vaddq_u32(abcd, abcdSaved);
+        efgh = vaddq_u32(efgh, efghSaved);
+    }
+
+    vst1q_u32(h, abcd);
+    vst1q_u32(h + 4, efgh);
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef FUZZME_V3_SHA_ACCEL_H
+#define FUZZME_V3_SHA_ACCEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ========== SHA INSTRUCTIONS ==========
+// Block functions built on the CPU's SHA instructions: SHA-NI on x86
+// (sha1rnds4, sha256rnds2), the ARMv8 Cryptography Extension on arm64
+// (sha1c, sha256h). They are variants in the SHA1_KERNELS and
+// SHA256_KERNELS tables (see cpu_dispatch.h), bound only when the CPU has
+// the instructions; all give the same chain values as the portable code.
+//
+// The message schedule stays in vector registers, so unlike the portable
+// code there is no schedule on the stack to wipe.
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * Compresses count consecutive 64-byte blocks into a chain value
+ * Needs SHA-NI, SSE4.1 and SSSE3
+ */
+void sha1_blocks_shani(uint32_t h[5], const unsigned char *blocks, size_t count);
+void sha256_blocks_shani(uint32_t h[8], const unsigned char *blocks, size_t count);
+
+#elif defined(__aarch64__)
+
+/**
+ * Compresses count consecutive 64-byte blocks into a chain value
+ * Needs the SHA1 / SHA2 instructions of the Cryptography Extension
+ */
+void sha1_blocks_ce(uint32_t h[5], const unsigned char *blocks, size_t count);
+void sha256_blocks_ce(uint32_t h[8], const unsigned char *blocks, size_t count);
+
+#endif
+
+#endif // FUZZME_V3_SHA_ACCEL_H
@@ -0,0 +1,251 @@
+# Computes the worst-case stack depth of the scrubbed JNI entry point bodies
+# and writes it out as a C++ source file (see stack_scrub.h).
+#
+# Run with cmake -P after the library objects are compiled with -fstack-usage:
+#   OBJECTS  '|'-separated object files (the .su files sit next to them)
+#   OBJDUMP  objdump / llvm-objdump used to recover the call graph (optional)
+#   ENTRIES  '|'-separated function names to measure
+#   OUTPUT   Source file to generate
+#
+# depth(f) = frame(f) + max(depth(callee)). Frames come from the .su files,
+# the call graph from disassembly plus call relocations. An indirect call
+# may reach any function whose address is stored in data of the same
+# object (function tables live next to the code that calls through them,
+# like the kernel variant tables of cpu_dispatch.h), so it is charged the
+# deepest of those. Functions outside
+# the library (libc, JNI function table) are charged EXTERNAL_FRAME: they are
+# small leaves or VM code that never holds our plaintext. Any entry we cannot
+# measure falls back to STACK_SCRUB_DEFAULT.
+
+cmake_minimum_required(VERSION 3.22.1)
+
+set(EXTERNAL_FRAME 256)
+
+string(REPLACE "|" ";" OBJECTS "${OBJECTS}")
+string(REPLACE "|" ";" ENTRIES "${ENTRIES}")
+
+# Reduces a mangled name (_ZL22check_credentials_implP7_JNIEnv...), a GCC
+# signature (jboolean check_credentials_impl(JNIEnv*, ...)) or a section
+# symbol (.text._Z...) to the bare function name
+function(plain_name raw out)
+    string(REGEX REPLACE "^\\.text\\." "" name "${raw}")
+    string(REGEX REPLACE "[-+@].*$" "" name "${name}")
+    if(name MATCHES "^_ZL?(N)?(.*)$")
+        set(nested "${CMAKE_MATCH_1}")
+        set(rest "${CMAKE_MATCH_2}")
+        set(ident "")
+        # Nested names list their components until 'E'; the function is the last
+        while(rest MATCHES "^(K|V)?([0-9]+)(.*)$")
+            set(len "${CMAKE_MATCH_2}")
+            string(SUBSTRING "${CMAKE_MATCH_3}" 0 ${len} ident)
+            string(SUBSTRING "${CMAKE_MATCH_3}" ${len} -1 rest)
+            if(NOT nested)
+                break()
+            endif()
+        endwhile()
+        if(ident STREQUAL "")
+            set(ident "${name}")
+        endif()
+        set(${out} "${ident}" PARENT_SCOPE)
+        return()
+    endif()
+    string(FIND "${name}" "(" paren)
+    if(paren GREATER 0)
+        string(SUBSTRING "${name}" 0 ${paren} name)
+    endif()
+    string(REGEX REPLACE "^.*[ :*&]" "" name "${name}")
+    set(${out} "${name}" PARENT_SCOPE)
+endfunction()
+
+# ---- Frame sizes ----
+foreach(obj IN LISTS OBJECTS)
+    string(REGEX REPLACE "\\.(o|obj)$" ".su" su "${obj}")
+    if(NOT EXISTS "${su}")
+        continue()
+    endif()
+    file(STRINGS "${su}" lines)
+    foreach(line IN LISTS lines)
+        if(NOT line MATCHES "^(.*)\t([0-9]+)\t")
+            continue()
+        endif()
+        set(size "${CMAKE_MATCH_2}")
+        set(where "${CMAKE_MATCH_1}")
+        if(where MATCHES ":(_Z[A-Za-z0-9_.]+)$")
+            set(raw "${CMAKE_MATCH_1}")
+        elseif(where MATCHES "^.*:[0-9]+:[0-9]+:(.*)$")
+            set(raw "${CMAKE_MATCH_1}")
+        else()
+            string(REGEX REPLACE "^.*:" "" raw "${where}")
+        endif()
+        plain_name("${raw}" fn)
+        # Same-named statics in different files: keep the larger frame
+        if(NOT DEFINED SU_${fn} OR size GREATER SU_${fn})
+            set(SU_${fn} ${size})
+        endif()
+    endforeach()
+endforeach()
+
+# ---- Call graph ----
+# Strips the leading zeros of a hex address so listings and relocations agree
+function(hex_key raw out)
+    string(REGEX REPLACE "^(0x)?0*([0-9a-f]+)$" "\\2" key "${raw}")
+    set(${out} "${key}" PARENT_SCOPE)
+endfunction()
+
+if(OBJDUMP)
+    foreach(obj IN LISTS OBJECTS)
+        execute_process(COMMAND "${OBJDUMP}" -dr --no-show-raw-insn "${obj}"
+                OUTPUT_VARIABLE dump ERROR_QUIET RESULT_VARIABLE rc)
+        if(NOT rc EQUAL 0)
+            continue()
+        endif()
+        # Keep the listing splittable: no ';' and no brackets (ARM addressing)
+        string(REPLACE ";" "," dump "${dump}")
+        string(REPLACE "[" "(" dump "${dump}")
+        string(REPLACE "]" ")" dump "${dump}")
+        string(REPLACE "\n" ";" dump "${dump}")
+        set(current "")
+        set(pending "")
+        set(afterCall FALSE)
+        set(section "")
+        set(textKeys "")
+        set(indirectCallers "")
+        set(indirectTargets "")
+        foreach(line IN LISTS dump)
+            # In an object file the call's own target is a placeholder; the
+            # relocation right after it names the real callee
+            if(afterCall AND line MATCHES "R_[A-Z0-9_]*(PLT32|PC32|CALL26|JUMP26|CALL|PLT)[ \t]+([^ \t]+)")
+                plain_name("${CMAKE_MATCH_2}" callee)
+                if(current AND NOT callee STREQUAL "" AND NOT callee STREQUAL ".text")
+                    list(APPEND CALLS_${current} "${callee}")
+                endif()
+                set(pending "")
+                set(afterCall FALSE)
+                continue()
+            endif()
+            if(pending)
+                list(APPEND CALLS_${current} "${pending}")
+                set(pending "")
+            endif()
+            set(afterCall FALSE)
+            if(line MATCHES "^Disassembly of section ([^:]+):")
+                set(section "${CMAKE_MATCH_1}")
+            elseif(line MATCHES "^([0-9a-f]+) <([^>]+)>:")
+                plain_name("${CMAKE_MATCH_2}" current)
+                # Data may point at a static function as .text+offset
+                if(section STREQUAL ".text")
+                    hex_key("${CMAKE_MATCH_1}" key)
+                    set(TEXT_AT_${key} "${current}")
+                    list(APPEND textKeys ${key})
+                endif()
+            elseif(line MATCHES "[ \t](call|callq|jmp|jmpq)[ \t]+\\*" OR
+                   line MATCHES "[ \t](blr|br)[ \t]+x[0-9]+" OR
+                   line MATCHES "[ \t](blx|bx)[ \t]+r[0-9]+")
+                # Through a pointer (switch jump tables land here too: harmless overcount)
+                if(current)
+                    list(APPEND indirectCallers "${current}")
+                endif()
+            elseif(line MATCHES "[ \t](call|callq|jmp|jmpq|bl|blx|b)[ \t]+[0-9a-fx]+ <([^>]+)>")
+                # Tail calls (jmp/b) count too; branches inside the function don't
+                plain_name("${CMAKE_MATCH_2}" callee)
+                set(afterCall TRUE)
+                if(NOT callee STREQUAL current)
+                    set(pending "${callee}")
+                endif()
+            endif()
+        endforeach()
+
+        # Function addresses stored in data sections
+        execute_process(COMMAND "${OBJDUMP}" -r "${obj}"
+                OUTPUT_VARIABLE relocs ERROR_QUIET RESULT_VARIABLE rc)
+        if(rc EQUAL 0)
+            string(REPLACE ";" "," relocs "${relocs}")
+            string(REPLACE "[" "(" relocs "${relocs}")
+            string(REPLACE "]" ")" relocs "${relocs}")
+            string(REPLACE "\n" ";" relocs "${relocs}")
+            set(inData FALSE)
+            foreach(line IN LISTS relocs)
+                if(line MATCHES "^RELOCATION RECORDS FOR \\(([^)]+)\\)")
+                    set(inData FALSE)
+                    if(CMAKE_MATCH_1 MATCHES "^\\.(data|rodata)")
+                        set(inData TRUE)
+                    endif()
+                elseif(inData AND line MATCHES "(R_X86_64_64|R_386_32|R_AARCH64_ABS64|R_ARM_ABS32)[ \t]+([^ \t]+)")
+                    set(value "${CMAKE_MATCH_2}")
+                    if(value MATCHES "^\\.text(\\+(0x[0-9a-f]+))?$")
+                        set(key 0)
+                        if(CMAKE_MATCH_2)
+                            hex_key("${CMAKE_MATCH_2}" key)
+                        endif()
+                        if(DEFINED TEXT_AT_${key})
+                            list(APPEND indirectTargets "${TEXT_AT_${key}}")
+                        endif()
+                    else()
+                        plain_name("${value}" target)
+                        if(DEFINED SU_${target})
+                            list(APPEND indirectTargets "${target}")
+                        endif()
+                    endif()
+                endif()
+            endforeach()
+        endif()
+        foreach(key IN LISTS textKeys)
+            unset(TEXT_AT_${key})
+        endforeach()
+
+        if(indirectCallers AND indirectTargets)
+            list(REMOVE_DUPLICATES indirectCallers)
+            list(REMOVE_DUPLICATES indirectTargets)
+            foreach(caller IN LISTS indirectCallers)
+                list(APPEND CALLS_${caller} ${indirectTargets})
+            endforeach()
+        endif()
+    endforeach()
+endif()
+
+function(depth_of fn visiting out)
+    get_property(memo GLOBAL PROPERTY DEPTH_${fn})
+    if(memo)
+        set(${out} ${memo} PARENT_SCOPE)
+        return()
+    endif()
+    if(NOT DEFINED SU_${fn})
+        set(${out} ${EXTERNAL_FRAME} PARENT_SCOPE)
+        return()
+    endif()
+    if(fn IN_LIST visiting)
+        # Recursion: its depth is unbounded, count the frame once
+        set(${out} ${SU_${fn}} PARENT_SCOPE)
+        return()
+    endif()
+    set(deepest 0)
+    if(DEFINED CALLS_${fn})
+        set(callees ${CALLS_${fn}})
+        list(REMOVE_DUPLICATES callees)
+        foreach(callee IN LISTS callees)
+            depth_of("${callee}" "${visiting};${fn}" d)
+            if(d GREATER deepest)
+                set(deepest ${d})
+            endif()
+        endforeach()
+    endif()
+    math(EXPR total "${SU_${fn}} + ${deepest}")
+    set_property(GLOBAL PROPERTY DEPTH_${fn} ${total})
+    set(${out} ${total} PARENT_SCOPE)
+endfunction()
+
+# ---- Output ----
+set(body "// Generated by stack_depth.cmake - do not edit\n\n#include \"stack_scrub.h\"\n\n")
+foreach(entry IN LISTS ENTRIES)
+    string(TOUPPER "${entry}" upper)
+    if(DEFINED SU_${entry})
+        depth_of("${entry}" "" depth)
+        string(APPEND body "const size_t STACK_DEPTH_${upper} = ${depth};\n")
+        message(STATUS "stack depth: ${entry} = ${depth} bytes (own frame ${SU_${entry}})")
+    else()
+        string(APPEND body "const size_t STACK_DEPTH_${upper} = STACK_SCRUB_DEFAULT;  // Not measured\n")
+        message(STATUS "stack depth: ${entry} not measured, using the default")
+    endif()
+endforeach()
+
+file(WRITE "${OUTPUT}" "${body}")
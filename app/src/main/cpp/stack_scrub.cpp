@@ -0,0 +1,23 @@
+#include "stack_scrub.h"
+
+#include <alloca.h>
+
+#include "native_stats.h"
+#include "secure_util.h"
+
+// Covers stack_scrub's own frame, which sits between the caller's stack
+// pointer and the alloca'd buffer
+static const size_t SCRUB_OWN_FRAME = 256;
+
+__attribute__((noinline)) void stack_scrub(size_t bytes) {
+    bytes += SCRUB_OWN_FRAME;
+    if (bytes > STACK_SCRUB_MAX) bytes = STACK_SCRUB_MAX;
+
+    // The buffer occupies exactly the stack the finished body used
+    unsigned char *buf = (unsigned char *) alloca(bytes);
+    secure_wipe_vectorized(buf, bytes);
+    stats_add(STAT_BYTES_WIPED, bytes);
+
+    // Keep the buffer (and the wipe) alive
+    __asm__ __volatile__("" : : "r"(buf) : "memory");
+}
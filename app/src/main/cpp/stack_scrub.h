@@ -0,0 +1,45 @@
+#ifndef FUZZME_V3_STACK_SCRUB_H
+#define FUZZME_V3_STACK_SCRUB_H
+
+#include <cstddef>
+
+// ========== STACK SCRUBBING ==========
+// Plaintext can be spilled anywhere in a stack frame, not just into the named
+// arrays we wipe. Sensitive JNI entry points therefore run their body in a
+// separate noinline *_impl function and, once it returns, zero the stack that
+// the body (and everything it called) used below the entry point's frame.
+
+// Used when the build could not measure an entry point
+static const size_t STACK_SCRUB_DEFAULT = 16 * 1024;
+
+// Hard cap so a bad measurement can never run off the end of the stack
+static const size_t STACK_SCRUB_MAX = 64 * 1024;
+
+/**
+ * Worst-case stack depth of each scrubbed *_impl body, in bytes
+ * Generated at build time from -fstack-usage frame sizes and the call graph
+ * of the library's own code (see stack_depth.cmake)
+ */
+extern const size_t STACK_DEPTH_CHECK_CREDENTIALS_IMPL;
+extern const size_t STACK_DEPTH_DECRYPT_FLAG_IMPL;
+extern const size_t STACK_DEPTH_VERIFY_CREDENTIALS_IMPL;
+extern const size_t STACK_DEPTH_VERIFY_STREAMED_CREDENTIALS_IMPL;
+extern const size_t STACK_DEPTH_APPLY_KEYSTROKE_EDIT;
+extern const size_t STACK_DEPTH_PREPARE_STREAMED_CHECK_IMPL;
+extern const size_t STACK_DEPTH_SPECULATE_KEYSTROKES_IMPL;
+extern const size_t STACK_DEPTH_HASH_PASSWORD_IMPL;
+extern const size_t STACK_DEPTH_PASSWORD_BREACHED_IMPL;
+extern const size_t STACK_DEPTH_KEYSTROKES_BREACHED_IMPL;
+extern const size_t STACK_DEPTH_PASSWORD_STRENGTH_IMPL;
+extern const size_t STACK_DEPTH_KEYSTROKES_STRENGTH_IMPL;
+extern const size_t STACK_DEPTH_PROVISION_OTP_IMPL;
+extern const size_t STACK_DEPTH_VERIFY_OTP_IMPL;
+extern const size_t STACK_DEPTH_VERIFY_KEYSTROKES_OTP_IMPL;
+
+/**
+ * Zeroes bytes of stack below the caller's stack pointer
+ * Call it right after the sensitive body returned, from the same frame
+ */
+void stack_scrub(size_t bytes);
+
+#endif // FUZZME_V3_STACK_SCRUB_H
@@ -0,0 +1,113 @@
+#include "strength_dict.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct StrengthDicts {
+    const unsigned char *base;          // Read-only mapping of the whole file
+    size_t mapLen;
+    size_t count;
+    StrengthTrie tries[STRENGTH_DICT_MAX_DICTS];
+    long long words;
+};
+
+// Walks hold it shared, open/close exclusively (to swap or unmap)
+static pthread_rwlock_t g_dictLock = PTHREAD_RWLOCK_INITIALIZER;
+static StrengthDicts g_dicts;
+
+/**
+ * Checks a mapped file and copies its list table
+ *
+ * @return false if a list or its root node lies outside the file
+ */
+static bool dicts_load(StrengthDicts *dicts, const unsigned char *base, size_t len) {
+    if (len < sizeof(StrengthDictHeader)) return false;
+    StrengthDictHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (memcmp(header.magic, STRENGTH_DICT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != STRENGTH_DICT_VERSION || header.dictCount == 0 ||
+        header.dictCount > STRENGTH_DICT_MAX_DICTS || header.fileBytes != len ||
+        len - sizeof(header) < header.dictCount * sizeof(StrengthDictEntry)) {
+        return false;
+    }
+
+    long long words = 0;
+    for (uint32_t i = 0; i < header.dictCount; i++) {
+        StrengthDictEntry entry;
+        memcpy(&entry, base + sizeof(header) + i * sizeof(entry), sizeof(entry));
+        StrengthNode root;
+        if (entry.kind >= STRENGTH_DICT_KIND_COUNT || entry.offset > len ||
+            entry.trieBytes > len - entry.offset ||
+            !strength_node_decode(base + entry.offset, entry.trieBytes, 0, &root)) {
+            return false;
+        }
+        StrengthTrie *trie = &dicts->tries[i];
+        trie->data = base + entry.offset;
+        trie->size = entry.trieBytes;
+        trie->kind = (StrengthDictKind) entry.kind;
+        trie->wordCount = entry.wordCount;
+        words += entry.wordCount;
+    }
+
+    dicts->base = base;
+    dicts->mapLen = len;
+    dicts->count = header.dictCount;
+    dicts->words = words;
+    return true;
+}
+
+static void dicts_unload(StrengthDicts *dicts) {
+    if (dicts->base) munmap((void *) dicts->base, dicts->mapLen);
+    memset(dicts, 0, sizeof(*dicts));
+}
+
+long long strength_dict_open(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct stat st;
+    void *base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        base = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) return -1;
+
+    StrengthDicts loaded = {};
+    if (!dicts_load(&loaded, (const unsigned char *) base, (size_t) st.st_size)) {
+        munmap(base, (size_t) st.st_size);
+        return -1;
+    }
+    // A few MB walked on every keystroke: page it all in now, not while typing
+    madvise(base, (size_t) st.st_size, MADV_WILLNEED);
+
+    pthread_rwlock_wrlock(&g_dictLock);
+    StrengthDicts old = g_dicts;
+    g_dicts = loaded;
+    pthread_rwlock_unlock(&g_dictLock);
+
+    dicts_unload(&old);
+    return loaded.words;
+}
+
+void strength_dict_close() {
+    pthread_rwlock_wrlock(&g_dictLock);
+    StrengthDicts old = g_dicts;
+    memset(&g_dicts, 0, sizeof(g_dicts));
+    pthread_rwlock_unlock(&g_dictLock);
+
+    dicts_unload(&old);
+}
+
+size_t strength_dict_acquire(const StrengthTrie **tries) {
+    pthread_rwlock_rdlock(&g_dictLock);
+    *tries = g_dicts.count ? g_dicts.tries : NULL;
+    return g_dicts.count;
+}
+
+void strength_dict_release() {
+    pthread_rwlock_unlock(&g_dictLock);
+}
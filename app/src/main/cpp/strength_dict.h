@@ -0,0 +1,52 @@
+#ifndef FUZZME_V3_STRENGTH_DICT_H
+#define FUZZME_V3_STRENGTH_DICT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "strength_dict_format.h"
+
+// ========== STRENGTH DICTIONARIES ==========
+// The ranked word lists the strength estimator matches passwords against,
+// memory-mapped from a file built on the host (format:
+// strength_dict_format.h, builder: tools/). The file is read-only and paged
+// in on demand; tries are walked in place with strength_cursor_step().
+
+/**
+ * One mapped word list
+ */
+struct StrengthTrie {
+    const unsigned char *data;
+    uint32_t size;
+    StrengthDictKind kind;
+    uint32_t wordCount;
+};
+
+/**
+ * Maps a dictionary file, replacing the current one
+ * The header and list table are validated and copied; tries are only
+ * bounds-checked as they are walked, so a bad file gives odd ranks at worst
+ *
+ * @return Words over all lists, -1 if the file is missing or malformed (the
+ *         current dictionaries then stay)
+ */
+long long strength_dict_open(const char *path);
+
+/**
+ * Unmaps the current dictionaries
+ */
+void strength_dict_close();
+
+/**
+ * Pins the current dictionaries for walking (callable from any thread)
+ * Every call must be paired with strength_dict_release(), which ends the
+ * tries' lifetime
+ *
+ * @param tries Receives the lists (NULL when none are loaded)
+ * @return Number of lists
+ */
+size_t strength_dict_acquire(const StrengthTrie **tries);
+
+void strength_dict_release();
+
+#endif // FUZZME_V3_STRENGTH_DICT_H
@@ -0,0 +1,192 @@
+#ifndef FUZZME_V3_STRENGTH_DICT_FORMAT_H
+#define FUZZME_V3_STRENGTH_DICT_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ========== STRENGTH DICTIONARY FILE FORMAT ==========
+// Shared by the library (strength_dict.cpp, strength_estimate.cpp) and the
+// host builder (tools/build_strength_dict.cpp); header-only like
+// breach_filter_format.h.
+//
+// A file holds up to STRENGTH_DICT_MAX_DICTS ranked word lists (most common
+// first, rank 1), each a path-compressed (radix) trie of its lowercased
+// words: chains of single-child nodes are folded into one edge label, nodes
+// are laid out depth-first with no pointers (a node's first child follows
+// it, siblings are skipped by their encoded size) and ranks and sizes are
+// varints. The estimator walks a trie one password byte at a time straight
+// from the mapping, so matching needs no allocation and no decompression.
+//
+// Layout (little-endian): StrengthDictHeader, dictCount StrengthDictEntry,
+// then the tries, each rooted at its first byte:
+//
+//   node  := head:u8 [labelLen:u8] label[labelLen] [rank:varint]
+//            [childCount - 1:u8 child...]
+//   child := [size:varint] node        size (bytes of node) on all but the last
+//
+// head holds the label length (STRENGTH_NODE_LABEL_EXT: in the next byte)
+// and the TERMINAL and CHILDREN flags, which say whether a rank and
+// children follow. A label is the whole edge into the node: never empty
+// except at the root, and siblings are sorted by its first byte.
+
+static const char STRENGTH_DICT_MAGIC[8] = {'F', 'Z', 'S', 'T', 'R', 'D', 'I', 'C'};
+static const uint32_t STRENGTH_DICT_VERSION = 1;
+static const uint32_t STRENGTH_DICT_MAX_DICTS = 8;
+static const size_t STRENGTH_DICT_MAX_WORD_BYTES = 64;
+
+static const uint8_t STRENGTH_NODE_LABEL_MASK = 0x0F;
+static const uint8_t STRENGTH_NODE_LABEL_EXT = 0x0F;
+static const uint8_t STRENGTH_NODE_TERMINAL = 0x10;
+static const uint8_t STRENGTH_NODE_CHILDREN = 0x20;
+
+/**
+ * What a word list holds (decides the feedback a match gives)
+ */
+enum StrengthDictKind {
+    STRENGTH_DICT_PASSWORDS = 0,    // Passwords from breaches, by frequency
+    STRENGTH_DICT_WORDS,            // Words of a language, by frequency
+    STRENGTH_DICT_NAMES,            // First names and surnames
+    STRENGTH_DICT_KIND_COUNT
+};
+
+struct StrengthDictHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dictCount;
+    uint64_t fileBytes;
+};
+
+struct StrengthDictEntry {
+    uint32_t kind;              // StrengthDictKind
+    uint32_t wordCount;         // Highest rank
+    uint64_t offset;            // Trie, from the start of the file
+    uint32_t trieBytes;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(StrengthDictHeader) == 24, "StrengthDictHeader layout");
+static_assert(sizeof(StrengthDictEntry) == 24, "StrengthDictEntry layout");
+
+/**
+ * A decoded node (offsets are from the start of the trie)
+ */
+struct StrengthNode {
+    uint32_t label;
+    uint32_t labelLen;
+    uint32_t rank;              // 0 if no word ends here
+    uint32_t childCount;
+    uint32_t children;          // First child
+};
+
+/**
+ * Position in a trie: labelPos bytes into the label of node
+ */
+struct StrengthCursor {
+    StrengthNode node;
+    uint32_t labelPos;
+};
+
+/**
+ * Reads a varint, bounds-checked
+ */
+static inline bool strength_varint(const unsigned char *trie, uint32_t size, uint32_t *p,
+                                   uint32_t *out) {
+    uint32_t v = 0;
+    for (int shift = 0;; shift += 7) {
+        if (*p >= size || shift > 28) return false;
+        uint8_t b = trie[(*p)++];
+        v |= (uint32_t) (b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+    }
+    *out = v;
+    return true;
+}
+
+/**
+ * Decodes the node at offset, bounds-checked against the trie
+ *
+ * @return false if the node does not fit (a corrupt file only fails walks)
+ */
+static inline bool strength_node_decode(const unsigned char *trie, uint32_t size,
+                                        uint32_t offset, StrengthNode *out) {
+    uint32_t p = offset;
+    if (p >= size) return false;
+    uint8_t head = trie[p++];
+    out->labelLen = head & STRENGTH_NODE_LABEL_MASK;
+    if (out->labelLen == STRENGTH_NODE_LABEL_EXT) {
+        if (p >= size) return false;
+        out->labelLen = trie[p++];
+    }
+    out->label = p;
+    if (out->labelLen > size - p) return false;
+    p += out->labelLen;
+
+    out->rank = 0;
+    if ((head & STRENGTH_NODE_TERMINAL) && !strength_varint(trie, size, &p, &out->rank)) {
+        return false;
+    }
+    out->childCount = 0;
+    if (head & STRENGTH_NODE_CHILDREN) {
+        if (p >= size) return false;
+        out->childCount = (uint32_t) trie[p++] + 1;
+    }
+    out->children = p;
+    return true;
+}
+
+/**
+ * Places a cursor at the root of a trie
+ */
+static inline bool strength_cursor_root(const unsigned char *trie, uint32_t size,
+                                        StrengthCursor *cursor) {
+    cursor->labelPos = 0;
+    return strength_node_decode(trie, size, 0, &cursor->node);
+}
+
+/**
+ * Advances a cursor by one byte
+ *
+ * @return false if no word continues with it (the cursor is then unchanged)
+ */
+static inline bool strength_cursor_step(const unsigned char *trie, uint32_t size,
+                                        StrengthCursor *cursor, unsigned char c) {
+    const StrengthNode *node = &cursor->node;
+    if (cursor->labelPos < node->labelLen) {
+        if (trie[node->label + cursor->labelPos] != c) return false;
+        cursor->labelPos++;
+        return true;
+    }
+    uint32_t p = node->children;
+    for (uint32_t i = 0; i < node->childCount; i++) {
+        uint32_t childSize = 0;
+        bool last = i + 1 == node->childCount;
+        if (!last && !strength_varint(trie, size, &p, &childSize)) return false;
+        // Peek at the first label byte; decode only the child taken
+        uint32_t label = p + 1;
+        if (label >= size) return false;
+        if ((trie[p] & STRENGTH_NODE_LABEL_MASK) == STRENGTH_NODE_LABEL_EXT) label++;
+        if (label >= size || (trie[p] & STRENGTH_NODE_LABEL_MASK) == 0) return false;
+        unsigned char first = trie[label];
+        if (first == c) {
+            StrengthNode child;
+            if (!strength_node_decode(trie, size, p, &child) || child.labelLen == 0) return false;
+            cursor->node = child;
+            cursor->labelPos = 1;
+            return true;
+        }
+        // Sorted: nothing further on can match
+        if (first > c || last) return false;
+        if (childSize > size - p) return false;
+        p += childSize;
+    }
+    return false;
+}
+
+/**
+ * Rank of the word ending at a cursor, 0 if none does
+ */
+static inline uint32_t strength_cursor_rank(const StrengthCursor *cursor) {
+    return cursor->labelPos == cursor->node.labelLen ? cursor->node.rank : 0;
+}
+
+#endif // FUZZME_V3_STRENGTH_DICT_FORMAT_H
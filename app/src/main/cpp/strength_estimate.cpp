@@ -0,0 +1,822 @@
+#include "strength_estimate.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <pthread.h>
+
+#include "lock_budget.h"
+#include "secure_util.h"
+#include "strength_dict.h"
+
+// zxcvbn's constants
+static const double MIN_GUESSES_BEFORE_GROWING_SEQUENCE_LOG10 = 4;   // 10^4
+static const double MIN_SUBMATCH_GUESSES_SINGLE_CHAR = 10;
+static const double MIN_SUBMATCH_GUESSES_MULTI_CHAR = 50;
+static const int MIN_YEAR_SPACE = 20;
+static const int DATE_MIN_YEAR = 1000;
+static const int DATE_MAX_YEAR = 2050;
+static const int SEQUENCE_MAX_DELTA = 5;
+static const uint32_t TOP_PASSWORD_RANK = 100;
+
+static const size_t N = STRENGTH_MAX_BYTES;
+
+/**
+ * Best match of one span
+ */
+struct Span {
+    float log10Guesses;         // INFINITY if nothing matched
+    uint8_t feedback;           // StrengthFeedback
+};
+
+/**
+ * dp[k][l]: cheapest sequence of l matches covering [begin, k]
+ */
+struct DpEntry {
+    float pi;                   // log10 of the product of the matches' guesses, INFINITY if none
+    float g;                    // log10 of the sequence's guesses (what entries compete on)
+    uint8_t start;              // Where the last match starts
+    uint8_t brute;              // Whether the last match is brute force
+    uint8_t feedback;
+};
+
+/**
+ * Depth-first walk of a trie over the password and its l33t readings
+ */
+struct WalkFrame {
+    StrengthCursor cursor;
+    uint8_t alt;                // Next reading of the byte to try
+    uint8_t subs;               // l33t substitutions on the way here
+};
+
+/**
+ * All working memory of an estimate (locked, wiped after every use)
+ */
+struct Scratch {
+    const unsigned char *raw;
+    size_t n;
+    int referenceYear;
+    unsigned char lower[N];
+    uint8_t codePoints[N + 1];  // Code points before each byte
+    unsigned char path[N];      // Letters the walk read
+    Span spans[N][N];           // [i][j]: best match of bytes i..j
+    DpEntry dp[N][N + 1];
+    uint8_t dpMaxL[N];
+    WalkFrame frames[N + 1];
+};
+
+// The UI thread estimates on every keystroke: one scratch is kept for it
+// (mapping and locking a fresh one costs ~140 us on its own). An estimate
+// finding it busy maps its own
+static pthread_mutex_t g_scratchLock = PTHREAD_MUTEX_INITIALIZER;
+static LockedRegion g_scratch;
+
+// ========== TABLES ==========
+
+/**
+ * A keyboard layout, as in zxcvbn: keys on a grid, each with an unshifted
+ * and an optional shifted character
+ */
+struct KeyGraph {
+    int8_t x[128], y[128];      // Key of each ASCII character, x = -1 if none
+    uint8_t shifted[128];
+    const int8_t (*directions)[2];
+    int directionCount;
+    double startingPositions;   // Characters on the layout
+    double averageDegree;       // Neighbours per key
+};
+
+static const char *const QWERTY_ROWS[] = {
+        "`~ 1! 2@ 3# 4$ 5% 6^ 7& 8* 9( 0) -_ =+",
+        "    qQ wW eE rR tT yY uU iI oO pP [{ ]} \\|",
+        "     aA sS dD fF gG hH jJ kK lL ;: '\"",
+        "      zZ xX cC vV bB nN mM ,< .> /?",
+};
+static const char *const KEYPAD_ROWS[] = {
+        "  / * -",
+        "7 8 9 +",
+        "4 5 6",
+        "1 2 3",
+        "  0 .",
+};
+// Neighbour directions; the index is the direction a walk turns on
+static const int8_t SLANTED_DIRECTIONS[6][2] = {{-1, 0}, {0, -1}, {1, -1}, {1, 0}, {0, 1}, {-1, 1}};
+static const int8_t ALIGNED_DIRECTIONS[8][2] = {{-1, 0}, {-1, -1}, {0, -1}, {1, -1},
+                                                {1, 0},  {1, 1},   {0, 1},  {-1, 1}};
+
+static KeyGraph g_qwerty, g_keypad;
+static double g_log10Factorial[N + 1];
+static pthread_once_t g_tablesOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Places the keys of a layout (zxcvbn's build_graph: a key's x is its
+ * column over the key width, less one per row on slanted layouts)
+ */
+static void build_graph(KeyGraph *graph, const char *const *rows, int rowCount, int keyWidth,
+                        int slant, const int8_t (*directions)[2], int directionCount) {
+    memset(graph->x, -1, sizeof(graph->x));
+    graph->directions = directions;
+    graph->directionCount = directionCount;
+    int keys = 0, chars = 0;
+    for (int y = 0; y < rowCount; y++) {
+        const char *row = rows[y];
+        for (int col = 0; row[col];) {
+            if (row[col] == ' ') {
+                col++;
+                continue;
+            }
+            int x = (col - slant * y) / keyWidth;
+            for (int k = 0; row[col] && row[col] != ' '; k++, col++) {
+                unsigned char c = (unsigned char) row[col];
+                graph->x[c] = (int8_t) x;
+                graph->y[c] = (int8_t) y;
+                graph->shifted[c] = k > 0;
+                chars++;
+            }
+            keys++;
+        }
+    }
+
+    // Degree: occupied neighbour slots, averaged over keys
+    int neighbours = 0;
+    for (int c = 0; c < 128; c++) {
+        if (graph->x[c] < 0 || graph->shifted[c]) continue;
+        for (int d = 0; d < directionCount; d++) {
+            for (int o = 0; o < 128; o++) {
+                if (graph->x[o] == graph->x[c] + directions[d][0] &&
+                    graph->y[o] == graph->y[c] + directions[d][1] && graph->x[o] >= 0 &&
+                    !graph->shifted[o]) {
+                    neighbours++;
+                    break;
+                }
+            }
+        }
+    }
+    graph->startingPositions = chars;
+    graph->averageDegree = (double) neighbours / keys;
+}
+
+static void build_tables() {
+    build_graph(&g_qwerty, QWERTY_ROWS, 4, 3, 1, SLANTED_DIRECTIONS, 6);
+    build_graph(&g_keypad, KEYPAD_ROWS, 5, 2, 0, ALIGNED_DIRECTIONS, 8);
+    g_log10Factorial[0] = 0;
+    for (size_t i = 1; i <= N; i++) g_log10Factorial[i] = g_log10Factorial[i - 1] + log10((double) i);
+}
+
+/**
+ * Letters a l33t character may stand for (zxcvbn's l33t table, inverted)
+ */
+static const char *l33t_letters(unsigned char c) {
+    switch (c) {
+        case '4': case '@': return "a";
+        case '8': return "b";
+        case '(': case '{': case '[': case '<': return "c";
+        case '3': return "e";
+        case '6': case '9': return "g";
+        case '1': case '|': return "il";
+        case '!': return "i";
+        case '7': return "lt";
+        case '0': return "o";
+        case '$': case '5': return "s";
+        case '+': return "t";
+        case '%': return "x";
+        case '2': return "z";
+        default: return "";
+    }
+}
+
+// ========== HELPERS ==========
+
+static inline bool is_upper(unsigned char c) { return c >= 'A' && c <= 'Z'; }
+static inline bool is_lower(unsigned char c) { return c >= 'a' && c <= 'z'; }
+static inline bool is_digit(unsigned char c) { return c >= '0' && c <= '9'; }
+static inline unsigned char to_lower(unsigned char c) { return is_upper(c) ? c + ('a' - 'A') : c; }
+
+static double n_choose_k(int n, int k) {
+    if (k > n) return 0;
+    double r = 1;
+    for (int d = 1; d <= k; d++) r = r * (n - k + d) / d;
+    return r;
+}
+
+/**
+ * sum_{i=1}^{min(a,b)} C(a+b, i): the ways to place the rarer of two kinds
+ */
+static double variations(int a, int b) {
+    double sum = 0;
+    int m = a < b ? a : b;
+    for (int i = 1; i <= m; i++) sum += n_choose_k(a + b, i);
+    return sum;
+}
+
+/**
+ * log10(10^a + 10^b)
+ */
+static inline double log10_add(double a, double b) {
+    double hi = a > b ? a : b, lo = a > b ? b : a;
+    return hi + log10(1 + pow(10, lo - hi));
+}
+
+/**
+ * Keeps a match if it beats the span's current best
+ */
+static inline void offer(Scratch *s, size_t i, size_t j, double log10Guesses, StrengthFeedback fb) {
+    Span *span = &s->spans[i][j];
+    if (log10Guesses < span->log10Guesses) {
+        span->log10Guesses = (float) log10Guesses;
+        span->feedback = (uint8_t) fb;
+    }
+}
+
+// ========== DICTIONARY MATCHING ==========
+
+/**
+ * zxcvbn's uppercase variations of raw[i..j]
+ */
+static double uppercase_variations(const Scratch *s, size_t i, size_t j) {
+    int upper = 0, lower = 0;
+    for (size_t p = i; p <= j; p++) {
+        upper += is_upper(s->raw[p]);
+        lower += is_lower(s->raw[p]);
+    }
+    if (upper == 0) return 1;
+    // All caps, or only the first or last letter capitalized
+    if (lower == 0 ||
+        (upper == 1 && j > i && (is_upper(s->raw[i]) || is_upper(s->raw[j])))) {
+        return 2;
+    }
+    return variations(upper, lower);
+}
+
+/**
+ * zxcvbn's l33t variations of bytes i..j as the walk read them (path)
+ */
+static double l33t_variations(const Scratch *s, size_t i, size_t j) {
+    double v = 1;
+    for (size_t p = i; p <= j; p++) {
+        unsigned char letter = s->path[p - i];
+        if (letter == s->lower[p]) continue;
+        // Each substitution once
+        bool seen = false;
+        for (size_t q = i; q < p && !seen; q++) {
+            seen = s->path[q - i] != s->lower[q] && s->raw[q] == s->raw[p] &&
+                   s->path[q - i] == letter;
+        }
+        if (seen) continue;
+        int subbed = 0, unsubbed = 0;
+        for (size_t q = i; q <= j; q++) {
+            subbed += s->raw[q] == s->raw[p];
+            unsubbed += s->lower[q] == letter;
+        }
+        v *= unsubbed == 0 ? 2 : variations(subbed, unsubbed);
+    }
+    return v;
+}
+
+static StrengthFeedback dictionary_feedback(StrengthDictKind kind, uint32_t rank) {
+    switch (kind) {
+        case STRENGTH_DICT_PASSWORDS:
+            return rank <= TOP_PASSWORD_RANK ? STRENGTH_FEEDBACK_TOP_PASSWORD
+                                             : STRENGTH_FEEDBACK_COMMON_PASSWORD;
+        case STRENGTH_DICT_NAMES: return STRENGTH_FEEDBACK_NAME;
+        default: return STRENGTH_FEEDBACK_WORD;
+    }
+}
+
+/**
+ * Finds every word of a trie starting at each byte, reading each byte as
+ * itself and as every letter it is l33t for
+ */
+static void match_trie(Scratch *s, const StrengthTrie *trie) {
+    for (size_t i = 0; i < s->n; i++) {
+        WalkFrame *frames = s->frames;
+        if (!strength_cursor_root(trie->data, trie->size, &frames[0].cursor)) return;
+        frames[0].alt = 0;
+        frames[0].subs = 0;
+        size_t depth = 0;
+        for (;;) {
+            WalkFrame *f = &frames[depth];
+            size_t p = i + depth;
+            const char *letters = p < s->n ? l33t_letters(s->raw[p]) : "";
+            if (p >= s->n || f->alt > strlen(letters)) {
+                if (depth == 0) break;
+                depth--;
+                continue;
+            }
+            unsigned char c = f->alt == 0 ? s->lower[p] : (unsigned char) letters[f->alt - 1];
+            f->alt++;
+            WalkFrame *next = &frames[depth + 1];
+            next->cursor = f->cursor;
+            if (!strength_cursor_step(trie->data, trie->size, &next->cursor, c)) continue;
+            next->alt = 0;
+            next->subs = (uint8_t) (f->subs + (c != s->lower[p]));
+            s->path[depth] = c;
+
+            uint32_t rank = strength_cursor_rank(&next->cursor);
+            // Single-character l33t "words" are noise (zxcvbn drops them too)
+            if (rank && !(next->subs && p == i)) {
+                double guesses = (double) rank * uppercase_variations(s, i, p);
+                if (next->subs) guesses *= l33t_variations(s, i, p);
+                offer(s, i, p, log10(guesses), dictionary_feedback(trie->kind, rank));
+            }
+            depth++;
+        }
+    }
+}
+
+/**
+ * Finds every word of a trie spelled backwards, ending at each byte
+ */
+static void match_trie_reversed(Scratch *s, const StrengthTrie *trie) {
+    StrengthCursor *cursor = &s->frames[0].cursor;
+    for (size_t j = 0; j < s->n; j++) {
+        if (!strength_cursor_root(trie->data, trie->size, cursor)) return;
+        for (size_t p = j + 1; p-- > 0;) {
+            if (!strength_cursor_step(trie->data, trie->size, cursor, s->lower[p])) break;
+            uint32_t rank = strength_cursor_rank(cursor);
+            if (rank) {
+                double guesses = 2.0 * rank * uppercase_variations(s, p, j);
+                offer(s, p, j, log10(guesses), dictionary_feedback(trie->kind, rank));
+            }
+        }
+    }
+}
+
+/**
+ * Matches one token of the context, forwards and backwards
+ */
+static void match_context_token(Scratch *s, const unsigned char *token, size_t len,
+                                uint32_t rank) {
+    if (len == 0 || len > s->n) return;
+    for (size_t i = 0; i + len <= s->n; i++) {
+        bool forward = true, backward = true;
+        for (size_t k = 0; k < len; k++) {
+            unsigned char c = to_lower(token[k]);
+            forward = forward && s->lower[i + k] == c;
+            backward = backward && s->lower[i + len - 1 - k] == c;
+        }
+        double upper = uppercase_variations(s, i, i + len - 1);
+        if (forward) offer(s, i, i + len - 1, log10(rank * upper), STRENGTH_FEEDBACK_USER_INPUT);
+        if (backward) {
+            offer(s, i, i + len - 1, log10(2.0 * rank * upper), STRENGTH_FEEDBACK_USER_INPUT);
+        }
+    }
+}
+
+/**
+ * The context as a whole (rank 1), then each run of 3 or more letters and
+ * digits in it (ranks 2, 3, ...): "jane.doe@example.com" also gives "jane"
+ */
+static void match_context(Scratch *s, const unsigned char *context, size_t len) {
+    match_context_token(s, context, len, 1);
+    uint32_t rank = 2;
+    for (size_t i = 0; i < len;) {
+        size_t j = i;
+        while (j < len && (is_lower(to_lower(context[j])) || is_digit(context[j]))) j++;
+        if (j - i >= 3 && j - i < len) match_context_token(s, context + i, j - i, rank++);
+        i = j > i ? j : i + 1;
+    }
+}
+
+// ========== PATTERN MATCHING ==========
+
+/**
+ * Whether b is next to a on a layout, and in which direction
+ */
+static inline int key_direction(const KeyGraph *graph, unsigned char a, unsigned char b) {
+    if (a >= 128 || b >= 128 || graph->x[a] < 0 || graph->x[b] < 0) return -1;
+    int dx = graph->x[b] - graph->x[a], dy = graph->y[b] - graph->y[a];
+    for (int d = 0; d < graph->directionCount; d++) {
+        if (graph->directions[d][0] == dx && graph->directions[d][1] == dy) return d;
+    }
+    return -1;
+}
+
+/**
+ * Keyboard walks of 3 or more keys (zxcvbn's spatial matching and guesses)
+ */
+static void match_spatial(Scratch *s, const KeyGraph *graph) {
+    size_t i = 0;
+    while (i + 1 < s->n) {
+        size_t j = i + 1;
+        int lastDirection = -1, turns = 0;
+        int shifted = s->raw[i] < 128 && graph->x[s->raw[i]] >= 0 && graph->shifted[s->raw[i]];
+        while (j < s->n) {
+            int d = key_direction(graph, s->raw[j - 1], s->raw[j]);
+            if (d < 0) break;
+            shifted += graph->shifted[s->raw[j]];
+            if (d != lastDirection) {
+                turns++;
+                lastDirection = d;
+            }
+            j++;
+        }
+        if (j - i > 2) {
+            int len = (int) (j - i);
+            double guesses = 0;
+            for (int k = 2; k <= len; k++) {
+                int possibleTurns = turns < k - 1 ? turns : k - 1;
+                for (int t = 1; t <= possibleTurns; t++) {
+                    guesses += n_choose_k(k - 1, t - 1) * graph->startingPositions *
+                               pow(graph->averageDegree, t);
+                }
+            }
+            if (shifted) guesses *= shifted == len ? 2 : variations(shifted, len - shifted);
+            offer(s, i, j - 1, log10(guesses), STRENGTH_FEEDBACK_SPATIAL);
+        }
+        i = j;
+    }
+}
+
+/**
+ * Runs of bytes with a constant step of at most 5: abc, 2468, zyx
+ */
+static void match_sequences(Scratch *s) {
+    if (s->n < 2) return;
+    size_t i = 0;
+    int lastDelta = s->raw[1] - s->raw[0];
+    for (size_t k = 1; k <= s->n; k++) {
+        int delta = k < s->n ? s->raw[k] - s->raw[k - 1] : INT32_MIN;
+        if (k < s->n && delta == lastDelta) continue;
+        size_t j = k - 1;
+        int absDelta = lastDelta < 0 ? -lastDelta : lastDelta;
+        if ((j - i > 1 || absDelta == 1) && absDelta > 0 && absDelta <= SEQUENCE_MAX_DELTA) {
+            unsigned char first = s->raw[i];
+            double base = first && strchr("aAzZ019", first) ? 4 : is_digit(first) ? 10 : 26;
+            if (lastDelta < 0) base *= 2;
+            offer(s, i, j, log10(base * (double) (j - i + 1)), STRENGTH_FEEDBACK_SEQUENCE);
+        }
+        i = j;
+        lastDelta = delta;
+    }
+}
+
+static inline int year_guesses(int year, int referenceYear) {
+    int space = year > referenceYear ? year - referenceYear : referenceYear - year;
+    return space > MIN_YEAR_SPACE ? space : MIN_YEAR_SPACE;
+}
+
+/**
+ * 19xx and 20xx
+ */
+static void match_years(Scratch *s) {
+    for (size_t i = 0; i + 4 <= s->n;) {
+        const unsigned char *r = s->raw + i;
+        if (is_digit(r[0]) && is_digit(r[1]) && is_digit(r[2]) && is_digit(r[3]) &&
+            ((r[0] == '1' && r[1] == '9') || (r[0] == '2' && r[1] == '0'))) {
+            int year = (r[0] - '0') * 1000 + (r[1] - '0') * 100 + (r[2] - '0') * 10 + (r[3] - '0');
+            offer(s, i, i + 3, log10((double) year_guesses(year, s->referenceYear)),
+                  STRENGTH_FEEDBACK_YEAR);
+            i += 4;
+        } else {
+            i++;
+        }
+    }
+}
+
+/**
+ * Day and month out of two integers, either order (zxcvbn's map_ints_to_dm)
+ */
+static bool ints_to_dm(int a, int b) {
+    return (a >= 1 && a <= 31 && b >= 1 && b <= 12) || (b >= 1 && b <= 31 && a >= 1 && a <= 12);
+}
+
+/**
+ * Year of three integers that read as a date, -1 if they do not
+ * (zxcvbn's map_ints_to_dmy)
+ */
+static int ints_to_year(const int ints[3]) {
+    if (ints[1] > 31 || ints[1] <= 0) return -1;
+    int over12 = 0, over31 = 0, under1 = 0;
+    for (int k = 0; k < 3; k++) {
+        int v = ints[k];
+        if ((v > 99 && v < DATE_MIN_YEAR) || v > DATE_MAX_YEAR) return -1;
+        over31 += v > 31;
+        over12 += v > 12;
+        under1 += v <= 0;
+    }
+    if (over31 >= 2 || over12 == 3 || under1 >= 2) return -1;
+
+    // Year last, then year first
+    const int splits[2][3] = {{ints[2], ints[0], ints[1]}, {ints[0], ints[1], ints[2]}};
+    for (const int *split : splits) {
+        if (split[0] >= DATE_MIN_YEAR && split[0] <= DATE_MAX_YEAR) {
+            return ints_to_dm(split[1], split[2]) ? split[0] : -1;
+        }
+    }
+    for (const int *split : splits) {
+        if (ints_to_dm(split[1], split[2])) {
+            int y = split[0];
+            return y > 99 ? y : y > 50 ? 1900 + y : 2000 + y;
+        }
+    }
+    return -1;
+}
+
+static int parse_digits(const unsigned char *p, size_t len) {
+    int v = 0;
+    for (size_t k = 0; k < len; k++) v = v * 10 + (p[k] - '0');
+    return v;
+}
+
+static void offer_date(Scratch *s, size_t i, size_t j, int year, bool separator) {
+    double guesses = (double) year_guesses(year, s->referenceYear) * 365;
+    if (separator) guesses *= 4;
+    offer(s, i, j, log10(guesses), STRENGTH_FEEDBACK_DATE);
+}
+
+/**
+ * Dates of 4 to 8 digits (131298, 2001979) and with separators (13.12.98)
+ */
+static void match_dates(Scratch *s) {
+    // zxcvbn's DATE_SPLITS: where the digits may be cut, by length
+    static const uint8_t SPLITS[9][4][2] = {
+            {}, {}, {}, {},
+            {{1, 2}, {2, 3}},
+            {{1, 3}, {2, 3}},
+            {{1, 2}, {2, 4}, {4, 5}},
+            {{1, 3}, {2, 3}, {4, 5}, {4, 6}},
+            {{2, 4}, {4, 6}},
+    };
+    for (size_t i = 0; i < s->n; i++) {
+        size_t digits = 0;
+        while (i + digits < s->n && is_digit(s->raw[i + digits])) digits++;
+        for (size_t len = 4; len <= 8 && len <= digits; len++) {
+            const unsigned char *t = s->raw + i;
+            int best = -1;
+            for (int k = 0; k < 4 && SPLITS[len][k][0]; k++) {
+                size_t a = SPLITS[len][k][0], b = SPLITS[len][k][1];
+                int ints[3] = {parse_digits(t, a), parse_digits(t + a, b - a),
+                               parse_digits(t + b, len - b)};
+                int year = ints_to_year(ints);
+                if (year >= 0 && (best < 0 || year_guesses(year, s->referenceYear) <
+                                                      year_guesses(best, s->referenceYear))) {
+                    best = year;
+                }
+            }
+            if (best >= 0) offer_date(s, i, i + len - 1, best, false);
+        }
+
+        // d{1,4} sep d{1,2} sep d{1,4}, the same separator twice
+        if (digits == 0) continue;
+        for (size_t a = 1; a <= 4 && a <= digits; a++) {
+            size_t p = i + a;
+            if (p >= s->n || !s->raw[p] || !strchr(" \t/\\_.-", s->raw[p])) continue;
+            unsigned char sep = s->raw[p++];
+            size_t b = 0;
+            while (p + b < s->n && b < 2 && is_digit(s->raw[p + b])) b++;
+            if (b == 0 || p + b >= s->n || s->raw[p + b] != sep) continue;
+            size_t q = p + b + 1;
+            size_t c = 0;
+            while (q + c < s->n && is_digit(s->raw[q + c])) c++;
+            for (size_t cl = 1; cl <= 4 && cl <= c; cl++) {
+                int ints[3] = {parse_digits(s->raw + i, a), parse_digits(s->raw + p, b),
+                               parse_digits(s->raw + q, cl)};
+                int year = ints_to_year(ints);
+                if (year >= 0) offer_date(s, i, q + cl - 1, year, true);
+            }
+        }
+    }
+}
+
+// ========== SCORING ==========
+
+/**
+ * log10 guesses of brute-forcing bytes i..k (10 per code point)
+ */
+static inline double brute_log10(const Scratch *s, size_t i, size_t k) {
+    int chars = s->codePoints[k + 1] - s->codePoints[i];
+    // zxcvbn's floors (11 and 51 guesses) only bind for one character
+    return chars <= 1 ? log10(MIN_SUBMATCH_GUESSES_SINGLE_CHAR + 1) : chars;
+}
+
+static inline void dp_update(Scratch *s, size_t k, size_t l, double pi, size_t start, bool brute,
+                             uint8_t feedback) {
+    double g = g_log10Factorial[l] + pi;
+    g = log10_add(g, MIN_GUESSES_BEFORE_GROWING_SEQUENCE_LOG10 * (double) (l - 1));
+    // Only worth keeping if no sequence of at most as many matches is as cheap
+    for (size_t cl = 1; cl <= l && cl <= s->dpMaxL[k]; cl++) {
+        if (s->dp[k][cl].g <= g) return;
+    }
+    DpEntry *e = &s->dp[k][l];
+    e->pi = (float) pi;
+    e->g = (float) g;
+    e->start = (uint8_t) start;
+    e->brute = brute;
+    e->feedback = feedback;
+    if (l > s->dpMaxL[k]) s->dpMaxL[k] = (uint8_t) l;
+}
+
+/**
+ * zxcvbn's most_guessable_match_sequence over bytes [begin, end)
+ *
+ * @param feedback Receives the feedback of the longest match in the
+ *                 cheapest sequence (NULL = not needed)
+ * @return log10 of its guesses
+ */
+static double most_guessable(Scratch *s, size_t begin, size_t end, StrengthFeedback *feedback) {
+    size_t total = end - begin;
+    for (size_t k = begin; k < end; k++) {
+        for (size_t l = 0; l <= total; l++) s->dp[k][l].g = s->dp[k][l].pi = INFINITY;
+        s->dpMaxL[k] = 0;
+    }
+
+    for (size_t k = begin; k < end; k++) {
+        for (size_t i = begin; i <= k; i++) {
+            const Span *m = &s->spans[i][k];
+            if (!(m->log10Guesses < INFINITY)) continue;
+            double guesses = m->log10Guesses;
+            if (k - i + 1 < total) {
+                double floor = log10(k == i ? MIN_SUBMATCH_GUESSES_SINGLE_CHAR
+                                            : MIN_SUBMATCH_GUESSES_MULTI_CHAR);
+                if (guesses < floor) guesses = floor;
+            }
+            if (i == begin) {
+                dp_update(s, k, 1, guesses, i, false, m->feedback);
+                continue;
+            }
+            for (size_t l = 1; l <= s->dpMaxL[i - 1]; l++) {
+                const DpEntry *prev = &s->dp[i - 1][l];
+                if (prev->pi < INFINITY) dp_update(s, k, l + 1, prev->pi + guesses, i, false, m->feedback);
+            }
+        }
+
+        // Brute force from the start, or after a match that is not brute force
+        dp_update(s, k, 1, brute_log10(s, begin, k), begin, true, STRENGTH_FEEDBACK_NONE);
+        for (size_t i = begin + 1; i <= k; i++) {
+            double guesses = brute_log10(s, i, k);
+            for (size_t l = 1; l <= s->dpMaxL[i - 1]; l++) {
+                const DpEntry *prev = &s->dp[i - 1][l];
+                if (prev->pi < INFINITY && !prev->brute) {
+                    dp_update(s, k, l + 1, prev->pi + guesses, i, true, STRENGTH_FEEDBACK_NONE);
+                }
+            }
+        }
+    }
+
+    size_t last = end - 1, bestL = 1;
+    for (size_t l = 1; l <= s->dpMaxL[last]; l++) {
+        if (s->dp[last][l].g < s->dp[last][bestL].g) bestL = l;
+    }
+    if (feedback) {
+        *feedback = STRENGTH_FEEDBACK_NONE;
+        size_t longest = 0;
+        for (size_t k = last, l = bestL; l > 0; l--) {
+            const DpEntry *e = &s->dp[k][l];
+            if (!e->brute && k - e->start + 1 > longest) {
+                longest = k - e->start + 1;
+                *feedback = (StrengthFeedback) e->feedback;
+            }
+            if (e->start == begin) break;
+            k = e->start - 1;
+        }
+    }
+    return s->dp[last][bestL].g;
+}
+
+/**
+ * Repeated chunks (aaa, abcabc), scored as the chunk's guesses times the
+ * repeats; runs after the other matchers since the chunk is scored with them
+ */
+static void match_repeats(Scratch *s) {
+    size_t i = 0;
+    while (i + 1 < s->n) {
+        size_t bestLen = 0, bestChunk = 0;
+        for (size_t chunk = 1; i + 2 * chunk <= s->n; chunk++) {
+            size_t count = 1;
+            while (i + (count + 1) * chunk <= s->n &&
+                   memcmp(s->raw + i, s->raw + i + count * chunk, chunk) == 0) {
+                count++;
+            }
+            if (count >= 2 && count * chunk > bestLen) {
+                bestLen = count * chunk;
+                bestChunk = chunk;
+            }
+        }
+        if (!bestLen) {
+            i++;
+            continue;
+        }
+        double chunkGuesses = most_guessable(s, i, i + bestChunk, NULL);
+        offer(s, i, i + bestLen - 1, chunkGuesses + log10((double) (bestLen / bestChunk)),
+              STRENGTH_FEEDBACK_REPEAT);
+        i += bestLen;
+    }
+}
+
+static int score_of(double log10Guesses) {
+    // zxcvbn's thresholds: 10^3, 10^6, 10^8 and 10^10 guesses, 5 of slack each
+    static const double limits[4] = {1e3 + 5, 1e6 + 5, 1e8 + 5, 1e10 + 5};
+    int score = 0;
+    while (score < 4 && log10Guesses >= log10(limits[score])) score++;
+    return score;
+}
+
+static int current_year() {
+    time_t now = time(NULL);
+    struct tm tm;
+    return gmtime_r(&now, &tm) ? tm.tm_year + 1900 : 2020;
+}
+
+/**
+ * Takes the cached scratch, or maps one into own if it is busy
+ */
+static Scratch *scratch_acquire(LockedRegion *own) {
+    if (pthread_mutex_trylock(&g_scratchLock) == 0) {
+        if (g_scratch.ptr || locked_alloc(&g_scratch, sizeof(Scratch), LOCK_PRIO_NORMAL)) {
+            return (Scratch *) g_scratch.ptr;
+        }
+        pthread_mutex_unlock(&g_scratchLock);
+        return NULL;
+    }
+    return locked_alloc(own, sizeof(Scratch), LOCK_PRIO_NORMAL) ? (Scratch *) own->ptr : NULL;
+}
+
+/**
+ * Wipes what an estimate of n bytes wrote, and gives the scratch back
+ */
+static void scratch_release(Scratch *s, LockedRegion *own) {
+    if (own->ptr) {
+        locked_free(own);
+        return;
+    }
+    size_t n = s->n;
+    secure_wipe_vectorized(s, offsetof(Scratch, spans));
+    secure_wipe_vectorized(s->spans, n * sizeof(s->spans[0]));
+    secure_wipe_vectorized(s->dp, n * sizeof(s->dp[0]));
+    secure_wipe_vectorized(s->dpMaxL, sizeof(s->dpMaxL));
+    secure_wipe_vectorized(s->frames, (n + 1) * sizeof(s->frames[0]));
+    pthread_mutex_unlock(&g_scratchLock);
+}
+
+size_t strength_trim() {
+    pthread_mutex_lock(&g_scratchLock);
+    size_t released = g_scratch.ptr ? g_scratch.mapLen : 0;
+    if (g_scratch.ptr) locked_free(&g_scratch);
+    pthread_mutex_unlock(&g_scratchLock);
+    return released;
+}
+
+bool strength_estimate(const unsigned char *password, size_t len, const unsigned char *context,
+                       size_t contextLen, StrengthEstimate *out) {
+    pthread_once(&g_tablesOnce, build_tables);
+
+    // Past STRENGTH_MAX_BYTES (cut on a code point boundary), brute force
+    size_t n = len;
+    double tail = 0;
+    if (n > N) {
+        n = N;
+        while (n > 0 && (password[n] & 0xC0) == 0x80) n--;
+        for (size_t p = n; p < len; p++) tail += (password[p] & 0xC0) != 0x80;
+    }
+    if (n == 0) {
+        out->log10Guesses = tail;
+        out->score = score_of(tail);
+        out->feedback = STRENGTH_FEEDBACK_NONE;
+        return true;
+    }
+
+    LockedRegion own = {};
+    Scratch *s = scratch_acquire(&own);
+    if (!s) return false;
+    s->raw = password;
+    s->n = n;
+    s->referenceYear = current_year();
+    s->codePoints[0] = 0;
+    for (size_t p = 0; p < n; p++) {
+        s->lower[p] = to_lower(password[p]);
+        s->codePoints[p + 1] = (uint8_t) (s->codePoints[p] + ((password[p] & 0xC0) != 0x80));
+    }
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = i; j < n; j++) {
+            s->spans[i][j].log10Guesses = INFINITY;
+            s->spans[i][j].feedback = STRENGTH_FEEDBACK_NONE;
+        }
+    }
+
+    const StrengthTrie *tries;
+    size_t trieCount = strength_dict_acquire(&tries);
+    for (size_t t = 0; t < trieCount; t++) {
+        match_trie(s, &tries[t]);
+        match_trie_reversed(s, &tries[t]);
+    }
+    strength_dict_release();
+    if (context && contextLen) match_context(s, context, contextLen);
+    match_spatial(s, &g_qwerty);
+    match_spatial(s, &g_keypad);
+    match_sequences(s);
+    match_years(s);
+    match_dates(s);
+    match_repeats(s);
+
+    StrengthFeedback feedback;
+    double log10Guesses = most_guessable(s, 0, n, &feedback) + tail;
+    scratch_release(s, &own);
+
+    out->log10Guesses = log10Guesses;
+    out->score = score_of(log10Guesses);
+    out->feedback = out->score > 2 ? STRENGTH_FEEDBACK_NONE : feedback;
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef FUZZME_V3_STRENGTH_ESTIMATE_H
+#define FUZZME_V3_STRENGTH_ESTIMATE_H
+
+#include <cstddef>
+
+// ========== PASSWORD STRENGTH ESTIMATE ==========
+// zxcvbn (Wheeler, "zxcvbn: Low-Budget Password Strength Estimation", 2016)
+// computed on the secure buffer: the password is matched against ranked
+// dictionaries (also reversed and with l33t substitutions), keyboard walks,
+// repeats, sequences, years and dates, and a dynamic program finds the
+// sequence of matches (with brute force between them) that needs the
+// fewest guesses. Scores and guess counts follow zxcvbn's formulas.
+//
+// Matching keeps only the best match of each span, in a fixed-size table,
+// so nothing is allocated per match; all working memory is one locked
+// scratch region, kept between estimates and wiped after every one.
+
+// Longer passwords: the rest adds 10 guesses per code point, as brute force
+static const size_t STRENGTH_MAX_BYTES = 64;
+
+/**
+ * Why a weak password is weak: the pattern of the longest match in the
+ * cheapest guessing sequence
+ */
+enum StrengthFeedback {
+    STRENGTH_FEEDBACK_NONE = 0,         // Strong enough, or nothing stands out
+    STRENGTH_FEEDBACK_TOP_PASSWORD,     // One of the 100 most common passwords
+    STRENGTH_FEEDBACK_COMMON_PASSWORD,  // In the password list
+    STRENGTH_FEEDBACK_WORD,             // A word, possibly l33t or reversed
+    STRENGTH_FEEDBACK_NAME,             // A first name or surname
+    STRENGTH_FEEDBACK_USER_INPUT,       // Contains the user name
+    STRENGTH_FEEDBACK_SPATIAL,          // A keyboard walk such as qwerty
+    STRENGTH_FEEDBACK_REPEAT,           // Repeated characters or chunks
+    STRENGTH_FEEDBACK_SEQUENCE,         // abc, 9753
+    STRENGTH_FEEDBACK_YEAR,             // A recent year
+    STRENGTH_FEEDBACK_DATE              // A date
+};
+
+struct StrengthEstimate {
+    double log10Guesses;
+    int score;                          // 0 (< 10^3 guesses) to 4 (>= 10^10)
+    StrengthFeedback feedback;          // NONE when score > 2
+};
+
+/**
+ * Estimates how many guesses a password takes
+ * Dictionaries come from strength_dict.h; without them only the other
+ * patterns are matched
+ *
+ * @param password   UTF-8 as typed (letters are compared ASCII-lowercased)
+ * @param context    Text the user entered elsewhere, e.g. their user name,
+ *                   matched like a top-ranked dictionary (NULL = none)
+ * @return false only if no scratch memory could be obtained
+ */
+bool strength_estimate(const unsigned char *password, size_t len, const unsigned char *context,
+                       size_t contextLen, StrengthEstimate *out);
+
+/**
+ * Frees the scratch kept between estimates (memory pressure)
+ * @return Bytes of locked regions handed back to locked_free()
+ */
+size_t strength_trim();
+
+#endif // FUZZME_V3_STRENGTH_ESTIMATE_H
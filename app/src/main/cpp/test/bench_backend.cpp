@@ -0,0 +1,117 @@
+#include <initializer_list>
+#include <sys/resource.h>
+#include <utility>
+#include <vector>
+
+#include "host_test.h"
+#include "secure_backend.h"
+#include "secure_util.h"
+
+// ========== SECURE MEMORY BACKENDS ==========
+// Every backend the kernel supports, forced in turn with backend_select():
+// map + unmap latency by size, the cost of touching each page once after the
+// map (MAP_LOCKED has already faulted everything in, memfd_secret faults on
+// first touch) and dependent random reads, one per page, over up to 64 MiB, which
+// is where TLB reach shows (memfd_secret pages are 4 KiB and outside the
+// direct map; map_locked asks for huge pages from 2 MiB). Sizes stay within
+// RLIMIT_MEMLOCK so that every mapping is locked by the backend under test.
+
+static const size_t SIZES[] = {4096, 64 * 1024, 1024 * 1024, 4 * 1024 * 1024};
+static const size_t TLB_MAX_BYTES = 64 * 1024 * 1024;
+static const size_t HUGE_PAGE = 2 * 1024 * 1024;
+static const int TLB_LOADS = 2000000;
+
+static size_t g_tlbBytes;
+
+static void map_and_touch(SecureBackendKind want, size_t size) {
+    const size_t ps = page_size();
+    const int reps = size >= (1u << 20) ? 20 : 200;
+    uint64_t mapNs = 0, touchNs = 0, unmapNs = 0;
+    int off = 0, unlocked = 0;
+    for (int r = 0; r < reps; r++) {
+        bool locked = false;
+        SecureBackendKind kind;
+        uint64_t t0 = host_now_ns();
+        void *mem = backend_map(size, LOCK_PRIO_CRITICAL, &locked, &kind);
+        uint64_t t1 = host_now_ns();
+        if (!mem) {
+            printf("  %9zu B: backend_map failed\n", size);
+            return;
+        }
+        volatile unsigned char *p = (volatile unsigned char *) mem;
+        for (size_t i = 0; i < size; i += ps) p[i] = 1;
+        uint64_t t2 = host_now_ns();
+        backend_unmap(mem, size, locked, kind);
+        uint64_t t3 = host_now_ns();
+        mapNs += t1 - t0;
+        touchNs += t2 - t1;
+        unmapNs += t3 - t2;
+        off += kind != want;
+        unlocked += !locked;
+    }
+    printf("  %9zu B: map %9.1f us  first touch %9.1f us (%6.0f ns/page)  unmap %8.1f us",
+           size, (double) mapNs / reps / 1e3, (double) touchNs / reps / 1e3,
+           (double) touchNs / reps / (double) (size / ps), (double) unmapNs / reps / 1e3);
+    if (off) printf("  [%d fell back]", off);
+    if (unlocked) printf("  [%d unlocked]", unlocked);
+    printf("\n");
+}
+
+static void random_reads(SecureBackendKind want) {
+    const size_t ps = page_size();
+    bool locked = false;
+    SecureBackendKind kind;
+    void *mem = backend_map(g_tlbBytes, LOCK_PRIO_CRITICAL, &locked, &kind);
+    if (!mem) {
+        printf("  dependent random reads: backend_map of %zu MiB failed\n", g_tlbBytes >> 20);
+        return;
+    }
+    // One random cycle through every page: each visited page holds the
+    // offset of the next one, so every load waits for the previous one and
+    // pays its TLB miss in full. The line within each page varies
+    unsigned char *base = (unsigned char *) mem;
+    const size_t pages = g_tlbBytes / ps;
+    std::vector<size_t> order(pages);
+    for (size_t i = 0; i < pages; i++) order[i] = i;
+    unsigned seed = 11;
+    for (size_t i = pages - 1; i > 0; i--) std::swap(order[i], order[(size_t) rand_r(&seed) % (i + 1)]);
+    for (size_t i = 0; i < pages; i++) {
+        size_t at = order[i] * ps + (order[i] % 63) * 64;
+        size_t next = order[(i + 1) % pages];
+        *(size_t *) (base + at) = next * ps + (next % 63) * 64;
+    }
+
+    size_t at = order[0] * ps + (order[0] % 63) * 64;
+    uint64_t start = host_now_ns();
+    for (int i = 0; i < TLB_LOADS; i++) at = *(volatile size_t *) (base + at);
+    double ns = (double) (host_now_ns() - start) / TLB_LOADS;
+    printf("  dependent random reads over %zu MiB: %.1f ns/load%s%s\n", g_tlbBytes >> 20, ns,
+           kind != want ? " [fell back]" : "", locked ? "" : " [unlocked]");
+    backend_unmap(mem, g_tlbBytes, locked, kind);
+}
+
+int main() {
+    // Room to lock everything, if the hard limit allows
+    struct rlimit rl = {RLIM_INFINITY, RLIM_INFINITY};
+    setrlimit(RLIMIT_MEMLOCK, &rl);
+    getrlimit(RLIMIT_MEMLOCK, &rl);
+    g_tlbBytes = TLB_MAX_BYTES;
+    if (rl.rlim_cur != RLIM_INFINITY && rl.rlim_cur / 4 * 3 < g_tlbBytes) {
+        g_tlbBytes = rl.rlim_cur / 4 * 3 / HUGE_PAGE * HUGE_PAGE;
+        printf("RLIMIT_MEMLOCK is %llu KiB: random reads over %zu MiB\n",
+               (unsigned long long) rl.rlim_cur >> 10, g_tlbBytes >> 20);
+    }
+
+    printf("selected by probe: %s\n", backend_name(backend_selected()));
+    for (int k = 0; k < BACKEND_COUNT; k++) {
+        SecureBackendKind kind = (SecureBackendKind) k;
+        if (!backend_select(kind)) {
+            printf("%s: not supported here, skipped\n", backend_name(kind));
+            continue;
+        }
+        printf("%s:\n", backend_name(kind));
+        for (size_t size : SIZES) map_and_touch(kind, size);
+        random_reads(kind);
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include <random>
+
+#include "breach_filter.h"
+#include "host_test.h"
+
+// ========== BREACH FILTER ==========
+// Membership, false positive rate and lookup latency of a filter built by
+// tools/build_breach_filter from the SHA-1s of "pw0" .. "pw<members-1>":
+//
+//   bench_breach_filter <filter> <members> [probes]
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <filter> <members> [probes]\n", argv[0]);
+        return 2;
+    }
+    long long keys = breach_filter_open(argv[1]);
+    unsigned long long members = strtoull(argv[2], NULL, 10);
+    unsigned long long probes = argc > 3 ? strtoull(argv[3], NULL, 10) : 1000000;
+    if (keys <= 0 || members == 0) {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+    printf("open: %lld keys\n", keys);
+
+    std::mt19937_64 rng(7);
+    unsigned long long missed = 0, falsePositives = 0;
+    char password[32];
+    for (unsigned long long i = 0; i < probes; i++) {
+        int len = snprintf(password, sizeof(password), "pw%llu", rng() % members);
+        missed += breach_filter_contains(password, (size_t) len) != 1;
+        len = snprintf(password, sizeof(password), "nope%llu", i);
+        falsePositives += breach_filter_contains(password, (size_t) len) == 1;
+    }
+    printf("members missed %llu/%llu, false positives %llu/%llu (%.6f%%)\n", missed, probes,
+           falsePositives, probes, 100.0 * (double) falsePositives / (double) probes);
+
+    std::vector<double> latency;
+    for (int i = 0; i < 200000; i++) {
+        int len = snprintf(password, sizeof(password), "%s%llu", i & 1 ? "pw" : "zz", rng() % members);
+        uint64_t start = host_now_ns();
+        volatile int hit = breach_filter_contains(password, (size_t) len);
+        (void) hit;
+        latency.push_back((double) (host_now_ns() - start));
+    }
+    printf("lookup: p50 %.0f ns p99 %.0f ns max %.0f ns\n", host_percentile(latency, .5),
+           host_percentile(latency, .99), host_percentile(latency, 1));
+    breach_filter_close();
+    return 0;
+}
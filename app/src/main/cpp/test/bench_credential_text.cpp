@@ -0,0 +1,87 @@
+#include <initializer_list>
+#include <vector>
+
+#include "credential_text.h"
+#include "host_test.h"
+
+// ========== CREDENTIAL TEXT ==========
+// Throughput of credential_to_utf8() and of the bare utf16_to_utf8()
+// transcoder by input length, on three kinds of text:
+// - ascii:      passes the NFKC quick check 8 units at a time, then goes
+//               straight to the transcoder;
+// - nfkc:       Cyrillic, Greek and CJK that is already normalized, so the
+//               quick check passes but runs unit by unit;
+// - normalize:  combining marks, fullwidth forms, ligatures, jamo and
+//               surrogate pairs, which take the decompose / reorder /
+//               compose path through the scratch.
+
+static const uint16_t ASCII[] = {'a', 'd', 'm', 'i', 'n', '1', '2', '3', 'P', '@', 's', 'S',
+                                 'w', '0', 'r', 'd', '-', '_', '.', 'x'};
+static const uint16_t NFKC[] = {0x0430, 0x0431, 0x0436, 0x044F, 0x03B1, 0x03B2, 0x03C9,
+                                0x4E2D, 0x6587, 0x5B57, 'a', '1'};
+static const uint16_t MIXED[] = {'a', 0x0301, 'e', 0x0308, 0xFF41, 0xFF11, 0xFB01, 0x1100,
+                                 0x1161, 0x11A8, 0x212B, 0x304B, 0x3099, 0xD83D, 0xDE00, 'x'};
+
+static std::vector<uint16_t> make_text(const uint16_t *alphabet, size_t count, size_t len) {
+    std::vector<uint16_t> text;
+    unsigned seed = 7;
+    while (text.size() < len) {
+        uint16_t u = alphabet[rand_r(&seed) % count];
+        if (u == 0xDE00) continue;  // Only as the second half of a pair
+        if (u == 0xD83D) {
+            if (text.size() + 2 > len) continue;
+            text.push_back(u);
+            u = 0xDE00;
+        }
+        text.push_back(u);
+    }
+    return text;
+}
+
+/**
+ * Runs one conversion until 100 ms have passed
+ * @return ns per call
+ */
+static double time_calls(bool normalize, const std::vector<uint16_t> &text,
+                         std::vector<unsigned char> &utf8, std::vector<uint32_t> &scratch) {
+    uint64_t calls = 0;
+    uint64_t start = host_now_ns(), elapsed;
+    do {
+        for (int i = 0; i < 64; i++) {
+            long n = normalize
+                     ? credential_to_utf8(text.data(), text.size(), utf8.data(), utf8.size(),
+                                          scratch.data(), scratch.size())
+                     : utf16_to_utf8(text.data(), text.size(), utf8.data(), utf8.size());
+            if (n < 0) return -1;
+        }
+        calls += 64;
+        elapsed = host_now_ns() - start;
+    } while (elapsed < 100000000ull);
+    return (double) elapsed / (double) calls;
+}
+
+int main() {
+    struct {
+        const char *name;
+        const uint16_t *alphabet;
+        size_t count;
+    } kinds[] = {
+            {"ascii", ASCII, sizeof(ASCII) / sizeof(ASCII[0])},
+            {"nfkc", NFKC, sizeof(NFKC) / sizeof(NFKC[0])},
+            {"normalize", MIXED, sizeof(MIXED) / sizeof(MIXED[0])},
+    };
+    printf("%-10s %6s  %24s  %24s\n", "input", "units", "credential_to_utf8", "utf16_to_utf8");
+    for (auto &kind : kinds) {
+        for (size_t len : {16, 64, 1024, 16384}) {
+            std::vector<uint16_t> text = make_text(kind.alphabet, kind.count, len);
+            std::vector<unsigned char> utf8(credential_utf8_capacity(len));
+            std::vector<uint32_t> scratch(credential_scratch_capacity(len));
+            double full = time_calls(true, text, utf8, scratch);
+            double plain = time_calls(false, text, utf8, scratch);
+            // MB/s of UTF-16 input
+            printf("%-10s %6zu  %9.0f ns %8.0f MB/s  %9.0f ns %8.0f MB/s\n", kind.name, len,
+                   full, (double) len * 2 * 1e3 / full, plain, (double) len * 2 * 1e3 / plain);
+        }
+    }
+    return 0;
+}
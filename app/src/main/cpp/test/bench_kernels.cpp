@@ -0,0 +1,69 @@
+#include <cstring>
+#include <initializer_list>
+
+#include "cpu_dispatch.h"
+#include "hkdf.h"
+#include "hmac.h"
+#include "host_test.h"
+#include "sha256.h"
+
+// ========== KERNELS ==========
+// The built-in variant table (what cpu_dispatch_bench() reports to the
+// app), then SHA-256, HMAC and HKDF per sha256 variant, and the 8-way
+// batches per sha256x8 variant. Agreement between variants is checked by
+// test_kernels and test_hash_vectors.
+
+// Runs fn for ~300 ms; MB/s for bytes per call
+template <class F>
+static double mb_per_second(size_t bytes, F fn) {
+    uint64_t start = host_now_ns(), calls = 0;
+    while (host_now_ns() - start < 300000000ull) {
+        fn();
+        calls++;
+    }
+    return (double) (bytes * calls) * 1e3 / (double) (host_now_ns() - start);
+}
+
+static bool usable(const KernelVariant *table, size_t count, const char *name) {
+    for (size_t i = 0; i < count; i++)
+        if (!strcmp(table[i].name, name)) return (table[i].features & ~cpu_features()) == 0;
+    return false;
+}
+
+int main() {
+    static char table[4096];
+    cpu_dispatch_bench(table, sizeof(table), 200);
+    fputs(table, stdout);
+
+    std::vector<unsigned char> buf(1 << 20, 7);
+    unsigned char out[32 * 64];
+    HmacKey key;
+    hmac_key_init(&key, HMAC_SHA256, "key", 3);
+
+    cpu_dispatch_select("sha256x8", "serial");
+    for (size_t v = 0; v < SHA256_KERNEL_COUNT; v++) {
+        const char *name = SHA256_KERNELS[v].name;
+        if (!usable(SHA256_KERNELS, SHA256_KERNEL_COUNT, name)) continue;
+        cpu_dispatch_select("sha256", name);
+        double hkdfRate = mb_per_second(1, [&] { hkdf(HMAC_SHA256, "s", 1, "ikm", 3, "info", 4, out, 32); });
+        printf("sha256=%-9s sha256 64 B %7.0f MB/s, 1 MiB %7.0f MB/s | hmac 64 B %7.0f MB/s, "
+               "1 MiB %7.0f MB/s | hkdf 32 B %6.0f k/s\n", name,
+               mb_per_second(64, [&] { sha256(out, buf.data(), 64); }),
+               mb_per_second(1 << 20, [&] { sha256(out, buf.data(), 1 << 20); }),
+               mb_per_second(64, [&] { hmac(&key, buf.data(), 64, out); }),
+               mb_per_second(1 << 20, [&] { hmac(&key, buf.data(), 1 << 20, out); }),
+               hkdfRate * 1e3);
+    }
+    cpu_dispatch_select("sha256", "auto");
+
+    for (size_t v = 0; v < SHA256_MULTI_KERNEL_COUNT; v++) {
+        const char *name = SHA256_MULTI_KERNELS[v].name;
+        if (!usable(SHA256_MULTI_KERNELS, SHA256_MULTI_KERNEL_COUNT, name)) continue;
+        cpu_dispatch_select("sha256x8", name);
+        printf("sha256x8=%-7s sha256_batch 64 x 64 B %7.0f MB/s | hmac_short_batch 64 x 8 B %6.2f M MACs/s\n",
+               name, mb_per_second(64 * 64, [&] { sha256_batch(buf.data(), 64, 64, out); }),
+               mb_per_second(64, [&] { hmac_short_batch(&key, buf.data(), 8, 64, out); }));
+    }
+    cpu_dispatch_select("sha256x8", "auto");
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include <unistd.h>
+
+#include "host_test.h"
+#include "keystroke_stream.h"
+
+// ========== KEYSTROKE STREAMS ==========
+// Cost of one keystroke on the UI thread, keystroke-to-applied latency with
+// typing-like gaps (the absorber parks between edits), and burst throughput.
+// Correctness lives in test_keystroke_stream.
+
+int main() {
+    uint64_t stream = keystroke_open();
+    if (!stream) {
+        fprintf(stderr, "keystroke_open failed\n");
+        return 1;
+    }
+
+    std::vector<double> push, applied;
+    for (int i = 0; i < 2000; i++) {
+        if (i % 200 == 0) keystroke_clear(stream);
+        usleep(2000);
+        uint64_t start = host_now_ns();
+        keystroke_append(stream, (uint16_t) ('a' + i % 26));
+        uint64_t pushed = host_now_ns();
+        keystroke_sync();
+        push.push_back((double) (pushed - start));
+        applied.push_back((double) (host_now_ns() - start));
+    }
+    printf("append: p50 %.0f p99 %.0f ns\n", host_percentile(push, .5), host_percentile(push, .99));
+    printf("append->applied: p50 %.0f p99 %.0f max %.0f ns\n", host_percentile(applied, .5),
+           host_percentile(applied, .99), host_percentile(applied, 1));
+
+    const int edits = 200000;
+    keystroke_clear(stream);
+    keystroke_sync();
+    uint64_t start = host_now_ns();
+    for (int i = 0; i < edits; i++) {
+        if (i % 250 == 249) keystroke_clear(stream);
+        else keystroke_append(stream, (uint16_t) ('a' + i % 26));
+    }
+    keystroke_sync();
+    printf("burst: %.1f ns/edit\n", (double) (host_now_ns() - start) / edits);
+    keystroke_close(stream);
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+#include "host_test.h"
+#include "lazy_region.h"
+#include "lock_budget.h"
+#include "secure_util.h"
+
+// ========== LAZY REGIONS ==========
+// Creation, a first sequential pass and random reads after everything was
+// dropped, against what the eager fallback does (one locked copy of the
+// whole blob), by blob size.
+
+static const int RANDOM_READS = 10000;
+
+static double ms_since(uint64_t start) {
+    return (double) (host_now_ns() - start) / 1e6;
+}
+
+static double sequential_pass(const unsigned char *data, size_t len) {
+    const size_t ps = page_size();
+    volatile unsigned char sink = 0;
+    uint64_t start = host_now_ns();
+    for (size_t i = 0; i < len; i += ps) sink = sink + data[i];
+    return ms_since(start);
+}
+
+static double random_reads(const unsigned char *data, size_t len) {
+    volatile unsigned char sink = 0;
+    unsigned seed = 5;
+    uint64_t start = host_now_ns();
+    for (int i = 0; i < RANDOM_READS; i++) sink = sink + data[(size_t) rand_r(&seed) % len];
+    return ms_since(start);
+}
+
+int main() {
+    for (size_t size : {1u << 20, 8u << 20, 64u << 20}) {
+        std::vector<unsigned char> blob(size, 0x5a);
+
+        uint64_t start = host_now_ns();
+        LazyRegion *region = lazy_region_create(blob.data(), size, 0);
+        double create = ms_since(start);
+        if (!region) {
+            printf("%6zu MiB: lazy_region_create failed\n", size >> 20);
+            continue;
+        }
+        if (!lazy_region_is_lazy(region)) printf("(userfaultfd unavailable: eager fallback)\n");
+        const unsigned char *data = (const unsigned char *) lazy_region_data(region);
+        double firstPass = sequential_pass(data, size);
+        double warm = random_reads(data, size);
+        lazy_region_drop_all(region);
+        double cold = random_reads(data, size);
+        printf("%6zu MiB lazy:  create %7.2f ms  first pass %7.2f ms  "
+               "%d random reads resident %6.2f ms, after a drop %7.2f ms\n",
+               size >> 20, create, firstPass, RANDOM_READS, warm, cold);
+        lazy_region_destroy(region);
+
+        LockedRegion eager;
+        start = host_now_ns();
+        if (!locked_alloc(&eager, size, LOCK_PRIO_BULK)) continue;
+        memcpy(eager.ptr, blob.data(), size);
+        create = ms_since(start);
+        firstPass = sequential_pass((const unsigned char *) eager.ptr, size);
+        warm = random_reads((const unsigned char *) eager.ptr, size);
+        printf("%6zu MiB eager: create %7.2f ms  first pass %7.2f ms  "
+               "%d random reads %6.2f ms\n", size >> 20, create, firstPass, RANDOM_READS, warm);
+        locked_free(&eager);
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <cstring>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "host_test.h"
+#include "lock_budget.h"
+
+// ========== SMALL LOCKED ALLOCATIONS ==========
+// Alloc + free of random 16-256 B secrets in batches of 32 through
+// locked_alloc() (slab) against malloc + mlock, at 1, 4 and 16 threads.
+
+static const int ITERS = 20000;
+static const int BATCH = 32;
+static bool g_malloc = false;
+
+static void *run(void *) {
+    unsigned seed = (unsigned) (uintptr_t) &seed;
+    LockedRegion regions[BATCH];
+    void *blocks[BATCH];
+    size_t sizes[BATCH];
+    for (int it = 0; it < ITERS / BATCH; it++) {
+        for (int i = 0; i < BATCH; i++) {
+            sizes[i] = 16 + rand_r(&seed) % 241;
+            if (g_malloc) {
+                blocks[i] = malloc(sizes[i]);
+                mlock(blocks[i], sizes[i]);
+                memset(blocks[i], 1, sizes[i]);
+            } else {
+                locked_alloc(&regions[i], sizes[i], LOCK_PRIO_NORMAL);
+                memset(regions[i].ptr, 1, sizes[i]);
+            }
+        }
+        for (int i = 0; i < BATCH; i++) {
+            if (g_malloc) {
+                memset(blocks[i], 0, sizes[i]);
+                munlock(blocks[i], sizes[i]);
+                free(blocks[i]);
+            } else {
+                locked_free(&regions[i]);
+            }
+        }
+    }
+    return NULL;
+}
+
+int main() {
+    for (int mode = 0; mode < 2; mode++) {
+        g_malloc = mode == 1;
+        for (int threads : {1, 4, 16}) {
+            pthread_t th[16];
+            uint64_t start = host_now_ns();
+            for (int i = 0; i < threads; i++) pthread_create(&th[i], NULL, run, NULL);
+            for (int i = 0; i < threads; i++) pthread_join(th[i], NULL);
+            double ns = (double) (host_now_ns() - start);
+            double ops = 2.0 * threads * (ITERS / BATCH * BATCH);
+            printf("%-14s threads=%2d  %6.0f ns/op\n", g_malloc ? "malloc+mlock" : "locked_alloc",
+                   threads, ns / ops);
+        }
+    }
+    return 0;
+}
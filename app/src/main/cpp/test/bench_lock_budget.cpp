@@ -0,0 +1,73 @@
+#include <cstring>
+#include <sys/resource.h>
+
+#include "host_test.h"
+#include "lock_budget.h"
+
+// ========== DEGRADED LOCKING ==========
+// Alloc + free throughput of locked_alloc() under the RLIMIT_MEMLOCK the
+// bench was started with (raise it to lock everything), a 64 KiB limit (a few locks, the rest denied) and under a
+// zero limit (every request denied, unlocked). Correctness of the degraded
+// mode lives in test_lock_budget; this shows what it costs the caller.
+
+static const int ITERS = 20000;
+static const int BATCH = 16;
+
+static const size_t SIZES[] = {32, 8192, 256 * 1024};
+static rlim_t g_limit;
+static bool g_keepLimit;
+
+static void run_limit() {
+    struct rlimit rl = {g_limit, g_limit};
+    if (!g_keepLimit && setrlimit(RLIMIT_MEMLOCK, &rl) != 0) _exit(77);
+    uint64_t denied = 0;
+    for (size_t size : SIZES) {
+        int iters = size > 8192 ? ITERS / 20 : ITERS;
+        LockedRegion regions[BATCH];
+        uint64_t locked = 0;
+        uint64_t start = host_now_ns();
+        for (int it = 0; it < iters / BATCH; it++) {
+            for (int i = 0; i < BATCH; i++) {
+                locked_alloc(&regions[i], size, LOCK_PRIO_NORMAL);
+                memset(regions[i].ptr, 1, size);
+                locked += regions[i].locked;
+            }
+            for (int i = 0; i < BATCH; i++) locked_free(&regions[i]);
+        }
+        double ns = (double) (host_now_ns() - start);
+        double ops = (double) (iters / BATCH * BATCH);
+        LockBudgetInfo info;
+        lock_budget_info(&info);
+        printf("  %7zu B  %8.0f ns per alloc+free  %5.1f%% locked  %llu denials\n", size,
+               ns / ops, 100.0 * (double) locked / ops,
+               (unsigned long long) (info.deniedRequests - denied));
+        denied = info.deniedRequests;
+    }
+    fflush(stdout);
+}
+
+int main() {
+    struct rlimit current;
+    getrlimit(RLIMIT_MEMLOCK, &current);
+    struct {
+        const char *name;
+        bool keep;
+        rlim_t limit;
+    } limits[] = {
+            {"current limit", true, current.rlim_cur},
+            {"64 KiB limit", false, 64 * 1024},
+            {"zero limit", false, 0},
+    };
+    for (auto &l : limits) {
+        g_limit = l.limit;
+        g_keepLimit = l.keep;
+        if (l.keep && l.limit == RLIM_INFINITY) printf("%s (unlimited):\n", l.name);
+        else if (l.keep) printf("%s (%llu KiB):\n", l.name, (unsigned long long) l.limit >> 10);
+        else printf("%s:\n", l.name);
+        int code = 0;
+        int sig = host_run_child(run_limit, &code);
+        if (code == 77) printf("  cannot set RLIMIT_MEMLOCK, skipped\n");
+        else if (sig || code) printf("  failed (signal %d, exit %d)\n", sig, code);
+    }
+    return 0;
+}
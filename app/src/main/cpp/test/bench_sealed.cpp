@@ -0,0 +1,62 @@
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+#include <vector>
+
+#include "host_test.h"
+#include "sealed_memory.h"
+#include "secret_shares.h"
+
+// ========== SEALED SECRETS AND SHARES ==========
+// Unseal + reseal by size, share recombination, and the CPU the share
+// refresh thread takes under a full and a 10% budget.
+
+static double process_cpu_percent(uint32_t seconds) {
+    clock_t start = clock();
+    sleep(seconds);
+    return (double) (clock() - start) / CLOCKS_PER_SEC / seconds * 100;
+}
+
+int main() {
+    for (size_t size = 32; size <= 65536; size *= 4) {
+        std::vector<unsigned char> plain(size, 7);
+        SealedSecret secret;
+        if (!sealed_seal(&secret, plain.data(), size)) return 1;
+        int reps = (int) (20000000 / size) + 10;
+        uint64_t start = host_now_ns();
+        for (int r = 0; r < reps; r++) {
+            SealedSlot *slot;
+            sealed_unseal(&secret, &slot);
+            sealed_reseal(slot);
+        }
+        double ns = (double) (host_now_ns() - start) / reps;
+        printf("unseal+reseal %6zu B: %8.0f ns (%.2f GB/s)\n", size, ns, size / ns);
+        sealed_free(&secret);
+    }
+
+    std::vector<unsigned char> big(64 << 20), out(64 << 20);
+    for (size_t i = 0; i < big.size(); i++) big[i] = (unsigned char) (i * 37 + 1);
+    SharedSecret *bigShares = shares_create(big.data(), big.size());
+    SharedSecret *small = shares_create("admin", 5);
+    if (!bigShares || !small) return 1;
+
+    char word[16];
+    const int reps = 1000000;
+    uint64_t start = host_now_ns();
+    for (int r = 0; r < reps; r++) shares_combine(small, word, sizeof(word));
+    printf("combine 5 B: %.1f ns\n", (double) (host_now_ns() - start) / reps);
+    start = host_now_ns();
+    shares_combine(bigShares, out.data(), out.size());
+    printf("combine 64 MiB: %.2f GB/s\n", big.size() / (double) (host_now_ns() - start));
+
+    shares_set_refresh(10, 1000);
+    printf("refresh CPU, no budget: %.1f%%\n", process_cpu_percent(2));
+    shares_set_refresh(10, 100);
+    printf("refresh CPU, 10%% budget: %.1f%%\n", process_cpu_percent(2));
+
+    shares_combine(bigShares, out.data(), out.size());
+    printf("64 MiB intact after refresh: %s\n", memcmp(out.data(), big.data(), big.size()) ? "NO" : "yes");
+    shares_destroy(bigShares);
+    shares_destroy(small);
+    return 0;
+}
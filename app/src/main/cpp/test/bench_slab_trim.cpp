@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <vector>
+
+#include "host_test.h"
+#include "lock_budget.h"
+#include "secure_slab.h"
+
+// ========== SLAB TRIM ==========
+// Fragmentation left by freeing part of 20k random 16-256 B secrets, and
+// what slab_trim() gives back: locked bytes before and after, the share of
+// them still holding live data, and the time the trim takes. Slots never
+// move, so a slab with one live slot stays; the free patterns show how much
+// that costs.
+
+static const int COUNT = 20000;
+
+struct Pattern {
+    const char *name;
+    int freePercent;
+    bool random;   // Random victims, or the oldest allocations first
+};
+
+static uint64_t locked_bytes() {
+    LockBudgetInfo info;
+    lock_budget_info(&info);
+    return info.lockedBytes;
+}
+
+int main() {
+    const Pattern patterns[] = {
+            {"90% random", 90, true},
+            {"50% random", 50, true},
+            {"90% oldest", 90, false},
+            {"100%", 100, false},
+    };
+    printf("%-11s %12s %12s %12s %10s %10s\n", "freed", "live KiB", "before KiB", "after KiB",
+           "live/after", "trim ms");
+    for (const Pattern &p : patterns) {
+        slab_trim();
+        uint64_t base = locked_bytes();
+
+        std::vector<LockedRegion> regions(COUNT);
+        unsigned seed = 42;
+        for (LockedRegion &r : regions) locked_alloc(&r, 16 + rand_r(&seed) % 241, LOCK_PRIO_NORMAL);
+
+        std::vector<int> order(COUNT);
+        for (int i = 0; i < COUNT; i++) order[i] = i;
+        if (p.random) {
+            for (int i = COUNT - 1; i > 0; i--) std::swap(order[i], order[rand_r(&seed) % (i + 1)]);
+        }
+        int freed = COUNT * p.freePercent / 100;
+        for (int i = 0; i < freed; i++) locked_free(&regions[order[i]]);
+        uint64_t live = 0;
+        for (int i = freed; i < COUNT; i++) live += regions[order[i]].len;
+
+        uint64_t before = locked_bytes() - base;
+        uint64_t start = host_now_ns();
+        slab_trim();
+        double ms = (double) (host_now_ns() - start) / 1e6;
+        uint64_t after = locked_bytes() - base;
+
+        printf("%-11s %12.1f %12.1f %12.1f %9.1f%% %10.2f\n", p.name, (double) live / 1024,
+               (double) before / 1024, (double) after / 1024,
+               after ? 100.0 * (double) live / (double) after : 0.0, ms);
+        for (int i = freed; i < COUNT; i++) locked_free(&regions[order[i]]);
+    }
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include <jni.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "host_test.h"
+
+// ========== SPECULATIVE CHECKS ==========
+// Replays typing traces for a password field with and without
+// speculateKeystrokes() on a 400 ms idle timer, and reports
+// press-to-result latency.
+//
+//   bench_speculation [trials]        synthetic traces (default 20, ~2 s each)
+//   bench_speculation <trace file>    recorded traces
+//
+// Synthetic traces (log-normal key gaps, hesitations, corrected typos,
+// then a 200-1500 ms pause before the button press) only show that the
+// mechanism works; whether 400 ms suits real typing takes recorded ones.
+// A trace file holds one trace per line, '#' starts a comment:
+//
+//   k180 k240 k150 b410 k300 k170 p950
+//
+// kN types a key N ms after the previous event, bN erases one and pN
+// presses the button (ends the trace). Only the timing is replayed: keys
+// are typed as placeholders, so the check fails and ok stays 0.
+
+extern "C" {
+jlong Java_com_example_fuzzme_1v3_NativeBridge_openKeystrokeStream(JNIEnv *, jclass);
+jboolean Java_com_example_fuzzme_1v3_NativeBridge_appendKeystroke(JNIEnv *, jclass, jlong, jchar);
+jboolean Java_com_example_fuzzme_1v3_NativeBridge_deleteKeystrokes(JNIEnv *, jclass, jlong, jint);
+jboolean Java_com_example_fuzzme_1v3_NativeBridge_clearKeystrokes(JNIEnv *, jclass, jlong);
+jboolean Java_com_example_fuzzme_1v3_NativeBridge_checkStreamedCredentials(JNIEnv *, jclass, jlong, jlong);
+jboolean Java_com_example_fuzzme_1v3_NativeBridge_speculateKeystrokes(JNIEnv *, jclass, jlong);
+}
+#define JNI_FN(name) Java_com_example_fuzzme_1v3_NativeBridge_##name
+
+static const double IDLE_MS = 400;
+
+struct TraceEvent {
+    double gapMs;
+    bool erase;
+    char c;
+};
+
+struct Trace {
+    std::vector<TraceEvent> events;
+    double pressMs;
+};
+
+static std::vector<Trace> synthetic_traces(int trials) {
+    std::mt19937 rng(45);
+    std::lognormal_distribution<double> key(std::log(170.0), 0.45);
+    std::uniform_real_distribution<double> unit(0, 1);
+    std::vector<Trace> traces;
+    for (int t = 0; t < trials; t++) {
+        Trace trace;
+        for (const char *c = "admin"; *c; c++) {
+            double gap = key(rng);
+            if (unit(rng) < 0.1) gap += 400 + 800 * unit(rng);
+            if (unit(rng) < 0.08) {
+                trace.events.push_back({gap, false, 'x'});
+                trace.events.push_back({250 + 250 * unit(rng), true, 0});
+                gap = key(rng);
+            }
+            trace.events.push_back({gap, false, *c});
+        }
+        trace.pressMs = std::exp(std::log(200.0) + unit(rng) * std::log(1500.0 / 200.0));
+        traces.push_back(trace);
+    }
+    return traces;
+}
+
+// Reads a trace file (format above); false on a malformed line
+static bool read_traces(const char *path, std::vector<Trace> *traces) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "cannot read %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    char line[4096];
+    int lineNo = 0;
+    bool good = true;
+    while (good && fgets(line, sizeof(line), f)) {
+        lineNo++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = 0;
+        Trace trace = {{}, -1};
+        for (char *tok = strtok(line, " \t\r\n"); tok; tok = strtok(NULL, " \t\r\n")) {
+            char *end;
+            double ms = strtod(tok + 1, &end);
+            if (*end || end == tok + 1 || ms < 0 || trace.pressMs >= 0 ||
+                (tok[0] != 'k' && tok[0] != 'b' && tok[0] != 'p')) {
+                good = false;
+                break;
+            }
+            if (tok[0] == 'p') trace.pressMs = ms;
+            else trace.events.push_back({ms, tok[0] == 'b', 'a'});
+        }
+        if (!good || (trace.events.empty() && trace.pressMs < 0)) continue;
+        if (trace.pressMs < 0) good = false;
+        else traces->push_back(trace);
+    }
+    fclose(f);
+    if (!good) fprintf(stderr, "%s:%d: expected kN/bN events ending in pN\n", path, lineNo);
+    else if (traces->empty()) fprintf(stderr, "%s: no traces\n", path);
+    return good && !traces->empty();
+}
+
+static void sleep_ms(double ms) {
+    usleep((useconds_t) (ms * 1000));
+}
+
+// Sleeps through a gap before an edit, firing the idle timer if it is long
+static bool idle_gap(jlong pass, double gapMs, bool speculate) {
+    if (!speculate || gapMs <= IDLE_MS) {
+        sleep_ms(gapMs);
+        return false;
+    }
+    sleep_ms(IDLE_MS);
+    JNI_FN(speculateKeystrokes)(NULL, NULL, pass);
+    sleep_ms(gapMs - IDLE_MS);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 && !isdigit((unsigned char) argv[1][0]) ? argv[1] : NULL;
+    std::vector<Trace> traces;
+    if (!path) {
+        traces = synthetic_traces(argc > 1 ? atoi(argv[1]) : 20);
+    } else if (!read_traces(path, &traces)) {
+        return 1;
+    }
+    if (path) {
+        printf("%zu traces from %s\n", traces.size(), path);
+    } else {
+        printf("%zu synthetic traces: they exercise the mechanism, they do not validate\n"
+               "the %.0f ms idle policy (pass a recorded trace file for that)\n",
+               traces.size(), IDLE_MS);
+    }
+
+    jlong user = JNI_FN(openKeystrokeStream)(NULL, NULL);
+    jlong pass = JNI_FN(openKeystrokeStream)(NULL, NULL);
+    for (const char *c = "admin"; *c; c++) JNI_FN(appendKeystroke)(NULL, NULL, user, (jchar) *c);
+    JNI_FN(checkStreamedCredentials)(NULL, NULL, user, pass);
+
+    for (int speculate = 0; speculate < 2; speculate++) {
+        std::vector<double> latency;
+        int ok = 0, speculated = 0;
+        for (const Trace &trace : traces) {
+            JNI_FN(clearKeystrokes)(NULL, NULL, pass);
+            for (size_t i = 0; i < trace.events.size(); i++) {
+                const TraceEvent &e = trace.events[i];
+                idle_gap(pass, e.gapMs, speculate && i > 0);
+                if (e.erase) JNI_FN(deleteKeystrokes)(NULL, NULL, pass, 1);
+                else JNI_FN(appendKeystroke)(NULL, NULL, pass, (jchar) e.c);
+            }
+            speculated += idle_gap(pass, trace.pressMs, speculate);
+            uint64_t start = host_now_ns();
+            ok += JNI_FN(checkStreamedCredentials)(NULL, NULL, user, pass);
+            latency.push_back((double) (host_now_ns() - start) / 1e6);
+        }
+        printf("%-11s n=%zu ok=%d speculated=%d: press->result p50 %.1f ms p90 %.1f ms max %.1f ms\n",
+               speculate ? "speculation" : "baseline", traces.size(), ok, speculated,
+               host_percentile(latency, .5), host_percentile(latency, .9), host_percentile(latency, 1));
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <cstring>
+#include <initializer_list>
+#include <random>
+
+#include "host_test.h"
+#include "strength_dict.h"
+#include "strength_estimate.h"
+
+// ========== STRENGTH ESTIMATES ==========
+// strength_estimate() runs on every keystroke: per-keystroke latency over
+// typing sessions (every prefix of a few passwords), then by length and on
+// inputs that make the matchers do the most work.
+//
+//   bench_strength [dictionary]   (built by tools/build_strength_dict;
+//                                  without one only the other matchers run)
+
+static double estimate_ns(const char *password, size_t len, const char *context, StrengthEstimate *out) {
+    uint64_t start = host_now_ns();
+    strength_estimate((const unsigned char *) password, len, (const unsigned char *) context,
+                      context ? strlen(context) : 0, out);
+    return (double) (host_now_ns() - start);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strength_dict_open(argv[1]) < 0) {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    static const char *const typed[] = {
+            "password", "P@ssw0rd!2024", "correcthorsebatterystaple", "Tr0ub4dour&3",
+            "x7#Kq9!mZ2vB", "ilovejennifer1990", "qwertyuiop[]", "jsmith13/12/1998",
+            "1q2w3e4r5t6y7u8i"};
+    StrengthEstimate estimate;
+    std::vector<double> keystroke;
+    for (int rep = 0; rep < 200; rep++)
+        for (const char *password : typed)
+            for (size_t len = 1; len <= strlen(password); len++)
+                keystroke.push_back(estimate_ns(password, len, "jsmith@example.com", &estimate));
+    printf("keystrokes %zu: p50 %.1f us p90 %.1f us p99 %.1f us max %.1f us\n", keystroke.size(),
+           host_percentile(keystroke, .5) / 1e3, host_percentile(keystroke, .9) / 1e3,
+           host_percentile(keystroke, .99) / 1e3, host_percentile(keystroke, 1) / 1e3);
+
+    std::mt19937 rng(3);
+    for (size_t len : {8, 16, 32, 64}) {
+        std::vector<double> v;
+        char password[64];
+        for (int r = 0; r < 300; r++) {
+            for (size_t i = 0; i < len; i++) password[i] = (char) (33 + rng() % 94);
+            v.push_back(estimate_ns(password, len, NULL, &estimate));
+        }
+        printf("random, %2zu bytes: p50 %.1f us p99 %.1f us\n", len, host_percentile(v, .5) / 1e3,
+               host_percentile(v, .99) / 1e3);
+    }
+
+    static const char *const worst[] = {
+            "1111111111111111111111111111111111111111111111111111111111111111",
+            "p4$$w0rdp4$$w0rdp4$$w0rdp4$$w0rdp4$$w0rdp4$$w0rdp4$$w0rdp4$$w0rd",
+            "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghijkl",
+            "qwertyuiopasdfghjklzxcvbnmqwertyuiopasdfghjklzxcvbnmqwertyuiopas"};
+    for (const char *password : worst) {
+        std::vector<double> v;
+        for (int r = 0; r < 200; r++) v.push_back(estimate_ns(password, 64, NULL, &estimate));
+        printf("%.12s...: p50 %.1f us p99 %.1f us (score %d, 10^%.1f guesses)\n", password,
+               host_percentile(v, .5) / 1e3, host_percentile(v, .99) / 1e3, estimate.score,
+               estimate.log10Guesses);
+    }
+    strength_dict_close();
+    return 0;
+}
@@ -0,0 +1,264 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <initializer_list>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#include "host_test.h"
+#include "secret_registry.h"
+#include "secure_backend.h"
+#include "secure_util.h"
+#include "stack_scrub.h"
+
+#ifndef __NR_memfd_secret
+#define __NR_memfd_secret 447
+#endif
+
+// ========== WIPES ==========
+// Time per wipe for each variant by size (the secure_wipe() thresholds come
+// from this table), emergency registry wipes of 1-100 MB and stack scrubs.
+// Then, per backend, whole-page wipes by stores against mapping fresh zero
+// pages over the range the way that backend would (a new secret file,
+// MAP_LOCKED | MAP_POPULATE, mmap + mlock). The next touch of every page is
+// included, since the region stays in use. Remapping never won, which is
+// why secure_wipe() always stores. Last, what each variant leaves in the
+// cache: a hot working set re-read after a large wipe (time, and cache
+// misses where perf events are available) and the latency of the first
+// load of each wiped line, which tells whether the wipe evicted it.
+
+typedef void (*WipeFn)(void *, size_t);
+
+/**
+ * Replaces [ptr, ptr + len) of a backend_map() mapping with zero pages
+ */
+static bool remap_zero(void *ptr, size_t len, SecureBackendKind kind) {
+    const int prot = PROT_READ | PROT_WRITE;
+    void *mem = MAP_FAILED;
+    if (kind == BACKEND_MEMFD_SECRET) {
+        long fd = syscall(__NR_memfd_secret, O_CLOEXEC);
+        if (fd < 0) return false;
+        if (ftruncate((int) fd, (off_t) len) == 0) {
+            mem = mmap(ptr, len, prot, MAP_SHARED | MAP_FIXED, (int) fd, 0);
+        }
+        close((int) fd);
+    } else if (kind == BACKEND_MAP_LOCKED) {
+        mem = mmap(ptr, len, prot,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_LOCKED | MAP_POPULATE, -1, 0);
+    } else {
+        mem = mmap(ptr, len, prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+        if (mem != MAP_FAILED) mlock(mem, len);
+    }
+    return mem == ptr;
+}
+
+static void touch_pages(void *ptr, size_t len) {
+    volatile unsigned char *p = (volatile unsigned char *) ptr;
+    for (size_t i = 0; i < len; i += page_size()) p[i] = 0;
+}
+
+/**
+ * Counter of this thread's user-space hardware cache misses
+ * @return Counter fd, or -1 if perf events are unavailable (no PMU in the
+ *         VM, perf_event_paranoid, seccomp)
+ */
+static int open_miss_counter() {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static uint64_t read_counter(int fd) {
+    uint64_t value = 0;
+    if (read(fd, &value, sizeof(value)) != (ssize_t) sizeof(value)) return 0;
+    return value;
+}
+
+static void hot_set_after_wipes() {
+    const size_t hotLen = 512 * 1024, wipeLen = 8 << 20;
+    const int reps = 20;
+    int fd = open_miss_counter();
+    if (fd < 0) printf("\nperf_event_open: %s, cache misses not counted\n", strerror(errno));
+
+    std::vector<unsigned char> hot(hotLen, 1);
+    unsigned char *buf = (unsigned char *) aligned_alloc(4096, wipeLen);
+    const WipeFn fns[] = {secure_wipe_vectorized, secure_wipe_nontemporal, secure_wipe_flush,
+                          secure_wipe};
+    const char *names[] = {"vector", "nontemporal", "flush", "secure_wipe"};
+    printf("\n%zu KiB hot set re-read after a %zu MiB wipe:\n", hotLen >> 10, wipeLen >> 20);
+    for (int v = 0; v < 4; v++) {
+        uint64_t ns = 0, misses = 0;
+        for (int r = 0; r < reps; r++) {
+            memset(buf, 0xAA, wipeLen);
+            volatile unsigned char sink = 0;
+            for (size_t i = 0; i < hotLen; i += 64) sink = sink + hot[i];
+            fns[v](buf, wipeLen);
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+            uint64_t start = host_now_ns();
+            for (size_t i = 0; i < hotLen; i += 64) sink = sink + hot[i];
+            ns += host_now_ns() - start;
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+                misses += read_counter(fd);
+            }
+        }
+        printf("  %-12s %8.1f us", names[v], (double) ns / reps / 1e3);
+        if (fd >= 0) printf("  %8llu misses", (unsigned long long) (misses / reps));
+        printf("\n");
+    }
+    free(buf);
+    if (fd >= 0) close(fd);
+}
+
+/**
+ * Latency of the first load of each line of a just-wiped buffer
+ * The lines are visited in a shuffled order with each address depending on
+ * the previous load, so neither prefetchers nor overlapping misses hide it
+ */
+static void wiped_line_residency() {
+    const size_t len = 4096, lines = len / 64;
+    const int reps = 2000;
+    unsigned char *buf = (unsigned char *) aligned_alloc(4096, len);
+    size_t order[lines];
+    for (size_t i = 0; i < lines; i++) order[i] = i;
+    unsigned seed = 9;
+    for (size_t i = lines - 1; i > 0; i--) {
+        size_t j = (size_t) rand_r(&seed) % (i + 1);
+        size_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+
+    const WipeFn fns[] = {secure_wipe_vectorized, secure_wipe_nontemporal, secure_wipe_flush};
+    const char *names[] = {"vector", "nontemporal", "flush"};
+    printf("\nfirst load of a wiped line (%zu B buffer):\n", len);
+    double resident = 0;
+    for (int v = 0; v < 3; v++) {
+        std::vector<double> samples;
+        for (int r = 0; r < reps; r++) {
+            memset(buf, 0xAA, len);
+            fns[v](buf, len);
+            size_t at = 0;
+            uint64_t start = host_now_ns();
+            for (size_t i = 0; i < lines; i++) {
+                at = *(volatile unsigned char *) (buf + order[i] * 64 + at);
+            }
+            samples.push_back((double) (host_now_ns() - start) / lines);
+        }
+        double p50 = host_percentile(samples, 0.5);
+        if (v == 0) resident = p50;
+        printf("  %-12s %6.1f ns/line", names[v], p50);
+        if (v > 0) printf("  %s", p50 > 3 * resident ? "evicted" : "still cached");
+        printf("\n");
+    }
+    free(buf);
+}
+
+static void remap_crossover() {
+    printf("\n%-13s %10s %12s %12s %12s   (us per wipe + touch)\n", "backend", "bytes",
+           "vector", "nontemporal", "remap");
+    for (int k = 0; k < BACKEND_COUNT; k++) {
+        SecureBackendKind want = (SecureBackendKind) k;
+        if (!backend_select(want)) {
+            printf("%-13s not supported here, skipped\n", backend_name(want));
+            continue;
+        }
+        for (size_t size : {64ul << 10, 1ul << 20, 4ul << 20}) {
+            bool locked = false;
+            SecureBackendKind kind;
+            void *mem = backend_map(size, LOCK_PRIO_CRITICAL, &locked, &kind);
+            if (!mem) continue;
+            int reps = size >= (1ul << 20) ? 20 : 200;
+            double us[3];
+            for (int strategy = 0; strategy < 3; strategy++) {
+                uint64_t total = 0;
+                bool failed = false;
+                for (int r = 0; r < reps; r++) {
+                    memset(mem, 0xAA, size);
+                    uint64_t start = host_now_ns();
+                    if (strategy == 0) secure_wipe_vectorized(mem, size);
+                    else if (strategy == 1) secure_wipe_nontemporal(mem, size);
+                    else failed |= !remap_zero(mem, size, kind);
+                    touch_pages(mem, size);
+                    total += host_now_ns() - start;
+                }
+                us[strategy] = failed ? -1 : (double) total / reps / 1e3;
+            }
+            printf("%-13s %10zu %12.1f %12.1f %12.1f%s%s\n", backend_name(kind), size, us[0],
+                   us[1], us[2], kind != want ? "  [fell back]" : "", locked ? "" : "  [unlocked]");
+            backend_unmap(mem, size, locked, kind);
+        }
+    }
+}
+
+int main() {
+    // Room to lock the crossover mappings, if the hard limit allows
+    struct rlimit rl = {RLIM_INFINITY, RLIM_INFINITY};
+    setrlimit(RLIMIT_MEMLOCK, &rl);
+
+    const WipeFn fns[] = {secure_wipe_vectorized, secure_wipe_flush, secure_wipe_nontemporal,
+                          secure_wipe, secure_memzero};
+    const char *names[] = {"vector", "flush", "nontemporal", "secure_wipe", "memzero"};
+
+    printf("%10s", "bytes");
+    for (const char *name : names) printf(" %12s", name);
+    printf("   (us per wipe)\n");
+    for (size_t size : {4096ul, 16384ul, 1ul << 20, 8ul << 20, 64ul << 20}) {
+        unsigned char *buf = (unsigned char *) aligned_alloc(4096, size);
+        int reps = size >= (8ul << 20) ? 5 : size >= (1ul << 20) ? 50 : 5000;
+        printf("%10zu", size);
+        for (WipeFn fn : fns) {
+            uint64_t total = 0;
+            for (int r = 0; r < reps; r++) {
+                memset(buf, 0xAA, size);
+                uint64_t start = host_now_ns();
+                fn(buf, size);
+                total += host_now_ns() - start;
+            }
+            printf(" %12.2f", (double) total / reps / 1e3);
+        }
+        printf("\n");
+        free(buf);
+    }
+
+    // Registry wipe: 64 KiB regions
+    for (size_t mb : {1, 10, 100}) {
+        std::vector<SecretNode> nodes(mb * 16);
+        std::vector<unsigned char> big(mb << 20, 1);
+        for (size_t i = 0; i < nodes.size(); i++) {
+            secret_registry_add(&nodes[i], &big[i * 65536], 65536, SECRET_CLASS_PLAINTEXT);
+        }
+        uint64_t start = host_now_ns();
+        size_t wiped = secret_registry_wipe_all(SECRET_CLASS_ALL);
+        printf("registry wipe %3zu MB: %zu bytes in %.3f ms\n", mb, wiped,
+               (double) (host_now_ns() - start) / 1e6);
+        for (SecretNode &node : nodes) secret_registry_remove(&node);
+    }
+
+    // Stack scrubs at measured depths and at the blanket default
+    for (size_t depth : {1024ul, 6144ul, (size_t) STACK_SCRUB_DEFAULT}) {
+        const int reps = 100000;
+        uint64_t start = host_now_ns();
+        for (int r = 0; r < reps; r++) stack_scrub(depth);
+        printf("stack_scrub(%zu): %.0f ns\n", depth, (double) (host_now_ns() - start) / reps);
+    }
+
+    remap_crossover();
+    hot_set_after_wipes();
+    wiped_line_residency();
+    return 0;
+}
@@ -0,0 +1,38 @@
+#include <cstring>
+#include <initializer_list>
+#include <unistd.h>
+
+#include "host_test.h"
+#include "lock_budget.h"
+#include "wipe_queue.h"
+
+// ========== DEFERRED WIPES ==========
+// Caller latency of locked_free() for large regions, wiping inline against
+// handing the mapping to the wipe queue, and the worst wipe lag seen.
+
+int main() {
+    for (int deferred = 0; deferred < 2; deferred++) {
+        wipe_queue_set_enabled(deferred);
+        for (size_t size : {64u << 10, 1u << 20, 4u << 20}) {
+            const int reps = 50;
+            uint64_t total = 0;
+            for (int r = 0; r < reps; r++) {
+                LockedRegion region;
+                locked_alloc(&region, size, LOCK_PRIO_BULK);
+                memset(region.ptr, 0xAB, size);
+                uint64_t start = host_now_ns();
+                locked_free(&region);
+                total += host_now_ns() - start;
+                usleep(2000);
+            }
+            WipeQueueInfo info;
+            wipe_queue_info(&info);
+            printf("%-8s %8zu B: free %8.1f us  deferred %llu  fallbacks %llu  max lag %.2f ms\n",
+                   deferred ? "deferred" : "inline", size, (double) total / reps / 1e3,
+                   (unsigned long long) info.deferred, (unsigned long long) info.fallbacks,
+                   (double) info.maxLagNs / 1e6);
+        }
+    }
+    wipe_queue_set_enabled(false);
+    return 0;
+}
@@ -0,0 +1,210 @@
+#include <jni.h>
+
+#include <atomic>
+#include <cstdarg>
+#include <cstring>
+#include <initializer_list>
+#include <sched.h>
+#include <unistd.h>
+
+#include "host_test.h"
+#include "jni_util.h"
+#include "worker_pool.h"
+
+// ========== WORKER POOL ==========
+// Drives the async JNI entry points over a fake JavaVM that records when
+// each onNativeResult() callback arrives: submit cost, submit-to-callback
+// latency in isolation and in bursts, and cancel cost. Every check runs
+// the password KDF, so the counts are small.
+
+extern "C" {
+jboolean Java_com_example_fuzzme_1v3_NativeBridge_checkCredentials(
+        JNIEnv *, jclass, jcharArray, jcharArray, jint, jint);
+jlong Java_com_example_fuzzme_1v3_NativeBridge_submitCheckCredentials(
+        JNIEnv *, jclass, jcharArray, jcharArray, jint, jint, jlong, jcharArray, jint, jobject);
+jlong Java_com_example_fuzzme_1v3_NativeBridge_submitDecryptFlag(
+        JNIEnv *, jclass, jcharArray, jobject);
+jboolean Java_com_example_fuzzme_1v3_NativeBridge_cancelRequest(JNIEnv *, jclass, jlong);
+}
+#define JNI_FN(name) Java_com_example_fuzzme_1v3_NativeBridge_##name
+
+// The JDK and the NDK name the function tables differently
+#ifdef _JAVASOFT_JNI_H_
+typedef JNINativeInterface_ FakeFunctionTable;
+typedef JNIInvokeInterface_ FakeInvokeTable;
+#else
+typedef JNINativeInterface FakeFunctionTable;
+typedef JNIInvokeInterface FakeInvokeTable;
+#endif
+
+struct FakeArray : _jcharArray {
+    jchar data[64];
+    jsize len;
+};
+
+static const uint32_t HANDLE_SLOTS = 1 << 16;
+
+static FakeArray g_user, g_pass, g_flag;
+static _jobject g_callback;
+static _jclass g_class;
+static std::atomic<uint64_t> g_doneAt[HANDLE_SLOTS];
+static std::atomic<int> g_ok{0}, g_done{0};
+
+static FakeArray *as_array(jarray array) {
+    return static_cast<FakeArray *>(static_cast<_jcharArray *>(array));
+}
+
+static jclass fake_GetObjectClass(JNIEnv *, jobject) { return &g_class; }
+static jmethodID fake_GetMethodID(JNIEnv *, jclass, const char *, const char *) { return (jmethodID) 1; }
+static void fake_DeleteLocalRef(JNIEnv *, jobject) {}
+static jobject fake_NewGlobalRef(JNIEnv *, jobject obj) { return obj; }
+static void fake_DeleteGlobalRef(JNIEnv *, jobject) {}
+static jboolean fake_ExceptionCheck(JNIEnv *) { return JNI_FALSE; }
+static void fake_ExceptionClear(JNIEnv *) {}
+static void fake_ExceptionDescribe(JNIEnv *) {}
+static jsize fake_GetArrayLength(JNIEnv *, jarray array) { return as_array(array)->len; }
+
+static void fake_CallVoidMethodV(JNIEnv *, jobject, jmethodID, va_list args) {
+    jlong handle = va_arg(args, jlong);
+    int ok = va_arg(args, int);
+    g_doneAt[(uint32_t) handle % HANDLE_SLOTS].store(host_now_ns());
+    if (ok) g_ok++;
+    g_done++;
+}
+
+static void fake_GetCharArrayRegion(JNIEnv *, jcharArray array, jsize start, jsize len, jchar *buf) {
+    memcpy(buf, as_array(array)->data + start, (size_t) len * sizeof(jchar));
+}
+
+static jchar *fake_GetCharArrayElements(JNIEnv *, jcharArray array, jboolean *isCopy) {
+    if (isCopy) *isCopy = JNI_FALSE;
+    return as_array(array)->data;
+}
+
+static void fake_ReleaseCharArrayElements(JNIEnv *, jcharArray, jchar *, jint) {}
+
+static void *fake_GetPrimitiveArrayCritical(JNIEnv *, jarray array, jboolean *isCopy) {
+    if (isCopy) *isCopy = JNI_FALSE;
+    return as_array(array)->data;
+}
+
+static void fake_ReleasePrimitiveArrayCritical(JNIEnv *, jarray, void *, jint) {}
+
+static FakeFunctionTable g_functions;
+static JNIEnv g_env;
+static FakeInvokeTable g_invoke;
+static JavaVM g_vm;
+
+static jint fake_GetEnv(JavaVM *, void **env, jint) {
+    *env = &g_env;
+    return JNI_OK;
+}
+
+static void fake_jvm_init() {
+    g_functions.GetObjectClass = fake_GetObjectClass;
+    g_functions.GetMethodID = fake_GetMethodID;
+    g_functions.DeleteLocalRef = fake_DeleteLocalRef;
+    g_functions.NewGlobalRef = fake_NewGlobalRef;
+    g_functions.DeleteGlobalRef = fake_DeleteGlobalRef;
+    g_functions.ExceptionCheck = fake_ExceptionCheck;
+    g_functions.ExceptionClear = fake_ExceptionClear;
+    g_functions.ExceptionDescribe = fake_ExceptionDescribe;
+    g_functions.GetArrayLength = fake_GetArrayLength;
+    g_functions.CallVoidMethodV = fake_CallVoidMethodV;
+    g_functions.GetCharArrayRegion = fake_GetCharArrayRegion;
+    g_functions.GetCharArrayElements = fake_GetCharArrayElements;
+    g_functions.ReleaseCharArrayElements = fake_ReleaseCharArrayElements;
+    g_functions.GetPrimitiveArrayCritical = fake_GetPrimitiveArrayCritical;
+    g_functions.ReleasePrimitiveArrayCritical = fake_ReleasePrimitiveArrayCritical;
+    g_env.functions = &g_functions;
+    g_invoke.GetEnv = fake_GetEnv;
+    g_vm.functions = &g_invoke;
+    jni_set_vm(&g_vm);
+}
+
+static void fill(FakeArray *array, const char *text) {
+    array->len = (jsize) strlen(text);
+    for (jsize i = 0; i < array->len; i++) array->data[i] = (jchar) text[i];
+}
+
+static jlong submit_check() {
+    fill(&g_user, "admin");
+    fill(&g_pass, "admin");
+    return JNI_FN(submitCheckCredentials)(&g_env, NULL, &g_user, &g_pass, 5, 5, 0, NULL, 0,
+                                          &g_callback);
+}
+
+static void wait_done(int target) {
+    while (g_done.load() < target) sched_yield();
+}
+
+int main() {
+    fake_jvm_init();
+
+    std::vector<double> sync;
+    for (int i = 0; i < 5; i++) {
+        fill(&g_user, "admin");
+        fill(&g_pass, "admin");
+        uint64_t start = host_now_ns();
+        JNI_FN(checkCredentials)(&g_env, NULL, &g_user, &g_pass, 5, 5);
+        sync.push_back((double) (host_now_ns() - start) / 1e6);
+    }
+    printf("sync checkCredentials: p50 %.1f ms\n", host_percentile(sync, .5));
+
+    std::vector<double> submit, latency;
+    for (int i = 0; i < 10; i++) {
+        int before = g_done.load();
+        uint64_t start = host_now_ns();
+        jlong handle = submit_check();
+        submit.push_back((double) (host_now_ns() - start) / 1e3);
+        wait_done(before + 1);
+        latency.push_back((double) (g_doneAt[(uint32_t) handle % HANDLE_SLOTS].load() - start) / 1e6);
+    }
+    printf("isolated: submit p50 %.2f us, submit->callback p50 %.1f p99 %.1f ms\n",
+           host_percentile(submit, .5), host_percentile(latency, .5), host_percentile(latency, .99));
+
+    for (int burst : {4, 8, 16}) {
+        std::vector<double> done;
+        double whole = 0;
+        const int rounds = 2;
+        for (int r = 0; r < rounds; r++) {
+            int before = g_done.load();
+            jlong handles[16];
+            uint64_t submitted[16];
+            uint64_t start = host_now_ns();
+            for (int i = 0; i < burst; i++) {
+                submitted[i] = host_now_ns();
+                handles[i] = submit_check();
+            }
+            wait_done(before + burst);
+            uint64_t last = 0;
+            for (int i = 0; i < burst; i++) {
+                uint64_t at = g_doneAt[(uint32_t) handles[i] % HANDLE_SLOTS].load();
+                last = std::max(last, at);
+                done.push_back((double) (at - submitted[i]) / 1e6);
+            }
+            whole += (double) (last - start) / 1e6;
+        }
+        printf("burst %2d: completion p50 %.1f p99 %.1f ms, all done %.1f ms\n", burst,
+               host_percentile(done, .5), host_percentile(done, .99), whole / rounds);
+    }
+
+    std::vector<double> cancel;
+    int cancelled = 0;
+    for (int i = 0; i < 200; i++) {
+        jlong handle = submit_check();
+        uint64_t start = host_now_ns();
+        cancelled += JNI_FN(cancelRequest)(&g_env, NULL, handle);
+        cancel.push_back((double) (host_now_ns() - start) / 1e3);
+    }
+    while (worker_pending() > 0) usleep(1000);
+    printf("cancel: p50 %.2f us, %d/200 cancelled before running\n", host_percentile(cancel, .5),
+           cancelled);
+
+    int before = g_done.load();
+    g_flag.len = 25;
+    JNI_FN(submitDecryptFlag)(&g_env, NULL, &g_flag, &g_callback);
+    wait_done(before + 1);
+    printf("results: %d ok of %d callbacks\n", g_ok.load(), g_done.load());
+    return 0;
+}
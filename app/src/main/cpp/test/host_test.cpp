@@ -0,0 +1,9 @@
+#include "host_test.h"
+
+// Linked into every test and benchmark
+
+// Slab free maps are only referenced from headers inside the mmap'd slab
+// pages, which LeakSanitizer does not scan (same as ../fuzz/fake_jni.cpp)
+extern "C" const char *__lsan_default_suppressions() {
+    return "leak:grow_cache\n";
+}
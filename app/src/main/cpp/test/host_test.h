@@ -0,0 +1,77 @@
+#ifndef FUZZME_V3_HOST_TEST_H
+#define FUZZME_V3_HOST_TEST_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// ========== HOST TEST HELPERS ==========
+// Shared by the tests and benchmarks in this directory: every test is its
+// own executable that prints its failures and exits non-zero, so ctest
+// needs no framework.
+
+static int g_hostTestFailures = 0;
+
+/**
+ * Records a failure (with its location) and keeps going
+ */
+#define CHECK(cond)                                                                         \
+    do {                                                                                    \
+        if (!(cond)) {                                                                      \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);        \
+            g_hostTestFailures++;                                                           \
+        }                                                                                   \
+    } while (0)
+
+/**
+ * Exit status of a test: prints a summary line
+ */
+static inline int host_test_result(const char *name) {
+    if (g_hostTestFailures) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, g_hostTestFailures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+static inline uint64_t host_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * Runs fn in a forked child (for aborts, or state read once per process)
+ * @return The signal that killed the child, or 0 and *exitCode on a normal exit
+ */
+static inline int host_run_child(void (*fn)(), int *exitCode = NULL) {
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == 0) {
+        fn();
+        _exit(g_hostTestFailures ? 1 : 0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (WIFSIGNALED(status)) return WTERMSIG(status);
+    if (exitCode) *exitCode = WEXITSTATUS(status);
+    return 0;
+}
+
+/**
+ * Percentile of a sample set (sorts a copy)
+ */
+static inline double host_percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[(size_t) (p * (double) (v.size() - 1))];
+}
+
+#endif // FUZZME_V3_HOST_TEST_H
@@ -0,0 +1,207 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "breach_filter.h"
+#include "breach_filter_format.h"
+#include "host_test.h"
+#include "sha1.h"
+
+// ========== BREACH FILTER ==========
+// Filters built by tools/build_breach_filter report every password of their
+// corpus, false positives stay near 2^-fingerprintBits, and files that are
+// truncated or whose header or shard table would send a lookup outside the
+// mapping are refused (leaving the loaded filter in place).
+//
+//   test_breach_filter <build_breach_filter>
+
+static const unsigned MEMBERS = 40000;
+static const unsigned PROBES = 400000;
+
+static std::string g_dir;
+
+static bool write_file(const std::string &path, const std::vector<unsigned char> &bytes) {
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    bool ok = bytes.empty() || fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    return fclose(f) == 0 && ok;
+}
+
+static std::vector<unsigned char> read_file(const std::string &path) {
+    std::vector<unsigned char> bytes;
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f) return bytes;
+    unsigned char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) bytes.insert(bytes.end(), buf, buf + n);
+    fclose(f);
+    return bytes;
+}
+
+static int contains(const char *prefix, unsigned i) {
+    char password[32];
+    int len = snprintf(password, sizeof(password), "%s%u", prefix, i);
+    return breach_filter_contains(password, (size_t) len);
+}
+
+/**
+ * Writes the HIBP-style corpus: SHA-1 of "pw0" .. "pw<MEMBERS-1>", upper
+ * case with counts, plus a duplicate and lines the builder must skip
+ */
+static std::string write_corpus() {
+    std::string path = g_dir + "/corpus.txt";
+    FILE *f = fopen(path.c_str(), "w");
+    CHECK(f != NULL);
+    if (!f) return path;
+    for (unsigned i = 0; i < MEMBERS; i++) {
+        char password[32];
+        unsigned char digest[SHA1_OUT_BYTES];
+        int len = snprintf(password, sizeof(password), "pw%u", i);
+        sha1(digest, password, (size_t) len);
+        for (unsigned char byte : digest) fprintf(f, "%02X", byte);
+        fprintf(f, ":%u\n", i % 7 + 1);
+        if (i == 0) {
+            for (unsigned char byte : digest) fprintf(f, "%02x", byte);
+            fprintf(f, "\n\nnot a hash\n");
+        }
+    }
+    fclose(f);
+    return path;
+}
+
+static std::string build_filter(const char *builder, const std::string &corpus,
+                                const char *name, const char *options) {
+    std::string out = g_dir + "/" + name;
+    std::string command = std::string(builder) + " " + options + " -o " + out + " " + corpus +
+                          " 2>/dev/null";
+    CHECK(system(command.c_str()) == 0);
+    return out;
+}
+
+static void check_filter(const std::string &path, unsigned fingerprintBits) {
+    CHECK(breach_filter_open(path.c_str()) == MEMBERS);
+
+    unsigned missed = 0, falsePositives = 0;
+    for (unsigned i = 0; i < MEMBERS; i++) missed += contains("pw", i) != 1;
+    for (unsigned i = 0; i < PROBES; i++) falsePositives += contains("nope", i) != 0;
+    CHECK(missed == 0);
+
+    // Binomial around PROBES * 2^-bits: 6 expected for 16 bits, 1562 for 8
+    double expected = (double) PROBES / (double) (1u << fingerprintBits);
+    printf("%u-bit fingerprints: %u false positives in %u (%.1f expected)\n", fingerprintBits,
+           falsePositives, PROBES, expected);
+    CHECK(falsePositives <= 2 * expected + 20);
+    CHECK(falsePositives >= expected / 2 - 5);
+}
+
+/**
+ * A modified copy of a filter must be refused, and the loaded one kept
+ */
+static void check_refused(const std::vector<unsigned char> &bytes, const char *what) {
+    std::string path = g_dir + "/corrupt.bin";
+    CHECK(write_file(path, bytes));
+    if (breach_filter_open(path.c_str()) != -1) {
+        fprintf(stderr, "accepted: %s\n", what);
+        CHECK(!"corrupt filter accepted");
+    }
+    CHECK(contains("pw", 1) == 1);
+}
+
+static void check_corrupt(const std::string &path) {
+    const std::vector<unsigned char> good = read_file(path);
+    CHECK(good.size() > sizeof(BreachFilterHeader) + sizeof(BreachFilterShard));
+    CHECK(breach_filter_open(path.c_str()) == MEMBERS);
+
+    // Truncated or grown
+    check_refused({}, "empty");
+    check_refused(std::vector<unsigned char>(good.begin(), good.begin() + 20), "half a header");
+    size_t cut = sizeof(BreachFilterHeader) + 8;
+    check_refused(std::vector<unsigned char>(good.begin(), good.begin() + cut),
+                  "cut in the shard table");
+    check_refused(std::vector<unsigned char>(good.begin(), good.end() - 1), "last byte missing");
+    std::vector<unsigned char> grown = good;
+    grown.push_back(0);
+    check_refused(grown, "byte appended");
+
+    // Header fields
+    auto with_header = [&](void (*edit)(BreachFilterHeader *)) {
+        std::vector<unsigned char> bytes = good;
+        BreachFilterHeader header;
+        memcpy(&header, bytes.data(), sizeof(header));
+        edit(&header);
+        memcpy(bytes.data(), &header, sizeof(header));
+        return bytes;
+    };
+    check_refused(with_header([](BreachFilterHeader *h) { h->magic[0] ^= 1; }), "magic");
+    check_refused(with_header([](BreachFilterHeader *h) { h->version++; }), "version");
+    check_refused(with_header([](BreachFilterHeader *h) { h->fingerprintBits = 12; }),
+                  "fingerprint bits");
+    check_refused(with_header([](BreachFilterHeader *h) {
+        h->shardBits = BREACH_FILTER_MAX_SHARD_BITS + 1;
+    }), "shard bits");
+    check_refused(with_header([](BreachFilterHeader *h) {
+        h->shardBits = BREACH_FILTER_MAX_SHARD_BITS;
+    }), "shard table past the end");
+    check_refused(with_header([](BreachFilterHeader *h) { h->keyCount++; }), "key count");
+    check_refused(with_header([](BreachFilterHeader *h) { h->fileBytes++; }), "file size");
+
+    // First shard's table entry
+    auto with_shard = [&](void (*edit)(BreachFilterShard *, size_t)) {
+        std::vector<unsigned char> bytes = good;
+        BreachFilterShard shard;
+        memcpy(&shard, bytes.data() + sizeof(BreachFilterHeader), sizeof(shard));
+        edit(&shard, bytes.size());
+        memcpy(bytes.data() + sizeof(BreachFilterHeader), &shard, sizeof(shard));
+        return bytes;
+    };
+    check_refused(with_shard([](BreachFilterShard *s, size_t) { s->segmentLength = 0; }),
+                  "zero segment length");
+    check_refused(with_shard([](BreachFilterShard *s, size_t) { s->segmentLength += 1; }),
+                  "segment length not a power of two");
+    check_refused(with_shard([](BreachFilterShard *s, size_t) {
+        s->segmentLength = BREACH_FILTER_MAX_SEGMENT_LENGTH * 2;
+    }), "segment length too large");
+    check_refused(with_shard([](BreachFilterShard *s, size_t) { s->segmentCount = 0; }),
+                  "no segments");
+    check_refused(with_shard([](BreachFilterShard *s, size_t) { s->arrayLength++; }),
+                  "array length");
+    check_refused(with_shard([](BreachFilterShard *s, size_t len) { s->offset = len + 64; }),
+                  "offset past the end");
+    check_refused(with_shard([](BreachFilterShard *s, size_t len) { s->offset = len - 2; }),
+                  "array past the end");
+    check_refused(with_shard([](BreachFilterShard *s, size_t) { s->keyCount++; }),
+                  "shard key count");
+
+    CHECK(breach_filter_open((g_dir + "/missing.bin").c_str()) == -1);
+    CHECK(contains("pw", 1) == 1);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <build_breach_filter>\n", argv[0]);
+        return 2;
+    }
+    char dir[] = "/tmp/test_breach_filter.XXXXXX";
+    CHECK(mkdtemp(dir) != NULL);
+    g_dir = dir;
+
+    CHECK(breach_filter_contains("pw1", 3) == -1);
+    std::string corpus = write_corpus();
+
+    // Several shards with 16-bit fingerprints, one shard with 8-bit ones
+    std::string wide = build_filter(argv[1], corpus, "wide.bin", "--shard-keys 6000");
+    std::string narrow = build_filter(argv[1], corpus, "narrow.bin", "--fingerprint-bits 8");
+    CHECK(read_file(wide).size() > sizeof(BreachFilterHeader) + 4 * sizeof(BreachFilterShard));
+    check_filter(wide, 16);
+    check_filter(narrow, 8);
+    check_corrupt(wide);
+
+    breach_filter_close();
+    CHECK(contains("pw", 1) == -1);
+
+    std::string cleanup = "rm -rf " + g_dir;
+    CHECK(system(cleanup.c_str()) == 0);
+    return host_test_result("test_breach_filter");
+}
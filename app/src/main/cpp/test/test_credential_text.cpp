@@ -0,0 +1,89 @@
+#include <cstring>
+#include <vector>
+
+#include "credential_text.h"
+#include "host_test.h"
+
+// ========== CREDENTIAL TEXT ==========
+// Credentials compare as NFKC-normalized UTF-8: every code point counts (no
+// low-byte narrowing), equivalent spellings give the same bytes, invalid
+// UTF-16 is rejected, and ASCII never needs the normalization scratch.
+
+/**
+ * credential_to_utf8() of a UTF-16 literal, as a byte vector
+ * @param ok false if the conversion failed
+ */
+static std::vector<unsigned char> encode(const std::vector<uint16_t> &text, bool *ok) {
+    std::vector<unsigned char> out(credential_utf8_capacity(text.size()));
+    std::vector<uint32_t> scratch(credential_scratch_capacity(text.size()));
+    long n = credential_to_utf8(text.data(), text.size(), out.data(), out.size(),
+                                scratch.data(), scratch.size());
+    *ok = n >= 0;
+    out.resize(n >= 0 ? (size_t) n : 0);
+    return out;
+}
+
+static bool same_bytes(const std::vector<uint16_t> &a, const std::vector<uint16_t> &b) {
+    bool okA = false, okB = false;
+    std::vector<unsigned char> bytesA = encode(a, &okA), bytesB = encode(b, &okB);
+    return okA && okB && bytesA == bytesB;
+}
+
+static bool encodes_to(const std::vector<uint16_t> &text, const char *utf8) {
+    bool ok = false;
+    std::vector<unsigned char> bytes = encode(text, &ok);
+    return ok && bytes == std::vector<unsigned char>(utf8, utf8 + strlen(utf8));
+}
+
+static bool rejected(const std::vector<uint16_t> &text) {
+    bool ok = true;
+    encode(text, &ok);
+    return !ok;
+}
+
+int main() {
+    // U+0161 used to narrow to 0x61 ('a'), so "pšss" logged in as "pass"
+    CHECK(!same_bytes({'p', 0x0161, 's', 's'}, {'p', 'a', 's', 's'}));
+    CHECK(encodes_to({'p', 0x0161, 's', 's'}, "p\xC5\xA1ss"));
+    CHECK(!same_bytes({0x4E61}, {'a'}));
+
+    // Canonical equivalence: precomposed vs combining
+    CHECK(same_bytes({0x00E9}, {'e', 0x0301}));
+    CHECK(encodes_to({'e', 0x0301}, "\xC3\xA9"));
+    CHECK(same_bytes({'c', 'a', 'f', 'e', 0x0301}, {'c', 'a', 'f', 0x00E9}));
+
+    // Compatibility forms: fullwidth and ligatures fold to ASCII
+    CHECK(same_bytes({0xFF21, 0xFF22, 0xFF23, 0xFF11}, {'A', 'B', 'C', '1'}));
+    CHECK(encodes_to({0xFB01}, "fi"));
+
+    // Hangul: a syllable and its conjoining jamo (L V T) are one code point
+    CHECK(same_bytes({0xD55C}, {0x1112, 0x1161, 0x11AB}));
+    CHECK(encodes_to({0x1112, 0x1161, 0x11AB}, "\xED\x95\x9C"));
+
+    // Surrogates: pairs decode, unpaired halves never match anything
+    CHECK(encodes_to({0xD83D, 0xDE00}, "\xF0\x9F\x98\x80"));
+    CHECK(rejected({'a', 0xD800, 'b'}));
+    CHECK(rejected({'a', 0xDC00}));
+    CHECK(rejected({'a', 'b', 'c', 'd', 'e', 'f', 'g', 0xD83D}));
+    CHECK(rejected({0xDE00, 0xD83D}));
+
+    // ASCII takes the transcoding fast path: no scratch needed, and it agrees
+    // with the plain transcoder across the 8-unit SIMD blocks and their tail
+    std::vector<uint16_t> ascii;
+    for (int i = 0; i < 37; i++) ascii.push_back((uint16_t) ('!' + i * 7 % 94));
+    std::vector<unsigned char> fast(credential_utf8_capacity(ascii.size()));
+    long fastLen = credential_to_utf8(ascii.data(), ascii.size(), fast.data(), fast.size(),
+                                      NULL, 0);
+    CHECK(fastLen == (long) ascii.size());
+    for (size_t i = 0; fastLen > 0 && i < ascii.size(); i++) CHECK(fast[i] == ascii[i]);
+    std::vector<unsigned char> plain(ascii.size() * 3);
+    CHECK(utf16_to_utf8(ascii.data(), ascii.size(), plain.data(), plain.size()) == fastLen);
+    CHECK(memcmp(plain.data(), fast.data(), ascii.size()) == 0);
+
+    // ...while text that needs normalizing does use it
+    std::vector<uint16_t> combining = {'e', 0x0301};
+    CHECK(credential_to_utf8(combining.data(), combining.size(), fast.data(), fast.size(),
+                             NULL, 0) < 0);
+
+    return host_test_result("test_credential_text");
+}
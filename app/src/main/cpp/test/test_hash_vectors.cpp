@@ -0,0 +1,271 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#include "blake2s.h"
+#include "cpu_dispatch.h"
+#include "hkdf.h"
+#include "hmac.h"
+#include "host_test.h"
+#include "sha256.h"
+
+// ========== HMAC / HKDF / BATCHED SHA-256 / BLAKE2s ==========
+// HKDF matches RFC 5869 test cases A.1-A.4 on every SHA-1 and SHA-256 block
+// variant the host CPU can run; incremental HMAC matches one-shot HMAC
+// across block boundaries; sha256_batch() and hmac_short_batch() match the
+// one-at-a-time functions for every lane count on every multi-buffer
+// variant. BLAKE2s (the keystroke digest) matches RFC 7693 and the
+// reference implementation's known answers, plain and keyed, whole or fed
+// in pieces.
+
+struct HkdfVector {
+    const char *name;
+    HmacHash hash;
+    const char *ikm;
+    const char *salt;
+    const char *info;
+    size_t outLen;
+    const char *okm;
+};
+
+static const HkdfVector RFC5869[] = {
+        {"A.1", HMAC_SHA256,
+         "0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b",
+         "000102030405060708090a0b0c",
+         "f0f1f2f3f4f5f6f7f8f9",
+         42,
+         "3cb25f25faacd57a90434f64d0362f2a2d2d0a90cf1a5a4c5db02d56ecc4c5bf"
+         "34007208d5b887185865"},
+        {"A.2", HMAC_SHA256,
+         "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+         "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+         "404142434445464748494a4b4c4d4e4f",
+         "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+         "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+         "a0a1a2a3a4a5a6a7a8a9aaabacadaeaf",
+         "b0b1b2b3b4b5b6b7b8b9babbbcbdbebfc0c1c2c3c4c5c6c7c8c9cacbcccdcecf"
+         "d0d1d2d3d4d5d6d7d8d9dadbdcdddedfe0e1e2e3e4e5e6e7e8e9eaebecedeeef"
+         "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",
+         82,
+         "b11e398dc80327a1c8e7f78c596a49344f012eda2d4efad8a050cc4c19afa97c"
+         "59045a99cac7827271cb41c65e590e09da3275600c2f09b8367793a9aca3db71"
+         "cc30c58179ec3e87c14c01d5c1f3434f1d87"},
+        {"A.3", HMAC_SHA256,
+         "0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b",
+         "",
+         "",
+         42,
+         "8da4e775a563c18f715f802a063c5a31b8a11f5c5ee1879ec3454e5f3c738d2d"
+         "9d201395faa4b61a96c8"},
+        {"A.4", HMAC_SHA1,
+         "0b0b0b0b0b0b0b0b0b0b0b",
+         "000102030405060708090a0b0c",
+         "f0f1f2f3f4f5f6f7f8f9",
+         42,
+         "085a01ea1b10f36933068b56efa5ad81a4f14b822f5b091568a9cdd4f155fda2"
+         "c22e422478d305f3f896"},
+};
+
+static unsigned char g_input[4096];
+
+/**
+ * Decodes a hex string into out
+ * @return Bytes written
+ */
+static size_t from_hex(const char *hex, unsigned char *out) {
+    size_t n = 0;
+    for (; hex[0] && hex[1]; hex += 2) {
+        unsigned byte;
+        sscanf(hex, "%2x", &byte);
+        out[n++] = (unsigned char) byte;
+    }
+    return n;
+}
+
+static void check_rfc5869() {
+    for (const HkdfVector &v : RFC5869) {
+        unsigned char ikm[128], salt[128], info[128], okm[128], out[128];
+        size_t ikmLen = from_hex(v.ikm, ikm);
+        size_t saltLen = from_hex(v.salt, salt);
+        size_t infoLen = from_hex(v.info, info);
+        CHECK(from_hex(v.okm, okm) == v.outLen);
+
+        memset(out, 0, sizeof(out));
+        bool ok = hkdf(v.hash, saltLen ? salt : NULL, saltLen, ikm, ikmLen,
+                       infoLen ? info : NULL, infoLen, out, v.outLen);
+        if (!ok || memcmp(out, okm, v.outLen) != 0) {
+            fprintf(stderr, "RFC 5869 %s on sha1=%s sha256=%s\n", v.name,
+                    cpu_dispatch_bound(KERNEL_SHA1), cpu_dispatch_bound(KERNEL_SHA256));
+            CHECK(ok && memcmp(out, okm, v.outLen) == 0);
+        }
+    }
+
+    // Expand stops at 255 hash lengths
+    static unsigned char big[HKDF_MAX_BLOCKS * 32 + 1];
+    CHECK(hkdf(HMAC_SHA256, NULL, 0, "k", 1, NULL, 0, big, HKDF_MAX_BLOCKS * 32));
+    CHECK(!hkdf(HMAC_SHA256, NULL, 0, "k", 1, NULL, 0, big, HKDF_MAX_BLOCKS * 32 + 1));
+}
+
+struct Blake2sVector {
+    size_t len;             // Input: bytes 0, 1, 2, ... (the reference KAT's)
+    const char *plain;
+    const char *keyed;      // Key: bytes 0 .. 31
+};
+
+// blake2s-kat.txt and blake2s-keyed-kat.txt of the BLAKE2 reference code
+static const Blake2sVector BLAKE2S_KAT[] = {
+        {0, "69217a3079908094e11121d042354a7c1f55b6482ca1a51e1b250dfd1ed0eef9",
+            "48a8997da407876b3d79c0d92325ad3b89cbb754d86ab71aee047ad345fd2c49"},
+        {1, "e34d74dbaf4ff4c6abd871cc220451d2ea2648846c7757fbaac82fe51ad64bea",
+            "40d15fee7c328830166ac3f918650f807e7e01e177258cdc0a39b11f598066f1"},
+        {63, "e57cb79487dd57902432b250733813bd96a84efce59f650fac26e6696aefafc3",
+             "c65382513f07460da39833cb666c5ed82e61b9e998f4b0c4287cee56c3cc9bcd"},
+        {64, "56f34e8b96557e90c1f24b52d0c89d51086acf1b00f634cf1dde9233b8eaaa3e",
+             "8975b0577fd35566d750b362b0897a26c399136df07bababbde6203ff2954ed4"},
+        {65, "1b53ee94aaf34e4b159d48de352c7f0661d0a40edff95a0b1639b4090e974472",
+             "21fe0ceb0052be7fb0f004187cacd7de67fa6eb0938d927677f2398c132317a8"},
+        {255, "f03f5789d3336b80d002d59fdf918bdb775b00956ed5528e86aa994acb38fe2d",
+              "3fb735061abc519dfe979e54c1ee5bfad0a9d858b3315bad34bde999efd724dd"},
+};
+
+/**
+ * BLAKE2s-256 of in, fed to blake2s_update() in pieces of 1, 4, 13, 40, ...
+ * bytes so they straddle every block boundary
+ */
+static void blake2s_pieces(const unsigned char *key, size_t keyLen, const unsigned char *in,
+                           size_t len, unsigned char *out) {
+    Blake2sState state;
+    CHECK(blake2s_init(&state, BLAKE2S_OUT_BYTES, key, keyLen));
+    size_t step = 1;
+    for (size_t pos = 0; pos < len; step = step * 3 + 1) {
+        size_t n = len - pos < step ? len - pos : step;
+        blake2s_update(&state, in + pos, n);
+        pos += n;
+    }
+    blake2s_final(&state, out);
+}
+
+static void check_blake2s() {
+    unsigned char in[256], key[BLAKE2S_KEY_BYTES], expected[BLAKE2S_OUT_BYTES];
+    unsigned char out[BLAKE2S_OUT_BYTES];
+    for (size_t i = 0; i < sizeof(in); i++) in[i] = (unsigned char) i;
+    for (size_t i = 0; i < sizeof(key); i++) key[i] = (unsigned char) i;
+
+    // RFC 7693 appendix B
+    from_hex("508c5e8c327c14e2e1a72ba34eeb452f37458b209ed63a294d999b4c86675982", expected);
+    CHECK(blake2s(out, sizeof(out), NULL, 0, "abc", 3));
+    CHECK(memcmp(out, expected, sizeof(out)) == 0);
+
+    for (const Blake2sVector &v : BLAKE2S_KAT) {
+        for (bool keyed : {false, true}) {
+            const unsigned char *k = keyed ? key : NULL;
+            size_t keyLen = keyed ? sizeof(key) : 0;
+            from_hex(keyed ? v.keyed : v.plain, expected);
+
+            memset(out, 0, sizeof(out));
+            CHECK(blake2s(out, sizeof(out), k, keyLen, in, v.len));
+            if (memcmp(out, expected, sizeof(out)) != 0) {
+                fprintf(stderr, "blake2s %s, %zu bytes\n", keyed ? "keyed" : "plain", v.len);
+                CHECK(memcmp(out, expected, sizeof(out)) == 0);
+            }
+
+            memset(out, 0, sizeof(out));
+            blake2s_pieces(k, keyLen, in, v.len, out);
+            CHECK(memcmp(out, expected, sizeof(out)) == 0);
+        }
+    }
+
+    // Block-sized and empty updates: a full block is held back (it may be the last)
+    Blake2sState state;
+    CHECK(blake2s_init(&state, BLAKE2S_OUT_BYTES, key, sizeof(key)));
+    blake2s_update(&state, in, 64);
+    blake2s_update(&state, in + 64, 0);
+    blake2s_update(&state, in + 64, 191);
+    blake2s_final(&state, out);
+    from_hex(BLAKE2S_KAT[5].keyed, expected);
+    CHECK(memcmp(out, expected, sizeof(out)) == 0);
+
+    CHECK(!blake2s_init(&state, 0, NULL, 0));
+    CHECK(!blake2s_init(&state, BLAKE2S_OUT_BYTES + 1, NULL, 0));
+    CHECK(!blake2s_init(&state, BLAKE2S_OUT_BYTES, key, BLAKE2S_KEY_BYTES + 1));
+}
+
+static void check_incremental_hmac() {
+    for (HmacHash hash : {HMAC_SHA1, HMAC_SHA256}) {
+        HmacKey key;
+        CHECK(hmac_key_init(&key, hash, "secret key", 10));
+        size_t outLen = hmac_out_bytes(hash);
+        for (size_t len : {0, 1, 55, 56, 63, 64, 65, 119, 128, 200, 1000}) {
+            unsigned char oneShot[HMAC_MAX_OUT_BYTES], pieces[HMAC_MAX_OUT_BYTES];
+            hmac(&key, g_input, len, oneShot);
+
+            // Pieces of 1, 4, 13, 40, ... bytes straddle every block boundary
+            HmacState state;
+            hmac_init(&state, &key);
+            size_t step = 1;
+            for (size_t pos = 0; pos < len; step = step * 3 + 1) {
+                size_t n = len - pos < step ? len - pos : step;
+                hmac_update(&state, g_input + pos, n);
+                pos += n;
+            }
+            hmac_final(&state, pieces);
+            CHECK(memcmp(oneShot, pieces, outLen) == 0);
+        }
+    }
+}
+
+static void check_batches() {
+    static unsigned char out[32 * 32];
+    for (size_t count : {1, 2, 7, 8, 9, 16, 19, 31}) {
+        for (size_t len : {0, 1, 55, 56, 63, 64, 65, 128}) {
+            sha256_batch(g_input, len, count, out);
+            for (size_t i = 0; i < count; i++) {
+                unsigned char one[SHA256_OUT_BYTES];
+                sha256(one, g_input + i * len, len);
+                CHECK(memcmp(one, out + i * SHA256_OUT_BYTES, SHA256_OUT_BYTES) == 0);
+            }
+        }
+    }
+
+    for (HmacHash hash : {HMAC_SHA1, HMAC_SHA256}) {
+        HmacKey key;
+        CHECK(hmac_key_init(&key, hash, "batch key", 9));
+        size_t outLen = hmac_out_bytes(hash);
+        for (size_t count : {1, 3, 7, 8, 9, 17, 31}) {
+            for (size_t len : {(size_t) 1, (size_t) 8, (size_t) 20, HMAC_SHORT_MAX_BYTES}) {
+                hmac_short_batch(&key, g_input, len, count, out);
+                for (size_t i = 0; i < count; i++) {
+                    unsigned char one[HMAC_MAX_OUT_BYTES];
+                    hmac(&key, g_input + i * len, len, one);
+                    CHECK(memcmp(one, out + i * outLen, outLen) == 0);
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    unsigned seed = 5869;
+    for (size_t i = 0; i < sizeof(g_input); i++) g_input[i] = (unsigned char) rand_r(&seed);
+
+    for (size_t v1 = 0; v1 < SHA1_KERNEL_COUNT; v1++) {
+        if (!cpu_dispatch_select("sha1", SHA1_KERNELS[v1].name)) continue;
+        for (size_t v256 = 0; v256 < SHA256_KERNEL_COUNT; v256++) {
+            if (!cpu_dispatch_select("sha256", SHA256_KERNELS[v256].name)) continue;
+            check_rfc5869();
+            check_incremental_hmac();
+        }
+    }
+    CHECK(cpu_dispatch_select("sha1", "auto"));
+    CHECK(cpu_dispatch_select("sha256", "auto"));
+
+    for (size_t v = 0; v < SHA256_MULTI_KERNEL_COUNT; v++) {
+        if (!cpu_dispatch_select("sha256x8", SHA256_MULTI_KERNELS[v].name)) continue;
+        check_batches();
+    }
+    CHECK(cpu_dispatch_select("sha256x8", "auto"));
+
+    check_blake2s();
+    return host_test_result("test_hash_vectors");
+}
@@ -0,0 +1,183 @@
+#include <atomic>
+#include <cstring>
+
+#include "blake2s.h"
+#include "host_test.h"
+#include "kdf_speculation.h"
+
+// ========== KDF SPECULATION ==========
+// The speculation slot's state machine, driven with a hash that holds until
+// released (or cancelled): a finished hash is adopted and collected only at
+// its own version; an edit cancels a running hash, whose output is wiped and
+// never handed out; a dropped ticket frees the slot; and
+// speculation_cancel_all() racing a real KDF returns with nothing running
+// and nothing left to collect.
+
+static std::atomic<int> g_entered{0};       // Hashes started
+static std::atomic<int> g_finished{0};      // Hashes returned
+static std::atomic<bool> g_release{false};  // Lets a held hash finish
+static std::atomic<unsigned char *> g_out{nullptr};
+
+static void sleep_ms(long ms) {
+    struct timespec ts = {ms / 1000, (ms % 1000) * 1000000};
+    nanosleep(&ts, NULL);
+}
+
+static bool wait_for(const std::atomic<int> &counter, int value) {
+    for (int i = 0; i < 5000 && counter.load() < value; i++) sleep_ms(1);
+    return counter.load() >= value;
+}
+
+/**
+ * BLAKE2s of the input once released; writes garbage first so a wipe of
+ * abandoned output shows
+ */
+static bool held_hash(const unsigned char *utf8, size_t len, const std::atomic<bool> *cancelled,
+                      unsigned char *out) {
+    g_out.store(out);
+    memset(out, 0xAB, KDF_OUT_BYTES);
+    g_entered++;
+    bool ok = false;
+    for (;;) {
+        if (cancelled->load()) break;
+        if (g_release.load()) {
+            ok = blake2s(out, KDF_OUT_BYTES, NULL, 0, utf8, len);
+            break;
+        }
+        sleep_ms(1);
+    }
+    g_finished++;
+    return ok;
+}
+
+static bool kdf_hash(const unsigned char *utf8, size_t len, const std::atomic<bool> *cancelled,
+                     unsigned char *out) {
+    PasswordKdfParams params = {};
+    params.memoryKiB = 4096;
+    params.passes = KDF_MAX_PASSES;
+    g_out.store(out);
+    g_entered++;
+    bool ok = password_kdf(utf8, len, &params, cancelled, out);
+    g_finished++;
+    return ok;
+}
+
+static bool output_wiped() {
+    unsigned char zeros[KDF_OUT_BYTES] = {};
+    unsigned char *out = g_out.load();
+    return out && memcmp(out, zeros, KDF_OUT_BYTES) == 0;
+}
+
+static const unsigned char TEXT[] = "tr0ub4dor";
+static const size_t TEXT_LEN = sizeof(TEXT) - 1;
+
+static void check_done_adopted() {
+    int entered = g_entered.load(), finished = g_finished.load();
+    g_release.store(true);
+    CHECK(speculation_start(1, 7, TEXT, TEXT_LEN, held_hash));
+    CHECK(wait_for(g_finished, finished + 1));
+    CHECK(g_entered.load() == entered + 1);
+    sleep_ms(20);   // The thread marks it DONE after the hash returns
+
+    // Same text again: nothing new is hashed
+    CHECK(speculation_start(1, 7, TEXT, TEXT_LEN, held_hash));
+    // Other stream or version: not adopted
+    CHECK(speculation_adopt(2, 7) == 0);
+    CHECK(speculation_adopt(1, 6) == 0);
+
+    uint64_t ticket = speculation_adopt(1, 7);
+    CHECK(ticket != 0);
+    CHECK(speculation_adopt(1, 7) == 0);    // Once only
+    unsigned char out[KDF_OUT_BYTES], expected[KDF_OUT_BYTES];
+    CHECK(speculation_collect(ticket, out));
+    blake2s(expected, KDF_OUT_BYTES, NULL, 0, TEXT, TEXT_LEN);
+    CHECK(memcmp(out, expected, sizeof(out)) == 0);
+    CHECK(output_wiped());
+    CHECK(!speculation_collect(ticket, out));  // Taken
+    CHECK(g_entered.load() == entered + 1);
+}
+
+static void check_edit_cancels_running() {
+    g_release.store(false);
+    int entered = g_entered.load(), finished = g_finished.load();
+    CHECK(speculation_start(3, 1, TEXT, TEXT_LEN, held_hash));
+    CHECK(wait_for(g_entered, entered + 1));
+
+    // An edit of the stream: the running hash is cancelled and wiped
+    speculation_invalidate(3);
+    CHECK(speculation_adopt(3, 1) == 0);
+    CHECK(wait_for(g_finished, finished + 1));
+    sleep_ms(20);
+    CHECK(output_wiped());
+    CHECK(speculation_adopt(3, 1) == 0);
+
+    // Adopted first, an edit no longer matters
+    entered = g_entered.load();
+    CHECK(speculation_start(3, 2, TEXT, TEXT_LEN, held_hash));
+    CHECK(wait_for(g_entered, entered + 1));
+    uint64_t ticket = speculation_adopt(3, 2);
+    CHECK(ticket != 0);
+    speculation_invalidate(3);
+    g_release.store(true);
+    unsigned char out[KDF_OUT_BYTES], expected[KDF_OUT_BYTES];
+    CHECK(speculation_collect(ticket, out));
+    blake2s(expected, KDF_OUT_BYTES, NULL, 0, TEXT, TEXT_LEN);
+    CHECK(memcmp(out, expected, sizeof(out)) == 0);
+}
+
+static void check_drop() {
+    g_release.store(false);
+    int entered = g_entered.load(), finished = g_finished.load();
+    CHECK(speculation_start(4, 1, TEXT, TEXT_LEN, held_hash));
+    CHECK(wait_for(g_entered, entered + 1));
+    uint64_t ticket = speculation_adopt(4, 1);
+    CHECK(ticket != 0);
+
+    // An adopted slot is not replaced...
+    CHECK(!speculation_start(5, 1, TEXT, TEXT_LEN, held_hash));
+    // ...until its ticket is dropped: the hash is cancelled and wiped
+    speculation_drop(ticket);
+    CHECK(wait_for(g_finished, finished + 1));
+    unsigned char out[KDF_OUT_BYTES];
+    CHECK(!speculation_collect(ticket, out));
+    sleep_ms(20);
+    CHECK(output_wiped());
+
+    // A dropped ticket is stale once the slot is reused
+    g_release.store(true);
+    finished = g_finished.load();
+    CHECK(speculation_start(5, 1, TEXT, TEXT_LEN, held_hash));
+    CHECK(wait_for(g_finished, finished + 1));
+    speculation_drop(ticket);
+    uint64_t fresh = speculation_adopt(5, 1);
+    CHECK(fresh != 0 && fresh != ticket);
+    CHECK(speculation_collect(fresh, out));
+}
+
+static void check_cancel_all_race() {
+    unsigned char out[KDF_OUT_BYTES];
+    for (int round = 0; round < 20; round++) {
+        int finished = g_finished.load();
+        uint64_t stream = 100 + (uint64_t) round;
+        CHECK(speculation_start(stream, 1, TEXT, TEXT_LEN, kdf_hash));
+        // Cancel before, at and well into the run; adopted or not
+        uint64_t ticket = round % 2 ? speculation_adopt(stream, 1) : 0;
+        if (round % 4 >= 2) sleep_ms(round);
+
+        speculation_cancel_all();
+        // Nothing runs on return, and nothing is left to take
+        CHECK(g_finished.load() == g_entered.load());
+        CHECK(g_finished.load() <= finished + 1);
+        if (g_finished.load() == finished + 1) CHECK(output_wiped());
+        CHECK(speculation_adopt(stream, 1) == 0);
+        CHECK(!speculation_collect(ticket, out));
+    }
+}
+
+int main() {
+    check_done_adopted();
+    check_edit_cancels_running();
+    check_drop();
+    check_cancel_all_race();
+    return host_test_result("test_kdf_speculation");
+}
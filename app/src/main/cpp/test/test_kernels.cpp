@@ -0,0 +1,144 @@
+#include <cstring>
+#include <initializer_list>
+
+#include "cpu_dispatch.h"
+#include "host_test.h"
+#include "sealed_memory.h"
+#include "secure_util.h"
+#include "sha1.h"
+#include "sha256.h"
+
+// ========== DISPATCHED KERNELS ==========
+// Every variant the host CPU can run must agree with the portable one:
+// wipes zero exactly their range, compares find every single-bit
+// difference, ChaCha20 and the SHA block functions give the same bytes.
+// Variants the CPU lacks are skipped (cpu_dispatch_select() refuses them).
+
+static unsigned char g_input[5000];
+
+static void check_wipe_range(void (*wipe)(void *, size_t)) {
+    static unsigned char buf[2 * 4096 + 128];
+    for (size_t off : {0, 1, 13, 15, 16, 31, 63, 64, 65}) {
+        for (size_t len : {0, 1, 7, 15, 16, 31, 33, 64, 127, 128, 129, 300, 4096, 5000}) {
+            memset(buf, 0xAA, sizeof(buf));
+            wipe(buf + 64 + off, len);
+            for (size_t i = 0; i < sizeof(buf); i++) {
+                bool inside = i >= 64 + off && i < 64 + off + len;
+                if (buf[i] != (inside ? 0 : 0xAA)) {
+                    CHECK(buf[i] == (inside ? 0 : 0xAA));
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static void test_wipes() {
+    for (size_t i = 0; i < WIPE_KERNEL_COUNT; i++) {
+        if (!cpu_dispatch_select("wipe", WIPE_KERNELS[i].name)) continue;
+        check_wipe_range(secure_wipe_vectorized);
+    }
+    CHECK(cpu_dispatch_select("wipe", "auto"));
+
+    // Cache-aware variants, and secure_wipe() across its size thresholds
+    check_wipe_range(secure_wipe_nontemporal);
+    check_wipe_range(secure_wipe_flush);
+    check_wipe_range(secure_wipe);
+    size_t big = WIPE_NONTEMPORAL_MIN_BYTES + 4096 + 3;
+    unsigned char *p = (unsigned char *) malloc(big + 2);
+    memset(p, 0xAA, big + 2);
+    secure_wipe(p + 1, big);
+    CHECK(p[0] == 0xAA && p[big + 1] == 0xAA);
+    size_t nonzero = 0;
+    for (size_t i = 1; i <= big; i++) nonzero += p[i] != 0;
+    CHECK(nonzero == 0);
+    free(p);
+}
+
+static void test_compares() {
+    static unsigned char copy[4096];
+    for (size_t v = 0; v < COMPARE_KERNEL_COUNT; v++) {
+        if (!cpu_dispatch_select("compare", COMPARE_KERNELS[v].name)) continue;
+        for (size_t len : {0, 1, 15, 16, 17, 31, 32, 33, 64, 100, 4096}) {
+            memcpy(copy, g_input, len);
+            CHECK(secure_equal(copy, g_input, len));
+            for (size_t i = 0; i < len; i++) {
+                copy[i] ^= (unsigned char) (1u << (i % 8));
+                CHECK(!secure_equal(copy, g_input, len));
+                copy[i] = g_input[i];
+            }
+        }
+    }
+    CHECK(cpu_dispatch_select("compare", "auto"));
+}
+
+static void test_chacha20() {
+    static unsigned char ref[5000], out[5000];
+    for (size_t len : {0, 1, 63, 64, 65, 255, 256, 257, 511, 512, 513, 1000, 4999}) {
+        CHECK(cpu_dispatch_select("chacha20", CHACHA20_KERNELS[0].name));
+        memcpy(ref, g_input, len);
+        CHECK(sealed_xor_keystream(ref, len, 77));
+        for (size_t v = 1; v < CHACHA20_KERNEL_COUNT; v++) {
+            if (!cpu_dispatch_select("chacha20", CHACHA20_KERNELS[v].name)) continue;
+            memcpy(out, g_input, len);
+            CHECK(sealed_xor_keystream(out, len, 77));
+            CHECK(memcmp(out, ref, len) == 0);
+        }
+    }
+    CHECK(cpu_dispatch_select("chacha20", "auto"));
+
+    // Seal / unseal round trip on the bound variant
+    SealedSecret secret;
+    CHECK(sealed_seal(&secret, g_input, 300));
+    CHECK(memcmp(secret.data, g_input, 300) != 0);
+    SealedSlot *slot = NULL;
+    void *plain = sealed_unseal(&secret, &slot);
+    CHECK(plain && memcmp(plain, g_input, 300) == 0);
+    sealed_reseal(slot);
+    sealed_free(&secret);
+}
+
+static void test_sha() {
+    for (size_t len : {0, 3, 55, 56, 63, 64, 119, 1000, 4999}) {
+        unsigned char ref1[20], ref256[32], d1[20], d256[32];
+        CHECK(cpu_dispatch_select("sha1", SHA1_KERNELS[0].name));
+        CHECK(cpu_dispatch_select("sha256", SHA256_KERNELS[0].name));
+        sha1(ref1, g_input, len);
+        sha256(ref256, g_input, len);
+        for (size_t v = 1; v < SHA1_KERNEL_COUNT; v++) {
+            if (!cpu_dispatch_select("sha1", SHA1_KERNELS[v].name)) continue;
+            sha1(d1, g_input, len);
+            CHECK(memcmp(d1, ref1, 20) == 0);
+        }
+        for (size_t v = 1; v < SHA256_KERNEL_COUNT; v++) {
+            if (!cpu_dispatch_select("sha256", SHA256_KERNELS[v].name)) continue;
+            sha256(d256, g_input, len);
+            CHECK(memcmp(d256, ref256, 32) == 0);
+        }
+    }
+    CHECK(cpu_dispatch_select("sha1", "auto"));
+    CHECK(cpu_dispatch_select("sha256", "auto"));
+}
+
+static void test_selection() {
+    CHECK(!cpu_dispatch_select("nope", "auto"));
+    CHECK(!cpu_dispatch_select("sha1", "nope"));
+    CHECK(cpu_dispatch_configure("sha1=portable,wipe=scalar,bogus,chacha20=x") == 2);
+    CHECK(strcmp(cpu_dispatch_bound(KERNEL_SHA1), "portable") == 0);
+    CHECK(strcmp(cpu_dispatch_bound(KERNEL_WIPE), "scalar") == 0);
+    for (const char *kernel : {"wipe", "compare", "chacha20", "sha1", "sha256", "sha256x8"}) {
+        CHECK(cpu_dispatch_select(kernel, "auto"));
+    }
+}
+
+int main() {
+    unsigned seed = 1;
+    for (size_t i = 0; i < sizeof(g_input); i++) g_input[i] = (unsigned char) rand_r(&seed);
+
+    test_wipes();
+    test_compares();
+    test_chacha20();
+    test_sha();
+    test_selection();
+    return host_test_result("test_kernels");
+}
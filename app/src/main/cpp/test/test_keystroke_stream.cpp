@@ -0,0 +1,104 @@
+#include <jni.h>
+
+#include <cstring>
+#include <vector>
+
+#include "credential_text.h"
+#include "host_test.h"
+#include "keystroke_stream.h"
+
+// ========== KEYSTROKE STREAMS ==========
+// Random edit sequences (ASCII, combining marks, Hangul jamo, fullwidth
+// forms, ligatures, surrogate pairs, deletes) must give the same digest as
+// normalizing the final text in one go, and so must a stream that went
+// over KEYSTROKE_MAX_UNITS and was trimmed back. Edits still in the ring
+// when wipeAllSecrets() runs are applied before the wipe, not after it.
+
+extern "C" jlong Java_com_example_fuzzme_1v3_NativeBridge_wipeAllSecrets(JNIEnv *, jclass);
+
+static const uint16_t ALPHABET[] = {
+        'a', 'e', 'x', '1', 0x0301, 0x0308, 0x00E9, 0xFF41, 0xFB01,
+        0xAC00, 0x1100, 0x1161, 0xD83D, 0xDE00, 0x212B, 0x3099, 0x304B};
+
+/**
+ * Digest of a whole text, normalized at once
+ * @return false where the stream must be invalid too
+ */
+static bool reference_digest(const std::vector<uint16_t> &units, unsigned char *out) {
+    if (units.size() > KEYSTROKE_MAX_UNITS) return false;
+    std::vector<unsigned char> utf8(credential_utf8_capacity(units.size()) + 1);
+    std::vector<uint32_t> scratch(credential_scratch_capacity(units.size()) + 1);
+    long n = credential_to_utf8(units.data(), units.size(), utf8.data(), utf8.size(),
+                                scratch.data(), scratch.size());
+    return n >= 0 && keystroke_digest_bytes(utf8.data(), (size_t) n, out);
+}
+
+static void check_digest(uint64_t stream, const std::vector<uint16_t> &model) {
+    unsigned char got[BLAKE2S_OUT_BYTES], want[BLAKE2S_OUT_BYTES];
+    keystroke_sync();
+    bool valid = keystroke_digest(stream, got);
+    CHECK(valid == reference_digest(model, want));
+    if (valid) CHECK(memcmp(got, want, sizeof(got)) == 0);
+}
+
+int main() {
+    uint64_t stream = keystroke_open();
+    CHECK(stream != 0);
+    if (!stream) return host_test_result("test_keystroke_stream");
+
+    unsigned seed = 1;
+    const size_t alphabetLen = sizeof(ALPHABET) / sizeof(ALPHABET[0]);
+    for (int round = 0; round < 2000; round++) {
+        std::vector<uint16_t> model;
+        keystroke_clear(stream);
+        int edits = rand_r(&seed) % 40;
+        for (int e = 0; e < edits; e++) {
+            int op = rand_r(&seed) % 10;
+            if (op < 7) {
+                uint16_t unit = ALPHABET[rand_r(&seed) % alphabetLen];
+                keystroke_append(stream, unit);
+                model.push_back(unit);
+            } else if (op < 9) {
+                size_t k = 1 + rand_r(&seed) % 3;
+                keystroke_delete(stream, (uint32_t) k);
+                model.resize(model.size() > k ? model.size() - k : 0);
+            } else {
+                check_digest(stream, model);
+            }
+        }
+        check_digest(stream, model);
+    }
+
+    // Over the limit the stream is invalid, trimmed back it is valid again
+    std::vector<uint16_t> model;
+    keystroke_clear(stream);
+    for (uint32_t i = 0; i < KEYSTROKE_MAX_UNITS + 44; i++) {
+        keystroke_append(stream, 'a');
+        model.push_back('a');
+    }
+    unsigned char digest[BLAKE2S_OUT_BYTES];
+    keystroke_sync();
+    CHECK(!keystroke_digest(stream, digest));
+    keystroke_delete(stream, 44);
+    model.resize(KEYSTROKE_MAX_UNITS);
+    check_digest(stream, model);
+
+    // Pause wipe with edits in flight: none of them outlives it
+    keystroke_clear(stream);
+    for (int i = 0; i < 200; i++) keystroke_append(stream, 'p');
+    CHECK(Java_com_example_fuzzme_1v3_NativeBridge_wipeAllSecrets(NULL, NULL) > 0);
+    for (int i = 0; i < 5; i++) keystroke_append(stream, 'q');
+    keystroke_sync();
+    CHECK(!keystroke_digest(stream, digest));
+    keystroke_clear(stream);
+    model.clear();
+    check_digest(stream, model);
+
+    keystroke_close(stream);
+    keystroke_sync();
+    CHECK(!keystroke_append(stream, 'a'));
+    uint64_t reopened = keystroke_open();
+    CHECK(reopened != 0 && reopened != stream);
+    keystroke_close(reopened);
+    return host_test_result("test_keystroke_stream");
+}
@@ -0,0 +1,116 @@
+#include <atomic>
+#include <cstring>
+#include <pthread.h>
+#include <vector>
+
+#include "host_test.h"
+#include "lazy_region.h"
+#include "secret_registry.h"
+#include "secure_util.h"
+
+// ========== LAZY REGIONS ==========
+// Contents must read back right on first touch, after explicit and idle
+// drops and while another thread keeps reading through drops. Resident
+// pages must be reachable by a pause wipe, and dropped pages must leave the
+// registry. Without userfaultfd only the eager fallback is checked.
+
+static const size_t BLOB = 37 * 4096 + 123;
+
+static std::vector<unsigned char> g_blob;
+
+static bool matches(const LazyRegion *region) {
+    return memcmp(lazy_region_data(region), g_blob.data(), g_blob.size()) == 0;
+}
+
+static void test_drops(LazyRegion *region) {
+    const size_t ps = page_size();
+    const volatile unsigned char *data = (const unsigned char *) lazy_region_data(region);
+
+    CHECK(lazy_region_resident(region) == 0);
+    CHECK(data[5 * ps + 7] == g_blob[5 * ps + 7]);
+    CHECK(lazy_region_resident(region) == ps);
+
+    CHECK(matches(region));
+    CHECK(lazy_region_resident(region) == BLOB);
+
+    // Every resident page is registered plaintext
+    size_t wiped = secret_registry_wipe_all(SECRET_CLASS_PLAINTEXT);
+    CHECK(wiped >= page_round_up(BLOB));
+    bool zero = true;
+    for (size_t i = 0; i < BLOB; i++) zero &= data[i] == 0;
+    CHECK(zero);
+
+    // Dropping brings the contents back and takes the pages out of the registry
+    lazy_region_drop_all(region);
+    CHECK(lazy_region_resident(region) == 0);
+    CHECK(secret_registry_wipe_all(SECRET_CLASS_PLAINTEXT) < page_round_up(BLOB));
+    CHECK(lazy_region_resident(region) == 0);
+    CHECK(matches(region));
+    lazy_region_drop_all(region);
+}
+
+static void test_idle_drop() {
+    LazyRegion *region = lazy_region_create(g_blob.data(), BLOB, 50);
+    CHECK(region != NULL);
+    if (!region) return;
+    CHECK(matches(region));
+    for (int waited = 0; waited < 500 && lazy_region_resident(region) > 0; waited++) usleep(10000);
+    CHECK(lazy_region_resident(region) == 0);
+    CHECK(matches(region));
+    lazy_region_destroy(region);
+}
+
+static std::atomic<bool> g_stop{false};
+static std::atomic<int> g_mismatches{0};
+
+static void *reader_main(void *arg) {
+    const LazyRegion *region = (const LazyRegion *) arg;
+    const volatile unsigned char *data = (const unsigned char *) lazy_region_data(region);
+    unsigned seed = 3;
+    while (!g_stop.load()) {
+        size_t i = rand_r(&seed) % BLOB;
+        if (data[i] != g_blob[i]) g_mismatches.fetch_add(1);
+    }
+    return NULL;
+}
+
+static void test_concurrent_drops() {
+    LazyRegion *region = lazy_region_create(g_blob.data(), BLOB, 0);
+    CHECK(region != NULL);
+    if (!region) return;
+    pthread_t reader;
+    pthread_create(&reader, NULL, reader_main, region);
+    for (int i = 0; i < 200; i++) {
+        usleep(500);
+        lazy_region_drop_all(region);
+    }
+    g_stop.store(true);
+    pthread_join(reader, NULL);
+    CHECK(g_mismatches.load() == 0);
+    lazy_region_destroy(region);
+}
+
+int main() {
+    unsigned seed = 1;
+    g_blob.resize(BLOB);
+    for (auto &b : g_blob) b = (unsigned char) (1 + rand_r(&seed) % 255);
+
+    LazyRegion *region = lazy_region_create(g_blob.data(), BLOB, 0);
+    CHECK(region != NULL);
+    if (!region) return host_test_result("test_lazy_region");
+    CHECK(lazy_region_len(region) == BLOB);
+
+    if (!lazy_region_is_lazy(region)) {
+        printf("userfaultfd unavailable: eager fallback only\n");
+        CHECK(matches(region));
+        CHECK(secret_registry_wipe_all(SECRET_CLASS_PLAINTEXT) >= BLOB);
+        lazy_region_destroy(region);
+        return host_test_result("test_lazy_region");
+    }
+
+    test_drops(region);
+    lazy_region_destroy(region);
+    test_idle_drop();
+    test_concurrent_drops();
+    return host_test_result("test_lazy_region");
+}
@@ -0,0 +1,165 @@
+#include <cstring>
+#include <sys/resource.h>
+
+#include "host_test.h"
+#include "lock_budget.h"
+#include "secret_registry.h"
+#include "secure_util.h"
+#include "wipe_queue.h"
+
+// ========== LOCK BUDGET UNDER RLIMIT_MEMLOCK ==========
+// The budget reads RLIMIT_MEMLOCK once per process, so every limit runs in
+// its own forked child. Denied requests must still get usable memory, lower
+// priorities must lose their lock first and freeing must give the budget
+// back. Mappings waiting in the wipe queue stay reachable by emergency
+// wipes, and a cached one only goes to a priority whose ceiling admits it.
+
+static const size_t REGION = 8192;
+
+static bool set_memlock(rlim_t limit) {
+    struct rlimit rl = {limit, limit};
+    return setrlimit(RLIMIT_MEMLOCK, &rl) == 0;
+}
+
+/**
+ * Allocates count regions at prio, checks they are usable
+ * @return How many of them are locked
+ */
+static int alloc_all(LockedRegion *regions, int count, LockPriority prio) {
+    int locked = 0;
+    for (int i = 0; i < count; i++) {
+        CHECK(locked_alloc(&regions[i], REGION, prio));
+        memset(regions[i].ptr, 0x5a, REGION);
+        locked += regions[i].locked;
+    }
+    return locked;
+}
+
+static void free_all(LockedRegion *regions, int count) {
+    for (int i = 0; i < count; i++) locked_free(&regions[i]);
+}
+
+static void small_limit() {
+    const size_t limit = 64 * 1024;
+    if (!set_memlock(limit)) _exit(77);
+
+    LockBudgetInfo info;
+    lock_budget_info(&info);
+    CHECK(info.limitBytes == limit);
+    CHECK(info.lockedBytes == 0);
+
+    // BULK stops at half the limit, the rest runs unlocked
+    LockedRegion bulk[16];
+    int bulkLocked = alloc_all(bulk, 16, LOCK_PRIO_BULK);
+    lock_budget_info(&info);
+    CHECK(bulkLocked == (int) (limit / 2 / REGION));
+    CHECK(info.lockedBytes == (uint64_t) bulkLocked * REGION);
+    CHECK(info.deniedRequests == (uint64_t) (16 - bulkLocked));
+    CHECK(info.pressurePermille == 500);
+
+    // NORMAL still fits up to 75%, CRITICAL up to the whole limit
+    LockedRegion normal[4], critical[4];
+    int normalLocked = alloc_all(normal, 4, LOCK_PRIO_NORMAL);
+    CHECK(normalLocked == (int) ((limit / 4 * 3 - limit / 2) / REGION));
+    int criticalLocked = alloc_all(critical, 4, LOCK_PRIO_CRITICAL);
+    CHECK(criticalLocked == (int) (limit / 4 / REGION));
+    lock_budget_info(&info);
+    CHECK(info.lockedBytes == limit);
+    CHECK(info.pressurePermille == 1000);
+
+    // A full budget still serves small secrets, unlocked
+    LockedRegion key;
+    CHECK(locked_alloc(&key, 32, LOCK_PRIO_CRITICAL, SECRET_CLASS_KEY));
+    CHECK(!key.locked);
+    memset(key.ptr, 1, 32);
+    locked_free(&key);
+
+    // Freeing gives the budget back and BULK locks again
+    free_all(critical, 4);
+    free_all(normal, 4);
+    free_all(bulk, 16);
+    lock_budget_info(&info);
+    CHECK(info.lockedBytes == 0);
+
+    LockedRegion again;
+    CHECK(locked_alloc(&again, REGION, LOCK_PRIO_BULK));
+    CHECK(again.locked);
+    locked_free(&again);
+}
+
+static void zero_limit() {
+    if (!set_memlock(0)) _exit(77);
+
+    // Nothing can be locked, everything still works
+    LockedRegion regions[4];
+    CHECK(alloc_all(regions, 4, LOCK_PRIO_CRITICAL) == 0);
+    LockedRegion small[64];
+    for (int i = 0; i < 64; i++) {
+        CHECK(locked_alloc(&small[i], 16 + (size_t) i * 4, LOCK_PRIO_CRITICAL));
+        CHECK(!small[i].locked);
+        memset(small[i].ptr, i, small[i].len);
+    }
+    for (int i = 0; i < 64; i++) {
+        const unsigned char *p = (const unsigned char *) small[i].ptr;
+        CHECK(p[0] == i && p[small[i].len - 1] == i);
+        locked_free(&small[i]);
+    }
+    free_all(regions, 4);
+
+    LockBudgetInfo info;
+    lock_budget_info(&info);
+    CHECK(info.lockedBytes == 0);
+    CHECK(info.deniedRequests >= 4 + 64);
+    CHECK(info.pressurePermille == 0);
+}
+
+static void deferred_wipes() {
+    const size_t limit = 256 * 1024;
+    const size_t big = 192 * 1024;
+    if (!set_memlock(limit)) _exit(77);
+    wipe_queue_set_enabled(true);
+
+    // Queued (PROT_NONE) but still registered: a pause wipe reaches it
+    LockedRegion region;
+    CHECK(locked_alloc(&region, big, LOCK_PRIO_CRITICAL));
+    CHECK(region.locked);
+    memset(region.ptr, 0x5a, big);
+    locked_free(&region);
+    CHECK(secret_registry_wipe_all(SECRET_CLASS_PLAINTEXT) >= big);
+
+    // Once wiped it is cached, locked and still counted: over BULK's ceiling
+    usleep(WIPE_QUEUE_MAX_LAG_MS * 3 * 1000);
+    LockBudgetInfo info;
+    lock_budget_info(&info);
+    CHECK(info.lockedBytes == big);
+    LockedRegion bulk;
+    CHECK(locked_alloc(&bulk, big, LOCK_PRIO_BULK));
+    CHECK(!bulk.locked);
+    LockedRegion critical;
+    CHECK(locked_alloc(&critical, big, LOCK_PRIO_CRITICAL));
+    CHECK(critical.locked);
+    lock_budget_info(&info);
+    CHECK(info.lockedBytes == big);
+
+    locked_free(&bulk);
+    locked_free(&critical);
+    wipe_queue_set_enabled(false);
+    lock_budget_info(&info);
+    CHECK(info.lockedBytes == 0);
+}
+
+int main() {
+    void (*cases[])() = {small_limit, zero_limit, deferred_wipes};
+    const char *names[] = {"64 KiB limit", "zero limit", "deferred wipes"};
+    for (int i = 0; i < 3; i++) {
+        int code = 0;
+        int sig = host_run_child(cases[i], &code);
+        if (code == 77) {
+            printf("%s: cannot set RLIMIT_MEMLOCK, skipped\n", names[i]);
+            continue;
+        }
+        if (sig || code) fprintf(stderr, "%s: failed (signal %d, exit %d)\n", names[i], sig, code);
+        CHECK(sig == 0 && code == 0);
+    }
+    return host_test_result("test_lock_budget");
+}
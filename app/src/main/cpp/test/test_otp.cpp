@@ -0,0 +1,243 @@
+#include <jni.h>
+
+#include <cstring>
+#include <ctime>
+
+#include "fuzz/fake_jni.h"
+#include "host_test.h"
+#include "keystroke_stream.h"
+#include "otp.h"
+#include "password_kdf.h"
+
+// ========== ONE-TIME PASSWORDS ==========
+// Codes match the HOTP vectors of RFC 4226 appendix D and the SHA-1 and
+// SHA-256 TOTP vectors of RFC 6238 appendix B; verification accepts a code
+// once and refuses malformed input; base32 seeds decode as in otpauth URIs.
+// Through the JNI entry points there is no second factor until a staged
+// seed is confirmed with a current code, and confirming a new seed retires
+// the old one. A submitted login reports one result for the credentials and
+// the code, and any attempt uses the code up.
+
+extern "C" {
+jboolean Java_com_example_fuzzme_1v3_NativeBridge_provisionOtp(JNIEnv *, jclass, jcharArray, jint,
+                                                               jint, jint, jint, jint);
+jboolean Java_com_example_fuzzme_1v3_NativeBridge_isOtpEnrolled(JNIEnv *, jclass);
+jboolean Java_com_example_fuzzme_1v3_NativeBridge_verifyOtp(JNIEnv *, jclass, jcharArray, jint);
+jboolean Java_com_example_fuzzme_1v3_NativeBridge_confirmOtp(JNIEnv *, jclass, jcharArray, jint);
+jboolean Java_com_example_fuzzme_1v3_NativeBridge_setPasswordKdfCost(JNIEnv *, jclass, jint, jint);
+jlong Java_com_example_fuzzme_1v3_NativeBridge_submitCheckCredentials(
+        JNIEnv *, jclass, jcharArray, jcharArray, jint, jint, jlong, jcharArray, jint, jobject);
+jlong Java_com_example_fuzzme_1v3_NativeBridge_submitCheckStreamedCredentials(
+        JNIEnv *, jclass, jlong, jlong, jlong, jcharArray, jint, jobject);
+}
+#define JNI_FN(name) Java_com_example_fuzzme_1v3_NativeBridge_##name
+
+static const char SEED_SHA1[] = "12345678901234567890";
+static const char SEED_SHA256[] = "12345678901234567890123456789012";
+
+static const uint32_t HOTP_CODES[] = {
+        755224, 287082, 359152, 969429, 338314, 254676, 287922, 162583, 399871, 520489
+};
+
+struct TotpVector {
+    uint64_t time;
+    uint32_t sha1;
+    uint32_t sha256;
+};
+
+static const TotpVector TOTP_VECTORS[] = {
+        {59, 94287082, 46119246},
+        {1111111109, 7081804, 68084774},
+        {1111111111, 14050471, 67062674},
+        {1234567890, 89005924, 91819424},
+        {2000000000, 69279037, 90698825},
+        {20000000000ull, 65353130, 77737706},
+};
+
+static bool verify(OtpKey *key, const char *code, uint64_t counter) {
+    return otp_verify(key, (const unsigned char *) code, strlen(code), counter);
+}
+
+static jcharArray chars(const char *text, int slot = 0) {
+    jchar units[64];
+    size_t len = strlen(text);
+    for (size_t i = 0; i < len; i++) units[i] = (jchar) text[i];
+    return fake_char_array(slot, units, len, false, false);
+}
+
+/**
+ * Code of a seed at a time step from now
+ */
+static void code_text(const OtpKey *key, int64_t steps, char text[16]) {
+    uint32_t code;
+    hotp_codes(key, totp_counter(key, (uint64_t) time(NULL)) + steps, 1, &code);
+    snprintf(text, 16, "%0*u", key->digits, code);
+}
+
+/**
+ * Calls a code-checking entry point with the code of a seed at a time step
+ * from now
+ */
+static bool call_with_code(jboolean (*fn)(JNIEnv *, jclass, jcharArray, jint),
+                           const OtpKey *key, int64_t steps) {
+    char text[16];
+    code_text(key, steps, text);
+    return fn(fake_jni_env(), NULL, chars(text), (jint) strlen(text));
+}
+
+/**
+ * Submits a login with a code as typed (NULL: none) and waits for its result
+ * @return ok, -1 if it was not submitted or never called back
+ */
+static int login(const char *user, const char *pass, const char *code) {
+    jcharArray jcode = code ? chars(code, 2) : NULL;
+    jlong handle = JNI_FN(submitCheckCredentials)(
+            fake_jni_env(), NULL, chars(user, 0), chars(pass, 1), (jint) strlen(user),
+            (jint) strlen(pass), 0, jcode, code ? (jint) strlen(code) : 0,
+            fake_result_callback());
+    return handle ? fake_wait_result(handle) : -1;
+}
+
+static uint64_t stream_of(const char *text) {
+    uint64_t stream = keystroke_open();
+    for (const char *c = text; stream && *c; c++) keystroke_append(stream, (uint16_t) *c);
+    return stream;
+}
+
+/**
+ * login() with every field streamed
+ */
+static int login_streamed(const char *user, const char *pass, const char *code) {
+    uint64_t streams[] = {stream_of(user), stream_of(pass), stream_of(code)};
+    jlong handle = 0;
+    if (streams[0] && streams[1] && streams[2]) {
+        handle = JNI_FN(submitCheckStreamedCredentials)(
+                fake_jni_env(), NULL, (jlong) streams[0], (jlong) streams[1], (jlong) streams[2],
+                NULL, 0, fake_result_callback());
+    }
+    for (uint64_t stream : streams) keystroke_close(stream);
+    return handle ? fake_wait_result(handle) : -1;
+}
+
+static bool provision(const char *base32, int hash) {
+    return JNI_FN(provisionOtp)(fake_jni_env(), NULL, chars(base32), (jint) strlen(base32), hash,
+                                6, 30, 1);
+}
+
+static void test_enrollment() {
+    fake_jni_init();
+    // The logins below are about the code: cheap password hashes will do
+    CHECK(JNI_FN(setPasswordKdfCost)(NULL, NULL, (jint) KDF_MIN_MEMORY_KIB, 1));
+    OtpKey first, second;
+    otp_key_init(&first, HMAC_SHA1, SEED_SHA1, strlen(SEED_SHA1), 6, 30, 1);
+    otp_key_init(&second, HMAC_SHA256, SEED_SHA256, strlen(SEED_SHA256), 6, 30, 1);
+
+    // Nothing built in: no code is valid until a seed is confirmed, and
+    // logins don't need one
+    CHECK(!JNI_FN(isOtpEnrolled)(NULL, NULL));
+    CHECK(!call_with_code(JNI_FN(verifyOtp), &first, 0));
+    CHECK(login("admin", "admin", NULL) == 1);
+    CHECK(login("admin", "admin", "123456") == 1);
+    CHECK(login("admin", "wrong", NULL) == 0);
+    CHECK(!provision("GE1Q", 0));
+    CHECK(provision("GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ", 0));
+    CHECK(!JNI_FN(isOtpEnrolled)(NULL, NULL));
+    CHECK(!call_with_code(JNI_FN(verifyOtp), &first, 0));
+    CHECK(!call_with_code(JNI_FN(confirmOtp), &second, 0));
+    CHECK(!JNI_FN(isOtpEnrolled)(NULL, NULL));
+
+    // The confirming code is used up; later steps in the window are not
+    CHECK(call_with_code(JNI_FN(confirmOtp), &first, 0));
+    CHECK(JNI_FN(isOtpEnrolled)(NULL, NULL));
+    CHECK(!call_with_code(JNI_FN(verifyOtp), &first, 0));
+    CHECK(call_with_code(JNI_FN(verifyOtp), &first, 1));
+
+    // A staged seed leaves the one in use alone until it is confirmed
+    CHECK(provision("GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQGEZA", 1));
+    CHECK(!call_with_code(JNI_FN(verifyOtp), &second, 0));
+    CHECK(call_with_code(JNI_FN(confirmOtp), &second, 0));
+    CHECK(!call_with_code(JNI_FN(confirmOtp), &second, 1));
+    CHECK(!call_with_code(JNI_FN(verifyOtp), &first, 1));
+    CHECK(call_with_code(JNI_FN(verifyOtp), &second, 1));
+    fake_jni_check_balanced();
+}
+
+static void test_login_code() {
+    // A wide window leaves codes to spend (the enrolled ones are used up)
+    OtpKey key;
+    otp_key_init(&key, HMAC_SHA1, SEED_SHA1, strlen(SEED_SHA1), 6, 30, 10);
+    const char *seed = "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ";
+    CHECK(JNI_FN(provisionOtp)(fake_jni_env(), NULL, chars(seed), (jint) strlen(seed), 0, 6, 30,
+                               10));
+    CHECK(call_with_code(JNI_FN(confirmOtp), &key, -10));
+
+    // One result: a wrong code, or none, reads like a wrong password
+    char text[16];
+    code_text(&key, 20, text);
+    CHECK(login("admin", "admin", text) == 0);
+    CHECK(login("admin", "admin", NULL) == 0);
+    CHECK(login("admin", "admin", "") == 0);
+    code_text(&key, -8, text);
+    CHECK(login("admin", "wrong", text) == 0);
+    CHECK(login("wrong", "admin", text) == 0);
+
+    // That attempt used the code up
+    CHECK(login("admin", "admin", text) == 0);
+    code_text(&key, -7, text);
+    CHECK(login("admin", "admin", text) == 1);
+    CHECK(login("admin", "admin", text) == 0);
+
+    // Streamed fields, code included
+    code_text(&key, 20, text);
+    CHECK(login_streamed("admin", "admin", text) == 0);
+    code_text(&key, -6, text);
+    CHECK(login_streamed("admin", "wrong", text) == 0);
+    code_text(&key, -5, text);
+    CHECK(login_streamed("admin", "admin", text) == 1);
+    fake_jni_check_balanced();
+}
+
+int main() {
+    OtpKey hotp;
+    CHECK(otp_key_init(&hotp, HMAC_SHA1, SEED_SHA1, strlen(SEED_SHA1), 6, OTP_DEFAULT_PERIOD,
+                       OTP_DEFAULT_WINDOW));
+    uint32_t codes[10];
+    hotp_codes(&hotp, 0, 10, codes);
+    for (int i = 0; i < 10; i++) CHECK(codes[i] == HOTP_CODES[i]);
+
+    OtpKey sha1, sha256;
+    CHECK(otp_key_init(&sha1, HMAC_SHA1, SEED_SHA1, strlen(SEED_SHA1), 8, 30, 0));
+    CHECK(otp_key_init(&sha256, HMAC_SHA256, SEED_SHA256, strlen(SEED_SHA256), 8, 30, 0));
+    for (const TotpVector &v : TOTP_VECTORS) {
+        uint32_t code;
+        hotp_codes(&sha1, totp_counter(&sha1, v.time), 1, &code);
+        CHECK(code == v.sha1);
+        hotp_codes(&sha256, totp_counter(&sha256, v.time), 1, &code);
+        CHECK(code == v.sha256);
+    }
+
+    // Window of one step either side; a counter is good once
+    CHECK(!verify(&hotp, "755224", 5));
+    CHECK(verify(&hotp, "254676", 4));
+    CHECK(!verify(&hotp, "254676", 4));
+    CHECK(!verify(&hotp, "338314", 5));
+    CHECK(!verify(&hotp, "28792", 6));
+    CHECK(!verify(&hotp, "28792x", 6));
+    CHECK(verify(&hotp, "287922", 6));
+
+    // Out-of-range parameters
+    OtpKey bad;
+    CHECK(!otp_key_init(&bad, HMAC_SHA1, SEED_SHA1, strlen(SEED_SHA1), OTP_MAX_DIGITS + 1, 30, 1));
+    CHECK(!otp_key_init(&bad, HMAC_SHA1, SEED_SHA1, strlen(SEED_SHA1), 6, 30, OTP_MAX_WINDOW + 1));
+
+    // RFC 4648 base32 of the SHA-1 seed, lower case, spaced and padded
+    const char *b32 = "gezdgnbvgy3tqojq GEZDGNBVGY3TQOJQ====";
+    unsigned char seed[32];
+    CHECK(otp_base32_decode((const unsigned char *) b32, strlen(b32), seed, sizeof(seed)) == 20);
+    CHECK(memcmp(seed, SEED_SHA1, 20) == 0);
+    CHECK(otp_base32_decode((const unsigned char *) "GE1Q", 4, seed, sizeof(seed)) == -1);
+
+    test_enrollment();
+    test_login_code();
+    return host_test_result("test_otp");
+}
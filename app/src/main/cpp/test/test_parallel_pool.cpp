@@ -0,0 +1,87 @@
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include "host_test.h"
+#include "parallel_pool.h"
+
+// ========== PARALLEL POOL ==========
+// Every index of a job runs exactly once, with or without workers and from
+// inside another job's item; scratch reaches every item zeroed; oversized
+// jobs are refused; parallel_trim() gives the kept scratch back and later
+// jobs allocate it again.
+
+static const size_t MAX_ITEMS = (size_t) 1 << 20;
+static const size_t SCRATCH = 64;
+
+static std::atomic<uint32_t> g_hits[MAX_ITEMS];
+static std::atomic<int> g_dirtyScratch{0};
+static std::atomic<int> g_nestedFailures{0};
+
+static void count_item(void *, size_t index, void *scratch, size_t scratchLen) {
+    const unsigned char *bytes = (const unsigned char *) scratch;
+    for (size_t k = 0; k < scratchLen; k++) {
+        if (bytes[k]) {
+            g_dirtyScratch++;
+            break;
+        }
+    }
+    // Dirty it: the pool must wipe it before the next item
+    memset(scratch, 0xAB, scratchLen);
+    g_hits[index]++;
+}
+
+static const size_t NESTED_BASE = 1000;
+static const size_t NESTED_ITEMS = 16;
+
+static void inner_item(void *arg, size_t index, void *scratch, size_t scratchLen) {
+    count_item(NULL, *(const size_t *) arg + index, scratch, scratchLen);
+}
+
+static void nested_item(void *, size_t index, void *, size_t) {
+    // Runs serially on this thread; counts land in a block of its own
+    size_t base = NESTED_BASE + index * NESTED_ITEMS;
+    if (!parallel_for(NESTED_ITEMS, inner_item, &base, 0, SCRATCH)) g_nestedFailures++;
+}
+
+/**
+ * Runs count_item over n indices, checks each ran exactly once
+ */
+static bool run_counted(size_t n) {
+    for (size_t i = 0; i < n; i++) g_hits[i] = 0;
+    if (!parallel_for(n, count_item, NULL, 0, SCRATCH)) return false;
+    for (size_t i = 0; i < n; i++) {
+        if (g_hits[i] != 1) return false;
+    }
+    return true;
+}
+
+int main() {
+    CHECK(parallel_concurrency() >= 1);
+    CHECK(parallel_for(0, count_item, NULL, 0, SCRATCH));
+    CHECK(!parallel_for((size_t) UINT32_MAX + 1, count_item, NULL, 0, SCRATCH));
+
+    for (size_t n : {(size_t) 1, (size_t) 7, (size_t) 1000, MAX_ITEMS}) CHECK(run_counted(n));
+
+    // Caller alone
+    parallel_set_limit(1);
+    CHECK(run_counted(1000));
+    parallel_set_limit(0);
+
+    // Jobs started from inside an item
+    size_t nestedEnd = NESTED_BASE + 8 * NESTED_ITEMS;
+    for (size_t i = NESTED_BASE; i < nestedEnd; i++) g_hits[i] = 0;
+    CHECK(parallel_for(8, nested_item, NULL, 1, 0));
+    CHECK(g_nestedFailures == 0);
+    for (size_t i = NESTED_BASE; i < nestedEnd; i++) CHECK(g_hits[i] == 1);
+
+    CHECK(g_dirtyScratch == 0);
+
+    // Scratch kept since the last job goes back, and comes again on demand
+    CHECK(parallel_trim() > 0);
+    CHECK(parallel_trim() == 0);
+    CHECK(run_counted(1000));
+    CHECK(g_dirtyScratch == 0);
+    CHECK(parallel_trim() > 0);
+    return host_test_result("test_parallel_pool");
+}
@@ -0,0 +1,150 @@
+#include <atomic>
+#include <cstring>
+#include <pthread.h>
+
+#include "host_test.h"
+#include "password_kdf.h"
+
+// ========== PASSWORD KDF ==========
+// password_kdf() matches known answers computed by an independent model of
+// the construction (BLAKE2s Balloon hashing, delta 3, as documented in
+// password_kdf.cpp), is deterministic, depends on every input, rejects
+// out-of-range costs, and gives up (without writing out) once cancelled,
+// whether the flag was set before or during the run.
+
+struct KdfVector {
+    const char *password;
+    unsigned char saltStart;    // Salt bytes saltStart, saltStart + step, ...
+    unsigned char saltStep;
+    uint32_t memoryKiB;
+    uint32_t passes;
+    const char *hash;
+};
+
+static const KdfVector VECTORS[] = {
+        {"password", 0, 1, 1, 2,
+         "c1f761b8a94131a50e83968ffc8a4ce63229e92cae02d9458f78fbae4764c0a0"},
+        {"", 0, 1, 1, 1,
+         "3e9d8c53a920f09243fb3d09ae177c9d1be7514a56a36bc92026b5c96b9b90f6"},
+        {"correct horse", 0, 0, 8, 3,
+         "bdec6a349dcb3ec25a1b0850e2facc963bf8c354c092080f4850f4c1c654fbb8"},
+};
+
+static void from_hex(const char *hex, unsigned char *out) {
+    for (size_t i = 0; hex[2 * i] && hex[2 * i + 1]; i++) {
+        unsigned byte;
+        sscanf(hex + 2 * i, "%2x", &byte);
+        out[i] = (unsigned char) byte;
+    }
+}
+
+static PasswordKdfParams params_of(unsigned char saltStart, unsigned char saltStep,
+                                   uint32_t memoryKiB, uint32_t passes) {
+    PasswordKdfParams params;
+    for (size_t i = 0; i < KDF_SALT_BYTES; i++) {
+        params.salt[i] = (unsigned char) (saltStart + i * saltStep);
+    }
+    params.memoryKiB = memoryKiB;
+    params.passes = passes;
+    return params;
+}
+
+static void check_vectors() {
+    for (const KdfVector &v : VECTORS) {
+        PasswordKdfParams params = params_of(v.saltStart, v.saltStep, v.memoryKiB, v.passes);
+        unsigned char expected[KDF_OUT_BYTES], out[KDF_OUT_BYTES];
+        from_hex(v.hash, expected);
+        CHECK(password_kdf(v.password, strlen(v.password), &params, NULL, out));
+        if (memcmp(out, expected, sizeof(out)) != 0) {
+            fprintf(stderr, "\"%s\", %u KiB, %u passes\n", v.password, v.memoryKiB, v.passes);
+            CHECK(memcmp(out, expected, sizeof(out)) == 0);
+        }
+    }
+}
+
+static void check_inputs() {
+    PasswordKdfParams params = params_of(7, 3, 16, 2);
+    unsigned char a[KDF_OUT_BYTES], b[KDF_OUT_BYTES];
+
+    // Deterministic
+    CHECK(password_kdf("hunter2", 7, &params, NULL, a));
+    CHECK(password_kdf("hunter2", 7, &params, NULL, b));
+    CHECK(memcmp(a, b, sizeof(a)) == 0);
+
+    // Every input counts: salt, password, memory, passes
+    PasswordKdfParams changed = params;
+    changed.salt[KDF_SALT_BYTES - 1] ^= 1;
+    CHECK(password_kdf("hunter2", 7, &changed, NULL, b));
+    CHECK(memcmp(a, b, sizeof(a)) != 0);
+    CHECK(password_kdf("hunter3", 7, &params, NULL, b));
+    CHECK(memcmp(a, b, sizeof(a)) != 0);
+    changed = params;
+    changed.memoryKiB++;
+    CHECK(password_kdf("hunter2", 7, &changed, NULL, b));
+    CHECK(memcmp(a, b, sizeof(a)) != 0);
+    changed = params;
+    changed.passes++;
+    CHECK(password_kdf("hunter2", 7, &changed, NULL, b));
+    CHECK(memcmp(a, b, sizeof(a)) != 0);
+
+    // Out-of-range costs
+    for (uint32_t memoryKiB : {KDF_MIN_MEMORY_KIB - 1, KDF_MAX_MEMORY_KIB + 1}) {
+        changed = params;
+        changed.memoryKiB = memoryKiB;
+        CHECK(!password_kdf("hunter2", 7, &changed, NULL, b));
+    }
+    for (uint32_t passes : {0u, KDF_MAX_PASSES + 1}) {
+        changed = params;
+        changed.passes = passes;
+        CHECK(!password_kdf("hunter2", 7, &changed, NULL, b));
+    }
+    CHECK(!password_kdf(NULL, 1, &params, NULL, b));
+}
+
+static std::atomic<bool> g_cancel{false};
+
+static void *cancel_soon(void *) {
+    struct timespec ts = {0, 20 * 1000000};
+    nanosleep(&ts, NULL);
+    g_cancel.store(true);
+    return nullptr;
+}
+
+static void check_cancel() {
+    PasswordKdfParams params = params_of(1, 1, 16, 1);
+    unsigned char out[KDF_OUT_BYTES];
+
+    // Set before the run
+    g_cancel.store(true);
+    memset(out, 0xAA, sizeof(out));
+    CHECK(!password_kdf("pw", 2, &params, &g_cancel, out));
+    CHECK(out[0] == 0xAA && out[KDF_OUT_BYTES - 1] == 0xAA);
+
+    // A clear flag changes nothing
+    unsigned char plain[KDF_OUT_BYTES];
+    g_cancel.store(false);
+    CHECK(password_kdf("pw", 2, &params, &g_cancel, out));
+    CHECK(password_kdf("pw", 2, &params, NULL, plain));
+    CHECK(memcmp(out, plain, sizeof(out)) == 0);
+
+    // Set mid-run: 64 passes over 4 MiB stop within a stride of mixing
+    params = params_of(1, 1, 4096, KDF_MAX_PASSES);
+    g_cancel.store(false);
+    memset(out, 0xAA, sizeof(out));
+    pthread_t thread;
+    pthread_create(&thread, NULL, cancel_soon, NULL);
+    uint64_t start = host_now_ns();
+    CHECK(!password_kdf("pw", 2, &params, &g_cancel, out));
+    double ms = (double) (host_now_ns() - start) / 1e6;
+    pthread_join(thread, NULL);
+    printf("cancelled after %.0f ms\n", ms);
+    CHECK(ms < 5000);
+    CHECK(out[0] == 0xAA && out[KDF_OUT_BYTES - 1] == 0xAA);
+}
+
+int main() {
+    check_vectors();
+    check_inputs();
+    check_cancel();
+    return host_test_result("test_password_kdf");
+}
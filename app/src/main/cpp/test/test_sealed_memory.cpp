@@ -0,0 +1,166 @@
+#include <cstdio>
+#include <cstring>
+
+#include "cpu_dispatch.h"
+#include "host_test.h"
+#include "sealed_memory.h"
+
+// ========== SEALED MEMORY ==========
+// Every ChaCha20 variant the host CPU can run produces the known keystreams
+// of the original (64-bit nonce) construction, so an error shared by all of
+// them can't hide behind test_kernels' cross-checks. Sealed secrets come back
+// intact, and only under their own nonce and ciphertext.
+
+struct KeystreamVector {
+    const char *name;
+    const char *key;     // 32 bytes, hex
+    const char *nonce;   // 8 bytes, hex (little-endian words 14 and 15)
+    const char *stream;  // Keystream from block counter 0, hex
+};
+
+// draft-agl-tls-chacha20poly1305-04 section 7; the first is also RFC 7539
+// appendix A.1 test vector #1 (all-zero key and nonce, counter 0)
+static const KeystreamVector VECTORS[] = {
+        {"zero key and nonce",
+         "0000000000000000000000000000000000000000000000000000000000000000",
+         "0000000000000000",
+         "76b8e0ada0f13d90405d6ae55386bd28bdd219b8a08ded1aa836efcc8b770dc7"
+         "da41597c5157488d7724e03fb8d84a376a43b8f41518a11cc387b669b2ee6586"},
+        {"last key bit",
+         "0000000000000000000000000000000000000000000000000000000000000001",
+         "0000000000000000",
+         "4540f05a9f1fb296d7736e7b208e3c96eb4fe1834688d2604f450952ed432d41"
+         "bbe2a0b6ea7566d2a5d1e7e20d42af2c53d792b1c43fea817e9ad275ae546963"},
+        {"last nonce bit",
+         "0000000000000000000000000000000000000000000000000000000000000000",
+         "0000000000000001",
+         "de9cba7bf3d69ef5e786dc63973f653a0b49e015adbff7134fcb7df137821031"
+         "e85a050278a7084527214f73efc7fa5b5277062eb7a0433e445f41e3"},
+        {"first nonce bit",
+         "0000000000000000000000000000000000000000000000000000000000000000",
+         "0100000000000000",
+         "ef3fdfd6c61578fbf5cf35bd3dd33b8009631634d21e42ac33960bd138e50d32"
+         "111e4caf237ee53ca8ad6426194a88545ddc497a0b466e7d6bbdb0041b2f586b"},
+        {"counting key and nonce, four blocks",
+         "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f",
+         "0001020304050607",
+         "f798a189f195e66982105ffb640bb7757f579da31602fc93ec01ac56f85ac3c1"
+         "34a4547b733b46413042c9440049176905d3be59ea1c53f15916155c2be8241a"
+         "38008b9a26bc35941e2444177c8ade6689de95264986d95889fb60e84629c9bd"
+         "9a5acb1cc118be563eb9b3a4a472f82e09a7e778492b562ef7130e88dfe031c7"
+         "9db9d4f7c7a899151b9a475032b63fc385245fe054e3dd5a97a5f576fe064025"
+         "d3ce042c566ab2c507b138db853e3d6959660996546cc9c4a6eafdc777c040d7"
+         "0eaf46f76dad3979e5c5360c3317166a1c894c94a371876a94df7628fe4eaaf2"
+         "ccb27d5aaae0ad7ad0f9d4b6ad3b54098746d4524d38407a6deb3ab78fab78c9"},
+};
+
+static unsigned char g_input[300];
+
+/**
+ * Decodes a hex string into out
+ * @return Bytes written
+ */
+static size_t from_hex(const char *hex, unsigned char *out) {
+    size_t n = 0;
+    for (; hex[0] && hex[1]; hex += 2) {
+        unsigned byte;
+        sscanf(hex, "%2x", &byte);
+        out[n++] = (unsigned char) byte;
+    }
+    return n;
+}
+
+static void check_known_keystreams() {
+    for (const KeystreamVector &v : VECTORS) {
+        unsigned char keyBytes[32], nonceBytes[8], expected[256], out[257];
+        CHECK(from_hex(v.key, keyBytes) == sizeof(keyBytes));
+        CHECK(from_hex(v.nonce, nonceBytes) == sizeof(nonceBytes));
+        size_t len = from_hex(v.stream, expected);
+
+        // The kernels take the key as little-endian words
+        uint32_t key[8];
+        for (int i = 0; i < 8; i++) {
+            key[i] = (uint32_t) keyBytes[4 * i] | (uint32_t) keyBytes[4 * i + 1] << 8 |
+                     (uint32_t) keyBytes[4 * i + 2] << 16 | (uint32_t) keyBytes[4 * i + 3] << 24;
+        }
+        uint64_t nonce = 0;
+        for (int i = 7; i >= 0; i--) nonce = nonce << 8 | nonceBytes[i];
+
+        // Encrypting zeros yields the keystream itself
+        static const unsigned char zeros[256] = {};
+        for (size_t k = 0; k < CHACHA20_KERNEL_COUNT; k++) {
+            const KernelVariant &variant = CHACHA20_KERNELS[k];
+            if ((cpu_features() & variant.features) != variant.features) continue;
+            memset(out, 0xAA, sizeof(out));
+            ((Chacha20Kernel) variant.fn)(key, nonce, zeros, out, len);
+            if (memcmp(out, expected, len) != 0) {
+                fprintf(stderr, "%s: %s\n", variant.name, v.name);
+                CHECK(memcmp(out, expected, len) == 0);
+            }
+            CHECK(out[len] == 0xAA);
+        }
+    }
+}
+
+static void check_round_trips() {
+    for (size_t len : {0, 1, 63, 64, 65, 300}) {
+        SealedSecret secret;
+        CHECK(sealed_seal(&secret, g_input, len));
+        CHECK(secret.len == len);
+        SealedSlot *slot = NULL;
+        void *plain = sealed_unseal(&secret, &slot);
+        CHECK(plain && memcmp(plain, g_input, len) == 0);
+        sealed_reseal(slot);
+        sealed_free(&secret);
+        CHECK(secret.data == NULL);
+    }
+
+    // The same plaintext sealed twice: fresh nonce, unrelated ciphertext
+    SealedSecret a, b;
+    CHECK(sealed_seal(&a, g_input, sizeof(g_input)));
+    CHECK(sealed_seal(&b, g_input, sizeof(g_input)));
+    CHECK(a.nonce != b.nonce);
+    CHECK(memcmp(a.data, g_input, sizeof(g_input)) != 0);
+    CHECK(memcmp(a.data, b.data, sizeof(g_input)) != 0);
+
+    // Unsealed under the wrong nonce: the plaintext does not come back
+    SealedSlot *slot = NULL;
+    uint64_t nonce = a.nonce;
+    a.nonce = b.nonce;
+    unsigned char *plain = (unsigned char *) sealed_unseal(&a, &slot);
+    CHECK(plain && memcmp(plain, g_input, sizeof(g_input)) != 0);
+    sealed_reseal(slot);
+    a.nonce = nonce;
+
+    // Tampered ciphertext: a stream cipher has no integrity, the flipped bit
+    // comes through and nothing else changes (seal is confidentiality only)
+    a.data[100] ^= 0x10;
+    plain = (unsigned char *) sealed_unseal(&a, &slot);
+    CHECK(plain && plain[100] == (g_input[100] ^ 0x10));
+    CHECK(plain && memcmp(plain, g_input, 100) == 0 &&
+          memcmp(plain + 101, g_input + 101, sizeof(g_input) - 101) == 0);
+    sealed_reseal(slot);
+    a.data[100] ^= 0x10;
+    plain = (unsigned char *) sealed_unseal(&a, &slot);
+    CHECK(plain && memcmp(plain, g_input, sizeof(g_input)) == 0);
+    sealed_reseal(slot);
+
+    sealed_free(&a);
+    sealed_free(&b);
+
+    // The in-place keystream is its own inverse
+    unsigned char buf[sizeof(g_input)];
+    memcpy(buf, g_input, sizeof(buf));
+    uint64_t n = sealed_next_nonce();
+    CHECK(sealed_xor_keystream(buf, sizeof(buf), n));
+    CHECK(memcmp(buf, g_input, sizeof(buf)) != 0);
+    CHECK(sealed_xor_keystream(buf, sizeof(buf), n));
+    CHECK(memcmp(buf, g_input, sizeof(buf)) == 0);
+}
+
+int main() {
+    for (size_t i = 0; i < sizeof(g_input); i++) g_input[i] = (unsigned char) (i * 29 + 3);
+    check_known_keystreams();
+    check_round_trips();
+    return host_test_result("test_sealed_memory");
+}
@@ -0,0 +1,70 @@
+#include <csignal>
+#include <cstring>
+
+#include "host_test.h"
+#include "lock_budget.h"
+#include "secret_registry.h"
+
+// ========== SECRET REGISTRY ==========
+// A pause wipe clears PLAINTEXT regions and keeps KEY ones; a fatal signal
+// wipes both before the previously installed handler runs; removed regions
+// are never touched again; strided regions lose only their secret prefixes.
+
+static unsigned char g_key[100];
+
+static void previous_handler(int) {
+    // Runs after the registry's handler: the key must already be gone
+    for (size_t i = 0; i < sizeof(g_key); i++) {
+        if (g_key[i]) _exit(2);
+    }
+    _exit(0);
+}
+
+static void crash_wipes_keys() {
+    signal(SIGTERM, previous_handler);
+    secret_registry_install_handlers();
+    memset(g_key, 7, sizeof(g_key));
+    SecretNode node;
+    secret_registry_add(&node, g_key, sizeof(g_key), SECRET_CLASS_KEY);
+    raise(SIGTERM);
+    _exit(3);
+}
+
+int main() {
+    unsigned char key[64], plain[64], removed[64];
+    memset(key, 1, sizeof(key));
+    memset(plain, 2, sizeof(plain));
+    memset(removed, 3, sizeof(removed));
+    SecretNode keyNode, plainNode, removedNode;
+    secret_registry_add(&keyNode, key, sizeof(key), SECRET_CLASS_KEY);
+    secret_registry_add(&plainNode, plain, sizeof(plain), SECRET_CLASS_PLAINTEXT);
+    secret_registry_add(&removedNode, removed, sizeof(removed), SECRET_CLASS_PLAINTEXT);
+    secret_registry_remove(&removedNode);
+
+    unsigned char table[40];
+    memset(table, 4, sizeof(table));
+    SecretNode tableNode;
+    secret_registry_add_strided(&tableNode, table, sizeof(table), 16, 12, SECRET_CLASS_PLAINTEXT);
+
+    LockedRegion region;
+    CHECK(locked_alloc(&region, 5000, LOCK_PRIO_NORMAL));
+    memset(region.ptr, 9, region.len);
+
+    CHECK(secret_registry_wipe_all(SECRET_CLASS_PLAINTEXT) >= sizeof(plain) + 32 + region.len);
+    for (size_t i = 0; i < sizeof(table); i++) CHECK(table[i] == (i % 16 < 12 ? 0 : 4));
+    CHECK(key[0] == 1 && key[63] == 1);
+    CHECK(plain[0] == 0 && plain[63] == 0);
+    CHECK(removed[0] == 3 && removed[63] == 3);
+    CHECK(((unsigned char *) region.ptr)[0] == 0);
+    CHECK(((unsigned char *) region.ptr)[region.len - 1] == 0);
+
+    secret_registry_remove(&keyNode);
+    secret_registry_remove(&plainNode);
+    secret_registry_remove(&tableNode);
+    locked_free(&region);
+
+    int code = -1;
+    CHECK(host_run_child(crash_wipes_keys, &code) == 0);
+    CHECK(code == 0);
+    return host_test_result("test_secret_registry");
+}
@@ -0,0 +1,75 @@
+#include <cstring>
+#include <pthread.h>
+#include <vector>
+
+#include "host_test.h"
+#include "secret_shares.h"
+
+// ========== SECRET SHARES ==========
+// Secrets combine back to their plaintext while the refresh thread
+// re-randomizes them with no CPU budget (so it never sleeps between chunks),
+// and while several threads destroy secrets around the one being refreshed.
+
+static const int THREADS = 4;
+static const int SECRETS_PER_THREAD = 4;
+
+struct Owner {
+    SharedSecret *secrets[SECRETS_PER_THREAD];
+    std::vector<unsigned char> plain[SECRETS_PER_THREAD];
+    unsigned seed;
+    int failures;
+};
+
+static void fill(std::vector<unsigned char> *plain, size_t len, unsigned seed) {
+    plain->resize(len);
+    for (size_t i = 0; i < len; i++) (*plain)[i] = (unsigned char) (seed * 131 + i * 37 + 1);
+}
+
+static bool intact(SharedSecret *secret, const std::vector<unsigned char> &plain) {
+    std::vector<unsigned char> out(plain.size());
+    return shares_combine(secret, out.data(), out.size()) && out == plain;
+}
+
+static void *churn(void *arg) {
+    Owner *owner = (Owner *) arg;
+    uint64_t end = host_now_ns() + 1000000000ull;
+    while (host_now_ns() < end) {
+        int i = rand_r(&owner->seed) % SECRETS_PER_THREAD;
+        if (!intact(owner->secrets[i], owner->plain[i])) owner->failures++;
+        // Destroy and recreate it (with a new size) mid-pass
+        shares_destroy(owner->secrets[i]);
+        fill(&owner->plain[i], 5 + (size_t) rand_r(&owner->seed) % 40000, owner->seed);
+        owner->secrets[i] = shares_create(owner->plain[i].data(), owner->plain[i].size());
+        if (!owner->secrets[i]) owner->failures++;
+    }
+    return nullptr;
+}
+
+int main() {
+    static Owner owners[THREADS];
+    for (int t = 0; t < THREADS; t++) {
+        owners[t].seed = (unsigned) t + 1;
+        for (int i = 0; i < SECRETS_PER_THREAD; i++) {
+            fill(&owners[t].plain[i], 5 + (size_t) (t * SECRETS_PER_THREAD + i) * 3000, (unsigned) i);
+            owners[t].secrets[i] = shares_create(owners[t].plain[i].data(), owners[t].plain[i].size());
+            CHECK(owners[t].secrets[i] != NULL);
+        }
+    }
+
+    shares_set_refresh(1, 1000);
+    pthread_t threads[THREADS];
+    for (int t = 0; t < THREADS; t++) pthread_create(&threads[t], NULL, churn, &owners[t]);
+    for (int t = 0; t < THREADS; t++) pthread_join(threads[t], NULL);
+    shares_set_refresh(0, 1000);
+
+    for (int t = 0; t < THREADS; t++) {
+        CHECK(owners[t].failures == 0);
+        for (int i = 0; i < SECRETS_PER_THREAD; i++) {
+            std::vector<unsigned char> out(owners[t].plain[i].size());
+            CHECK(intact(owners[t].secrets[i], owners[t].plain[i]));
+            CHECK(!shares_combine(owners[t].secrets[i], out.data(), out.size() - 1));
+            shares_destroy(owners[t].secrets[i]);
+        }
+    }
+    return host_test_result("test_secret_shares");
+}
@@ -0,0 +1,46 @@
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+
+#include "host_test.h"
+#include "secret_timer.h"
+
+// ========== SECRET TIMER WHEEL ==========
+// Timers spread over the first two wheel levels must all fire, cancelled
+// ones (parked on the third level) must leave their region alone, and a
+// cancel reports only once.
+
+int main() {
+    const int count = 5000;
+    std::vector<unsigned char> regions(count, 1);
+    std::vector<uint64_t> handles(count);
+
+    // Every tenth timer is cancelled: give those a minute so none fires first
+    for (int i = 0; i < count; i++) {
+        uint32_t ttl = i % 10 == 0 ? 60000 + (uint32_t) i : (uint32_t) (i % 500) + 1;
+        handles[i] = secret_timer_add_region(&regions[i], 1, ttl);
+        CHECK(handles[i] != 0);
+    }
+    for (int i = 0; i < count; i += 10) CHECK(secret_timer_cancel(handles[i]));
+
+    // Everything is due within 500 ms; allow a slow (sanitized) host 5 s
+    for (int waited = 0; waited < 500 && secret_timer_pending() > 0; waited++) usleep(10000);
+    CHECK(secret_timer_pending() == 0);
+
+    int wrong = 0;
+    for (int i = 0; i < count; i++) {
+        bool cancelled = i % 10 == 0;
+        wrong += regions[i] != (cancelled ? 1 : 0);
+    }
+    CHECK(wrong == 0);
+
+    // Fired and cancelled handles are stale
+    CHECK(!secret_timer_cancel(handles[1]));
+    unsigned char late[8];
+    memset(late, 1, sizeof(late));
+    uint64_t handle = secret_timer_add_region(late, sizeof(late), 70000);
+    CHECK(secret_timer_cancel(handle));
+    CHECK(!secret_timer_cancel(handle));
+    CHECK(late[0] == 1);
+    return host_test_result("test_secret_timer");
+}
@@ -0,0 +1,93 @@
+#include <csignal>
+#include <cstring>
+#include <pthread.h>
+
+#include "host_test.h"
+#include "secret_registry.h"
+#include "secure_slab.h"
+
+// ========== SLAB ALLOCATOR ==========
+// Canary checks must abort on overflows and double frees (also after a pause
+// wipe), slots freed on another thread must be reusable, reused slots must
+// come back zeroed and a pause wipe must clear PLAINTEXT slots but leave KEY
+// slots alone.
+
+static const int SLOTS = 1000;
+static void *g_ptrs[SLOTS];
+
+static size_t slot_len(int i) {
+    return 1 + (size_t) i % SLAB_MAX_OBJECT;
+}
+
+static SecretClass slot_class(int i) {
+    return i % 2 ? SECRET_CLASS_KEY : SECRET_CLASS_PLAINTEXT;
+}
+
+static void overflow() {
+    char *p = (char *) slab_alloc(20, LOCK_PRIO_NORMAL, SECRET_CLASS_PLAINTEXT);
+    memset(p, 1, 33);
+    slab_free(p);
+}
+
+static void off_by_one() {
+    char *p = (char *) slab_alloc(32, LOCK_PRIO_NORMAL, SECRET_CLASS_PLAINTEXT);
+    p[32] = 0;
+    slab_free(p);
+}
+
+static void double_free() {
+    void *p = slab_alloc(20, LOCK_PRIO_NORMAL, SECRET_CLASS_PLAINTEXT);
+    slab_free(p);
+    slab_free(p);
+}
+
+static void double_free_after_wipe() {
+    void *p = slab_alloc(20, LOCK_PRIO_NORMAL, SECRET_CLASS_PLAINTEXT);
+    slab_free(p);
+    secret_registry_wipe_all(SECRET_CLASS_PLAINTEXT);
+    slab_free(p);
+}
+
+static void *free_all(void *) {
+    for (int i = 0; i < SLOTS; i++) slab_free(g_ptrs[i]);
+    return NULL;
+}
+
+int main() {
+    CHECK(host_run_child(overflow) == SIGABRT);
+    CHECK(host_run_child(off_by_one) == SIGABRT);
+    CHECK(host_run_child(double_free) == SIGABRT);
+    CHECK(host_run_child(double_free_after_wipe) == SIGABRT);
+
+    CHECK(slab_alloc(0, LOCK_PRIO_NORMAL, SECRET_CLASS_PLAINTEXT) == NULL);
+    CHECK(slab_alloc(SLAB_MAX_OBJECT + 1, LOCK_PRIO_NORMAL, SECRET_CLASS_PLAINTEXT) == NULL);
+
+    // Allocate here, free on another thread
+    for (int i = 0; i < SLOTS; i++) {
+        g_ptrs[i] = slab_alloc(slot_len(i), LOCK_PRIO_NORMAL, slot_class(i));
+        CHECK(g_ptrs[i] && slab_usable_size(g_ptrs[i]) >= slot_len(i));
+        memset(g_ptrs[i], 0xCC, slot_len(i));
+    }
+    pthread_t thread;
+    pthread_create(&thread, NULL, free_all, NULL);
+    pthread_join(thread, NULL);
+
+    // Reused slots read zero
+    size_t nonzero = 0;
+    for (int i = 0; i < SLOTS; i++) {
+        unsigned char *p = (unsigned char *) slab_alloc(slot_len(i), LOCK_PRIO_NORMAL, slot_class(i));
+        for (size_t j = 0; j < slot_len(i); j++) nonzero += p[j] != 0;
+        memset(p, 0xDD, slot_len(i));
+        g_ptrs[i] = p;
+    }
+    CHECK(nonzero == 0);
+
+    // A pause wipe clears plaintext slots only
+    CHECK(secret_registry_wipe_all(SECRET_CLASS_PLAINTEXT) > 0);
+    for (int i = 0; i < SLOTS; i++) {
+        const unsigned char *p = (const unsigned char *) g_ptrs[i];
+        CHECK(p[0] == (slot_class(i) == SECRET_CLASS_KEY ? 0xDD : 0));
+        slab_free(g_ptrs[i]);
+    }
+    return host_test_result("test_secure_slab");
+}
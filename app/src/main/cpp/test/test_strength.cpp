@@ -0,0 +1,143 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "host_test.h"
+#include "strength_dict.h"
+#include "strength_estimate.h"
+
+// ========== STRENGTH ESTIMATES ==========
+// Pins what the estimator finds in a password (keyboard walks, years,
+// dates, repeats, sequences, dictionary words reversed or in l33t, the user
+// name) and how passwords rank against each other, first without and then
+// with a small dictionary built by tools/build_strength_dict. A change of
+// matcher tables or weights that moves any of these fails here.
+//
+//   test_strength <build_strength_dict>
+
+struct Expected {
+    const char *password;
+    int score;
+    StrengthFeedback feedback;
+};
+
+// Matched without dictionaries
+static const Expected PATTERNS[] = {
+        {"qwertyuiop", 1, STRENGTH_FEEDBACK_SPATIAL},
+        {"zxcvbn", 1, STRENGTH_FEEDBACK_SPATIAL},
+        {"1q2w3e4r", 2, STRENGTH_FEEDBACK_SPATIAL},
+        {"2024", 0, STRENGTH_FEEDBACK_YEAR},
+        {"13/12/1998", 1, STRENGTH_FEEDBACK_DATE},
+        {"aaaaaaaa", 0, STRENGTH_FEEDBACK_REPEAT},
+        {"abcabcabc", 0, STRENGTH_FEEDBACK_REPEAT},
+        {"abcdefgh", 0, STRENGTH_FEEDBACK_SEQUENCE},
+        {"9753", 0, STRENGTH_FEEDBACK_SEQUENCE},
+        {"jsmith99", 1, STRENGTH_FEEDBACK_USER_INPUT},
+        {"x7#Kq9!mZ2vB", 4, STRENGTH_FEEDBACK_NONE},
+};
+
+// Matched with the dictionary below ("sunshine" is ranked past the top 100)
+static const Expected WORDS[] = {
+        {"password", 0, STRENGTH_FEEDBACK_TOP_PASSWORD},
+        {"sunshine", 0, STRENGTH_FEEDBACK_COMMON_PASSWORD},
+        {"monkey", 0, STRENGTH_FEEDBACK_WORD},
+        {"yeknom", 0, STRENGTH_FEEDBACK_WORD},
+        {"m0nk3y", 0, STRENGTH_FEEDBACK_WORD},
+        {"MONKEY", 0, STRENGTH_FEEDBACK_WORD},
+        {"jennifer", 0, STRENGTH_FEEDBACK_NAME},
+        {"monkey2024", 1, STRENGTH_FEEDBACK_WORD},
+        {"correcthorsebatterystaple", 4, STRENGTH_FEEDBACK_NONE},
+};
+
+static const char *USER = "jsmith";
+
+static StrengthEstimate estimate(const char *password) {
+    StrengthEstimate e = {};
+    CHECK(strength_estimate((const unsigned char *) password, strlen(password),
+                            (const unsigned char *) USER, strlen(USER), &e));
+    return e;
+}
+
+static double guesses(const char *password) {
+    return estimate(password).log10Guesses;
+}
+
+static void check_expected(const Expected *expected, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        StrengthEstimate e = estimate(expected[i].password);
+        if (e.score != expected[i].score || e.feedback != expected[i].feedback) {
+            fprintf(stderr, "%s: score %d feedback %d, expected %d and %d (10^%.2f guesses)\n",
+                    expected[i].password, e.score, (int) e.feedback, expected[i].score,
+                    (int) expected[i].feedback, e.log10Guesses);
+            CHECK(e.score == expected[i].score && e.feedback == expected[i].feedback);
+        }
+    }
+}
+
+static bool write_lines(const std::string &path, const char *const *lines, size_t count,
+                        int filler) {
+    FILE *f = fopen(path.c_str(), "w");
+    if (!f) return false;
+    for (size_t i = 0; i < count; i++) {
+        fprintf(f, "%s\n", lines[i]);
+        // Pushes whatever follows out of the top 100
+        if (i == 0) {
+            for (int n = 0; n < filler; n++) fprintf(f, "filler%d\n", n);
+        }
+    }
+    return fclose(f) == 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <build_strength_dict>\n", argv[0]);
+        return 2;
+    }
+
+    // === Patterns alone ===
+    check_expected(PATTERNS, sizeof(PATTERNS) / sizeof(PATTERNS[0]));
+    double monkeyBrute = guesses("monkey");
+    CHECK(guesses("2024") < guesses("13/12/1998"));
+    CHECK(guesses("qwertyuiop") < guesses("qwfpgjluy;"));     // No walk on QWERTY
+    CHECK(guesses("abcdefgh") < guesses("aqzfkbxe"));
+    CHECK(guesses("jsmith99") < guesses("kqvoxb99"));
+
+    // === With dictionaries ===
+    char dir[] = "/tmp/test_strength.XXXXXX";
+    CHECK(mkdtemp(dir) != NULL);
+    std::string base = dir;
+    static const char *const passwords[] = {"password", "123456", "dragon", "sunshine"};
+    static const char *const words[] = {"correct", "horse", "battery", "staple", "monkey"};
+    static const char *const names[] = {"jennifer", "smith"};
+    CHECK(write_lines(base + "/passwords.txt", passwords, 4, 150));
+    CHECK(write_lines(base + "/words.txt", words, 5, 0));
+    CHECK(write_lines(base + "/names.txt", names, 2, 0));
+    std::string dict = base + "/strength_dict.bin";
+    std::string command = std::string(argv[1]) + " -o " + dict + " passwords:" + base +
+                          "/passwords.txt words:" + base + "/words.txt names:" + base +
+                          "/names.txt 2>/dev/null";
+    CHECK(system(command.c_str()) == 0);
+    CHECK(strength_dict_open(dict.c_str()) == 4 + 150 + 5 + 2);
+
+    check_expected(WORDS, sizeof(WORDS) / sizeof(WORDS[0]));
+
+    // Rank, then the cost of variations, then length
+    CHECK(guesses("password") < guesses("sunshine"));
+    CHECK(guesses("monkey") < guesses("yeknom"));
+    CHECK(guesses("monkey") < guesses("m0nk3y"));
+    CHECK(guesses("monkey") < monkeyBrute);
+    CHECK(guesses("monkey") < guesses("monkey2024"));
+    CHECK(guesses("monkey2024") < guesses("correcthorsebatterystaple"));
+    CHECK(guesses("correcthorse") < guesses("correcthorsebatterystaple"));
+
+    // Unchanged by the dictionary
+    check_expected(PATTERNS, sizeof(PATTERNS) / sizeof(PATTERNS[0]));
+
+    strength_dict_close();
+    CHECK(guesses("monkey") == monkeyBrute);
+
+    command = "rm -rf " + base;
+    CHECK(system(command.c_str()) == 0);
+    return host_test_result("test_strength");
+}
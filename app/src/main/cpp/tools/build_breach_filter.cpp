@@ -0,0 +1,466 @@
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "breach_filter_format.h"
+
+// ========== BREACH FILTER BUILDER ==========
+// Builds the filter file breach_filter.cpp maps (see breach_filter_format.h)
+// from a corpus of SHA-1 hashes, e.g. the Have I Been Pwned "ordered by
+// hash" download:
+//
+//   build_breach_filter [options] -o OUT INPUT...
+//     INPUT                one SHA-1 (40 hex digits) per line, optionally
+//                          followed by ":count" as in HIBP; "-" is stdin
+//     --binary             inputs are raw 20-byte digests instead
+//     --min-count N        skip text lines whose count is below N
+//     --fingerprint-bits B 8 or 16 (default 16): 2^-B false positives at
+//                          ~1.13 * B bits per key
+//     --shard-keys N       target keys per shard (default 2^21)
+//     --tmp DIR            where the bucket files go (default: OUT's directory)
+//
+// Memory stays bounded whatever the corpus size: pass 1 spreads the 64-bit
+// keys over BUCKETS temporary files by their top bits, pass 2 loads one
+// bucket (or a few) at a time, removes duplicates and builds its shards.
+// Every key is looked up in its finished shard before the shard is written.
+
+static const int BUCKET_BITS = 8;
+static const int BUCKETS = 1 << BUCKET_BITS;
+static const size_t BUCKET_BUFFER_BYTES = 256 * 1024;
+static const int MAX_SEED_ATTEMPTS = 100;
+
+struct Options {
+    const char *out = NULL;
+    std::vector<const char *> inputs;
+    bool binary = false;
+    uint64_t minCount = 0;
+    uint32_t fingerprintBits = 16;
+    uint64_t shardKeys = 1u << 21;
+    std::string tmpDir;
+};
+
+static void die(const char *what) {
+    fprintf(stderr, "build_breach_filter: %s\n", what);
+    exit(1);
+}
+
+static double now_seconds() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ========== PASS 1: KEYS INTO BUCKETS ==========
+
+struct Buckets {
+    FILE *files[BUCKETS];
+    std::string paths[BUCKETS];
+    uint64_t counts[BUCKETS];
+};
+
+static void bucket_add(Buckets *buckets, uint64_t key) {
+    int b = (int) (key >> (64 - BUCKET_BITS));
+    if (fwrite(&key, sizeof(key), 1, buckets->files[b]) != 1) die("writing a bucket file failed");
+    buckets->counts[b]++;
+}
+
+static int hex_value(int c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+/**
+ * Parses "HEX40[:count]"
+ * @return false for anything else (blank lines included)
+ */
+static bool parse_line(const char *line, size_t len, unsigned char *digest, uint64_t *count) {
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' || line[len - 1] == ' ')) {
+        len--;
+    }
+    if (len < 40) return false;
+    for (int i = 0; i < 20; i++) {
+        int hi = hex_value(line[2 * i]), lo = hex_value(line[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        digest[i] = (unsigned char) (hi << 4 | lo);
+    }
+    *count = UINT64_MAX;
+    if (len == 40) return true;
+    if (line[40] != ':') return false;
+    uint64_t n = 0;
+    for (size_t i = 41; i < len; i++) {
+        if (line[i] < '0' || line[i] > '9') return false;
+        n = n * 10 + (uint64_t) (line[i] - '0');
+    }
+    *count = n;
+    return true;
+}
+
+static void read_input(const Options &opt, const char *path, Buckets *buckets,
+                       uint64_t *lines, uint64_t *skipped) {
+    FILE *in = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (!in) {
+        perror(path);
+        exit(1);
+    }
+    unsigned char digest[20];
+    if (opt.binary) {
+        while (fread(digest, sizeof(digest), 1, in) == 1) {
+            bucket_add(buckets, breach_filter_key(digest));
+            (*lines)++;
+        }
+    } else {
+        char *line = NULL;
+        size_t cap = 0;
+        ssize_t len;
+        while ((len = getline(&line, &cap, in)) >= 0) {
+            (*lines)++;
+            uint64_t count;
+            if (!parse_line(line, (size_t) len, digest, &count)) {
+                (*skipped)++;
+                continue;
+            }
+            if (count < opt.minCount) continue;
+            bucket_add(buckets, breach_filter_key(digest));
+        }
+        free(line);
+    }
+    if (ferror(in)) die("reading an input failed");
+    if (in != stdin) fclose(in);
+}
+
+// ========== PASS 2: ONE SHARD ==========
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Segment geometry for n keys (the 3-wise parameters of the paper's
+ * reference implementation; at least one segment, so arrays are never empty)
+ */
+static void shard_geometry(uint32_t n, BreachFilterShard *shard) {
+    uint32_t segmentLength = n == 0 ? 4 : 1u << (int) floor(log((double) n) / log(3.33) + 2.25);
+    if (segmentLength > BREACH_FILTER_MAX_SEGMENT_LENGTH) {
+        segmentLength = BREACH_FILTER_MAX_SEGMENT_LENGTH;
+    }
+    double sizeFactor = n <= 1 ? 0 : std::max(1.125, 0.875 + 0.25 * log(1e6) / log((double) n));
+    uint64_t capacity = (uint64_t) llround(n * sizeFactor);
+    int64_t segmentCount = (int64_t) ((capacity + segmentLength - 1) / segmentLength) - 2;
+    if (segmentCount < 1) segmentCount = 1;
+
+    shard->segmentLength = segmentLength;
+    shard->segmentCount = (uint32_t) segmentCount;
+    shard->arrayLength = (uint32_t) ((segmentCount + 2) * segmentLength);
+    shard->keyCount = n;
+}
+
+/**
+ * Builds one shard's fingerprints from distinct keys
+ * Peels the 3-hypergraph: positions hit by a single key are resolved last
+ * to first, so each key's fingerprint is the XOR of its three slots
+ *
+ * @return false if no seed gave a peelable graph
+ */
+static bool build_shard(const uint64_t *keys, uint32_t n, uint32_t fingerprintBits,
+                        uint64_t *seedState, BreachFilterShard *shard,
+                        std::vector<uint16_t> *fingerprints) {
+    shard_geometry(n, shard);
+    uint32_t size = shard->arrayLength;
+    fingerprints->assign(size, 0);
+    if (n == 0) {
+        shard->seed = splitmix64(seedState);
+        return true;
+    }
+
+    // Per slot: number of keys * 4 | which of its three positions (0-2),
+    // XOR-ed over the keys; and the XOR of their hashes
+    std::vector<uint8_t> count(size);
+    std::vector<uint64_t> xorHash(size);
+    std::vector<uint32_t> queue(size);
+    std::vector<uint64_t> stackHash(n);
+    std::vector<uint8_t> stackFound(n);
+    uint32_t pos[3];
+
+    for (int attempt = 0; attempt < MAX_SEED_ATTEMPTS; attempt++) {
+        shard->seed = splitmix64(seedState);
+        std::fill(count.begin(), count.end(), 0);
+        std::fill(xorHash.begin(), xorHash.end(), 0);
+
+        bool overflow = false;
+        for (uint32_t i = 0; i < n; i++) {
+            uint64_t hash = breach_filter_hash(keys[i], shard->seed);
+            breach_filter_positions(hash, shard, pos);
+            for (uint32_t j = 0; j < 3; j++) {
+                count[pos[j]] += 4;
+                count[pos[j]] ^= (uint8_t) j;
+                xorHash[pos[j]] ^= hash;
+                overflow |= count[pos[j]] < 4;   // Wrapped past 63 keys
+            }
+        }
+        if (overflow) continue;
+
+        uint32_t queued = 0;
+        for (uint32_t i = 0; i < size; i++) {
+            if ((count[i] >> 2) == 1) queue[queued++] = i;
+        }
+        uint32_t stacked = 0;
+        while (queued > 0) {
+            uint32_t index = queue[--queued];
+            if ((count[index] >> 2) != 1) continue;   // Emptied since it was queued
+            uint64_t hash = xorHash[index];
+            uint8_t found = count[index] & 3;
+            stackHash[stacked] = hash;
+            stackFound[stacked] = found;
+            stacked++;
+
+            breach_filter_positions(hash, shard, pos);
+            for (uint32_t j = 0; j < 3; j++) {
+                if (j == found) continue;
+                uint32_t other = pos[j];
+                count[other] -= 4;
+                count[other] ^= (uint8_t) j;
+                xorHash[other] ^= hash;
+                if ((count[other] >> 2) == 1) queue[queued++] = other;
+            }
+            count[index] = 0;
+            xorHash[index] = 0;
+        }
+        if (stacked != n) continue;
+
+        uint32_t mask = fingerprintBits == 16 ? 0xFFFF : 0xFF;
+        std::vector<uint16_t> &fp = *fingerprints;
+        for (uint32_t i = n; i-- > 0;) {
+            uint64_t hash = stackHash[i];
+            breach_filter_positions(hash, shard, pos);
+            uint32_t found = stackFound[i];
+            fp[pos[found]] = (uint16_t) ((breach_filter_fingerprint(hash) ^
+                                          fp[pos[(found + 1) % 3]] ^
+                                          fp[pos[(found + 2) % 3]]) & mask);
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Looks every key up in a finished shard (no false negatives allowed)
+ */
+static bool verify_shard(const uint64_t *keys, uint32_t n, uint32_t fingerprintBits,
+                         const BreachFilterShard *shard, const std::vector<uint16_t> &fp) {
+    uint32_t mask = fingerprintBits == 16 ? 0xFFFF : 0xFF;
+    uint32_t pos[3];
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t hash = breach_filter_hash(keys[i], shard->seed);
+        breach_filter_positions(hash, shard, pos);
+        uint32_t x = (breach_filter_fingerprint(hash) ^ fp[pos[0]] ^ fp[pos[1]] ^ fp[pos[2]]) & mask;
+        if (x != 0) return false;
+    }
+    return true;
+}
+
+// ========== OUTPUT ==========
+
+static void write_all(FILE *out, const void *data, size_t len) {
+    if (len && fwrite(data, 1, len, out) != len) die("writing the output failed");
+}
+
+static void pad_to(FILE *out, uint64_t *offset, size_t align) {
+    static const unsigned char zeros[BREACH_FILTER_ALIGN] = {};
+    size_t pad = (size_t) ((align - *offset % align) % align);
+    write_all(out, zeros, pad);
+    *offset += pad;
+}
+
+/**
+ * Loads, sorts and deduplicates buckets [first, last]
+ */
+static void load_buckets(const Buckets &buckets, int first, int last, std::vector<uint64_t> *keys) {
+    keys->clear();
+    for (int b = first; b <= last; b++) {
+        FILE *f = buckets.files[b];
+        size_t start = keys->size();
+        keys->resize(start + buckets.counts[b]);
+        rewind(f);
+        if (fread(keys->data() + start, sizeof(uint64_t), buckets.counts[b], f) != buckets.counts[b]) {
+            die("reading a bucket file failed");
+        }
+    }
+    std::sort(keys->begin(), keys->end());
+    keys->erase(std::unique(keys->begin(), keys->end()), keys->end());
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: build_breach_filter [--binary] [--min-count N] [--fingerprint-bits 8|16]\n"
+            "                           [--shard-keys N] [--tmp DIR] -o OUT INPUT...\n");
+    exit(2);
+}
+
+static Options parse_options(int argc, char **argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "-o") == 0 && hasValue) {
+            opt.out = argv[++i];
+        } else if (strcmp(arg, "--binary") == 0) {
+            opt.binary = true;
+        } else if (strcmp(arg, "--min-count") == 0 && hasValue) {
+            opt.minCount = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--fingerprint-bits") == 0 && hasValue) {
+            opt.fingerprintBits = (uint32_t) strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--shard-keys") == 0 && hasValue) {
+            opt.shardKeys = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--tmp") == 0 && hasValue) {
+            opt.tmpDir = argv[++i];
+        } else if (arg[0] == '-' && arg[1] != '\0') {
+            usage();
+        } else {
+            opt.inputs.push_back(arg);
+        }
+    }
+    if (!opt.out || opt.inputs.empty() || opt.shardKeys == 0 ||
+        (opt.fingerprintBits != 8 && opt.fingerprintBits != 16)) {
+        usage();
+    }
+    if (opt.tmpDir.empty()) {
+        std::string out = opt.out;
+        size_t slash = out.rfind('/');
+        opt.tmpDir = slash == std::string::npos ? "." : out.substr(0, slash + 1);
+    }
+    return opt;
+}
+
+int main(int argc, char **argv) {
+    Options opt = parse_options(argc, argv);
+    double start = now_seconds();
+
+    // Pass 1
+    static Buckets buckets;
+    for (int b = 0; b < BUCKETS; b++) {
+        char name[64];
+        snprintf(name, sizeof(name), "/breach_bucket_%d_%03d.tmp", (int) getpid(), b);
+        buckets.paths[b] = opt.tmpDir + name;
+        buckets.files[b] = fopen(buckets.paths[b].c_str(), "w+b");
+        if (!buckets.files[b]) {
+            perror(buckets.paths[b].c_str());
+            return 1;
+        }
+        setvbuf(buckets.files[b], NULL, _IOFBF, BUCKET_BUFFER_BYTES);
+    }
+    uint64_t lines = 0, skipped = 0;
+    for (const char *input : opt.inputs) read_input(opt, input, &buckets, &lines, &skipped);
+    uint64_t total = 0;
+    for (int b = 0; b < BUCKETS; b++) {
+        if (fflush(buckets.files[b]) != 0) die("writing a bucket file failed");
+        total += buckets.counts[b];
+    }
+    double pass1 = now_seconds();
+    fprintf(stderr, "read %llu records (%llu unparsable, %llu kept) in %.1f s\n",
+            (unsigned long long) lines, (unsigned long long) skipped,
+            (unsigned long long) total, pass1 - start);
+
+    uint32_t shardBits = 0;
+    while ((total >> shardBits) > opt.shardKeys && shardBits < BREACH_FILTER_MAX_SHARD_BITS) {
+        shardBits++;
+    }
+    uint32_t shardCount = 1u << shardBits;
+
+    // Pass 2: header and table are rewritten once the shards are known
+    std::string tmpOut = std::string(opt.out) + ".tmp";
+    FILE *out = fopen(tmpOut.c_str(), "wb");
+    if (!out) {
+        perror(tmpOut.c_str());
+        return 1;
+    }
+    BreachFilterHeader header = {};
+    std::vector<BreachFilterShard> shards(shardCount);
+    write_all(out, &header, sizeof(header));
+    write_all(out, shards.data(), shards.size() * sizeof(BreachFilterShard));
+    uint64_t offset = sizeof(header) + shards.size() * sizeof(BreachFilterShard);
+
+    std::vector<uint64_t> keys;
+    std::vector<uint16_t> fingerprints;
+    std::vector<uint8_t> bytes;
+    int loadedFirst = -1;
+    uint64_t distinct = 0;
+    for (uint32_t s = 0; s < shardCount; s++) {
+        // Buckets holding this shard's keys (one bucket holds several shards
+        // once shardBits > BUCKET_BITS)
+        int first = (int) (((uint64_t) s << BUCKET_BITS) >> shardBits);
+        int last = (int) ((((uint64_t) (s + 1) << BUCKET_BITS) - 1) >> shardBits);
+        if (first != loadedFirst) {
+            load_buckets(buckets, first, last, &keys);
+            loadedFirst = first;
+        }
+        auto lo = std::lower_bound(keys.begin(), keys.end(), s,
+                                   [&](uint64_t key, uint32_t shard) {
+                                       return breach_filter_shard(key, shardBits) < shard;
+                                   });
+        auto hi = std::lower_bound(lo, keys.end(), s + 1,
+                                   [&](uint64_t key, uint32_t shard) {
+                                       return breach_filter_shard(key, shardBits) < shard;
+                                   });
+        const uint64_t *shardKeys = keys.data() + (lo - keys.begin());
+        uint32_t n = (uint32_t) (hi - lo);
+        distinct += n;
+
+        uint64_t seedState = 0x726B2B9D438B9D4Dull ^ s;
+        BreachFilterShard *shard = &shards[s];
+        if (!build_shard(shardKeys, n, opt.fingerprintBits, &seedState, shard, &fingerprints)) {
+            die("no seed gave a peelable shard");
+        }
+        if (!verify_shard(shardKeys, n, opt.fingerprintBits, shard, fingerprints)) {
+            die("a built shard misses one of its keys");
+        }
+
+        pad_to(out, &offset, BREACH_FILTER_ALIGN);
+        shard->offset = offset;
+        size_t width = opt.fingerprintBits / 8;
+        bytes.resize(fingerprints.size() * width);
+        for (size_t i = 0; i < fingerprints.size(); i++) {
+            bytes[i * width] = (uint8_t) fingerprints[i];
+            if (width == 2) bytes[i * width + 1] = (uint8_t) (fingerprints[i] >> 8);
+        }
+        write_all(out, bytes.data(), bytes.size());
+        offset += bytes.size();
+    }
+
+    memcpy(header.magic, BREACH_FILTER_MAGIC, sizeof(header.magic));
+    header.version = BREACH_FILTER_VERSION;
+    header.fingerprintBits = opt.fingerprintBits;
+    header.shardBits = shardBits;
+    header.keyCount = distinct;
+    header.fileBytes = offset;
+    if (fseek(out, 0, SEEK_SET) != 0) die("seeking in the output failed");
+    write_all(out, &header, sizeof(header));
+    write_all(out, shards.data(), shards.size() * sizeof(BreachFilterShard));
+    if (fclose(out) != 0) die("writing the output failed");
+    if (rename(tmpOut.c_str(), opt.out) != 0) die("renaming the output failed");
+
+    for (int b = 0; b < BUCKETS; b++) {
+        fclose(buckets.files[b]);
+        remove(buckets.paths[b].c_str());
+    }
+
+    double end = now_seconds();
+    fprintf(stderr,
+            "%llu distinct keys, %u shards, %llu bytes: %.2f bits per key, "
+            "false positives 2^-%u; built in %.1f s\n",
+            (unsigned long long) distinct, shardCount, (unsigned long long) offset,
+            distinct ? offset * 8.0 / distinct : 0.0, opt.fingerprintBits, end - pass1);
+    return 0;
+}
@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "strength_dict_format.h"
+
+// ========== STRENGTH DICTIONARY BUILDER ==========
+// Builds the dictionary file strength_dict.cpp maps (see
+// strength_dict_format.h) from ranked word lists, e.g. the frequency lists
+// zxcvbn ships:
+//
+//   build_strength_dict -o OUT KIND:PATH[:LIMIT]...
+//     KIND   passwords, words or names (decides the feedback a match gives)
+//     PATH   one word per line, most common first; anything after the first
+//            space or tab (a frequency count) is ignored; "-" is stdin
+//     LIMIT  keep only the first LIMIT words (default: all)
+//
+// Words are lowercased (ASCII only, as the estimator does); a word seen
+// twice keeps its better rank, empty and over-long words are skipped. Every
+// word is looked up in its finished trie before the file is written.
+
+struct Word {
+    std::string text;
+    uint32_t rank;
+};
+
+struct Dictionary {
+    StrengthDictKind kind;
+    std::vector<Word> words;        // Sorted by text once read
+    std::vector<unsigned char> trie;
+};
+
+static void die(const char *what) {
+    fprintf(stderr, "build_strength_dict: %s\n", what);
+    exit(1);
+}
+
+static void usage() {
+    fprintf(stderr, "usage: build_strength_dict -o OUT passwords|words|names:PATH[:LIMIT]...\n");
+    exit(2);
+}
+
+// ========== READING ==========
+
+static bool parse_kind(const std::string &name, StrengthDictKind *kind) {
+    if (name == "passwords") *kind = STRENGTH_DICT_PASSWORDS;
+    else if (name == "words") *kind = STRENGTH_DICT_WORDS;
+    else if (name == "names") *kind = STRENGTH_DICT_NAMES;
+    else return false;
+    return true;
+}
+
+static void read_list(const char *path, uint32_t limit, Dictionary *dict, uint64_t *skipped) {
+    FILE *in = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (!in) {
+        perror(path);
+        exit(1);
+    }
+    char *line = NULL;
+    size_t lineCap = 0;
+    ssize_t len;
+    uint32_t rank = 0;
+    while ((limit == 0 || rank < limit) && (len = getline(&line, &lineCap, in)) >= 0) {
+        size_t end = strcspn(line, " \t\r\n");
+        if (end == 0 || end > STRENGTH_DICT_MAX_WORD_BYTES) {
+            (*skipped)++;
+            continue;
+        }
+        Word word;
+        word.text.assign(line, end);
+        for (char &c : word.text) {
+            if (c >= 'A' && c <= 'Z') c = (char) (c + ('a' - 'A'));
+        }
+        word.rank = ++rank;
+        dict->words.push_back(word);
+    }
+    free(line);
+    if (in != stdin) fclose(in);
+
+    // Best rank first within equal words, then drop the rest
+    std::sort(dict->words.begin(), dict->words.end(), [](const Word &a, const Word &b) {
+        return a.text != b.text ? a.text < b.text : a.rank < b.rank;
+    });
+    dict->words.erase(std::unique(dict->words.begin(), dict->words.end(),
+                                  [](const Word &a, const Word &b) { return a.text == b.text; }),
+                      dict->words.end());
+}
+
+// ========== TRIE ==========
+
+static void put_varint(std::vector<unsigned char> *out, uint32_t v) {
+    while (v >= 0x80) {
+        out->push_back((unsigned char) (v | 0x80));
+        v >>= 7;
+    }
+    out->push_back((unsigned char) v);
+}
+
+/**
+ * Appends the node for words [lo, hi), which all share their first start
+ * bytes (the edge into the node begins at start), then its children
+ */
+static void emit_node(const std::vector<Word> &words, size_t lo, size_t hi, size_t start,
+                      std::vector<unsigned char> *out) {
+    // The label runs to the end of the prefix the whole range shares; sorted
+    // order puts a word that ends there (the terminal) first
+    const std::string &firstWord = words[lo].text;
+    const std::string &lastWord = words[hi - 1].text;
+    size_t end = start;
+    while (end < firstWord.size() && end < lastWord.size() && firstWord[end] == lastWord[end]) {
+        end++;
+    }
+    uint32_t rank = 0;
+    size_t child = lo;
+    if (firstWord.size() == end) {
+        rank = words[lo].rank;
+        child++;
+    }
+
+    std::vector<std::vector<unsigned char>> children;
+    while (child < hi) {
+        unsigned char c = (unsigned char) words[child].text[end];
+        size_t next = child;
+        while (next < hi && (unsigned char) words[next].text[end] == c) next++;
+        children.emplace_back();
+        emit_node(words, child, next, end, &children.back());
+        child = next;
+    }
+
+    size_t labelLen = end - start;
+    if (labelLen > 255 || children.size() > 256) die("a word list does not fit the format");
+    uint8_t head = labelLen < STRENGTH_NODE_LABEL_EXT ? (uint8_t) labelLen : STRENGTH_NODE_LABEL_EXT;
+    if (rank) head |= STRENGTH_NODE_TERMINAL;
+    if (!children.empty()) head |= STRENGTH_NODE_CHILDREN;
+    out->push_back(head);
+    if (labelLen >= STRENGTH_NODE_LABEL_EXT) out->push_back((unsigned char) labelLen);
+    out->insert(out->end(), firstWord.begin() + start, firstWord.begin() + end);
+    if (rank) put_varint(out, rank);
+    if (children.empty()) return;
+    out->push_back((unsigned char) (children.size() - 1));
+    for (size_t i = 0; i < children.size(); i++) {
+        if (children[i].size() > UINT32_MAX) die("a word list does not fit the format");
+        if (i + 1 < children.size()) put_varint(out, (uint32_t) children[i].size());
+        out->insert(out->end(), children[i].begin(), children[i].end());
+    }
+}
+
+static bool verify_trie(const Dictionary &dict) {
+    uint32_t size = (uint32_t) dict.trie.size();
+    for (const Word &word : dict.words) {
+        StrengthCursor cursor;
+        if (!strength_cursor_root(dict.trie.data(), size, &cursor)) return false;
+        for (char c : word.text) {
+            if (!strength_cursor_step(dict.trie.data(), size, &cursor, (unsigned char) c)) {
+                return false;
+            }
+        }
+        if (strength_cursor_rank(&cursor) != word.rank) return false;
+    }
+    return true;
+}
+
+static void write_all(FILE *out, const void *data, size_t len) {
+    if (len && fwrite(data, 1, len, out) != len) die("writing the output failed");
+}
+
+int main(int argc, char **argv) {
+    const char *outPath = NULL;
+    std::vector<Dictionary> dicts;
+    uint64_t skipped = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+            continue;
+        }
+        std::string spec = argv[i];
+        size_t colon = spec.find(':');
+        if (colon == std::string::npos) usage();
+        std::string path = spec.substr(colon + 1);
+        uint32_t limit = 0;
+        size_t limitColon = path.rfind(':');
+        if (limitColon != std::string::npos && limitColon + 1 < path.size() &&
+            strspn(path.c_str() + limitColon + 1, "0123456789") == path.size() - limitColon - 1) {
+            limit = (uint32_t) strtoul(path.c_str() + limitColon + 1, NULL, 10);
+            path.resize(limitColon);
+        }
+        Dictionary dict;
+        if (!parse_kind(spec.substr(0, colon), &dict.kind)) usage();
+        read_list(path.c_str(), limit, &dict, &skipped);
+        dicts.push_back(std::move(dict));
+    }
+    if (!outPath || dicts.empty() || dicts.size() > STRENGTH_DICT_MAX_DICTS) usage();
+
+    uint64_t offset = sizeof(StrengthDictHeader) + dicts.size() * sizeof(StrengthDictEntry);
+    std::vector<StrengthDictEntry> entries(dicts.size());
+    uint64_t totalWords = 0;
+    for (size_t d = 0; d < dicts.size(); d++) {
+        Dictionary &dict = dicts[d];
+        if (dict.words.empty()) die("a word list has no usable words");
+        emit_node(dict.words, 0, dict.words.size(), 0, &dict.trie);
+        if (dict.trie.size() > UINT32_MAX) die("a word list does not fit the format");
+        if (!verify_trie(dict)) die("a built trie misses one of its words");
+
+        uint32_t maxRank = 0;
+        for (const Word &word : dict.words) maxRank = std::max(maxRank, word.rank);
+        StrengthDictEntry *entry = &entries[d];
+        entry->kind = dict.kind;
+        entry->wordCount = maxRank;
+        entry->offset = offset;
+        entry->trieBytes = (uint32_t) dict.trie.size();
+        offset += dict.trie.size();
+        totalWords += dict.words.size();
+
+        size_t textBytes = 0;
+        for (const Word &word : dict.words) textBytes += word.text.size() + 1;
+        fprintf(stderr, "list %zu: %zu words, %zu bytes as text, %zu bytes as a trie\n", d,
+                dict.words.size(), textBytes, dict.trie.size());
+    }
+
+    StrengthDictHeader header = {};
+    memcpy(header.magic, STRENGTH_DICT_MAGIC, sizeof(header.magic));
+    header.version = STRENGTH_DICT_VERSION;
+    header.dictCount = (uint32_t) dicts.size();
+    header.fileBytes = offset;
+
+    std::string tmpOut = std::string(outPath) + ".tmp";
+    FILE *out = fopen(tmpOut.c_str(), "wb");
+    if (!out) {
+        perror(tmpOut.c_str());
+        return 1;
+    }
+    write_all(out, &header, sizeof(header));
+    write_all(out, entries.data(), entries.size() * sizeof(StrengthDictEntry));
+    for (const Dictionary &dict : dicts) write_all(out, dict.trie.data(), dict.trie.size());
+    if (fclose(out) != 0) die("writing the output failed");
+    if (rename(tmpOut.c_str(), outPath) != 0) die("renaming the output failed");
+
+    fprintf(stderr, "%llu words in %zu lists (%llu lines skipped), %llu bytes\n",
+            (unsigned long long) totalWords, dicts.size(), (unsigned long long) skipped,
+            (unsigned long long) offset);
+    return 0;
+}
@@ -0,0 +1,255 @@
+#include "wipe_queue.h"
+
+#include <atomic>
+#include <ctime>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+struct WipeEntry {
+    void *ptr;
+    size_t mapLen;
+    bool locked;
+    SecureBackendKind backend;
+    uint64_t queuedNs;
+    SecretNode node;        // Guarded: the mapping is PROT_NONE until wiped
+};
+
+struct CleanMapping {
+    void *ptr;
+    size_t mapLen;
+    bool locked;
+    SecureBackendKind backend;
+};
+
+// ========== QUEUE STATE ==========
+
+// Ring of released mappings waiting for the wipe thread
+static const int QUEUE_SLOTS = 64;
+// The thread waits for this many entries, or a quarter of the lag bound
+static const int BATCH_ENTRIES = 8;
+static const uint64_t BATCH_DELAY_NS = (uint64_t) WIPE_QUEUE_MAX_LAG_MS * 1000000ull / 4;
+// Wiped, still locked mappings kept for the next locked_alloc() of that size
+static const int CLEAN_SLOTS = 4;
+static const size_t CLEAN_MAX_BYTES = 4 * 1024 * 1024;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_wake;       // Entries queued
+static pthread_cond_t g_drained;    // A batch finished
+static pthread_once_t g_startOnce = PTHREAD_ONCE_INIT;
+static bool g_started = false;
+static bool g_enabled = false;
+
+// Entries are wiped in place (their nodes are registered), so the g_inFlight
+// slots before g_head stay taken until the thread is done with them
+static WipeEntry g_ring[QUEUE_SLOTS];
+static int g_head = 0;              // Oldest entry
+static int g_count = 0;
+static int g_inFlight = 0;          // Taken by the thread, not wiped yet
+static uint64_t g_pendingBytes = 0;
+
+static CleanMapping g_clean[CLEAN_SLOTS];
+static int g_cleanCount = 0;
+static size_t g_cleanBytes = 0;
+
+static std::atomic<uint64_t> g_deferred{0};
+static std::atomic<uint64_t> g_fallbacks{0};
+static std::atomic<uint64_t> g_maxLagNs{0};
+
+static uint64_t clock_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+// ========== WIPE THREAD ==========
+
+/**
+ * Wipes one mapping, then caches it for reuse or unmaps it
+ */
+static void wipe_entry(WipeEntry *e) {
+    bool writable = mprotect(e->ptr, e->mapLen, PROT_READ | PROT_WRITE) == 0;
+    if (writable) backend_wipe(e->ptr, e->mapLen);
+    // Zeroed (or about to be unmapped): emergency wipes may let go of it
+    secret_registry_remove(&e->node);
+    if (!writable) {
+        // Cannot write it back to zero: dropping the pages still discards them
+        backend_unmap(e->ptr, e->mapLen, e->locked, e->backend);
+        return;
+    }
+
+    uint64_t lag = clock_ns() - e->queuedNs;
+    uint64_t prev = g_maxLagNs.load(std::memory_order_relaxed);
+    while (lag > prev && !g_maxLagNs.compare_exchange_weak(prev, lag, std::memory_order_relaxed)) {}
+
+    pthread_mutex_lock(&g_lock);
+    bool keep = e->locked && g_enabled && g_cleanCount < CLEAN_SLOTS &&
+                g_cleanBytes + e->mapLen <= CLEAN_MAX_BYTES;
+    if (keep) {
+        g_clean[g_cleanCount++] = {e->ptr, e->mapLen, e->locked, e->backend};
+        g_cleanBytes += e->mapLen;
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    if (!keep) backend_unmap(e->ptr, e->mapLen, e->locked, e->backend);
+}
+
+static void *wipe_thread_main(void *) {
+    // Lower priority than the UI thread, but it still has a deadline to keep
+    setpriority(PRIO_PROCESS, (id_t) syscall(__NR_gettid), 5);
+
+    pthread_mutex_lock(&g_lock);
+    for (;;) {
+        if (g_count == 0) {
+            pthread_cond_wait(&g_wake, &g_lock);
+            continue;
+        }
+        // Gather a batch unless the oldest entry has waited long enough
+        uint64_t due = g_ring[g_head].queuedNs + BATCH_DELAY_NS;
+        if (g_count < BATCH_ENTRIES && g_enabled && clock_ns() < due) {
+            struct timespec ts;
+            ts.tv_sec = (time_t) (due / 1000000000ull);
+            ts.tv_nsec = (long) (due % 1000000000ull);
+            pthread_cond_timedwait(&g_wake, &g_lock, &ts);
+            continue;
+        }
+
+        int first = g_head;
+        int n = g_count;
+        g_head = (g_head + n) % QUEUE_SLOTS;
+        g_count = 0;
+        g_inFlight = n;
+        pthread_mutex_unlock(&g_lock);
+
+        for (int i = 0; i < n; i++) wipe_entry(&g_ring[(first + i) % QUEUE_SLOTS]);
+
+        pthread_mutex_lock(&g_lock);
+        for (int i = 0; i < n; i++) g_pendingBytes -= g_ring[(first + i) % QUEUE_SLOTS].mapLen;
+        g_inFlight = 0;
+        pthread_cond_broadcast(&g_drained);
+    }
+    return NULL;
+}
+
+static void start_wipe_thread() {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_wake, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_cond_init(&g_drained, NULL);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, wipe_thread_main, NULL) == 0) {
+        pthread_detach(thread);
+        g_started = true;
+    }
+}
+
+// ========== PUBLIC API ==========
+
+bool wipe_queue_set_enabled(bool enabled) {
+    if (enabled) pthread_once(&g_startOnce, start_wipe_thread);
+
+    pthread_mutex_lock(&g_lock);
+    bool prev = g_enabled;
+    g_enabled = enabled && g_started;
+
+    if (!g_enabled) {
+        // Nothing may outlive the mode: flush the queue, give back the cache
+        pthread_cond_broadcast(&g_wake);
+        while (g_count || g_inFlight) pthread_cond_wait(&g_drained, &g_lock);
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    if (!enabled) wipe_queue_trim();
+    return prev;
+}
+
+size_t wipe_queue_trim() {
+    CleanMapping clean[CLEAN_SLOTS];
+    pthread_mutex_lock(&g_lock);
+    int cleanCount = g_cleanCount;
+    for (int i = 0; i < cleanCount; i++) clean[i] = g_clean[i];
+    g_cleanCount = 0;
+    g_cleanBytes = 0;
+    pthread_mutex_unlock(&g_lock);
+
+    size_t released = 0;
+    for (int i = 0; i < cleanCount; i++) {
+        backend_unmap(clean[i].ptr, clean[i].mapLen, clean[i].locked, clean[i].backend);
+        released += clean[i].mapLen;
+    }
+    return released;
+}
+
+bool wipe_queue_defer(void *ptr, size_t mapLen, bool locked, SecureBackendKind backend,
+                      SecretNode *owner) {
+    if (!ptr || mapLen < WIPE_QUEUE_MIN_BYTES) return false;
+
+    pthread_mutex_lock(&g_lock);
+    if (!g_enabled) {
+        pthread_mutex_unlock(&g_lock);
+        return false;
+    }
+
+    // Keep the lag bound: a full ring or an overdue head means the thread is
+    // behind, and queueing more would only push every entry further out
+    uint64_t now = clock_ns();
+    uint64_t maxLagNs = (uint64_t) WIPE_QUEUE_MAX_LAG_MS * 1000000ull;
+    bool behind = g_count + g_inFlight == QUEUE_SLOTS ||
+                  (g_count && now - g_ring[g_head].queuedNs > maxLagNs / 2);
+    // The owner's node goes first: once it is out no wipe is writing to the
+    // mapping, so making it PROT_NONE cannot fault one. The guarded node
+    // below then covers it until the thread has zeroed it
+    if (!behind) secret_registry_remove(owner);
+    if (behind || mprotect(ptr, mapLen, PROT_NONE) != 0) {
+        pthread_mutex_unlock(&g_lock);
+        g_fallbacks.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    WipeEntry *e = &g_ring[(g_head + g_count) % QUEUE_SLOTS];
+    e->ptr = ptr;
+    e->mapLen = mapLen;
+    e->locked = locked;
+    e->backend = backend;
+    e->queuedNs = now;
+    // Released memory: a pause wipe may take it as well as a crash
+    secret_registry_add(&e->node, ptr, mapLen, SECRET_CLASS_PLAINTEXT, true);
+    g_count++;
+    g_pendingBytes += mapLen;
+    if (g_count == 1 || g_count == BATCH_ENTRIES) pthread_cond_signal(&g_wake);
+    pthread_mutex_unlock(&g_lock);
+
+    g_deferred.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void *wipe_queue_take_clean(size_t mapLen, bool *locked, SecureBackendKind *backend) {
+    void *mem = NULL;
+    pthread_mutex_lock(&g_lock);
+    for (int i = 0; i < g_cleanCount; i++) {
+        if (g_clean[i].mapLen != mapLen) continue;
+        mem = g_clean[i].ptr;
+        *locked = g_clean[i].locked;
+        *backend = g_clean[i].backend;
+        g_cleanBytes -= mapLen;
+        g_clean[i] = g_clean[--g_cleanCount];
+        break;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return mem;
+}
+
+void wipe_queue_info(WipeQueueInfo *out) {
+    out->deferred = g_deferred.load(std::memory_order_relaxed);
+    out->fallbacks = g_fallbacks.load(std::memory_order_relaxed);
+    out->maxLagNs = g_maxLagNs.load(std::memory_order_relaxed);
+    pthread_mutex_lock(&g_lock);
+    out->pendingBytes = g_pendingBytes;
+    pthread_mutex_unlock(&g_lock);
+}
@@ -0,0 +1,72 @@
+#ifndef FUZZME_V3_WIPE_QUEUE_H
+#define FUZZME_V3_WIPE_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "secret_registry.h"
+#include "secure_backend.h"
+
+// ========== DEFERRED WIPE QUEUE ==========
+// Optional mode that takes large wipes off the caller's thread. A released
+// mapping is made PROT_NONE right away (the caller can no longer read it) and
+// a dedicated thread zeroes the queued mappings in batches, then keeps a few
+// for reuse and unmaps the rest. Every queued mapping is wiped within
+// WIPE_QUEUE_MAX_LAG_MS; when the queue is full or the thread falls behind,
+// the caller wipes synchronously instead. Until it is wiped, a queued mapping
+// stays in the secret registry (guarded), so crash and pause wipes reach it.
+
+// Only mappings at least this large are deferred, smaller wipes are cheap
+static const size_t WIPE_QUEUE_MIN_BYTES = 64 * 1024;
+
+// Latency bound from release to wiped
+static const uint32_t WIPE_QUEUE_MAX_LAG_MS = 20;
+
+/**
+ * Turns deferred wiping on or off (off by default)
+ * Turning it off waits until everything queued has been wiped
+ *
+ * @return Previous setting
+ */
+bool wipe_queue_set_enabled(bool enabled);
+
+/**
+ * Hands a released, page-aligned mapping from backend_map() to the wipe thread
+ *
+ * @param owner Registry node covering the mapping; the queue registers its
+ *              own in its place
+ * @return false if the caller must wipe and unmap it itself
+ *         (mode off, too small, queue full or the thread is lagging);
+ *         owner may already be unregistered then
+ */
+bool wipe_queue_defer(void *ptr, size_t mapLen, bool locked, SecureBackendKind backend,
+                      SecretNode *owner);
+
+/**
+ * Takes an already wiped mapping of exactly mapLen for reuse
+ * Cached mappings are locked and still counted in the lock budget, so the
+ * caller checks its priority's ceiling first
+ *
+ * @return Mapping (readable and writable), or NULL if none is cached
+ */
+void *wipe_queue_take_clean(size_t mapLen, bool *locked, SecureBackendKind *backend);
+
+/**
+ * Unmaps the wiped mappings kept for reuse (memory pressure)
+ * @return Bytes unmapped
+ */
+size_t wipe_queue_trim();
+
+/**
+ * Queue diagnostics
+ */
+struct WipeQueueInfo {
+    uint64_t deferred;      // Mappings handed to the wipe thread
+    uint64_t fallbacks;     // Releases wiped synchronously while the mode was on
+    uint64_t maxLagNs;      // Longest release-to-wiped delay seen
+    uint64_t pendingBytes;  // Bytes currently waiting
+};
+
+void wipe_queue_info(WipeQueueInfo *out);
+
+#endif // FUZZME_V3_WIPE_QUEUE_H
@@ -0,0 +1,256 @@
+#include "worker_pool.h"
+
+#include <pthread.h>
+
+#include "jni_util.h"
+
+enum RequestState : uint8_t {
+    REQUEST_FREE = 0,
+    REQUEST_QUEUED,
+    REQUEST_RUNNING,      // Work or (if cancelled) cleanup in progress
+    REQUEST_DELIVERING    // Finished, cleanup and callback in progress
+};
+
+struct Request {
+    Request *prev;
+    Request *next;          // Queue link, or free list link when REQUEST_FREE
+    uint32_t index;
+    uint32_t generation;    // Bumped on every reuse so stale handles miss
+    RequestState state;
+    std::atomic<bool> cancelled;
+    WorkerRunFn run;
+    WorkerCleanupFn cleanup;
+    void *userState;
+    jobject callback;       // Global reference
+    jmethodID onResult;
+};
+
+// ========== POOL STATE (guarded by g_lock) ==========
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_work = PTHREAD_COND_INITIALIZER;   // Workers sleep on this
+static pthread_cond_t g_done = PTHREAD_COND_INITIALIZER;   // Cancel waits here for a running request
+static pthread_once_t g_startOnce = PTHREAD_ONCE_INIT;
+static bool g_started = false;
+
+static Request g_requests[WORKER_MAX_REQUESTS];
+static Request g_queue;                 // FIFO sentinel
+static Request *g_freeList = nullptr;
+static size_t g_pending = 0;
+
+// ========== REQUEST TABLE ==========
+
+static Request *request_alloc() {
+    Request *req = g_freeList;
+    if (!req) return nullptr;
+    g_freeList = req->next;
+    req->generation++;
+    req->cancelled.store(false, std::memory_order_relaxed);
+    return req;
+}
+
+static void request_free(Request *req) {
+    req->state = REQUEST_FREE;
+    req->userState = nullptr;
+    req->callback = nullptr;
+    req->next = g_freeList;
+    g_freeList = req;
+}
+
+static uint64_t request_handle(const Request *req) {
+    return ((uint64_t) req->generation << 32) | req->index;
+}
+
+static Request *request_lookup(uint64_t handle) {
+    uint32_t index = (uint32_t) handle;
+    if (index >= WORKER_MAX_REQUESTS) return nullptr;
+    Request *req = &g_requests[index];
+    return req->generation == (uint32_t) (handle >> 32) ? req : nullptr;
+}
+
+static void queue_push(Request *req) {
+    req->prev = g_queue.prev;
+    req->next = &g_queue;
+    g_queue.prev->next = req;
+    g_queue.prev = req;
+}
+
+static void queue_unlink(Request *req) {
+    req->prev->next = req->next;
+    req->next->prev = req->prev;
+    req->prev = req->next = nullptr;
+}
+
+static void release_callback(JNIEnv *env, Request *req) {
+    if (env && req->callback) env->DeleteGlobalRef(req->callback);
+}
+
+// ========== WORKERS ==========
+
+static void deliver(JNIEnv *env, Request *req, uint64_t handle, bool result) {
+    if (!env) return;
+    env->CallVoidMethod(req->callback, req->onResult, (jlong) handle,
+                        result ? JNI_TRUE : JNI_FALSE);
+    // A throwing callback must not leave a pending exception on this thread
+    if (env->ExceptionCheck()) {
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+    }
+}
+
+static void *worker_main(void *) {
+    JNIEnv *env = jni_attach_current_thread();
+
+    pthread_mutex_lock(&g_lock);
+    for (;;) {
+        while (g_queue.next == &g_queue) pthread_cond_wait(&g_work, &g_lock);
+        Request *req = g_queue.next;
+        queue_unlink(req);
+        req->state = REQUEST_RUNNING;
+        uint64_t handle = request_handle(req);
+        pthread_mutex_unlock(&g_lock);
+
+        bool result = req->run(env, req->userState, &req->cancelled);
+
+        // Decide under the lock so a concurrent cancel either wins (and waits
+        // for the cleanup below) or sees the request as finished
+        pthread_mutex_lock(&g_lock);
+        bool cancelled = req->cancelled.load(std::memory_order_relaxed);
+        if (!cancelled) req->state = REQUEST_DELIVERING;
+        pthread_mutex_unlock(&g_lock);
+
+        // State is wiped before Java hears about the result
+        req->cleanup(env, req->userState, cancelled);
+        if (!cancelled) deliver(env, req, handle, result);
+        release_callback(env, req);
+
+        pthread_mutex_lock(&g_lock);
+        request_free(req);
+        g_pending--;
+        pthread_cond_broadcast(&g_done);
+    }
+    return nullptr;
+}
+
+static void start_workers() {
+    g_queue.prev = g_queue.next = &g_queue;
+    for (uint32_t i = WORKER_MAX_REQUESTS; i-- > 0;) {
+        g_requests[i].index = i;
+        g_requests[i].next = g_freeList;
+        g_freeList = &g_requests[i];
+    }
+
+    for (int i = 0; i < WORKER_THREADS; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, worker_main, NULL) == 0) {
+            pthread_detach(thread);
+            g_started = true;
+        }
+    }
+}
+
+// ========== PUBLIC API ==========
+
+uint64_t worker_submit(JNIEnv *env, jobject callback, WorkerRunFn run,
+                       WorkerCleanupFn cleanup, void *state) {
+    pthread_once(&g_startOnce, start_workers);
+
+    // Resolved here: worker threads cannot see app classes by name
+    jmethodID onResult = nullptr;
+    jobject ref = nullptr;
+    if (g_started && env && callback) {
+        jclass cls = env->GetObjectClass(callback);
+        onResult = cls ? env->GetMethodID(cls, "onNativeResult", "(JZ)V") : nullptr;
+        if (cls) env->DeleteLocalRef(cls);
+        if (!onResult) env->ExceptionClear();
+        else ref = env->NewGlobalRef(callback);
+    }
+    if (!ref) {
+        cleanup(env, state, false);
+        return 0;
+    }
+
+    pthread_mutex_lock(&g_lock);
+    Request *req = request_alloc();
+    if (!req) {
+        pthread_mutex_unlock(&g_lock);
+        env->DeleteGlobalRef(ref);
+        cleanup(env, state, false);
+        return 0;
+    }
+    req->run = run;
+    req->cleanup = cleanup;
+    req->userState = state;
+    req->callback = ref;
+    req->onResult = onResult;
+    req->state = REQUEST_QUEUED;
+    queue_push(req);
+    g_pending++;
+    uint64_t handle = request_handle(req);
+    pthread_cond_signal(&g_work);
+    pthread_mutex_unlock(&g_lock);
+    return handle;
+}
+
+bool worker_cancel(JNIEnv *env, uint64_t handle) {
+    if (!handle || !g_started) return false;
+
+    pthread_mutex_lock(&g_lock);
+    Request *req = request_lookup(handle);
+    if (!req || req->state == REQUEST_FREE || req->state == REQUEST_DELIVERING) {
+        pthread_mutex_unlock(&g_lock);
+        return false;
+    }
+
+    // Running: flag it and wait until the worker has wiped it
+    if (req->state == REQUEST_RUNNING) {
+        req->cancelled.store(true, std::memory_order_relaxed);
+        while (req->generation == (uint32_t) (handle >> 32) && req->state == REQUEST_RUNNING) {
+            pthread_cond_wait(&g_done, &g_lock);
+        }
+        pthread_mutex_unlock(&g_lock);
+        return true;
+    }
+
+    queue_unlink(req);
+    req->state = REQUEST_RUNNING;  // Keeps the slot ours while we clean up
+    pthread_mutex_unlock(&g_lock);
+
+    req->cleanup(env, req->userState, true);
+    release_callback(env, req);
+
+    pthread_mutex_lock(&g_lock);
+    request_free(req);
+    g_pending--;
+    pthread_cond_broadcast(&g_done);
+    pthread_mutex_unlock(&g_lock);
+    return true;
+}
+
+size_t worker_cancel_all(JNIEnv *env) {
+    if (!g_started) return 0;
+
+    // Snapshot, then cancel one by one: worker_cancel() drops the lock to
+    // clean up, and requests finishing meanwhile simply miss
+    uint64_t handles[WORKER_MAX_REQUESTS];
+    size_t count = 0;
+    pthread_mutex_lock(&g_lock);
+    for (uint32_t i = 0; i < WORKER_MAX_REQUESTS; i++) {
+        const Request *req = &g_requests[i];
+        if (req->state == REQUEST_QUEUED || req->state == REQUEST_RUNNING) {
+            handles[count++] = request_handle(req);
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    size_t cancelled = 0;
+    for (size_t i = 0; i < count; i++) cancelled += worker_cancel(env, handles[i]);
+    return cancelled;
+}
+
+size_t worker_pending() {
+    pthread_mutex_lock(&g_lock);
+    size_t pending = g_pending;
+    pthread_mutex_unlock(&g_lock);
+    return pending;
+}
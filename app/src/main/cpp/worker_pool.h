@@ -0,0 +1,77 @@
+#ifndef FUZZME_V3_WORKER_POOL_H
+#define FUZZME_V3_WORKER_POOL_H
+
+#include <jni.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// ========== ASYNC WORKER POOL ==========
+// Runs slow native requests (credential checks, decrypts, KDFs) off the UI
+// thread. A JNI submit call hands a request to a small pool of attached
+// native threads and returns a handle at once; when the request finishes,
+// its result goes to a Java callback object on the worker thread. A request
+// can be cancelled at any point before its callback: its state is wiped and
+// no callback is made. Handles are never reused (0 = invalid).
+
+// Worker threads (requests are short and mostly serialized on the same secrets)
+static const int WORKER_THREADS = 2;
+
+// Requests queued or running at once; submitting more fails
+static const uint32_t WORKER_MAX_REQUESTS = 64;
+
+/**
+ * Does the work on a worker thread (attached to the VM)
+ * Long-running work should poll cancelled and give up early when it is set
+ *
+ * @return Result handed to the callback
+ */
+typedef bool (*WorkerRunFn)(JNIEnv *env, void *state, const std::atomic<bool> *cancelled);
+
+/**
+ * Wipes and frees a request's state; always called exactly once
+ *
+ * @param env       JNIEnv of the calling thread (worker or canceller), may be NULL
+ * @param cancelled The request was cancelled, so any output it already
+ *                  produced (e.g. plaintext written to a Java array) must go too
+ */
+typedef void (*WorkerCleanupFn)(JNIEnv *env, void *state, bool cancelled);
+
+/**
+ * Queues a request
+ * The callback object must have a void onNativeResult(long handle, boolean ok)
+ * method; it is called on a worker thread, so post to the UI from there.
+ * On failure cleanup has already run (not cancelled)
+ *
+ * @param env      JNIEnv of the submitting Java thread
+ * @param callback Java callback (a global reference is kept until it ran)
+ * @return Handle, or 0 if the pool is full or the callback is unusable
+ */
+uint64_t worker_submit(JNIEnv *env, jobject callback, WorkerRunFn run,
+                       WorkerCleanupFn cleanup, void *state);
+
+/**
+ * Cancels a request whose callback has not started
+ * A running request is flagged and waited for, so once this returns its
+ * state and outputs are wiped
+ *
+ * @return true if the request was cancelled (its callback will never run),
+ *         false if it already finished or the handle is unknown
+ */
+bool worker_cancel(JNIEnv *env, uint64_t handle);
+
+/**
+ * Cancels every request whose callback has not started, as worker_cancel()
+ * does for one: on return no worker is touching request state. Run before an
+ * emergency wipe so the wipe never zeroes a buffer a request is still using
+ *
+ * @return Requests cancelled
+ */
+size_t worker_cancel_all(JNIEnv *env);
+
+/**
+ * Number of requests queued or running
+ */
+size_t worker_pending();
+
+#endif // FUZZME_V3_WORKER_POOL_H
@@ -5,11 +5,14 @@ import androidx.appcompat.app.AppCompatActivity;
 import android.content.Intent;
 import android.os.Bundle;
 import android.util.Log;
+import android.view.View;
 import android.widget.Button;
+import android.widget.TextView;
 import android.widget.Toast;
 
 import com.example.fuzzme_v3.SecureEditText;
 
+import java.io.File;
 import java.security.SecureRandom;
 import java.util.Arrays;
 
@@ -19,10 +22,41 @@ public class MainActivity extends AppCompatActivity {
 
     // Custom secure text input fields - store data as char[] not String
     private SecureEditText secureUsername, securePassword;
+    // Second factor: a TOTP code, checked natively once the credentials matched
+    // Only shown (and asked for) once a seed was enrolled in SecretActivity
+    private SecureEditText secureOtp;
+    private TextView tvOtpLabel;
     // UI buttons
     private Button btnLogin, btnClear;
+    // Live password strength (non-sensitive: a score and a hint)
+    private TextView tvStrength;
     // Secure random generator for wiping sensitive arrays
     private final SecureRandom secureRandom = new SecureRandom();
+    // Native credential check in flight (0 = none), UI thread only
+    private long pendingLogin = 0;
+    // Typing pause after which the password hash starts speculatively
+    private static final long PASSWORD_SPECULATION_IDLE_MS = 400;
+    // Breached-password filter in the app's files directory (optional)
+    private static final String BREACH_FILTER_FILE = "breach_filter.bin";
+    // Strength estimator word lists in the app's files directory (optional)
+    private static final String STRENGTH_DICT_FILE = "strength_dict.bin";
+    private static final String[] STRENGTH_LABELS = {
+            "Very weak", "Weak", "Fair", "Strong", "Very strong"
+    };
+    // Indexed by NativeBridge.STRENGTH_FEEDBACK_*
+    private static final String[] STRENGTH_HINTS = {
+            "",
+            "one of the most common passwords",
+            "a commonly used password",
+            "contains a dictionary word",
+            "contains a name",
+            "contains your username",
+            "a keyboard pattern",
+            "repeated characters",
+            "a sequence like abc or 123",
+            "a recent year",
+            "a date"
+    };
 
     @Override
     protected void onCreate(Bundle savedInstanceState) {
@@ -33,44 +67,124 @@ public class MainActivity extends AppCompatActivity {
         // Initialize UI components by finding them in the layout
         secureUsername = findViewById(R.id.etUser);
         securePassword = findViewById(R.id.etPassword);
+        secureOtp = findViewById(R.id.etOtp);
+        tvOtpLabel = findViewById(R.id.tvOtpLabel);
         btnLogin = findViewById(R.id.btnLogin);
         btnClear = findViewById(R.id.btnClear);
+        tvStrength = findViewById(R.id.tvStrength);
 
         // Set hints (non-sensitive text, so using String is safe)
         secureUsername.setHint("Username");
         securePassword.setHint("Password");
+        secureOtp.setHint("One-time code");
+
+        // A check reads both credentials from streams or both from buffers, so
+        // when one field's stream is dropped the other falls back with it
+        secureUsername.pairKeystrokeStreams(securePassword);
+
+        // Hash the password while the user reaches for Login
+        securePassword.setSpeculativeHashing(PASSWORD_SPECULATION_IDLE_MS);
+
+        // Reject known-breached passwords if a filter was installed
+        File breachFilter = new File(getFilesDir(), BREACH_FILTER_FILE);
+        if (breachFilter.exists()) {
+            long breached = NativeBridge.loadBreachFilter(breachFilter.getPath());
+            Log.d("MEM_SEC", "Breach filter: " + breached + " passwords");
+        }
+
+        // Rate the password natively as it is typed (the username counts against it)
+        File strengthDict = new File(getFilesDir(), STRENGTH_DICT_FILE);
+        if (strengthDict.exists()) {
+            long words = NativeBridge.loadStrengthDictionary(strengthDict.getPath());
+            Log.d("MEM_SEC", "Strength dictionary: " + words + " words");
+        }
+        securePassword.setOnSecureEditListener(field -> updateStrength());
+        secureUsername.setOnSecureEditListener(field -> updateStrength());
 
         // Set up click listeners for buttons
         btnLogin.setOnClickListener(v -> doLogin());   // Login button
         btnClear.setOnClickListener(v -> clearAll());  // Clear button
     }
 
+    /**
+     * Called when the activity comes to the foreground
+     * A seed may have been enrolled meanwhile: show the code field if so
+     */
+    @Override
+    protected void onResume() {
+        super.onResume();
+        int visibility = NativeBridge.isOtpEnrolled() ? View.VISIBLE : View.GONE;
+        tvOtpLabel.setVisibility(visibility);
+        secureOtp.setVisibility(visibility);
+    }
+
     /**
      * Performs secure login with credential validation
-     * Uses direct buffer access to avoid copying sensitive data
+     * Streamed fields are checked from their native streams (their text never
+     * reached Java), other fields from their buffers; either way the check
+     * runs on the native worker pool and the result arrives in onLoginResult()
      */
     private void doLogin() {
+        // One check at a time (the button is disabled meanwhile)
+        if (pendingLogin != 0) return;
+
         // Step 1: Get buffer lengths first (without exposing actual data)
         int userLen = secureUsername.getBufferLength();
         int passLen = securePassword.getBufferLength();
 
-        // Validate that both fields have content
-        if (userLen == 0 || passLen == 0) {
-            showToast("Please enter both fields");
+        // Validate that every field has content (the code only once enrolled)
+        if (userLen == 0 || passLen == 0 ||
+                (NativeBridge.isOtpEnrolled() && secureOtp.getBufferLength() == 0)) {
+            showToast("Please fill in all fields");
             return; // Exit early if fields are empty
         }
 
+        // Streamed fields: the native side already holds the text; the password
+        // hash (usually started speculatively while typing paused) is taken or
+        // collected on the worker pool. The streams are read before this returns.
+        // The fields are paired, so either both are streamed or neither is
+        long userStream = secureUsername.getKeystrokeStream();
+        long passStream = securePassword.getKeystrokeStream();
+        if (passStream != 0 &&
+                NativeBridge.checkKeystrokesBreached(passStream) == NativeBridge.BREACH_FOUND) {
+            rejectBreachedPassword();
+            return;
+        }
+        // The one-time code goes with the credentials (natively it is only
+        // looked at once a seed is enrolled) and is used up by any attempt
+        long otpStream = secureOtp.getKeystrokeStream();
+        char[] otpBuffer = otpStream == 0 ? secureOtp.getSecureBufferDirect() : null;
+        int otpLen = secureOtp.getBufferLength();
+        if (userStream != 0 && passStream != 0) {
+            long handle = NativeBridge.submitCheckStreamedCredentials(userStream, passStream,
+                    otpStream, otpBuffer, otpLen,
+                    (h, ok) -> runOnUiThread(() -> onLoginResult(h, ok)));
+            secureUsername.clearSecureBuffer();
+            securePassword.clearSecureBuffer();
+            clearOtp(otpBuffer, otpLen);
+            startPendingLogin(handle);
+            return;
+        }
+
         // Step 2: Get direct buffer references - CRITICAL FOR SECURITY
         // These are direct references to the internal char[] buffers, NOT copies
         // This avoids creating additional copies of sensitive data
         char[] userBuffer = secureUsername.getSecureBufferDirect();
         char[] passBuffer = securePassword.getSecureBufferDirect();
+        if (passStream == 0 && NativeBridge.checkPasswordBreached(passBuffer, passLen)
+                == NativeBridge.BREACH_FOUND) {
+            rejectBreachedPassword();
+            return;
+        }
 
-        // Step 3: Call native code for credential validation
-        // NativeBridge receives the actual buffers (no copying on Java side)
-        boolean ok = NativeBridge.checkCredentials(
+        // Step 3: Hand the check to the native worker pool
+        // Native code copies the buffers into locked memory before returning,
+        // so the UI thread never waits for the comparison itself
+        long handle = NativeBridge.submitCheckCredentials(
                 userBuffer, passBuffer,    // Direct buffer references
-                userLen, passLen           // Actual data lengths
+                userLen, passLen,          // Actual data lengths
+                otpStream, otpBuffer, otpLen,
+                (h, ok) -> runOnUiThread(() -> onLoginResult(h, ok))
         );
 
         // Step 4: SECURE WIPING of the original buffers
@@ -82,14 +196,99 @@ public class MainActivity extends AppCompatActivity {
         // This ensures the UI components don't retain the data
         secureUsername.clearSecureBuffer();
         securePassword.clearSecureBuffer();
+        clearOtp(otpBuffer, otpLen);
+
+        startPendingLogin(handle);
+    }
+
+    /**
+     * Wipes the one-time code once it was submitted
+     * A code is only good once, so it is never worth keeping
+     */
+    private void clearOtp(char[] otpBuffer, int otpLen) {
+        secureWipeArray(otpBuffer, otpLen);
+        secureOtp.clearSecureBuffer();
+    }
 
+    /**
+     * Shows the strength of the password as typed so far (UI thread)
+     * The text never leaves native code (streamed fields) or the secure
+     * buffers; only the packed score comes back
+     */
+    private void updateStrength() {
+        int passLen = securePassword.getBufferLength();
+        if (passLen == 0) {
+            tvStrength.setText("");
+            return;
+        }
+        long passStream = securePassword.getKeystrokeStream();
+        long userStream = secureUsername.getKeystrokeStream();
+        int packed;
+        if (passStream != 0) {
+            packed = NativeBridge.estimateKeystrokesStrength(passStream, userStream);
+        } else {
+            char[] userBuffer = userStream == 0 ? secureUsername.getSecureBufferDirect() : null;
+            packed = NativeBridge.estimatePasswordStrength(securePassword.getSecureBufferDirect(),
+                    passLen, userBuffer, secureUsername.getBufferLength());
+        }
+        if (packed < 0) {
+            tvStrength.setText("");
+            return;
+        }
+        String label = STRENGTH_LABELS[NativeBridge.strengthScore(packed)];
+        int feedback = NativeBridge.strengthFeedback(packed);
+        String hint = feedback < STRENGTH_HINTS.length ? STRENGTH_HINTS[feedback] : "";
+        tvStrength.setText(hint.isEmpty() ? label : label + ": " + hint);
+    }
+
+    /**
+     * Refuses a password found in the breach filter, without checking it
+     */
+    private void rejectBreachedPassword() {
+        securePassword.clearSecureBuffer();
+        showToast("This password appeared in a data breach, choose another");
+    }
+
+    /**
+     * Tracks a submitted credential check until onLoginResult()
+     *
+     * @param handle Request handle, 0 if submitting failed
+     */
+    private void startPendingLogin(long handle) {
+        if (handle == 0) {
+            showToast("Login unavailable, try again");
+            return;
+        }
+        pendingLogin = handle;
+        btnLogin.setEnabled(false);
+    }
+
+    /**
+     * Handles the result of a credential check (UI thread)
+     *
+     * @param handle Request the result belongs to
+     * @param ok     Whether the credentials matched
+     */
+    private void onLoginResult(long handle, boolean ok) {
+        // Stale result: the check was cancelled meanwhile
+        if (handle != pendingLogin) return;
+        pendingLogin = 0;
+        btnLogin.setEnabled(true);
+        showLoginResult(ok);
+    }
+
+    /**
+     * Reports a finished credential check (UI thread)
+     * The check covered the code too: which factor failed is not shown
+     */
+    private void showLoginResult(boolean ok) {
         // Step 6: Handle login result
-        if (ok) {
+        if (!ok) {
+            showToast("Invalid credentials");
+        } else {
             showToast("Login Successful!");
             // Navigate to secret activity on successful login
             startActivity(new Intent(this, SecretActivity.class));
-        } else {
-            showToast("Invalid credentials");
         }
     }
 
@@ -135,9 +334,10 @@ public class MainActivity extends AppCompatActivity {
      * Clears all input fields (user-initiated)
      */
     private void clearAll() {
-        // Clear both username and password fields
+        // Clear every field
         secureUsername.clearSecureBuffer();
         securePassword.clearSecureBuffer();
+        secureOtp.clearSecureBuffer();
         showToast("All inputs cleared");
     }
 
@@ -157,12 +357,36 @@ public class MainActivity extends AppCompatActivity {
     @Override
     protected void onPause() {
         super.onPause();
+        // Drop a check still in flight; its native copy is wiped
+        if (pendingLogin != 0) {
+            NativeBridge.cancelRequest(pendingLogin);
+            pendingLogin = 0;
+            btnLogin.setEnabled(true);
+        }
+        // Native side: wipe any plaintext still in flight, regardless of finishing
+        NativeBridge.wipeAllSecrets();
+        // That included the text of streamed fields: empty them so they match
+        if (secureUsername.getKeystrokeStream() != 0) secureUsername.clearSecureBuffer();
+        if (securePassword.getKeystrokeStream() != 0) securePassword.clearSecureBuffer();
+        if (secureOtp.getKeystrokeStream() != 0) secureOtp.clearSecureBuffer();
         // Only clear if activity is finishing (being destroyed)
         // This prevents clearing during configuration changes like rotation
         if (isFinishing()) {
             secureUsername.clearSecureBuffer();
             securePassword.clearSecureBuffer();
+            secureOtp.clearSecureBuffer();
             Log.d("MEM_SEC", "Buffers cleared on pause");
         }
     }
+
+    /**
+     * Called when the system wants memory back
+     * Hands unused locked native memory back to the kernel
+     */
+    @Override
+    public void onTrimMemory(int level) {
+        super.onTrimMemory(level);
+        long released = NativeBridge.trimSecureMemory(level);
+        Log.d("MEM_SEC", "Trim level " + level + " released " + released + " locked bytes");
+    }
 }
\ No newline at end of file
@@ -18,6 +18,245 @@ public class NativeBridge {
     // Secure wipe
     public static native void wipeFlagBuffer(char[] buffer);
 
+    // Native TTL wipe: zeroes the buffer on a native thread after ttlMillis,
+    // independent of the UI thread. Returns a handle (0 on failure)
+    public static native long scheduleWipe(char[] buffer, long ttlMillis);
+
+    // Cancels a pending TTL wipe; true if it had not fired yet
+    public static native boolean cancelWipe(long handle);
+
+    // Emergency wipe of every in-flight native plaintext region (call from onPause)
+    // Returns the number of bytes wiped
+    public static native long wipeAllSecrets();
+
+    // Background re-randomization of the native credential shares:
+    // one pass every intervalMillis (0 = off), using at most cpuPermille/1000 of a core
+    public static native boolean setShareRefresh(long intervalMillis, int cpuPermille);
+
+    // Wipe large released native buffers on a background thread (bounded lag)
+    // Returns the previous setting; turning it off flushes the queue
+    public static native boolean setDeferredWipe(boolean enabled);
+
+    // Release locked native memory under pressure (call from onTrimMemory)
+    // Returns the number of locked bytes released
+    public static native long trimSecureMemory(int level);
+
+    // Result of a request submitted to the native worker pool
+    // Called on a native worker thread: post to the UI thread from here
+    public interface ResultCallback {
+        void onNativeResult(long handle, boolean ok);
+    }
+
+    // Async login check: the credentials, and the one-time code once a seed is
+    // enrolled (from codeStream if streamed, else from code). ok is true only
+    // if both matched. Everything is copied into locked native memory before
+    // this returns, so the caller can wipe its arrays at once
+    // Returns a request handle (0 on failure, then no callback comes)
+    public static native long submitCheckCredentials(char[] user, char[] pass, int realUlen, int realPlen,
+                                                     long codeStream, char[] code, int realClen,
+                                                     ResultCallback callback);
+
+    // Async decryptFlagIntoBuffer(): read the buffer only after ok == true
+    // Returns a request handle (0 on failure, then no callback comes)
+    public static native long submitDecryptFlag(char[] buffer, ResultCallback callback);
+
+    // Cancels a submitted request and wipes its native state (and a decrypt's buffer)
+    // True if cancelled: its callback will never run
+    public static native boolean cancelRequest(long handle);
+
+    // Keystroke streams: a text field sends each edit to native code as it is
+    // typed instead of keeping the characters (UI thread only)
+    // Returns a stream handle, 0 if none is available
+    public static native long openKeystrokeStream();
+
+    public static native boolean appendKeystroke(long stream, char c);
+
+    // Removes the last count characters
+    public static native boolean deleteKeystrokes(long stream, int count);
+
+    public static native boolean clearKeystrokes(long stream);
+
+    // Wipes the stream's text; the handle is dead afterwards
+    public static native void closeKeystrokeStream(long stream);
+
+    // checkCredentials() for two streamed fields (streams are left as they are)
+    public static native boolean checkStreamedCredentials(long userStream, long passStream);
+
+    // Async checkStreamedCredentials(), with the code as in submitCheckCredentials():
+    // the streams are read before this returns, the password hash is taken on
+    // a worker thread
+    // Returns a request handle (0 on failure, then no callback comes)
+    public static native long submitCheckStreamedCredentials(long userStream, long passStream,
+                                                             long codeStream, char[] code,
+                                                             int realClen, ResultCallback callback);
+
+    // Starts hashing a password stream in the background so a later check can
+    // reuse the hash; any edit of the stream cancels and wipes it
+    public static native boolean speculateKeystrokes(long stream);
+
+    // Cost of the memory-hard password hash (KiB per hash, mixing passes)
+    // The stored verifier is derived again; false on invalid arguments
+    public static native boolean setPasswordKdfCost(int memoryKiB, int passes);
+
+    // Offline breached-password check against a filter file built on the host
+    // (app/src/main/cpp/tools). Returns the passwords it holds, -1 on failure
+    public static native long loadBreachFilter(String path);
+
+    // BREACH_* result of looking a password up in the loaded filter
+    public static native int checkPasswordBreached(char[] pass, int realPlen);
+
+    // checkPasswordBreached() for a streamed field
+    public static native int checkKeystrokesBreached(long stream);
+
+    public static final int BREACH_FOUND = 1;
+    public static final int BREACH_NOT_FOUND = 0;
+    public static final int BREACH_UNKNOWN = -1;   // No filter loaded, or invalid text
+
+    // zxcvbn-style password strength, matched against ranked word lists built
+    // on the host (app/src/main/cpp/tools). Returns the words loaded, -1 on failure
+    public static native long loadStrengthDictionary(String path);
+
+    // Packed strength estimate of a password (decode with strength*()), -1 on
+    // failure; user (may be null) counts as guessable when it appears in pass
+    public static native int estimatePasswordStrength(char[] pass, int realPlen,
+                                                      char[] user, int realUlen);
+
+    // estimatePasswordStrength() for streamed fields (userStream 0 = none)
+    public static native int estimateKeystrokesStrength(long passStream, long userStream);
+
+    // Why a weak password is weak (mirrors strength_estimate.h)
+    public static final int STRENGTH_FEEDBACK_NONE = 0;
+    public static final int STRENGTH_FEEDBACK_TOP_PASSWORD = 1;
+    public static final int STRENGTH_FEEDBACK_COMMON_PASSWORD = 2;
+    public static final int STRENGTH_FEEDBACK_WORD = 3;
+    public static final int STRENGTH_FEEDBACK_NAME = 4;
+    public static final int STRENGTH_FEEDBACK_USER_INPUT = 5;
+    public static final int STRENGTH_FEEDBACK_SPATIAL = 6;
+    public static final int STRENGTH_FEEDBACK_REPEAT = 7;
+    public static final int STRENGTH_FEEDBACK_SEQUENCE = 8;
+    public static final int STRENGTH_FEEDBACK_YEAR = 9;
+    public static final int STRENGTH_FEEDBACK_DATE = 10;
+
+    // 0 (guessable within 10^3 tries) to 4 (10^10 or more)
+    public static int strengthScore(int packed) {
+        return packed & 0x7;
+    }
+
+    public static int strengthFeedback(int packed) {
+        return (packed >> 3) & 0x1F;
+    }
+
+    public static double strengthLog10Guesses(int packed) {
+        return (packed >>> 8) / 100.0;
+    }
+
+    // Second factor: TOTP (RFC 6238) codes, submitted with the credentials and
+    // checked natively alongside them. Each code is accepted once; the window
+    // allows for clock drift. Off until a seed is enrolled (nothing is built
+    // in), and enrollment lasts until the process ends
+    public static native boolean isOtpEnrolled();
+
+    // Checks a code on its own: false on a wrong code, and whenever no seed is enrolled
+    public static native boolean verifyOtp(char[] code, int realLen);
+
+    // verifyOtp() for a streamed field
+    public static native boolean verifyKeystrokesOtp(long stream);
+
+    // Enrollment: provisionOtp() stages a seed (base32, as in otpauth://
+    // URIs; false if invalid) and confirmOtp() enrolls it once a current code
+    // from it matches. Until then logins keep using the enrolled seed, if any
+    public static native boolean provisionOtp(char[] base32Seed, int realLen, int hash,
+                                              int digits, int periodSeconds, int windowSteps);
+
+    public static native boolean confirmOtp(char[] code, int realLen);
+
+    // confirmOtp() for a streamed field
+    public static native boolean confirmKeystrokesOtp(long stream);
+
+    // HMAC hash of a seed (mirrors hmac.h)
+    public static final int OTP_HASH_SHA1 = 0;
+    public static final int OTP_HASH_SHA256 = 1;
+
+    // Native stats layout (mirrors native_stats.h)
+    // Header: [version, entryCount, countersPerEntry, histogramBuckets]
+    public static final int STATS_HEADER_LEN = 4;
+    // Entry point order
+    public static final int STATS_EP_CHECK_CREDENTIALS = 0;
+    public static final int STATS_EP_GET_FLAG_LENGTH = 1;
+    public static final int STATS_EP_DECRYPT_FLAG = 2;
+    public static final int STATS_EP_WIPE_FLAG = 3;
+    public static final int STATS_EP_GET_NATIVE_STATS = 4;
+    public static final int STATS_EP_GET_LOCK_BUDGET = 5;
+    public static final int STATS_EP_GET_SECURE_BACKEND = 6;
+    public static final int STATS_EP_SCHEDULE_WIPE = 7;
+    public static final int STATS_EP_CANCEL_WIPE = 8;
+    public static final int STATS_EP_WIPE_ALL_SECRETS = 9;
+    public static final int STATS_EP_SET_SHARE_REFRESH = 10;
+    public static final int STATS_EP_SET_DEFERRED_WIPE = 11;
+    public static final int STATS_EP_TRIM_SECURE_MEMORY = 12;
+    public static final int STATS_EP_SUBMIT_CHECK_CREDENTIALS = 13;
+    public static final int STATS_EP_SUBMIT_DECRYPT_FLAG = 14;
+    public static final int STATS_EP_CANCEL_REQUEST = 15;
+    public static final int STATS_EP_OPEN_KEYSTROKE_STREAM = 16;
+    public static final int STATS_EP_APPEND_KEYSTROKE = 17;
+    public static final int STATS_EP_DELETE_KEYSTROKES = 18;
+    public static final int STATS_EP_CLEAR_KEYSTROKES = 19;
+    public static final int STATS_EP_CLOSE_KEYSTROKE_STREAM = 20;
+    public static final int STATS_EP_CHECK_STREAMED_CREDENTIALS = 21;
+    public static final int STATS_EP_SUBMIT_CHECK_STREAMED_CREDENTIALS = 22;
+    public static final int STATS_EP_SPECULATE_KEYSTROKES = 23;
+    public static final int STATS_EP_SET_PASSWORD_KDF_COST = 24;
+    public static final int STATS_EP_LOAD_BREACH_FILTER = 25;
+    public static final int STATS_EP_CHECK_PASSWORD_BREACHED = 26;
+    public static final int STATS_EP_CHECK_KEYSTROKES_BREACHED = 27;
+    public static final int STATS_EP_LOAD_STRENGTH_DICTIONARY = 28;
+    public static final int STATS_EP_ESTIMATE_PASSWORD_STRENGTH = 29;
+    public static final int STATS_EP_ESTIMATE_KEYSTROKES_STRENGTH = 30;
+    public static final int STATS_EP_PROVISION_OTP = 31;
+    public static final int STATS_EP_VERIFY_OTP = 32;
+    public static final int STATS_EP_VERIFY_KEYSTROKES_OTP = 33;
+    public static final int STATS_EP_BENCHMARK_KERNELS = 34;
+    public static final int STATS_EP_SELECT_KERNEL = 35;
+    public static final int STATS_EP_IS_OTP_ENROLLED = 36;
+    public static final int STATS_EP_CONFIRM_OTP = 37;
+    public static final int STATS_EP_CONFIRM_KEYSTROKES_OTP = 38;
+    // Counter order within an entry (histogram buckets follow the counters)
+    public static final int STATS_CALLS = 0;
+    public static final int STATS_FAILURES = 1;
+    // Bytes from secure_memzero, stack scrubs, locked-region frees, sealed slot reseals
+    // and wipeAllSecrets; other wipes go through the shared kernels and are not counted
+    public static final int STATS_BYTES_WIPED = 2;
+    public static final int STATS_MLOCK_CALLS = 3;
+    public static final int STATS_MLOCK_FAILURES = 4;
+    public static final int STATS_JNI_COPIES = 5;
+    public static final int STATS_LATENCY_SUM_NS = 6;
+    public static final int STATS_LATENCY_MAX_NS = 7;
+
+    // Per-entry-point counters and latency histograms, aggregated across threads
+    public static native long[] getNativeStats();
+
+    // Locked-memory budget: {limitBytes (-1 = unlimited), lockedBytes, deniedRequests, pressurePermille}
+    public static native long[] getLockBudget();
+
+    // Locking backend in use: "memfd_secret", "map_locked" or "mlock"
+    public static native String getSecureBackend();
+
+    // Wipe, compare, ChaCha20 and SHA kernels: each is bound at load to the
+    // fastest variant the CPU runs. benchmarkKernels() times every variant
+    // (blocks for ~2 * millisPerRun per variant, call off the UI thread);
+    // selectKernel("sha256", "portable") forces one, "auto" restores it
+    public static native String benchmarkKernels(int millisPerRun);
+
+    public static native boolean selectKernel(String kernel, String variant);
+
+    // Reads one counter out of a getNativeStats() snapshot
+    public static long statValue(long[] stats, int entry, int counter) {
+        if (stats == null || stats.length < STATS_HEADER_LEN) return 0;
+        int stride = (int) (stats[2] + stats[3]);
+        int idx = STATS_HEADER_LEN + entry * stride + counter;
+        return idx < stats.length ? stats[idx] : 0;
+    }
+
     // Helper method that manages buffer lifecycle
     public static char[] getAndWipeFlag() {
         int length = getFlagLength();
@@ -6,6 +6,7 @@ import android.os.Bundle;
 import android.os.Handler;
 import android.util.Log;
 import android.widget.Button;
+import android.widget.Toast;
 
 import java.security.SecureRandom;
 import java.util.Arrays;
@@ -23,6 +24,18 @@ public class SecretActivity extends AppCompatActivity {
     private final SecureRandom secureRandom = new SecureRandom();
     // Runnable task for auto-hiding the flag
     private Runnable hideFlagTask;
+    // Native decrypt in flight (0 = none) and the buffer it fills, UI thread only
+    private long pendingFlag = 0;
+    private char[] pendingFlagBuffer;
+
+    // Second-factor enrollment, offered only past a full login: the setup key
+    // (revealable, so it stays in a Java buffer) and a code it gives right now
+    private SecureEditText secureOtpSeed, secureOtpConfirm;
+    private Button btnEnrollOtp;
+    // What most authenticator apps assume for a bare setup key
+    private static final int OTP_DIGITS = 6;
+    private static final int OTP_PERIOD_SECONDS = 30;
+    private static final int OTP_WINDOW_STEPS = 1;
 
     @Override
     protected void onCreate(Bundle savedInstanceState) {
@@ -34,6 +47,16 @@ public class SecretActivity extends AppCompatActivity {
         flagView = findViewById(R.id.flagTextView);
         btnShow5Sec = findViewById(R.id.btnShow5Sec);
         btnHideFlag = findViewById(R.id.btnHideFlag);
+        secureOtpSeed = findViewById(R.id.etOtpSeed);
+        secureOtpConfirm = findViewById(R.id.etOtpConfirm);
+        btnEnrollOtp = findViewById(R.id.btnEnrollOtp);
+
+        secureOtpSeed.setHint("Setup key");
+        secureOtpConfirm.setHint("Code your authenticator shows for it");
+
+        // Native backstop: the flag is wiped after 5 seconds even if the
+        // UI thread is stalled and the Handler below runs late
+        flagView.setAutoWipeMillis(5000);
 
         // Set up button click listeners
         setupClickListeners();
@@ -60,16 +83,65 @@ public class SecretActivity extends AppCompatActivity {
 
         // "Hide Flag" button (immediate hide)
         btnHideFlag.setOnClickListener(v -> hideFlag());
+
+        btnEnrollOtp.setOnClickListener(v -> enrollOtp());
+    }
+
+    /**
+     * Enrolls the typed setup key as the login's second factor
+     * The key is only staged natively until the code typed with it matches,
+     * so a typo can't replace a working seed. Both fields are wiped either way
+     */
+    private void enrollOtp() {
+        int seedLen = secureOtpSeed.getBufferLength();
+        if (seedLen == 0 || secureOtpConfirm.getBufferLength() == 0) {
+            showToast("Enter the setup key and a code from it");
+            return;
+        }
+
+        boolean staged = NativeBridge.provisionOtp(secureOtpSeed.getSecureBufferDirect(), seedLen,
+                NativeBridge.OTP_HASH_SHA1, OTP_DIGITS, OTP_PERIOD_SECONDS, OTP_WINDOW_STEPS);
+        boolean ok = false;
+        if (staged) {
+            long confirmStream = secureOtpConfirm.getKeystrokeStream();
+            ok = confirmStream != 0
+                    ? NativeBridge.confirmKeystrokesOtp(confirmStream)
+                    : NativeBridge.confirmOtp(secureOtpConfirm.getSecureBufferDirect(),
+                            secureOtpConfirm.getBufferLength());
+        }
+        secureOtpSeed.clearSecureBuffer();
+        secureOtpConfirm.clearSecureBuffer();
+
+        if (!staged) {
+            showToast("Invalid setup key");
+        } else if (!ok) {
+            showToast("The code does not match this setup key");
+        } else {
+            showToast("One-time codes are on for the next login");
+        }
+    }
+
+    /**
+     * Helper method to show toast messages
+     *
+     * @param message The message to display (non-sensitive)
+     */
+    private void showToast(CharSequence message) {
+        Toast.makeText(this, message, Toast.LENGTH_SHORT).show();
     }
 
     /**
      * Retrieves and displays the flag from native code
      * Follows secure practices: uses char[], never String
+     * The decrypt runs on the native worker pool; the flag is shown in onFlagDecrypted()
      */
     private void showFlag() {
         // Logging for debugging the flag retrieval flow
         Log.d("FLAG_FLOW", "=== START: Getting flag ===");
 
+        // A decrypt is already on its way
+        if (pendingFlag != 0) return;
+
         // Step 1: Get flag length from native code
         int flagLength = NativeBridge.getFlagLength();
         if (flagLength <= 0) {
@@ -81,15 +153,40 @@ public class SecretActivity extends AppCompatActivity {
         // Using char[] instead of String to avoid interning in String pool
         char[] flagBuffer = new char[flagLength];
 
-        try {
-            // Step 3: Decrypt flag directly into our buffer (no intermediate Strings)
-            // NativeBridge.decryptFlagIntoBuffer fills the provided char array
-            NativeBridge.decryptFlagIntoBuffer(flagBuffer);
+        // Step 3: Decrypt directly into our buffer on the native worker pool
+        // (no intermediate Strings, and the UI thread never waits)
+        long handle = NativeBridge.submitDecryptFlag(flagBuffer,
+                (h, ok) -> runOnUiThread(() -> onFlagDecrypted(h, ok)));
+        if (handle == 0) {
+            Log.e("FLAG_FLOW", "Decrypt could not be submitted");
+            return;
+        }
+        pendingFlag = handle;
+        pendingFlagBuffer = flagBuffer;
+    }
 
-            // Step 4: Pass buffer to SecureTextView for display
-            flagView.setSecureFlag(flagBuffer, flagLength);
-            // Make the flag visible (SecureTextView will show actual characters)
-            flagView.setShowFlag(true);
+    /**
+     * Displays a decrypted flag and wipes the buffer it came in (UI thread)
+     *
+     * @param handle Request the result belongs to
+     * @param ok     Whether the buffer now holds the flag
+     */
+    private void onFlagDecrypted(long handle, boolean ok) {
+        // Stale result: the decrypt was cancelled and its buffer already wiped
+        if (handle != pendingFlag) return;
+        char[] flagBuffer = pendingFlagBuffer;
+        pendingFlag = 0;
+        pendingFlagBuffer = null;
+
+        try {
+            if (ok) {
+                // Step 4: Pass buffer to SecureTextView for display
+                flagView.setSecureFlag(flagBuffer, flagBuffer.length);
+                // Make the flag visible (SecureTextView will show actual characters)
+                flagView.setShowFlag(true);
+            } else {
+                Log.e("FLAG_FLOW", "Decrypt failed");
+            }
 
         } finally {
             // CRITICAL SECURITY STEP: Always wipe the buffer, even if errors occur
@@ -108,6 +205,21 @@ public class SecretActivity extends AppCompatActivity {
         Log.d("FLAG_FLOW", "=== COMPLETE: Local buffer wiped ===");
     }
 
+    /**
+     * Drops a decrypt that has not been shown yet
+     */
+    private void cancelPendingFlag() {
+        if (pendingFlag == 0) return;
+        // Cancelled: native code wiped the buffer. Otherwise the flag is in it
+        // and the (now stale) result is on its way, so wipe it here
+        if (!NativeBridge.cancelRequest(pendingFlag)) {
+            NativeBridge.wipeFlagBuffer(pendingFlagBuffer);
+            secureWipeArray(pendingFlagBuffer);
+        }
+        pendingFlag = 0;
+        pendingFlagBuffer = null;
+    }
+
     /**
      * Securely wipes a character array by overwriting with random data
      * Prevents sensitive data from being recovered from memory
@@ -142,6 +254,8 @@ public class SecretActivity extends AppCompatActivity {
      */
     private void hideFlag() {
         // Step 1: Tell SecureTextView to wipe its internal buffer and show dots
+        // (and drop a decrypt that has not arrived yet)
+        cancelPendingFlag();
         flagView.clearSecureFlag();
 
         // Step 2: Cancel any pending auto-hide task
@@ -163,6 +277,10 @@ public class SecretActivity extends AppCompatActivity {
     protected void onPause() {
         super.onPause();
         hideFlag(); // Always hide when activity is paused
+        NativeBridge.wipeAllSecrets(); // And wipe any native plaintext still in flight
+        // A half-typed enrollment is not worth keeping
+        secureOtpSeed.clearSecureBuffer();
+        secureOtpConfirm.clearSecureBuffer();
     }
 
     /**
@@ -174,4 +292,15 @@ public class SecretActivity extends AppCompatActivity {
         super.onDestroy();
         hideFlag(); // Final cleanup before destruction
     }
+
+    /**
+     * Called when the system wants memory back
+     * Hands unused locked native memory back to the kernel
+     */
+    @Override
+    public void onTrimMemory(int level) {
+        super.onTrimMemory(level);
+        long released = NativeBridge.trimSecureMemory(level);
+        Log.d("MEM_SEC", "Trim level " + level + " released " + released + " locked bytes");
+    }
 }
\ No newline at end of file
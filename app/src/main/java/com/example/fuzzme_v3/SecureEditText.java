@@ -32,6 +32,28 @@ public class SecureEditText extends LinearLayout {
     private final char[] secureBuffer;
     private int bufferLength = 0;        // Actual number of characters stored
 
+    // Native keystroke stream (0 = none): while attached, fields without a
+    // show/hide toggle send every edit to native code and secureBuffer stays
+    // empty; text that can be revealed has to stay in Java. A stream that
+    // rejects an edit is dropped and the field starts over in secureBuffer
+    private long keystrokeStream = 0;
+
+    // Field whose stream falls back together with this one (null = none), so
+    // a check reads either both fields from native streams or both from Java
+    private SecureEditText streamPartner = null;
+
+    // Speculative hashing of the streamed text (0 = off): after this much
+    // typing idle time, or when focus leaves the field, native code starts
+    // the password hash so a later check can reuse it
+    private long speculationIdleMillis = 0;
+    private final Runnable speculateRunnable = this::speculateNow;
+
+    // Told about every edit, clearing included (e.g. to refresh a strength meter)
+    public interface OnSecureEditListener {
+        void onSecureEdit(SecureEditText field);
+    }
+    private OnSecureEditListener editListener = null;
+
     // Configuration and state
     private boolean showToggleButton = false;  // Whether to show toggle button
     private boolean isPasswordVisible = false; // Whether password is currently visible
@@ -98,6 +120,11 @@ public class SecureEditText extends LinearLayout {
         editText.setInputType(android.text.InputType.TYPE_CLASS_TEXT |
                 android.text.InputType.TYPE_TEXT_VARIATION_PASSWORD);
 
+        // Leaving the field is as good a hint as an idle pause
+        editText.setOnFocusChangeListener((v, hasFocus) -> {
+            if (!hasFocus) speculateNow();
+        });
+
         addView(editText);
     }
 
@@ -148,17 +175,36 @@ public class SecureEditText extends LinearLayout {
                     // Character added (inserted or appended)
                     char newChar = current.charAt(newLength - 1);
                     if (bufferLength < secureBuffer.length) {
-                        // Store in secure buffer
-                        secureBuffer[bufferLength++] = newChar;
+                        if (keystrokeStream != 0) {
+                            // Straight to native code, nothing kept here
+                            if (NativeBridge.appendKeystroke(keystrokeStream, newChar)) {
+                                bufferLength++;
+                            } else {
+                                abandonKeystrokeStream();
+                            }
+                        } else {
+                            // Store in secure buffer
+                            secureBuffer[bufferLength++] = newChar;
+                        }
                     }
                 } else if (newLength < bufferLength) {
                     // Character deleted
-                    bufferLength = newLength;
+                    if (keystrokeStream != 0 &&
+                            !NativeBridge.deleteKeystrokes(keystrokeStream, bufferLength - newLength)) {
+                        abandonKeystrokeStream();
+                    } else {
+                        bufferLength = newLength;
+                    }
                     // Note: We don't shift array, just reduce length
                     // Old characters remain but are outside the "valid" length
                 }
                 // If lengths are equal, text was modified in place
 
+                // Every edit cancelled a running speculation natively: restart the idle timer
+                scheduleSpeculation();
+
+                if (editListener != null) editListener.onSecureEdit(SecureEditText.this);
+
                 // Update display (show dots or actual text)
                 updateDisplay();
             }
@@ -170,6 +216,26 @@ public class SecureEditText extends LinearLayout {
         });
     }
 
+    /**
+     * Starts the idle timer for speculative hashing (if enabled)
+     */
+    private void scheduleSpeculation() {
+        removeCallbacks(speculateRunnable);
+        if (speculationIdleMillis > 0 && keystrokeStream != 0 && bufferLength > 0) {
+            postDelayed(speculateRunnable, speculationIdleMillis);
+        }
+    }
+
+    /**
+     * Asks native code to hash the streamed text now (if enabled)
+     */
+    private void speculateNow() {
+        removeCallbacks(speculateRunnable);
+        if (speculationIdleMillis > 0 && keystrokeStream != 0 && bufferLength > 0) {
+            NativeBridge.speculateKeystrokes(keystrokeStream);
+        }
+    }
+
     /**
      * Toggles between showing password as dots or actual characters
      */
@@ -306,6 +372,35 @@ public class SecureEditText extends LinearLayout {
         return secureBuffer;
     }
 
+    /**
+     * Returns the native keystroke stream holding this field's text
+     * 0 if the text is kept in the secure buffer instead
+     */
+    public long getKeystrokeStream() {
+        return keystrokeStream;
+    }
+
+    /**
+     * Enables speculative hashing of a streamed field's text
+     * Native code starts the password hash once typing has been idle for
+     * idleMillis or focus leaves the field; any later edit cancels it.
+     * Only streamed fields (no toggle button) speculate
+     *
+     * @param idleMillis Idle time before hashing, 0 to turn speculation off
+     */
+    public void setSpeculativeHashing(long idleMillis) {
+        speculationIdleMillis = Math.max(0, idleMillis);
+        scheduleSpeculation();
+    }
+
+    /**
+     * Sets the listener told about every edit (null to remove it)
+     * It runs on the UI thread while the edit is applied: keep it short
+     */
+    public void setOnSecureEditListener(OnSecureEditListener listener) {
+        editListener = listener;
+    }
+
     /**
      * Returns current number of characters in buffer
      */
@@ -326,6 +421,12 @@ public class SecureEditText extends LinearLayout {
         byte[] randomBytes = new byte[bufferLength * 2];
         secureRandom.nextBytes(randomBytes);
 
+        // Streamed text only exists natively (clearing also cancels its speculation)
+        removeCallbacks(speculateRunnable);
+        if (keystrokeStream != 0) {
+            NativeBridge.clearKeystrokes(keystrokeStream);
+        }
+
         // Overwrite secure buffer with random data
         for (int i = 0; i < bufferLength; i++) {
             int byteIdx = i * 2;
@@ -364,6 +465,13 @@ public class SecureEditText extends LinearLayout {
         if (this.showToggleButton != show) {
             this.showToggleButton = show;
 
+            if (show && keystrokeStream != 0) {
+                // Revealable text must live in Java: drop the stream (and its text)
+                clearSecureBuffer();
+                closeKeystrokeStream();
+                if (streamPartner != null) streamPartner.abandonKeystrokeStream();
+            }
+
             if (show && toggleButton == null) {
                 // Add toggle button if showing
                 initToggleButton(getContext());
@@ -375,6 +483,26 @@ public class SecureEditText extends LinearLayout {
         }
     }
 
+    /**
+     * Called when view is attached to a window
+     * Opens the native keystroke stream (falls back to the secure buffer)
+     */
+    @Override
+    protected void onAttachedToWindow() {
+        super.onAttachedToWindow();
+        if (!showToggleButton && keystrokeStream == 0 && bufferLength == 0) {
+            // A partner already typing into its secure buffer keeps this one there too
+            if (streamPartner != null && streamPartner.isAttachedToWindow() &&
+                    streamPartner.keystrokeStream == 0) {
+                return;
+            }
+            keystrokeStream = NativeBridge.openKeystrokeStream();
+            if (keystrokeStream == 0 && streamPartner != null) {
+                streamPartner.abandonKeystrokeStream();
+            }
+        }
+    }
+
     /**
      * Called when view is removed from window
      * Ensures secure cleanup
@@ -383,5 +511,48 @@ public class SecureEditText extends LinearLayout {
     protected void onDetachedFromWindow() {
         super.onDetachedFromWindow();
         clearSecureBuffer();  // Always clear when view is detached
+        closeKeystrokeStream();
+    }
+
+    /**
+     * Makes this field and partner fall back from native streams together
+     * Call before the views are attached; a field with a toggle button never
+     * streams, so pairing it keeps its partner in Java as well
+     */
+    public void pairKeystrokeStreams(SecureEditText partner) {
+        streamPartner = partner;
+        partner.streamPartner = this;
+    }
+
+    /**
+     * Drops the native stream after it (or the partner's) rejected an edit
+     * Its text can't be read back into Java, so the field is cleared on screen
+     * and whatever is typed next goes to the secure buffer
+     */
+    private void abandonKeystrokeStream() {
+        if (keystrokeStream == 0) return;
+        Log.w(TAG, "Keystroke stream dropped, field cleared, keeping text in Java");
+        closeKeystrokeStream();
+        bufferLength = 0;
+
+        // Clear the shown dots so bufferLength matches the view again
+        boolean wasUpdating = isUpdating;
+        isUpdating = true;
+        editText.setText("");
+        isUpdating = wasUpdating;
+        if (editListener != null) editListener.onSecureEdit(this);
+
+        if (streamPartner != null) streamPartner.abandonKeystrokeStream();
+    }
+
+    /**
+     * Wipes and releases the native keystroke stream, if any
+     */
+    private void closeKeystrokeStream() {
+        removeCallbacks(speculateRunnable);
+        if (keystrokeStream != 0) {
+            NativeBridge.closeKeystrokeStream(keystrokeStream);
+            keystrokeStream = 0;
+        }
     }
 }
@@ -28,6 +28,10 @@ public class SecureTextView extends View {
     private int flagLength = 0;
     // Controls whether to show real flag or masked dots
     private boolean showFlag = false;
+    // Native TTL after which the buffer is wiped even if the UI thread stalls (0 = off)
+    private long autoWipeMillis = 0;
+    // Handle of the pending native wipe (0 = none)
+    private long wipeTimer = 0;
 
     // For drawing calculations
     private float charWidth = 0;    // Width of a single character
@@ -100,6 +104,11 @@ public class SecureTextView extends View {
         flagLength = length;
         showFlag = true;
 
+        // Backstop for UI auto-hide: native thread wipes our copy at the deadline
+        if (autoWipeMillis > 0) {
+            wipeTimer = NativeBridge.scheduleWipe(flagBuffer, autoWipeMillis);
+        }
+
         // Trigger redraw to display the new flag
         invalidate();
     }
@@ -114,11 +123,26 @@ public class SecureTextView extends View {
         invalidate();  // Request redraw with new visibility state
     }
 
+    /**
+     * Sets the native wipe deadline applied to every subsequent setSecureFlag()
+     *
+     * @param millis Time to live of the displayed flag, 0 to disable
+     */
+    public void setAutoWipeMillis(long millis) {
+        this.autoWipeMillis = Math.max(0, millis);
+    }
+
     /**
      * Securely wipe the flag buffer to prevent memory extraction
      * Uses multiple passes with random data followed by zeroing
      */
     public void clearSecureFlag() {
+        // Cancel the native wipe first so it never races our own wipe below
+        if (wipeTimer != 0) {
+            NativeBridge.cancelWipe(wipeTimer);
+            wipeTimer = 0;
+        }
+
         if (flagBuffer != null) {
             // Multi-pass secure wipe to prevent data recovery
 